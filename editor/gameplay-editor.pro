@@ -61,7 +61,6 @@ INCLUDEPATH += src \
   $$(FMAKE_REPO)/lib/cpp/openal-1.22.2-release/include \
   $$(FMAKE_REPO)/lib/cpp/bullet-3.24-release/include \
   $$(FMAKE_REPO)/lib/cpp/freetype-2.4.12-release/include \
-  $$(FMAKE_REPO)/lib/cpp/libjson-7.6.1-release/include \
   $$(FMAKE_REPO)/lib/cpp/ljs-1.0-release/include \
 
 CONFIG(release, debug|release): INCLUDEPATH += \
@@ -76,7 +75,6 @@ CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/glew-1.0-releas
 CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/openal-1.22.2-release/lib
 CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/bullet-3.24-release/lib
 CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/freetype-2.4.12-release/lib
-CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/libjson-7.6.1-release/lib
 CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/ljs-1.0-release/lib
 CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/mgpEngine-1.0-release/lib
 CONFIG(release, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/mgpModules-1.0-release/lib
@@ -86,7 +84,6 @@ CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/glew-1.0-debug/li
 CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/openal-1.22.2-debug/lib
 CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/bullet-3.24-debug/lib
 CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/freetype-2.4.12-debug/lib
-CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/libjson-7.6.1-debug/lib
 CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/ljs-1.0-debug/lib
 CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/mgpEngine-1.0-debug/lib
 CONFIG(debug, debug|release): LIBS += -L$$(FMAKE_REPO)/lib/cpp/mgpModules-1.0-debug/lib
@@ -99,7 +96,6 @@ LIBS += -lglfw
 LIBS += -lopenal
 LIBS += -lbullet
 LIBS += -lfreetype
-LIBS += -llibjson
 LIBS += -lljs
 
 win32 {
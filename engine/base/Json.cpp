@@ -0,0 +1,855 @@
+#include "Base.h"
+#include "Json.h"
+#include "Stream.h"
+
+// Size of the buffer the reader reads its stream into
+#define JSON_READ_BUFFER_SIZE 65536
+
+// Size of the blocks the writer flushes to its stream
+#define JSON_WRITE_BLOCK_SIZE 65536
+
+// Longest number the reader reads
+#define JSON_MAX_NUMBER_LENGTH 64
+
+namespace gameplay
+{
+
+JsonReader::JsonReader()
+    : _stream(NULL), _buffer(NULL), _position(0), _size(0), _offset(0), _line(1),
+      _first(false), _afterName(false), _done(false), _token(TOKEN_NULL), _number(0.0), _bool(false)
+{
+}
+
+JsonReader::~JsonReader()
+{
+}
+
+void JsonReader::open(Stream* stream)
+{
+    GP_ASSERT(stream);
+
+    reset();
+    _stream = stream;
+    _block.resize(JSON_READ_BUFFER_SIZE);
+    _buffer = &_block[0];
+    _offset = stream->position();
+
+    // Skip a UTF-8 byte order mark, which may be split by short reads.
+    if (peekChar() == 0xEF)
+    {
+        ++_position;
+        if (peekChar() == 0xBB)
+        {
+            ++_position;
+            if (peekChar() == 0xBF)
+                ++_position;
+        }
+    }
+}
+
+void JsonReader::open(const char* text, size_t length)
+{
+    GP_ASSERT(text || length == 0);
+
+    reset();
+    _block.assign(text, text + length);
+    _buffer = _block.empty() ? NULL : &_block[0];
+    _size = length;
+}
+
+void JsonReader::reset()
+{
+    _stream = NULL;
+    _block.clear();
+    _replay.clear();
+    _buffer = NULL;
+    _position = 0;
+    _size = 0;
+    _offset = 0;
+    _line = 1;
+    _containers.clear();
+    _first = false;
+    _afterName = false;
+    _done = false;
+    _token = TOKEN_NULL;
+    _name.clear();
+    _string.clear();
+}
+
+JsonReader::Token JsonReader::next()
+{
+    if (_token == TOKEN_ERROR)
+        return TOKEN_ERROR;
+
+    skipWhiteSpace();
+    if (_afterName)
+    {
+        _afterName = false;
+        return readValue();
+    }
+    if (_containers.empty())
+    {
+        if (!_done)
+            return readValue();
+        if (peekChar() >= 0)
+            fail("unexpected text after the root value");
+        else
+            _token = TOKEN_END;
+        return _token;
+    }
+
+    bool object = _containers.back() == '{';
+    int c = peekChar();
+    if (c == (object ? '}' : ']'))
+    {
+        ++_position;
+        endContainer();
+        return _token;
+    }
+    if (!_first)
+    {
+        if (c != ',')
+        {
+            fail(object ? "expected ',' or '}' in an object" : "expected ',' or ']' in an array");
+            return _token;
+        }
+        ++_position;
+        skipWhiteSpace();
+    }
+    _first = false;
+    if (!object)
+        return readValue();
+
+    if (peekChar() != '"')
+    {
+        fail("expected a member name");
+        return _token;
+    }
+    if (!readString(&_name))
+        return _token;
+    skipWhiteSpace();
+    if (peekChar() != ':')
+    {
+        fail("expected ':' after a member name");
+        return _token;
+    }
+    ++_position;
+    _afterName = true;
+    _token = TOKEN_NAME;
+    return _token;
+}
+
+JsonReader::Token JsonReader::getToken() const
+{
+    return _token;
+}
+
+const char* JsonReader::getName() const
+{
+    return _name.c_str();
+}
+
+bool JsonReader::getBool() const
+{
+    return _bool;
+}
+
+double JsonReader::getNumber() const
+{
+    return _number;
+}
+
+const char* JsonReader::getString() const
+{
+    return _string.c_str();
+}
+
+bool JsonReader::readNumbers(std::vector<float>* out)
+{
+    GP_ASSERT(out);
+    GP_ASSERT(_token == TOKEN_BEGIN_ARRAY);
+
+    out->clear();
+    char text[JSON_MAX_NUMBER_LENGTH];
+    char* end;
+    while (nextArrayNumber(text, sizeof(text), out->empty()))
+    {
+        out->push_back(strtof(text, &end));
+        if (*end != '\0')
+            return fail("invalid number");
+    }
+    return _token != TOKEN_ERROR;
+}
+
+bool JsonReader::readNumbers(std::vector<int>* out)
+{
+    GP_ASSERT(out);
+    GP_ASSERT(_token == TOKEN_BEGIN_ARRAY);
+
+    out->clear();
+    char text[JSON_MAX_NUMBER_LENGTH];
+    char* end;
+    while (nextArrayNumber(text, sizeof(text), out->empty()))
+    {
+        // Integers may have been written as floats.
+        out->push_back((int)strtod(text, &end));
+        if (*end != '\0')
+            return fail("invalid number");
+    }
+    return _token != TOKEN_ERROR;
+}
+
+bool JsonReader::skipValue(std::string* text)
+{
+    GP_ASSERT(_afterName);
+
+    if (text)
+        text->clear();
+    if (_token == TOKEN_ERROR)
+        return false;
+
+    _afterName = false;
+    skipWhiteSpace();
+    return scan(0, text, NULL, NULL);
+}
+
+bool JsonReader::skip()
+{
+    GP_ASSERT(!_containers.empty());
+
+    if (_token == TOKEN_ERROR)
+        return false;
+
+    _afterName = false;
+    if (!scan(1, NULL, NULL, NULL))
+        return false;
+    endContainer();
+    return true;
+}
+
+bool JsonReader::peek(unsigned int* count, std::vector<std::string>* names)
+{
+    GP_ASSERT(!_containers.empty());
+
+    if (names)
+        names->clear();
+    if (_token == TOKEN_ERROR)
+        return false;
+
+    // Copy the text scanned when it can't be read again from the stream.
+    size_t position = _position;
+    long int offset = _offset;
+    unsigned int line = _line;
+    bool copy = _stream && !_stream->canSeek();
+    std::string text;
+    if (!scan(1, copy ? &text : NULL, count, names))
+        return false;
+
+    // The offset of the buffer only changes when the buffer is filled again.
+    if (_offset == offset)
+    {
+        _position = position;
+    }
+    else if (!copy)
+    {
+        if (!_stream->seek(offset + (long int)position, SEEK_SET))
+            return fail("failed to seek back in the stream");
+        _buffer = &_block[0];
+        _offset = offset + (long int)position;
+        _position = 0;
+        _size = 0;
+    }
+    else
+    {
+        std::vector<char> replay(text.begin(), text.end());
+        replay.insert(replay.end(), _buffer + _position, _buffer + _size);
+        _replay.swap(replay);
+        _buffer = _replay.data();
+        _position = 0;
+        _size = _replay.size();
+    }
+    _line = line;
+
+    // Names are scanned as written, unescape the few that need it.
+    if (names)
+    {
+        for (size_t i = 0; i < names->size(); ++i)
+        {
+            std::string& name = (*names)[i];
+            if (name.find('\\') == std::string::npos)
+                continue;
+            JsonReader reader;
+            std::string quoted = "\"" + name + "\"";
+            reader.open(quoted.c_str(), quoted.size());
+            if (reader.next() == TOKEN_STRING)
+                name = reader.getString();
+        }
+    }
+    return true;
+}
+
+bool JsonReader::fill()
+{
+    if (!_stream)
+        return false;
+
+    // Read the text peek() copied first, then go on with the stream.
+    _offset += (long int)_size;
+    _buffer = &_block[0];
+    _position = 0;
+    _size = _stream->read(&_block[0], 1, _block.size());
+    return _size > 0;
+}
+
+int JsonReader::peekChar()
+{
+    if (_position == _size && !fill())
+        return -1;
+    return (unsigned char)_buffer[_position];
+}
+
+void JsonReader::skipWhiteSpace()
+{
+    while (_position < _size || fill())
+    {
+        char c = _buffer[_position];
+        if (c == '\n')
+            ++_line;
+        else if (!isspace((unsigned char)c))
+            return;
+        ++_position;
+    }
+}
+
+bool JsonReader::fail(const char* message)
+{
+    GP_WARN("Failed to parse json at line %u: %s.", _line, message);
+    _token = TOKEN_ERROR;
+    return false;
+}
+
+JsonReader::Token JsonReader::readValue()
+{
+    int c = peekChar();
+    if (c == '{' || c == '[')
+    {
+        ++_position;
+        _containers.push_back((char)c);
+        _first = true;
+        _token = c == '{' ? TOKEN_BEGIN_OBJECT : TOKEN_BEGIN_ARRAY;
+        return _token;
+    }
+
+    if (c == '"')
+    {
+        if (readString(&_string))
+            _token = TOKEN_STRING;
+    }
+    else if (c == 't' || c == 'f')
+    {
+        _bool = c == 't';
+        if (readLiteral(_bool ? "true" : "false"))
+            _token = TOKEN_BOOL;
+    }
+    else if (c == 'n')
+    {
+        if (readLiteral("null"))
+            _token = TOKEN_NULL;
+    }
+    else if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        char text[JSON_MAX_NUMBER_LENGTH];
+        char* end;
+        if (!readNumberText(text, sizeof(text)))
+            return _token;
+        _number = strtod(text, &end);
+        if (*end != '\0')
+            fail("invalid number");
+        else
+            _token = TOKEN_NUMBER;
+    }
+    else
+    {
+        fail(c < 0 ? "unexpected end of text" : "expected a value");
+    }
+
+    if (_containers.empty() && _token != TOKEN_ERROR)
+        _done = true;
+    return _token;
+}
+
+bool JsonReader::readString(std::string* str)
+{
+    GP_ASSERT(_buffer[_position] == '"');
+
+    ++_position;
+    str->clear();
+    while (true)
+    {
+        if (_position == _size && !fill())
+            return fail("unterminated string");
+
+        // Copy the characters up to the end of the string or the next escape at once.
+        size_t start = _position;
+        while (_position < _size && _buffer[_position] != '"' && _buffer[_position] != '\\')
+            ++_position;
+        str->append(_buffer + start, _position - start);
+        if (_position == _size)
+            continue;
+
+        if (_buffer[_position++] == '"')
+            return true;
+        int c = peekChar();
+        if (c < 0)
+            return fail("unterminated string");
+        ++_position;
+        if (!readEscape(c, str))
+            return false;
+    }
+}
+
+static void appendUtf8(int code, std::string* str)
+{
+    if (code < 0x80)
+    {
+        *str += (char)code;
+    }
+    else if (code < 0x800)
+    {
+        *str += (char)(0xC0 | (code >> 6));
+        *str += (char)(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000)
+    {
+        *str += (char)(0xE0 | (code >> 12));
+        *str += (char)(0x80 | ((code >> 6) & 0x3F));
+        *str += (char)(0x80 | (code & 0x3F));
+    }
+    else
+    {
+        *str += (char)(0xF0 | (code >> 18));
+        *str += (char)(0x80 | ((code >> 12) & 0x3F));
+        *str += (char)(0x80 | ((code >> 6) & 0x3F));
+        *str += (char)(0x80 | (code & 0x3F));
+    }
+}
+
+bool JsonReader::readEscape(int c, std::string* str)
+{
+    switch (c)
+    {
+    case '"': *str += '"'; return true;
+    case '\\': *str += '\\'; return true;
+    case '/': *str += '/'; return true;
+    case 'b': *str += '\b'; return true;
+    case 'f': *str += '\f'; return true;
+    case 'n': *str += '\n'; return true;
+    case 'r': *str += '\r'; return true;
+    case 't': *str += '\t'; return true;
+    case 'u':
+        break;
+    default:
+        return fail("invalid escape in a string");
+    }
+
+    int code = readHex4();
+    if (code < 0)
+        return fail("invalid unicode escape");
+
+    // Combine surrogate pairs.
+    if (code >= 0xD800 && code <= 0xDBFF && peekChar() == '\\')
+    {
+        ++_position;
+        int next = peekChar();
+        if (next < 0)
+            return fail("unterminated string");
+        ++_position;
+        if (next != 'u')
+        {
+            appendUtf8(code, str);
+            return readEscape(next, str);
+        }
+        int low = readHex4();
+        if (low < 0)
+            return fail("invalid unicode escape");
+        if (low >= 0xDC00 && low <= 0xDFFF)
+        {
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else
+        {
+            appendUtf8(code, str);
+            code = low;
+        }
+    }
+    appendUtf8(code, str);
+    return true;
+}
+
+int JsonReader::readHex4()
+{
+    int value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        int c = peekChar();
+        value <<= 4;
+        if (c >= '0' && c <= '9')
+            value |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            value |= c - 'A' + 10;
+        else
+            return -1;
+        ++_position;
+    }
+    return value;
+}
+
+bool JsonReader::readLiteral(const char* literal)
+{
+    for (; *literal; ++literal)
+    {
+        if (peekChar() != *literal)
+            return fail("expected a value");
+        ++_position;
+    }
+    return true;
+}
+
+bool JsonReader::readNumberText(char* text, size_t size)
+{
+    size_t length = 0;
+    while (_position < _size || fill())
+    {
+        char c = _buffer[_position];
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'))
+            break;
+        if (length + 1 == size)
+            return fail("number too long");
+        text[length++] = c;
+        ++_position;
+    }
+    text[length] = '\0';
+    return length > 0 || fail("expected a number");
+}
+
+bool JsonReader::nextArrayNumber(char* text, size_t size, bool first)
+{
+    if (_token == TOKEN_ERROR)
+        return false;
+
+    skipWhiteSpace();
+    int c = peekChar();
+    if (c == ']')
+    {
+        ++_position;
+        endContainer();
+        return false;
+    }
+    if (!first)
+    {
+        if (c != ',')
+            return fail("expected ',' or ']' in an array");
+        ++_position;
+        skipWhiteSpace();
+    }
+    return readNumberText(text, size);
+}
+
+void JsonReader::endContainer()
+{
+    _token = _containers.back() == '{' ? TOKEN_END_OBJECT : TOKEN_END_ARRAY;
+    _containers.pop_back();
+    _first = false;
+    _afterName = false;
+    _done = _containers.empty();
+}
+
+bool JsonReader::scan(unsigned int depth, std::string* text, unsigned int* count, std::vector<std::string>* names)
+{
+    // Whether a value, or member name, of the container scanned comes next; only tracked when peeking.
+    bool object = depth > 0 && _containers.back() == '{';
+    bool valueNext = depth > 0 && _first && !_afterName;
+    bool name = false;
+    bool started = false;
+    bool inString = false;
+    bool escaped = false;
+    if (count)
+        *count = 0;
+
+    size_t run = _position;
+    while (true)
+    {
+        if (_position == _size)
+        {
+            if (text)
+                text->append(_buffer + run, _size - run);
+            if (!fill())
+            {
+                // A number or literal may end the text.
+                if (depth == 0 && started && !inString)
+                    return true;
+                return fail("unexpected end of text");
+            }
+            run = _position;
+        }
+
+        char c = _buffer[_position];
+        if (inString)
+        {
+            ++_position;
+            if (escaped)
+            {
+                escaped = false;
+            }
+            else if (c == '\\')
+            {
+                escaped = true;
+            }
+            else if (c == '"')
+            {
+                inString = false;
+                if (depth == 0)
+                    break;
+                continue;
+            }
+            if (name)
+                names->back() += c;
+            continue;
+        }
+
+        // A number or literal ends at the first character that isn't part of it.
+        if (depth == 0 && started && (c == ',' || c == ']' || c == '}' || isspace((unsigned char)c)))
+            break;
+
+        ++_position;
+        if (c == '\n')
+            ++_line;
+        if (isspace((unsigned char)c))
+            continue;
+
+        if (depth == 1 && valueNext && c != ',' && c != ']' && c != '}')
+        {
+            valueNext = false;
+            if (count)
+                ++*count;
+            name = object && names && c == '"';
+            if (name)
+                names->push_back(std::string());
+        }
+        else if (c != '"')
+        {
+            name = false;
+        }
+
+        if (c == '"')
+        {
+            inString = true;
+            started = true;
+        }
+        else if (c == '{' || c == '[')
+        {
+            ++depth;
+        }
+        else if (c == '}' || c == ']')
+        {
+            if (depth == 0)
+                return fail("expected a value");
+            if (--depth == 0)
+                break;
+        }
+        else if (depth == 0)
+        {
+            if (c == ',' || c == ':')
+                return fail("expected a value");
+            started = true;
+        }
+        else if (c == ',' && depth == 1)
+        {
+            valueNext = true;
+        }
+    }
+
+    if (text)
+        text->append(_buffer + run, _position - run);
+    return true;
+}
+
+JsonWriter::JsonWriter(Stream* stream) : _stream(stream)
+{
+    GP_ASSERT(stream);
+    _buffer.reserve(JSON_WRITE_BLOCK_SIZE + 1024);
+}
+
+JsonWriter::~JsonWriter()
+{
+    flush();
+}
+
+void JsonWriter::beginObject(const char* name)
+{
+    writeName(name);
+    _buffer += '{';
+    _arrays.push_back(false);
+    _empty.push_back(true);
+}
+
+void JsonWriter::beginArray(const char* name)
+{
+    writeName(name);
+    _buffer += '[';
+    _arrays.push_back(true);
+    _empty.push_back(true);
+}
+
+void JsonWriter::end()
+{
+    GP_ASSERT(!_arrays.empty());
+
+    bool array = _arrays.back();
+    bool empty = _empty.back();
+    _arrays.pop_back();
+    _empty.pop_back();
+    if (!empty)
+    {
+        _buffer += '\n';
+        _buffer.append(_arrays.size(), '\t');
+    }
+    _buffer += array ? ']' : '}';
+
+    if (_buffer.size() >= JSON_WRITE_BLOCK_SIZE)
+        flush();
+}
+
+bool JsonWriter::isArray() const
+{
+    return !_arrays.empty() && _arrays.back();
+}
+
+void JsonWriter::writeBool(const char* name, bool value)
+{
+    writeName(name);
+    _buffer += value ? "true" : "false";
+}
+
+void JsonWriter::writeInt(const char* name, int value)
+{
+    writeName(name);
+    char str[16];
+    snprintf(str, sizeof(str), "%d", value);
+    _buffer += str;
+}
+
+void JsonWriter::writeFloat(const char* name, float value)
+{
+    writeName(name);
+    char str[32];
+    snprintf(str, sizeof(str), "%.9g", value);
+    _buffer += str;
+}
+
+void JsonWriter::writeString(const char* name, const char* value)
+{
+    writeName(name);
+    if (value)
+        appendString(value);
+    else
+        _buffer += "null";
+}
+
+void JsonWriter::writeNumbers(const char* name, const float* values, size_t count)
+{
+    GP_ASSERT(values || count == 0);
+
+    writeName(name);
+    _buffer += '[';
+    char str[32];
+    for (size_t i = 0; i < count; ++i)
+    {
+        snprintf(str, sizeof(str), i > 0 ? ", %.9g" : "%.9g", values[i]);
+        _buffer += str;
+        if (_buffer.size() >= JSON_WRITE_BLOCK_SIZE)
+            flush();
+    }
+    _buffer += ']';
+}
+
+void JsonWriter::writeNumbers(const char* name, const int* values, size_t count)
+{
+    GP_ASSERT(values || count == 0);
+
+    writeName(name);
+    _buffer += '[';
+    char str[16];
+    for (size_t i = 0; i < count; ++i)
+    {
+        snprintf(str, sizeof(str), i > 0 ? ", %d" : "%d", values[i]);
+        _buffer += str;
+        if (_buffer.size() >= JSON_WRITE_BLOCK_SIZE)
+            flush();
+    }
+    _buffer += ']';
+}
+
+void JsonWriter::flush()
+{
+    if (!_buffer.empty())
+    {
+        _stream->write(_buffer.data(), sizeof(char), _buffer.size());
+        _buffer.clear();
+    }
+}
+
+void JsonWriter::writeName(const char* name)
+{
+    if (_arrays.empty())
+        return;
+
+    // Every value of a container goes on its own line.
+    if (!_empty.back())
+        _buffer += ',';
+    _empty.back() = false;
+    _buffer += '\n';
+    _buffer.append(_arrays.size(), '\t');
+
+    if (!_arrays.back())
+    {
+        appendString(name ? name : "");
+        _buffer += ": ";
+    }
+}
+
+void JsonWriter::appendString(const char* str)
+{
+    _buffer += '"';
+    for (; *str; ++str)
+    {
+        unsigned char c = (unsigned char)*str;
+        switch (c)
+        {
+        case '"': _buffer += "\\\""; break;
+        case '\\': _buffer += "\\\\"; break;
+        case '\b': _buffer += "\\b"; break;
+        case '\f': _buffer += "\\f"; break;
+        case '\n': _buffer += "\\n"; break;
+        case '\r': _buffer += "\\r"; break;
+        case '\t': _buffer += "\\t"; break;
+        default:
+            if (c < 0x20)
+            {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                _buffer += escape;
+            }
+            else
+            {
+                _buffer += (char)c;
+            }
+            break;
+        }
+    }
+    _buffer += '"';
+}
+
+}
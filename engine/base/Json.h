@@ -0,0 +1,340 @@
+#pragma once
+
+#include "Base.h"
+
+namespace gameplay
+{
+
+class Stream;
+
+/**
+ * Defines a pull reader of json text.
+ *
+ * The text is read from a stream through a fixed-size buffer and split into tokens, one per
+ * call to next(), so no document is built in memory. Member names and strings are unescaped
+ * into the reader, and arrays of numbers are converted straight from the buffer by readNumbers().
+ *
+ * Values that are not needed are passed over with skipValue() and skip(), which only scan the
+ * text and may copy it, to be read later by a reader opened on the copy. peek() scans the rest
+ * of an array or object to count its values, then reads the text again: by seeking back in
+ * streams that can seek, or else from a copy of the text scanned.
+ */
+class JsonReader
+{
+public:
+
+    /**
+     * The tokens of json text.
+     */
+    enum Token
+    {
+        TOKEN_ERROR,
+        TOKEN_END,
+        TOKEN_NAME,
+        TOKEN_NULL,
+        TOKEN_BOOL,
+        TOKEN_NUMBER,
+        TOKEN_STRING,
+        TOKEN_BEGIN_ARRAY,
+        TOKEN_END_ARRAY,
+        TOKEN_BEGIN_OBJECT,
+        TOKEN_END_OBJECT
+    };
+
+    /**
+     * Constructor.
+     */
+    JsonReader();
+
+    /**
+     * Destructor.
+     */
+    ~JsonReader();
+
+    /**
+     * Starts reading the remainder of a stream.
+     *
+     * @param stream The stream to read, which the reader does not own and which must stay open while it is read.
+     */
+    void open(Stream* stream);
+
+    /**
+     * Starts reading text in memory.
+     *
+     * @param text The text, which is copied.
+     * @param length The length of the text.
+     */
+    void open(const char* text, size_t length);
+
+    /**
+     * Reads the next token.
+     *
+     * Members of objects are read as a TOKEN_NAME followed by the tokens of their value.
+     *
+     * @return The token read, TOKEN_END after the root value, or TOKEN_ERROR if the text is not valid json.
+     */
+    Token next();
+
+    /**
+     * Returns the last token read.
+     *
+     * @return The token.
+     */
+    Token getToken() const;
+
+    /**
+     * Returns the member name read by the last TOKEN_NAME.
+     *
+     * @return The member name.
+     */
+    const char* getName() const;
+
+    /**
+     * Returns the value of the last TOKEN_BOOL.
+     *
+     * @return The bool value.
+     */
+    bool getBool() const;
+
+    /**
+     * Returns the value of the last TOKEN_NUMBER.
+     *
+     * @return The number.
+     */
+    double getNumber() const;
+
+    /**
+     * Returns the value of the last TOKEN_STRING.
+     *
+     * @return The string.
+     */
+    const char* getString() const;
+
+    /**
+     * Reads the numbers of the array started by the last TOKEN_BEGIN_ARRAY, up to its end.
+     *
+     * @param out The vector to set to the numbers.
+     *
+     * @return True if the array was read, false if it holds other values than numbers.
+     */
+    bool readNumbers(std::vector<float>* out);
+
+    /**
+     * Reads the numbers of the array started by the last TOKEN_BEGIN_ARRAY, up to its end.
+     *
+     * @param out The vector to set to the numbers.
+     *
+     * @return True if the array was read, false if it holds other values than numbers.
+     */
+    bool readNumbers(std::vector<int>* out);
+
+    /**
+     * Passes over the value of the member whose name was just read.
+     *
+     * @param text Set to the text of the value, if not NULL.
+     *
+     * @return True if the value was passed over, false if the text is not valid json.
+     */
+    bool skipValue(std::string* text);
+
+    /**
+     * Passes over the rest of the innermost array or object being read, up to and including its end.
+     *
+     * @return True if the array or object was passed over, false if the text is not valid json.
+     */
+    bool skip();
+
+    /**
+     * Scans the rest of the innermost array or object being read, without reading it.
+     *
+     * The values of the array or object are left to read. As the text is scanned again when
+     * read, this costs another pass over the text of the array or object.
+     *
+     * @param count Set to the number of elements or members left, if not NULL.
+     * @param names Set to the names of the members left, if not NULL. When called after a
+     *        member name, this is the members following the member.
+     *
+     * @return True if the text was scanned, false if it is not valid json.
+     */
+    bool peek(unsigned int* count, std::vector<std::string>* names);
+
+private:
+
+    JsonReader(const JsonReader&);
+
+    JsonReader& operator=(const JsonReader&);
+
+    void reset();
+
+    bool fill();
+
+    int peekChar();
+
+    void skipWhiteSpace();
+
+    Token readValue();
+
+    bool readString(std::string* str);
+
+    bool readEscape(int c, std::string* str);
+
+    int readHex4();
+
+    bool readLiteral(const char* literal);
+
+    bool readNumberText(char* text, size_t size);
+
+    bool nextArrayNumber(char* text, size_t size, bool first);
+
+    void endContainer();
+
+    bool scan(unsigned int depth, std::string* text, unsigned int* count, std::vector<std::string>* names);
+
+    bool fail(const char* message);
+
+    Stream* _stream;
+    // The buffer the stream is read into, or the text in memory.
+    std::vector<char> _block;
+    // Text peek() scanned in a stream that can't seek, read again before the rest of the stream.
+    std::vector<char> _replay;
+    const char* _buffer;
+    size_t _position;
+    size_t _size;
+    // Position in the stream of the start of the buffer.
+    long int _offset;
+    unsigned int _line;
+    // '[' or '{' for each array and object being read.
+    std::vector<char> _containers;
+    // Whether no value of the innermost container was read yet, whether the value of a
+    // member is next, and whether the root value was read.
+    bool _first;
+    bool _afterName;
+    bool _done;
+    Token _token;
+    std::string _name;
+    std::string _string;
+    double _number;
+    bool _bool;
+};
+
+/**
+ * Defines a writer of json text to a stream.
+ *
+ * Values are formatted as they are written and the text is flushed to the stream in
+ * blocks, so no document is built in memory.
+ */
+class JsonWriter
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param stream The stream to write to, which the writer does not own.
+     */
+    JsonWriter(Stream* stream);
+
+    /**
+     * Destructor. Flushes the text written.
+     */
+    ~JsonWriter();
+
+    /**
+     * Starts an object.
+     *
+     * @param name The member name, ignored in arrays and at the root.
+     */
+    void beginObject(const char* name);
+
+    /**
+     * Starts an array.
+     *
+     * @param name The member name, ignored in arrays and at the root.
+     */
+    void beginArray(const char* name);
+
+    /**
+     * Ends the last object or array started.
+     */
+    void end();
+
+    /**
+     * Determines if the last container started is an array.
+     *
+     * @return True if values are written to an array, false if they are written to an object or at the root.
+     */
+    bool isArray() const;
+
+    /**
+     * Writes a bool.
+     *
+     * @param name The member name, ignored in arrays.
+     * @param value The value.
+     */
+    void writeBool(const char* name, bool value);
+
+    /**
+     * Writes an integer.
+     *
+     * @param name The member name, ignored in arrays.
+     * @param value The value.
+     */
+    void writeInt(const char* name, int value);
+
+    /**
+     * Writes a number with enough digits to read back the same float.
+     *
+     * @param name The member name, ignored in arrays.
+     * @param value The value.
+     */
+    void writeFloat(const char* name, float value);
+
+    /**
+     * Writes a string.
+     *
+     * @param name The member name, ignored in arrays.
+     * @param value The value, written as null when NULL.
+     */
+    void writeString(const char* name, const char* value);
+
+    /**
+     * Writes an array of numbers on a single line.
+     *
+     * @param name The member name, ignored in arrays.
+     * @param values The numbers.
+     * @param count The number of numbers.
+     */
+    void writeNumbers(const char* name, const float* values, size_t count);
+
+    /**
+     * Writes an array of numbers on a single line.
+     *
+     * @param name The member name, ignored in arrays.
+     * @param values The numbers.
+     * @param count The number of numbers.
+     */
+    void writeNumbers(const char* name, const int* values, size_t count);
+
+    /**
+     * Writes the text buffered so far to the stream.
+     */
+    void flush();
+
+private:
+
+    JsonWriter(const JsonWriter&);
+
+    JsonWriter& operator=(const JsonWriter&);
+
+    void writeName(const char* name);
+
+    void appendString(const char* str);
+
+    Stream* _stream;
+    std::string _buffer;
+    // For each open container, whether it is an array and whether it has values.
+    std::vector<bool> _arrays;
+    std::vector<bool> _empty;
+};
+
+}
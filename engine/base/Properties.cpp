@@ -3,8 +3,58 @@
 #include "FileSystem.h"
 #include "math/Quaternion.h"
 
+#include <mutex>
+
+// Binary properties file identifier and version
+#define PROPERTIES_BINARY_MAGIC 0x42505047 // 'GPPB'
+#define PROPERTIES_BINARY_VERSION 1
+
+// Namespaces with more properties than this look them up through a hash index
+#define PROPERTY_INDEX_THRESHOLD 8
+
 namespace gameplay
 {
+
+/**
+ * Hashes C strings without copying them into std::string keys.
+ */
+struct CStringHash
+{
+    size_t operator()(const char* str) const
+    {
+        // FNV-1a
+        size_t hash = 2166136261u;
+        for (; *str; ++str)
+            hash = (hash ^ (unsigned char)*str) * 16777619u;
+        return hash;
+    }
+};
+
+struct CStringEqual
+{
+    bool operator()(const char* a, const char* b) const
+    {
+        return strcmp(a, b) == 0;
+    }
+};
+
+struct Properties::Index
+{
+    Index() : propertiesIndexed(false), namespacesIndexed(false) { }
+
+    // Keys point to the names held by the properties and namespaces, which never move.
+    std::unordered_map<const char*, Property*, CStringHash, CStringEqual> properties;
+    std::unordered_map<const char*, Properties*, CStringHash, CStringEqual> namespaceIds;
+    std::unordered_map<const char*, Properties*, CStringHash, CStringEqual> namespaceNames;
+    bool propertiesIndexed;
+    bool namespacesIndexed;
+};
+
+// Parsed files, by path. Properties::create() hands out copies.
+static std::unordered_map<std::string, Properties*> __cache;
+static std::mutex __cacheMutex;
+static bool __cacheEnabled = true;
+
 void splitURL(const std::string& url, std::string* file, std::string* id)
 {
     if (url.empty())
@@ -62,12 +112,12 @@ void calculateNamespacePath(const std::string& urlString, std::string& fileStrin
 Properties* getPropertiesFromNamespacePath(Properties* properties, const std::vector<std::string>& namespacePath);
 
 Properties::Properties()
-    : _variables(NULL), _dirPath(NULL), _visited(false), _parent(NULL)
+    : _variables(NULL), _dirPath(NULL), _visited(false), _parent(NULL), _index(NULL)
 {
 }
 
 Properties::Properties(const Properties& copy)
-    : _namespace(copy._namespace), _id(copy._id), _parentID(copy._parentID), _properties(copy._properties), _variables(NULL), _dirPath(NULL), _visited(false), _parent(copy._parent)
+    : _namespace(copy._namespace), _id(copy._id), _parentID(copy._parentID), _properties(copy._properties), _variables(NULL), _dirPath(NULL), _visited(false), _parent(copy._parent), _index(NULL)
 {
     setDirectoryPath(copy._dirPath);
     _namespaces = std::vector<Properties*>();
@@ -81,14 +131,14 @@ Properties::Properties(const Properties& copy)
 }
 
 Properties::Properties(Stream* stream)
-    : _variables(NULL), _dirPath(NULL), _visited(false), _parent(NULL)
+    : _variables(NULL), _dirPath(NULL), _visited(false), _parent(NULL), _index(NULL)
 {
     readProperties(stream);
     rewind();
 }
 
 Properties::Properties(Stream* stream, const char* name, const char* id, const char* parentID, Properties* parent)
-    : _namespace(name), _variables(NULL), _dirPath(NULL), _visited(false), _parent(parent)
+    : _namespace(name), _variables(NULL), _dirPath(NULL), _visited(false), _parent(parent), _index(NULL)
 {
     if (id)
     {
@@ -115,16 +165,27 @@ Properties* Properties::create(const char* url)
     std::vector<std::string> namespacePath;
     calculateNamespacePath(urlString, fileString, namespacePath);
 
-    std::unique_ptr<Stream> stream(FileSystem::open(fileString.c_str()));
-    if (stream.get() == NULL)
+    // Copy the file from the cache, or parse it and keep a copy.
+    Properties* properties = NULL;
     {
-        GP_WARN("Failed to open file '%s'.", fileString.c_str());
-        return NULL;
+        std::lock_guard<std::mutex> lock(__cacheMutex);
+        if (__cacheEnabled)
+        {
+            std::unordered_map<std::string, Properties*>::const_iterator itr = __cache.find(fileString);
+            if (itr != __cache.end())
+                properties = itr->second->clone();
+        }
     }
+    if (!properties)
+    {
+        properties = load(fileString);
+        if (!properties)
+            return NULL;
 
-    Properties* properties = new Properties(stream.get());
-    properties->resolveInheritance();
-    stream->close();
+        std::lock_guard<std::mutex> lock(__cacheMutex);
+        if (__cacheEnabled && __cache.find(fileString) == __cache.end())
+            __cache[fileString] = properties->clone();
+    }
 
     // Get the specified properties object.
     Properties* p = getPropertiesFromNamespacePath(properties, namespacePath);
@@ -147,6 +208,186 @@ Properties* Properties::create(const char* url)
     return p;
 }
 
+Properties* Properties::load(const std::string& path)
+{
+    std::unique_ptr<Stream> stream(FileSystem::open(path.c_str()));
+    if (stream.get() == NULL)
+    {
+        GP_WARN("Failed to open file '%s'.", path.c_str());
+        return NULL;
+    }
+
+    // Binary files are read as is, their inheritance is already resolved.
+    unsigned int header[2];
+    if (stream->read(header, sizeof(unsigned int), 2) == 2 && header[0] == PROPERTIES_BINARY_MAGIC)
+    {
+        if (header[1] != PROPERTIES_BINARY_VERSION)
+        {
+            GP_WARN("Unsupported version %u of binary properties file '%s'.", header[1], path.c_str());
+            return NULL;
+        }
+
+        Properties* properties = new Properties();
+        if (!properties->readBinary(stream.get()))
+        {
+            GP_WARN("Failed to read binary properties file '%s'.", path.c_str());
+            SAFE_DELETE(properties);
+            return NULL;
+        }
+        return properties;
+    }
+
+    if (!stream->rewind())
+    {
+        GP_WARN("Failed to rewind file '%s'.", path.c_str());
+        return NULL;
+    }
+
+    Properties* properties = new Properties(stream.get());
+    properties->resolveInheritance();
+    stream->close();
+    return properties;
+}
+
+void Properties::setCacheEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(__cacheMutex);
+    __cacheEnabled = enabled;
+    if (!enabled)
+    {
+        for (std::unordered_map<std::string, Properties*>::iterator itr = __cache.begin(); itr != __cache.end(); ++itr)
+            SAFE_DELETE(itr->second);
+        __cache.clear();
+    }
+}
+
+void Properties::clearCache()
+{
+    std::lock_guard<std::mutex> lock(__cacheMutex);
+    for (std::unordered_map<std::string, Properties*>::iterator itr = __cache.begin(); itr != __cache.end(); ++itr)
+        SAFE_DELETE(itr->second);
+    __cache.clear();
+}
+
+static bool writeString(Stream* stream, const std::string& str)
+{
+    unsigned int length = (unsigned int)str.size();
+    return stream->write(&length, sizeof(length), 1) == 1 &&
+        (length == 0 || stream->write(str.data(), 1, length) == length);
+}
+
+static bool readString(Stream* stream, std::string* str)
+{
+    unsigned int length;
+    if (stream->read(&length, sizeof(length), 1) != 1)
+        return false;
+    str->resize(length);
+    return length == 0 || stream->read(&(*str)[0], 1, length) == length;
+}
+
+static bool readCount(Stream* stream, unsigned int* count)
+{
+    return stream->read(count, sizeof(unsigned int), 1) == 1;
+}
+
+bool Properties::saveBinary(const char* path) const
+{
+    GP_ASSERT(path);
+
+    std::unique_ptr<Stream> stream(FileSystem::open(path, FileSystem::WRITE));
+    if (stream.get() == NULL || !stream->canWrite())
+    {
+        GP_WARN("Failed to open file '%s' for writing.", path);
+        return false;
+    }
+
+    unsigned int header[2] = { PROPERTIES_BINARY_MAGIC, PROPERTIES_BINARY_VERSION };
+    if (stream->write(header, sizeof(unsigned int), 2) != 2 || !writeBinary(stream.get()))
+    {
+        GP_WARN("Failed to write binary properties file '%s'.", path);
+        return false;
+    }
+    stream->close();
+    return true;
+}
+
+bool Properties::writeBinary(Stream* stream) const
+{
+    if (!writeString(stream, _namespace) || !writeString(stream, _id) || !writeString(stream, _parentID))
+        return false;
+
+    unsigned int count = (unsigned int)_properties.size();
+    if (stream->write(&count, sizeof(count), 1) != 1)
+        return false;
+    for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+    {
+        if (!writeString(stream, itr->name) || !writeString(stream, itr->value))
+            return false;
+    }
+
+    count = _variables ? (unsigned int)_variables->size() : 0;
+    if (stream->write(&count, sizeof(count), 1) != 1)
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!writeString(stream, (*_variables)[i].name) || !writeString(stream, (*_variables)[i].value))
+            return false;
+    }
+
+    count = (unsigned int)_namespaces.size();
+    if (stream->write(&count, sizeof(count), 1) != 1)
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!_namespaces[i]->writeBinary(stream))
+            return false;
+    }
+    return true;
+}
+
+bool Properties::readBinary(Stream* stream)
+{
+    if (!readString(stream, &_namespace) || !readString(stream, &_id) || !readString(stream, &_parentID))
+        return false;
+
+    std::string name;
+    std::string value;
+    unsigned int count;
+    if (!readCount(stream, &count))
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!readString(stream, &name) || !readString(stream, &value))
+            return false;
+        _properties.push_back(Property(name.c_str(), value.c_str()));
+    }
+
+    if (!readCount(stream, &count))
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!readString(stream, &name) || !readString(stream, &value))
+            return false;
+        if (!_variables)
+            _variables = new std::vector<Property>();
+        _variables->push_back(Property(name.c_str(), value.c_str()));
+    }
+
+    if (!readCount(stream, &count))
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Properties* space = new Properties();
+        space->_parent = this;
+        _namespaces.push_back(space);
+        if (!space->readBinary(stream))
+            return false;
+    }
+
+    rewind();
+    return true;
+}
+
 static bool isVariable(const char* str, char* outName, size_t outSize)
 {
     size_t len = strlen(str);
@@ -422,6 +663,7 @@ Properties::~Properties()
     }
 
     SAFE_DELETE(_variables);
+    SAFE_DELETE(_index);
 }
 
 void Properties::skipWhiteSpace(Stream* stream)
@@ -483,7 +725,7 @@ void Properties::resolveInheritance(const char* id)
     Properties* derived;
     if (id)
     {
-        derived = getNamespace(id);
+        derived = findNamespace(id, false, true);
     }
     else
     {
@@ -495,7 +737,7 @@ void Properties::resolveInheritance(const char* id)
         if (!derived->_parentID.empty())
         {
             derived->_visited = true;
-            Properties* parent = getNamespace(derived->_parentID.c_str());
+            Properties* parent = findNamespace(derived->_parentID.c_str(), false, true);
             if (parent)
             {
                 GP_ASSERT(!parent->_visited);
@@ -520,6 +762,7 @@ void Properties::resolveInheritance(const char* id)
                     derived->_namespaces.push_back(new Properties(**itt));
                 }
                 derived->rewind();
+                derived->clearIndex();
 
                 // Take the original copy of the child and override the data copied from the parent.
                 derived->mergeWith(overrides);
@@ -586,6 +829,7 @@ void Properties::mergeWith(Properties* overrides)
 
             this->_namespaces.push_back(newNamespace);
             this->_namespacesItr = this->_namespaces.end();
+            clearIndex();
         }
 
         overridesNamespace = overrides->getNextNamespace();
@@ -639,6 +883,38 @@ Properties* Properties::getNamespace(const char* id, bool searchNames, bool recu
 {
     GP_ASSERT(id);
 
+    if (!recurse)
+        return findNamespace(id, searchNames, false);
+
+    if (!_index)
+        _index = new Index();
+    if (!_index->namespacesIndexed)
+    {
+        indexNamespaces(_index);
+        _index->namespacesIndexed = true;
+    }
+
+    const std::unordered_map<const char*, Properties*, CStringHash, CStringEqual>& map = searchNames ? _index->namespaceNames : _index->namespaceIds;
+    std::unordered_map<const char*, Properties*, CStringHash, CStringEqual>::const_iterator itr = map.find(id);
+    return itr != map.end() ? itr->second : NULL;
+}
+
+void Properties::indexNamespaces(Index* index) const
+{
+    // Depth-first, keeping the first namespace found for each ID and name as the linear search does.
+    for (size_t i = 0, count = _namespaces.size(); i < count; ++i)
+    {
+        Properties* p = _namespaces[i];
+        index->namespaceIds.insert(std::make_pair(p->_id.c_str(), p));
+        index->namespaceNames.insert(std::make_pair(p->_namespace.c_str(), p));
+        p->indexNamespaces(index);
+    }
+}
+
+Properties* Properties::findNamespace(const char* id, bool searchNames, bool recurse) const
+{
+    GP_ASSERT(id);
+
     for (std::vector<Properties*>::const_iterator it = _namespaces.begin(); it < _namespaces.end(); ++it)
     {
         Properties* p = *it;
@@ -648,7 +924,7 @@ Properties* Properties::getNamespace(const char* id, bool searchNames, bool recu
         if (recurse)
         {
             // Search recursively.
-            p = p->getNamespace(id, searchNames, true);
+            p = p->findNamespace(id, searchNames, true);
             if (p)
                 return p;
         }
@@ -672,13 +948,40 @@ bool Properties::exists(const char* name) const
     if (name == NULL)
         return false;
 
+    return findProperty(name) != NULL;
+}
+
+Properties::Property* Properties::findProperty(const char* name) const
+{
+    GP_ASSERT(name);
+
+    // Most namespaces hold a handful of properties, which are faster to compare than to hash.
+    if (_properties.size() > PROPERTY_INDEX_THRESHOLD)
+    {
+        if (!_index)
+            _index = new Index();
+        if (!_index->propertiesIndexed)
+        {
+            for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+                _index->properties.insert(std::make_pair(itr->name.c_str(), const_cast<Property*>(&*itr)));
+            _index->propertiesIndexed = true;
+        }
+
+        std::unordered_map<const char*, Property*, CStringHash, CStringEqual>::const_iterator itr = _index->properties.find(name);
+        return itr != _index->properties.end() ? itr->second : NULL;
+    }
+
     for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
     {
         if (itr->name == name)
-            return true;
+            return const_cast<Property*>(&*itr);
     }
+    return NULL;
+}
 
-    return false;
+void Properties::clearIndex()
+{
+    SAFE_DELETE(_index);
 }
 
 static const bool isStringNumeric(const char* str)
@@ -762,14 +1065,9 @@ const char* Properties::getString(const char* name, const char* defaultValue) co
             return getVariable(variable, defaultValue);
         }
 
-        for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
-        {
-            if (itr->name == name)
-            {
-                value = itr->value.c_str();
-                break;
-            }
-        }
+        const Property* property = findProperty(name);
+        if (property)
+            value = property->value.c_str();
     }
     else
     {
@@ -796,18 +1094,18 @@ bool Properties::setString(const char* name, const char* value)
 {
     if (name)
     {
-        for (std::list<Property>::iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+        // Update the first property that matches this name
+        Property* property = findProperty(name);
+        if (property)
         {
-            if (itr->name == name)
-            {
-                // Update the first property that matches this name
-                itr->value = value ? value : "";
-                return true;
-            }
+            property->value = value ? value : "";
+            return true;
         }
 
         // There is no property with this name, so add one
         _properties.push_back(Property(name, value ? value : ""));
+        if (_index && _index->propertiesIndexed)
+            _index->properties.insert(std::make_pair(_properties.back().name.c_str(), &_properties.back()));
     }
     else
     {
@@ -1051,6 +1349,8 @@ Properties* Properties::clone()
     p->_properties = _properties;
     p->_propertiesItr = p->_properties.end();
     p->setDirectoryPath(_dirPath);
+    if (_variables)
+        p->_variables = new std::vector<Property>(*_variables);
 
     for (size_t i = 0, count = _namespaces.size(); i < count; i++)
     {
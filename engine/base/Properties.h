@@ -155,6 +155,38 @@ public:
      */
     static Properties* create(const char* url);
 
+    /**
+     * Sets whether parsed files are cached.
+     *
+     * Files are parsed once and kept in memory, keyed by path: creating properties from
+     * the same file again copies the parsed namespaces instead of reading the file. This
+     * is enabled by default. Disabling it also clears the cache.
+     *
+     * @param enabled True to cache parsed files, false otherwise.
+     */
+    static void setCacheEnabled(bool enabled);
+
+    /**
+     * Removes all the parsed files from the cache, so that they are read again.
+     *
+     * Call this after changing files that may already have been loaded.
+     */
+    static void clearCache();
+
+    /**
+     * Writes this namespace and its nested namespaces to a file in a binary form.
+     *
+     * Properties::create() loads binary files without text parsing, so the files shipped with
+     * a game can be replaced by their binary form under the same name. Inheritance is already
+     * resolved in the binary form.
+     *
+     * @param path The path of the file to write.
+     *
+     * @return True if the file was written, false otherwise.
+     * @script{ignore}
+     */
+    bool saveBinary(const char* path) const;
+
     /**
      * Destructor.
      */
@@ -518,6 +550,11 @@ private:
         Property(const char* name, const char* value) : name(name), value(value) { }
     };
 
+    /**
+     * Hash indices of the properties and nested namespaces, built on first lookup.
+     */
+    struct Index;
+
     /**
      * Constructor.
      */
@@ -540,6 +577,21 @@ private:
 
     void readProperties(Stream* stream);
 
+    static Properties* load(const std::string& path);
+
+    bool readBinary(Stream* stream);
+
+    bool writeBinary(Stream* stream) const;
+
+    Property* findProperty(const char* name) const;
+
+    // Linear search used while namespaces are still being built.
+    Properties* findNamespace(const char* id, bool searchNames, bool recurse) const;
+
+    void indexNamespaces(Index* index) const;
+
+    void clearIndex();
+
     void setDirectoryPath(const std::string* path);
 
     void setDirectoryPath(const std::string& path);
@@ -566,6 +618,7 @@ private:
     std::string* _dirPath;
     bool _visited;
     Properties* _parent;
+    mutable Index* _index;
 };
 
 }
@@ -18,8 +18,11 @@ Serializer::Serializer(Type type, const std::string& path, Stream* stream, uint3
 
 Serializer::~Serializer()
 {
-    _stream->close();
-    SAFE_DELETE(_stream);
+    if (_stream)
+    {
+        _stream->close();
+        SAFE_DELETE(_stream);
+    }
 }
 
 Serializer* Serializer::createReader(const std::string& path)
@@ -8,61 +8,141 @@
 #include "math/Vector4.h"
 #include "math/Matrix.h"
 
-#include <iostream>
 #include <sstream>
 
 namespace gameplay
 {
 
+static const char* __base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void encodeBase64(const unsigned char* data, size_t count, std::string& out)
+{
+    out.clear();
+    out.reserve((count + 2) / 3 * 4);
+    for (size_t i = 0; i < count; i += 3)
+    {
+        unsigned int bits = data[i] << 16;
+        if (i + 1 < count)
+            bits |= data[i + 1] << 8;
+        if (i + 2 < count)
+            bits |= data[i + 2];
+        out += __base64Chars[(bits >> 18) & 0x3F];
+        out += __base64Chars[(bits >> 12) & 0x3F];
+        out += i + 1 < count ? __base64Chars[(bits >> 6) & 0x3F] : '=';
+        out += i + 2 < count ? __base64Chars[bits & 0x3F] : '=';
+    }
+}
+
+static int decodeBase64Char(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+')
+        return 62;
+    if (c == '/')
+        return 63;
+    return -1;
+}
+
+static size_t decodeBase64Length(const char* str)
+{
+    size_t digits = 0;
+    for (; *str; ++str)
+    {
+        if (decodeBase64Char(*str) >= 0)
+            ++digits;
+    }
+    return digits * 3 / 4;
+}
+
+static size_t decodeBase64(const char* str, unsigned char* out)
+{
+    // Characters other than base64 digits, such as padding and line breaks, are skipped.
+    size_t size = 0;
+    unsigned int bits = 0;
+    int bitCount = 0;
+    for (; *str; ++str)
+    {
+        int digit = decodeBase64Char(*str);
+        if (digit < 0)
+            continue;
+        bits = (bits << 6) | digit;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            out[size++] = (unsigned char)((bits >> bitCount) & 0xFF);
+        }
+    }
+    return size;
+}
+
 SerializerJson::SerializerJson(Type type,
                                const std::string& path,
                                Stream* stream,
                                uint32_t versionMajor,
                                uint32_t versionMinor,
-                               JSONNODE* root) : 
-    Serializer(type, path, stream, versionMajor, versionMinor), 
-    _root(root)
+                               JsonReader* reader) :
+    Serializer(type, path, stream, versionMajor, versionMinor),
+    _reader(reader), _writer(nullptr)
 {
-    _nodes.push(root);
+    if (_reader)
+        pushFrame(_reader, false, false);
+    else
+        _writer = new JsonWriter(stream);
 }
 
 SerializerJson::~SerializerJson()
 {
+    SAFE_DELETE(_writer);
+    clearFrames();
+    SAFE_DELETE(_reader);
 }
-        
+
 Serializer* SerializerJson::create(const std::string& path, Stream* stream)
 {
-    size_t length = stream->length();
-    char* buffer = new char[length + 1];
-    stream->read(buffer, sizeof(char), length);
-    buffer[length] = '\0';
-    JSONNODE* root = json_parse(buffer);
-    if (root == nullptr)
+    JsonReader* reader = new JsonReader();
+    reader->open(stream);
+    if (reader->next() != JsonReader::TOKEN_BEGIN_OBJECT)
+    {
+        SAFE_DELETE(reader);
         return nullptr;
+    }
 
-    Serializer* serializer = nullptr;
+    // The version is written first, the rest of the file is read as it is deserialized.
+    SerializerJson* serializer = new SerializerJson(Type::eReader, path, stream, GP_ENGINE_VERSION_MAJOR, GP_ENGINE_VERSION_MINOR, reader);
+    bool valid = false;
+    std::string version;
+    JsonReader* property = serializer->beginProperty("version");
+    if (property)
+    {
+        valid = property->getToken() == JsonReader::TOKEN_STRING;
+        if (valid)
+            version = property->getString();
+        serializer->endProperty(property);
+    }
+    if (!valid)
+    {
+        // The serializer doesn't own the stream yet.
+        serializer->_stream = nullptr;
+        SAFE_DELETE(serializer);
+        return nullptr;
+    }
 
-    JSONNODE* versionNode = json_get(root, "version");
-    int versionMajor = GP_ENGINE_VERSION_MAJOR;
-    int versionMinor = GP_ENGINE_VERSION_MINOR;
-    if (versionNode)
+    if (version.length() > 0)
     {
-        json_char* str = json_as_string(versionNode);
-        std::string version = std::string(str);
-        json_free(str);
-        if (version.length() > 0)
-        {
-            std::string major = version.substr(0, 1);
-            versionMajor = std::stoi(major);
-        }
-        if (version.length() > 2)
-        {
-            std::string minor = version.substr(2, 1);
-            versionMinor = std::stoi(minor);
-        }
-        serializer = new SerializerJson(Type::eReader, path, stream, versionMajor, versionMinor, root);
+        std::string major = version.substr(0, 1);
+        serializer->_version[0] = std::stoi(major);
+    }
+    if (version.length() > 2)
+    {
+        std::string minor = version.substr(2, 1);
+        serializer->_version[1] = std::stoi(minor);
     }
-    SAFE_DELETE_ARRAY(buffer);
     return serializer;
 }
 
@@ -72,15 +152,15 @@ Serializer* SerializerJson::createWriter(const std::string& path)
     if (stream == nullptr)
         return nullptr;
 
-    JSONNODE* root = json_new(JSON_NODE);
+    SerializerJson* serializer = new SerializerJson(Type::eWriter, path, stream, GP_ENGINE_VERSION_MAJOR, GP_ENGINE_VERSION_MINOR, nullptr);
+
     std::string version;
     version.append(std::to_string(GP_ENGINE_VERSION_MAJOR));
     version.append(".");
     version.append(std::to_string(GP_ENGINE_VERSION_MINOR));
-    json_push_back(root, json_new_a("version", version.c_str()));
+    serializer->_writer->beginObject(nullptr);
+    serializer->_writer->writeString("version", version.c_str());
 
-    Serializer* serializer = new SerializerJson(Type::eWriter, path, stream, GP_ENGINE_VERSION_MAJOR, GP_ENGINE_VERSION_MINOR, root);
-  
     return serializer;
 }
 
@@ -88,15 +168,15 @@ void SerializerJson::close()
 {
     if (_stream)
     {
-        if (_type == Type::eWriter)
+        if (_writer)
         {
-            json_char* buffer = json_write_formatted(_root);
-            std::string str = buffer;
-            _stream->write(str.c_str(), sizeof(char), str.length());
-            json_free(buffer);
+            // End the root object.
+            _writer->end();
+            _writer->flush();
+            SAFE_DELETE(_writer);
         }
-        if (_root)
-            json_delete(_root);
+        clearFrames();
+        SAFE_DELETE(_reader);
         _stream->close();
     }
 }
@@ -110,65 +190,57 @@ void SerializerJson::writeEnum(const char* propertyName, const char* enumName, i
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(enumName);
-    
+
     if (value == defaultValue)
         return;
-    
+
     std::string str = SerializerManager::getActivator()->enumToString(enumName, value);
     writeString(propertyName, str.c_str(), "");
 }
-    
+
 void SerializerJson::writeBool(const char* propertyName, bool value, bool defaultValue)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    
+
     if (value == defaultValue)
         return;
-    
-    JSONNODE* node = _nodes.top();
-    json_push_back(node, json_new_b(propertyName, value));
+
+    _writer->writeBool(propertyName, value);
 }
 
 void SerializerJson::writeInt(const char* propertyName, int value, int defaultValue)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    
+
     if (value == defaultValue)
         return;
-    
-    JSONNODE* node = _nodes.top();
-    json_push_back(node, json_new_i(propertyName, value));
+
+    _writer->writeInt(propertyName, value);
 }
 
 void SerializerJson::writeFloat(const char* propertyName, float value, float defaultValue)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    
+
     if (value == defaultValue)
         return;
 
-    JSONNODE* node = _nodes.top();
-    json_push_back(node, json_new_f(propertyName, value));
+    _writer->writeFloat(propertyName, value);
 }
 
 void SerializerJson::writeVector(const char* propertyName, const Vector2& value, const Vector2& defaultValue)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    
+
     if (value == defaultValue)
         return;
-    
+
     // "properyName" : [ x, y ]
-    JSONNODE* node = _nodes.top();
-    JSONNODE* array = json_new(JSON_ARRAY);
-    json_set_name(array, propertyName);
-    json_push_back(array, json_new_f(nullptr, value.x));
-    json_push_back(array, json_new_f(nullptr, value.y));
-    json_push_back(node, array);
+    _writer->writeNumbers(propertyName, &value.x, 2);
 }
 
 void SerializerJson::writeVector(const char* propertyName, const Vector3& value, const Vector3& defaultValue)
@@ -180,51 +252,37 @@ void SerializerJson::writeVector(const char* propertyName, const Vector3& value,
         return;
 
     // "properyName" : [ x, y, z ]
-    JSONNODE* node = _nodes.top();
-    JSONNODE* array = json_new(JSON_ARRAY);
-    json_set_name(array, propertyName);
-    json_push_back(array, json_new_f(nullptr, value.x));
-    json_push_back(array, json_new_f(nullptr, value.y));
-    json_push_back(array, json_new_f(nullptr, value.z));
-    json_push_back(node, array);
+    _writer->writeNumbers(propertyName, &value.x, 3);
 }
 
 void SerializerJson::writeVector(const char* propertyName, const Vector4& value, const Vector4& defaultValue)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    
+
     if (value == defaultValue)
         return;
-    
+
     // "properyName" : [ x, y, z, w ]
-    JSONNODE* node = _nodes.top();
-    JSONNODE* array = json_new(JSON_ARRAY);
-    json_set_name(array, propertyName);
-    json_push_back(array, json_new_f(nullptr, value.x));
-    json_push_back(array, json_new_f(nullptr, value.y));
-    json_push_back(array, json_new_f(nullptr, value.z));
-    json_push_back(array, json_new_f(nullptr, value.w));
-    json_push_back(node, array);
+    _writer->writeNumbers(propertyName, &value.x, 4);
 }
 
 void SerializerJson::writeColor(const char* propertyName, const Vector3& value, const Vector3& defaultValue)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    
+
     if (value == defaultValue)
         return;
-    
+
     // "property" : "#rrggbb"
-   JSONNODE* node = _nodes.top();
-   char buffer[9];
-   sprintf(buffer, "%02x%02x%02x", (int)(value.x * 255.0f), (int)(value.y * 255.0f), (int)(value.z * 255.0f));
-   std::ostringstream s;
-   s << "#" << buffer;
-    json_push_back(node, json_new_a(propertyName, s.str().c_str()));
-}
-    
+    char buffer[9];
+    sprintf(buffer, "%02x%02x%02x", (int)(value.x * 255.0f), (int)(value.y * 255.0f), (int)(value.z * 255.0f));
+    std::ostringstream s;
+    s << "#" << buffer;
+    _writer->writeString(propertyName, s.str().c_str());
+}
+
 void SerializerJson::writeColor(const char* propertyName, const Vector4& value, const Vector4& defaultValue)
 {
     GP_ASSERT(propertyName);
@@ -232,14 +290,13 @@ void SerializerJson::writeColor(const char* propertyName, const Vector4& value,
 
     if (value == defaultValue)
         return;
-    
+
     // "property" : "#rrggbbaa"
-    JSONNODE* node = _nodes.top();
     std::ostringstream s;
-    s << "#" << std::hex << value.toColor();    
-    json_push_back(node, json_new_a(propertyName, s.str().c_str()));
+    s << "#" << std::hex << value.toColor();
+    _writer->writeString(propertyName, s.str().c_str());
 }
-    
+
 void SerializerJson::writeMatrix(const char* propertyName, const Matrix& value, const Matrix& defaultValue)
 {
     GP_ASSERT(propertyName);
@@ -249,71 +306,25 @@ void SerializerJson::writeMatrix(const char* propertyName, const Matrix& value,
         return;
 
     // "properyName" : [ m0, ... , m15 ]
-    JSONNODE* node = _nodes.top();
-    JSONNODE* array = json_new(JSON_ARRAY);
-    json_set_name(array, propertyName);
-    json_push_back(array, json_new_f(nullptr, value.m[0]));
-    json_push_back(array, json_new_f(nullptr, value.m[1]));
-    json_push_back(array, json_new_f(nullptr, value.m[2]));
-    json_push_back(array, json_new_f(nullptr, value.m[3]));
-    json_push_back(array, json_new_f(nullptr, value.m[4]));
-    json_push_back(array, json_new_f(nullptr, value.m[5]));
-    json_push_back(array, json_new_f(nullptr, value.m[6]));
-    json_push_back(array, json_new_f(nullptr, value.m[7]));
-    json_push_back(array, json_new_f(nullptr, value.m[8]));
-    json_push_back(array, json_new_f(nullptr, value.m[9]));
-    json_push_back(array, json_new_f(nullptr, value.m[10]));
-    json_push_back(array, json_new_f(nullptr, value.m[11]));
-    json_push_back(array, json_new_f(nullptr, value.m[12]));
-    json_push_back(array, json_new_f(nullptr, value.m[13]));
-    json_push_back(array, json_new_f(nullptr, value.m[14]));
-    json_push_back(array, json_new_f(nullptr, value.m[15]));
-    json_push_back(node, array);
-}
-
-JSONNODE* SerializerJson::createNode(JSONNODE* parent, const char* propertyName)
-{
-    if (((json_type(parent) == JSON_NODE) && propertyName) || json_type(parent) == JSON_ARRAY)
-    {
-        JSONNODE* node = json_new(JSON_NODE);
-        json_push_back(parent, node);
-        
-        if (json_type(parent) == JSON_NODE && propertyName)
-            json_set_name(node, propertyName);
-        
-        return node;
-    }
-    else
-    {
-        return parent;
-    }
+    _writer->writeNumbers(propertyName, value.m, 16);
 }
 
 void SerializerJson::writeString(const char* propertyName, const char* value, const char* defaultValue)
 {
-    //GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
 
     if ((value == defaultValue) || (value && defaultValue && strcmp (value, defaultValue) == 0))
         return;
 
-    JSONNODE* node = _nodes.top();
-    json_push_back(node, json_new_a(propertyName, value));
+    _writer->writeString(propertyName, value ? value : "");
 }
 
 void SerializerJson::writeMap(const char* propertyName, std::vector<std::string> &keys)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    //if (keys.size() == 0)
-    //    return;
-
-    JSONNODE* parentNode = _nodes.top();
-    JSONNODE* writeNode = nullptr;
-    writeNode = createNode(parentNode, propertyName);
 
-    _nodes.push(writeNode);
-    _nodesListCounts.push(keys.size());
+    _writer->beginObject(propertyName);
 }
 
 void SerializerJson::writeObject(const char* propertyName, Serializable *value)
@@ -322,68 +333,53 @@ void SerializerJson::writeObject(const char* propertyName, Serializable *value)
     if (value == nullptr)
         return;
 
-    JSONNODE* parentNode = _nodes.top();
-    JSONNODE* writeNode = nullptr;
-    JSONNODE* xrefNode = nullptr;
-    if (value && dynamic_cast<Ref*>(value)->getRefCount() > 1)
+    // Objects without a name are written in place of their parent object, except in lists.
+    bool open = propertyName || _writer->isArray();
+    if (open)
+        _writer->beginObject(propertyName);
+    _writer->writeString("class", value->getClassName().c_str());
+
+    // The first occurrence of an object referenced more than once is written in full
+    // with its address, the others refer to it with "@" and the address.
+    bool reference = false;
+    Ref* ref = dynamic_cast<Ref*>(value);
+    if (ref && ref->getRefCount() > 1)
     {
         unsigned long xrefAddress = (unsigned long)value;
-        std::map<unsigned long, JSONNODE*>::const_iterator itr = _xrefsWrite.find(xrefAddress);
-        std::string url;
-        if (itr == _xrefsWrite.end())
-        {
-            writeNode = createNode(parentNode, propertyName);
-            json_push_back(writeNode, json_new_a("class", value->getClassName().c_str()));
-            url = std::to_string(xrefAddress);
-            _xrefsWrite[xrefAddress] = writeNode;
-        }
-        else
+        std::string url = std::to_string(xrefAddress);
+        if (!_xrefsWrite.insert(xrefAddress).second)
         {
-            writeNode = createNode(parentNode, propertyName);
-            json_push_back(writeNode, json_new_a("class", value->getClassName().c_str()));
-            std::ostringstream o;
-            o << "@" << std::to_string(xrefAddress);
-            url = o.str();
-            xrefNode = itr->second;
-            json_push_back(writeNode, json_new_a("xref", url.c_str()));
+            url.insert(0, "@");
+            reference = true;
         }
+        _writer->writeString("xref", url.c_str());
     }
-    else
-    {
-        writeNode = createNode(parentNode, propertyName);
-        json_push_back(writeNode, json_new_a("class", value->getClassName().c_str()));
-    }
-    
-    if (xrefNode == nullptr) {
-        _nodes.push(writeNode);
+
+    if (!reference)
         value->onSerialize(this);
-        _nodes.pop();
-    }
+    if (open)
+        _writer->end();
 }
 
 void SerializerJson::writeList(const char* propertyName, size_t count)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eWriter);
-    //if (count == 0)
-    //    return;
-    
-    JSONNODE* node = _nodes.top();
-    JSONNODE* list = json_new(JSON_ARRAY);
-    json_push_back(node, list);
-    json_set_name(list, propertyName);
-    
-    _nodes.push(list);
-    _nodesListCounts.push(count);
-}
-
-void SerializerJson::finishColloction() {
-    //JSONNODE* parentNode = _nodes.top();
-    //if (json_type(parentNode) == JSON_ARRAY || json_type(parentNode) == JSON_NODE)
-    //{
-    _nodes.pop();
-    _nodesListCounts.pop();
-    //}
+
+    _writer->beginArray(propertyName);
+}
+
+void SerializerJson::finishColloction()
+{
+    if (_type == Type::eWriter)
+    {
+        _writer->end();
+    }
+    else
+    {
+        GP_ASSERT(_frames.size() > 1);
+        popFrame();
+    }
 }
 
 void SerializerJson::writeIntArray(const char* propertyName, const int* data, size_t count)
@@ -394,14 +390,7 @@ void SerializerJson::writeIntArray(const char* propertyName, const int* data, si
         return;
 
     // "properyName" : [ 0, ... , count - 1 ]
-    JSONNODE* node = _nodes.top();
-    JSONNODE* array = json_new(JSON_ARRAY);
-    json_set_name(array, propertyName);
-    for (size_t i = 0; i < count; i++)
-    {
-        json_push_back(array, json_new_f(nullptr, data[i]));
-    }
-    json_push_back(node, array);
+    _writer->writeNumbers(propertyName, data, count);
 }
 
 void SerializerJson::writeFloatArray(const char* propertyName, const float* data, size_t count)
@@ -410,16 +399,9 @@ void SerializerJson::writeFloatArray(const char* propertyName, const float* data
     GP_ASSERT(_type == Type::eWriter);
     if (!data || count == 0)
         return;
-    
+
     // "properyName" : [ 0.0, ... , count - 1 ]
-    JSONNODE* node = _nodes.top();
-    JSONNODE* array = json_new(JSON_ARRAY);
-    json_set_name(array, propertyName);
-    for (size_t i = 0; i < count; i++)
-    {
-        json_push_back(array, json_new_f(nullptr, data[i]));
-    }
-    json_push_back(node, array);
+    _writer->writeNumbers(propertyName, data, count);
 }
 
 void SerializerJson::writeByteArray(const char* propertyName, const unsigned char* data, size_t count)
@@ -428,19 +410,175 @@ void SerializerJson::writeByteArray(const char* propertyName, const unsigned cha
     GP_ASSERT(_type == Type::eWriter);
     if (!data || count == 0)
         return;
-    
+
     // "properyName" : "base64_encode(data)"
-    JSONNODE* node = _nodes.top();
-    json_push_back(node, json_new_a(propertyName, json_encode64((const void*)data, sizeof(unsigned char) * (uint32_t)count)));
+    std::string str;
+    encodeBase64(data, count, str);
+    _writer->writeString(propertyName, str.c_str());
+}
+
+void SerializerJson::pushFrame(JsonReader* reader, bool list, bool ownsReader)
+{
+    Frame frame;
+    frame.reader = reader;
+    frame.ownsReader = ownsReader;
+    frame.list = list;
+    frame.open = reader != nullptr;
+    frame.pending = false;
+    frame.remaining = 0;
+    frame.scanned = false;
+    frame.nextName = 0;
+    _frames.push_back(frame);
+}
+
+void SerializerJson::popFrame()
+{
+    GP_ASSERT(!_frames.empty());
+
+    Frame& frame = _frames.back();
+    if (frame.ownsReader)
+        delete frame.reader;
+    else if (frame.open)
+        frame.reader->skip();
+    _frames.pop_back();
+}
+
+void SerializerJson::clearFrames()
+{
+    for (size_t i = 0; i < _frames.size(); ++i)
+    {
+        if (_frames[i].ownsReader)
+            delete _frames[i].reader;
+    }
+    _frames.clear();
+}
+
+JsonReader* SerializerJson::findProperty(const char* propertyName)
+{
+    GP_ASSERT(!_frames.empty());
+
+    Frame& frame = _frames.back();
+    if (frame.reader == nullptr)
+        return nullptr;
+
+    if (frame.list)
+    {
+        // Lists are read in order: take the next element.
+        if (frame.remaining == 0)
+            return nullptr;
+        --frame.remaining;
+        return frame.reader;
+    }
+
+    if (propertyName == nullptr)
+        return nullptr;
+
+    for (size_t i = 0; i < frame.skipped.size(); ++i)
+    {
+        if (frame.skipped[i].first == propertyName)
+        {
+            const std::string& text = frame.skipped[i].second;
+            JsonReader* reader = new JsonReader();
+            reader->open(text.c_str(), text.size());
+            return reader;
+        }
+    }
+
+    while (frame.open)
+    {
+        if (!frame.pending)
+        {
+            if (frame.reader->next() != JsonReader::TOKEN_NAME)
+            {
+                frame.open = false;
+                break;
+            }
+            frame.pending = true;
+            if (frame.scanned)
+                ++frame.nextName;
+        }
+        if (strcmp(frame.reader->getName(), propertyName) == 0)
+        {
+            frame.pending = false;
+            return frame.reader;
+        }
+
+        // The writer leaves out properties with default values: scan the names of the members
+        // left once, to know the property is missing without reading on.
+        if (!frame.scanned)
+        {
+            frame.scanned = true;
+            frame.nextName = 0;
+            if (!frame.reader->peek(nullptr, &frame.names))
+            {
+                frame.open = false;
+                break;
+            }
+        }
+        if (std::find(frame.names.begin() + frame.nextName, frame.names.end(), propertyName) == frame.names.end())
+            return nullptr;
+
+        // The property was written after the next member: keep the member to read it later.
+        frame.skipped.push_back(std::make_pair(std::string(frame.reader->getName()), std::string()));
+        frame.pending = false;
+        if (!frame.reader->skipValue(&frame.skipped.back().second))
+            frame.open = false;
+    }
+    return nullptr;
+}
+
+JsonReader* SerializerJson::beginProperty(const char* propertyName)
+{
+    JsonReader* reader = findProperty(propertyName);
+    if (reader == nullptr)
+        return nullptr;
+
+    JsonReader::Token token = reader->next();
+    if (token == JsonReader::TOKEN_ERROR || token == JsonReader::TOKEN_END_ARRAY)
+    {
+        Frame& frame = _frames.back();
+        if (reader == frame.reader)
+        {
+            frame.open = false;
+            frame.remaining = 0;
+        }
+        else
+        {
+            delete reader;
+        }
+        return nullptr;
+    }
+    return reader;
+}
+
+void SerializerJson::endProperty(JsonReader* reader)
+{
+    GP_ASSERT(reader);
+
+    // Pass over an array or object that wasn't read.
+    JsonReader::Token token = reader->getToken();
+    if (token == JsonReader::TOKEN_BEGIN_ARRAY || token == JsonReader::TOKEN_BEGIN_OBJECT)
+        reader->skip();
+    if (reader != _frames.back().reader)
+        delete reader;
+}
+
+unsigned int SerializerJson::readNumbers(JsonReader* reader, float* out, unsigned int count)
+{
+    if (reader->getToken() != JsonReader::TOKEN_BEGIN_ARRAY || !reader->readNumbers(&_floats))
+        return 0;
+    count = std::min(count, (unsigned int)_floats.size());
+    std::copy(_floats.begin(), _floats.begin() + count, out);
+    return count;
 }
 
 int SerializerJson::readEnum(const char* propertyName, const char* enumName, int defaultValue)
 {
     GP_ASSERT(enumName);
-    
+
     std::string str;
     readString(propertyName, str, "");
-    
+
     return SerializerManager::getActivator()->enumParse(enumName, str.c_str());
 }
 
@@ -448,14 +586,17 @@ bool SerializerJson::readBool(const char* propertyName, bool defaultValue)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_BOOL)
+        bool value = false;
+        if (property->getToken() != JsonReader::TOKEN_BOOL)
             GP_ERROR("Invalid json bool for propertyName:%s", propertyName);
-        return json_as_bool(property);
+        else
+            value = property->getBool();
+        endProperty(property);
+        return value;
     }
     return defaultValue;
 }
@@ -465,14 +606,16 @@ int SerializerJson::readInt(const char* propertyName, int defaultValue)
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
 
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_NUMBER)
+        int value = 0;
+        if (property->getToken() != JsonReader::TOKEN_NUMBER)
             GP_ERROR("Invalid json number for propertyName:%s", propertyName);
-        
-        return json_as_int(property);
+        else
+            value = (int)property->getNumber();
+        endProperty(property);
+        return value;
     }
     return defaultValue;
 }
@@ -482,14 +625,16 @@ float SerializerJson::readFloat(const char* propertyName, float defaultValue)
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
 
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_NUMBER)
+        float value = 0.0f;
+        if (property->getToken() != JsonReader::TOKEN_NUMBER)
             GP_ERROR("Invalid json number for propertyName:%s", propertyName);
-        
-        return (float)json_as_float(property);
+        else
+            value = (float)property->getNumber();
+        endProperty(property);
+        return value;
     }
     return defaultValue;
 }
@@ -498,19 +643,14 @@ Vector2 SerializerJson::readVector(const char* propertyName, const Vector2& defa
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_ARRAY || json_size(property) < 2)
-            GP_ERROR("Invalid json array from Vector2 for propertyName:%s", propertyName);
-        
         Vector2 value;
-        JSONNODE* x = json_at(property, 0);
-        value.x  = json_as_float(x);
-        JSONNODE* y = json_at(property, 1);
-        value.y  = json_as_float(y);
+        if (readNumbers(property, &value.x, 2) < 2)
+            GP_ERROR("Invalid json array from Vector2 for propertyName:%s", propertyName);
+        endProperty(property);
         return value;
     }
     return defaultValue;
@@ -521,20 +661,13 @@ Vector3 SerializerJson::readVector(const char* propertyName, const Vector3& defa
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
 
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_ARRAY || json_size(property) < 3)
-            GP_ERROR("Invalid json array from Vector3 for propertyName:%s", propertyName);
-        
         Vector3 value;
-        JSONNODE* x = json_at(property, 0);
-        value.x  = json_as_float(x);
-        JSONNODE* y = json_at(property, 1);
-        value.y  = json_as_float(y);
-        JSONNODE* z = json_at(property, 2);
-        value.z  = json_as_float(z);
+        if (readNumbers(property, &value.x, 3) < 3)
+            GP_ERROR("Invalid json array from Vector3 for propertyName:%s", propertyName);
+        endProperty(property);
         return value;
     }
     return defaultValue;
@@ -545,22 +678,13 @@ Vector4 SerializerJson::readVector(const char* propertyName, const Vector4& defa
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
 
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_ARRAY || json_size(property) < 4)
-            GP_ERROR("Invalid json array from Vector4 for propertyName:%s", propertyName);
-        
         Vector4 value;
-        JSONNODE* x = json_at(property, 0);
-        value.x  = json_as_float(x);
-        JSONNODE* y = json_at(property, 1);
-        value.y  = json_as_float(y);
-        JSONNODE* z = json_at(property, 2);
-        value.z  = json_as_float(z);
-        JSONNODE* w = json_at(property, 3);
-        value.w  = json_as_float(w);
+        if (readNumbers(property, &value.x, 4) < 4)
+            GP_ERROR("Invalid json array from Vector4 for propertyName:%s", propertyName);
+        endProperty(property);
         return value;
     }
     return defaultValue;
@@ -570,16 +694,16 @@ Vector3 SerializerJson::readColor(const char* propertyName, const Vector3& defau
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_STRING)
+        Vector3 value = defaultValue;
+        if (property->getToken() != JsonReader::TOKEN_STRING)
             GP_ERROR("Invalid json string from color for propertyName:%s", propertyName);
-        json_char* str = json_as_string(property);
-        Vector3 value = Vector3::fromColorString(str);
-        json_free(str);
+        else
+            value = Vector3::fromColorString(property->getString());
+        endProperty(property);
         return value;
     }
     return defaultValue;
@@ -589,16 +713,16 @@ Vector4 SerializerJson::readColor(const char* propertyName, const Vector4& defau
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_STRING)
+        Vector4 value = defaultValue;
+        if (property->getToken() != JsonReader::TOKEN_STRING)
             GP_ERROR("Invalid json string from color for propertyName:%s", propertyName);
-        json_char* str = json_as_string(property);
-        Vector4 value = Vector4::fromColorString(str);
-        json_free(str);
+        else
+            value = Vector4::fromColorString(property->getString());
+        endProperty(property);
         return value;
     }
     return defaultValue;
@@ -609,47 +733,13 @@ Matrix SerializerJson::readMatrix(const char* propertyName, const Matrix& defaul
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
 
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_ARRAY || json_size(property) < 16)
-            GP_ERROR("Invalid json array from Matrix for propertyName:%s", propertyName);
-        
         Matrix value;
-        JSONNODE* m0 = json_at(property, 0);
-        value.m[0]  = json_as_float(m0);
-        JSONNODE* m1 = json_at(property, 1);
-        value.m[1]  = json_as_float(m1);
-        JSONNODE* m2 = json_at(property, 2);
-        value.m[2]  = json_as_float(m2);
-        JSONNODE* m3 = json_at(property, 3);
-        value.m[3]  = json_as_float(m3);
-        JSONNODE* m4 = json_at(property, 4);
-        value.m[4]  = json_as_float(m4);
-        JSONNODE* m5 = json_at(property, 5);
-        value.m[5]  = json_as_float(m5);
-        JSONNODE* m6 = json_at(property, 6);
-        value.m[6]  = json_as_float(m6);
-        JSONNODE* m7 = json_at(property, 7);
-        value.m[7]  = json_as_float(m7);
-        JSONNODE* m8 = json_at(property, 8);
-        value.m[8]  = json_as_float(m8);
-        JSONNODE* m9 = json_at(property, 9);
-        value.m[9]  = json_as_float(m9);
-        JSONNODE* m10 = json_at(property, 10);
-        value.m[10]  = json_as_float(m10);
-        JSONNODE* m11 = json_at(property, 11);
-        value.m[11]  = json_as_float(m11);
-        JSONNODE* m12 = json_at(property, 12);
-        value.m[12]  = json_as_float(m12);
-        JSONNODE* m13 = json_at(property, 13);
-        value.m[13]  = json_as_float(m13);
-        JSONNODE* m14 = json_at(property, 14);
-        value.m[14]  = json_as_float(m14);
-        JSONNODE* m15 = json_at(property, 15);
-        value.m[15]  = json_as_float(m15);
-        
+        if (readNumbers(property, value.m, 16) < 16)
+            GP_ERROR("Invalid json array from Matrix for propertyName:%s", propertyName);
+        endProperty(property);
         return value;
     }
     return defaultValue;
@@ -659,93 +749,77 @@ void SerializerJson::readString(const char* propertyName, std::string& value, co
 {
     GP_ASSERT(_type == Type::eReader);
 
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = nullptr;
-
-    if (json_type(node) == JSON_ARRAY)
-    {
-        size_t  arraySize = json_size(node);
-        property = json_at(node, (uint32_t)arraySize - (uint32_t)_nodesListCounts.top());
-        _nodesListCounts.top() -= 1;
-    }
-    else
-    {
-        GP_ASSERT(propertyName);
-        property = json_get(node, propertyName);
-    }
-   
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_STRING)
+        if (property->getToken() != JsonReader::TOKEN_STRING)
+        {
             GP_ERROR("Invalid json string for propertyName:%s", propertyName);
-
-        json_char* str = json_as_string(property);
-        value.clear();
-        value.resize(strlen(str));
-        std::strcpy(&value[0], str);
-        json_free(str);
+            value = defaultValue ? defaultValue : "";
+        }
+        else
+        {
+            value = property->getString();
+        }
+        endProperty(property);
     }
     else
     {
-        value.clear();
-        value.resize(strlen(defaultValue));
-        std::strcpy(&value[0], defaultValue);
+        value = defaultValue ? defaultValue : "";
     }
 }
 
 Serializable* SerializerJson::readObject(const char* propertyName)
 {
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* parentNode = _nodes.top();
-    JSONNODE* readNode = nullptr;
-    
-    if (json_type(parentNode) == JSON_ARRAY)
-    {
-        size_t  arraySize = json_size(parentNode);
-        readNode = json_at(parentNode, (uint32_t)arraySize - (uint32_t)_nodesListCounts.top());
-        _nodesListCounts.top() -= 1;
-    }
-    else if (json_type(parentNode) == JSON_NODE && propertyName)
+
+    // Objects without a name are written in place of their parent object, except in lists.
+    const Frame& parent = _frames.back();
+    if (parent.reader == nullptr)
+        return nullptr;
+    bool open = propertyName || parent.list;
+    if (open)
     {
-        JSONNODE* propertyNode = json_get(parentNode, propertyName);
-        if (propertyNode == nullptr)
+        JsonReader* property = beginProperty(propertyName);
+        if (property == nullptr)
             return nullptr;
-        if (json_type(propertyNode) != JSON_NODE)
+        if (property->getToken() != JsonReader::TOKEN_BEGIN_OBJECT)
         {
             GP_WARN("Invalid json object for propertyName:%s", propertyName);
+            endProperty(property);
             return nullptr;
         }
-        readNode = propertyNode;
+        pushFrame(property, false, property != _frames.back().reader);
     }
-    else
+
+    std::string className;
+    readString("class", className, "");
+    if (className.empty())
     {
-        readNode = parentNode;
+        GP_WARN("Missing json class for propertyName:%s", propertyName);
+        if (open)
+            popFrame();
+        return nullptr;
     }
-    
-    JSONNODE* classProperty = json_get(readNode, "class");
-    char* className = json_as_string(classProperty);
-    
+
     // Look for xref's
     unsigned long xrefAddress = 0L;
-    JSONNODE* xrefProperty = json_get(readNode, "xref");
-    if (xrefProperty)
-    {
-        json_char* str = json_as_string(xrefProperty);
-        std::string url = str;
-        json_free(str);
-        std::string at = "@";
-        if (url.compare(0, at.length(), at) != 0)
+    std::string url;
+    readString("xref", url, "");
+    if (!url.empty())
+    {
+        if (url[0] != '@')
         {
             // no @ sign. This is xref'ed by others
-            xrefAddress = std::strtol(url.c_str(), nullptr, 10);
+            xrefAddress = std::strtoul(url.c_str(), nullptr, 10);
         }
         else
         {
-            // This needs to lookup the node from the xref address. So save it for lookup
-            std::string addressStr = url.substr(1, url.length());
-            xrefAddress = std::strtol(addressStr.c_str(), nullptr, 10);
-         
+            // This needs to lookup the node from the xref address.
+            xrefAddress = std::strtoul(url.c_str() + 1, nullptr, 10);
+            if (open)
+                popFrame();
+
             std::map<unsigned long, Serializable*>::const_iterator itr = _xrefsRead.find(xrefAddress);
             if (itr != _xrefsRead.end())
             {
@@ -754,26 +828,26 @@ Serializable* SerializerJson::readObject(const char* propertyName)
             }
             else
             {
-                GP_WARN("Unresolved xref:%u for class:%s", xrefAddress, className);
-                json_free(className);
+                GP_WARN("Unresolved xref:%lu for class:%s", xrefAddress, className.c_str());
                 return nullptr;
             }
         }
     }
-    
+
     Serializable *value = (SerializerManager::getActivator()->createObject(className));
     if (value == nullptr)
     {
-        GP_WARN("Failed to deserialize json object:%s for class:", className);
-        json_free(className);
+        GP_WARN("Failed to deserialize json object for class:%s", className.c_str());
+        if (open)
+            popFrame();
         return nullptr;
     }
-    json_free(className);
 
-    _nodes.push(readNode);
+    // The properties are read in the order they were written, after the class and xref.
     value->onDeserialize(this);
-    _nodes.pop();
-    
+    if (open)
+        popFrame();
+
     if (xrefAddress)
         _xrefsRead[xrefAddress] = value;
 
@@ -785,35 +859,49 @@ void SerializerJson::readMap(const char* propertyName, std::vector<std::string>
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
 
-    JSONNODE* node = _nodes.top();
-    JSONNODE* list = json_get(node, propertyName);
-    size_t count = json_size(list);
-    //if (count > 0)
-    //{
-        _nodes.push(list);
-        _nodesListCounts.push(count);
-
-        for (int i=0; i<count; ++i) {
-            JSONNODE *item = json_at(list, i);
-            const char* name = json_name(item);
-            keys.push_back(name);
-        }
-    //}
+    JsonReader* property = beginProperty(propertyName);
+    if (property && property->getToken() != JsonReader::TOKEN_BEGIN_OBJECT)
+    {
+        GP_WARN("Invalid json object for propertyName:%s", propertyName);
+        endProperty(property);
+        property = nullptr;
+    }
+    pushFrame(property, false, property && property != _frames.back().reader);
+
+    if (property)
+    {
+        Frame& frame = _frames.back();
+        frame.scanned = true;
+        if (property->peek(nullptr, &frame.names))
+            keys.insert(keys.end(), frame.names.begin(), frame.names.end());
+        else
+            frame.open = false;
+    }
 }
 
 size_t SerializerJson::readList(const char* propertyName)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* node = _nodes.top();
-    JSONNODE* list = json_get(node, propertyName);
-    size_t count = json_size(list);
-    //if (count > 0)
-    //{
-    _nodes.push(list);
-    _nodesListCounts.push(count);
-    //}
+
+    JsonReader* property = beginProperty(propertyName);
+    if (property && property->getToken() != JsonReader::TOKEN_BEGIN_ARRAY)
+    {
+        GP_WARN("Invalid json array for propertyName:%s", propertyName);
+        endProperty(property);
+        property = nullptr;
+    }
+    pushFrame(property, true, property && property != _frames.back().reader);
+
+    if (property == nullptr)
+        return 0;
+
+    // Count the elements ahead, the list is then read as it is streamed.
+    Frame& frame = _frames.back();
+    unsigned int count = 0;
+    if (!property->peek(&count, nullptr))
+        frame.open = false;
+    frame.remaining = count;
     return count;
 }
 
@@ -821,32 +909,23 @@ size_t SerializerJson::readIntArray(const char* propertyName, int** data)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* node = _nodes.top();
+
     size_t count = 0;
-    JSONNODE* property = json_get(node, propertyName);
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_ARRAY )
-            GP_ERROR("Invalid json array for propertyName:%s", propertyName);
-        
-        count = json_size(property);
-        int* buffer = nullptr;
-        if (*data == nullptr)
+        if (property->getToken() != JsonReader::TOKEN_BEGIN_ARRAY || !property->readNumbers(&_ints))
         {
-            buffer = new int[count];
+            GP_ERROR("Invalid json array for propertyName:%s", propertyName);
         }
         else
         {
-            buffer = *data;
+            count = _ints.size();
+            if (*data == nullptr)
+                *data = new int[count];
+            std::copy(_ints.begin(), _ints.end(), *data);
         }
-        
-        for (size_t i = 0; i < count; i++)
-        {
-            JSONNODE* item = json_at(property, (uint32_t)i);
-            buffer[i] = (uint32_t)json_as_int(item);
-        }
-        *data = buffer;
+        endProperty(property);
     }
     return count;
 }
@@ -855,64 +934,50 @@ size_t SerializerJson::readFloatArray(const char* propertyName, float** data)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    JSONNODE* node = _nodes.top();
+
     size_t count = 0;
-    JSONNODE* property = json_get(node, propertyName);
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_ARRAY )
-            GP_ERROR("Invalid json array for propertyName:%s", propertyName);
-        
-        count = json_size(property);
-        float* buffer = nullptr;
-        if (*data == nullptr)
+        if (property->getToken() != JsonReader::TOKEN_BEGIN_ARRAY || !property->readNumbers(&_floats))
         {
-            buffer = new float[count];
+            GP_ERROR("Invalid json array for propertyName:%s", propertyName);
         }
         else
         {
-            buffer = *data;
-        }
-        
-        for (size_t i = 0; i < count; i++)
-        {
-            JSONNODE* item = json_at(property, (uint32_t)i);
-            buffer[i] = json_as_float(item);
+            count = _floats.size();
+            if (*data == nullptr)
+                *data = new float[count];
+            std::copy(_floats.begin(), _floats.end(), *data);
         }
-        *data = buffer;
+        endProperty(property);
     }
     return count;
 }
-    
+
 size_t SerializerJson::readByteArray(const char* propertyName, unsigned char** data)
 {
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Type::eReader);
-    
-    unsigned long size = 0L;
-    JSONNODE* node = _nodes.top();
-    JSONNODE* property = json_get(node, propertyName);
+
+    size_t size = 0;
+    JsonReader* property = beginProperty(propertyName);
     if (property)
     {
-        if (json_type(property) != JSON_STRING)
-            GP_ERROR("Invalid json base64 string for propertyName:%s", propertyName);
-        
-        json_char* str = json_as_string(property);
-        void* decoded = json_decode64(str, &size);
-        
-        if (*data == nullptr)
+        if (property->getToken() != JsonReader::TOKEN_STRING)
         {
-            *data = (unsigned char*)decoded;
+            GP_ERROR("Invalid json base64 string for propertyName:%s", propertyName);
         }
         else
         {
-            memcpy(*data, decoded, size);
-            json_free(decoded);
+            const char* str = property->getString();
+            if (*data == nullptr)
+                *data = new unsigned char[decodeBase64Length(str)];
+            size = decodeBase64(str, *data);
         }
-        json_free(str);
+        endProperty(property);
     }
-    return (size_t)size;
+    return size;
 }
 
 }
@@ -1,10 +1,7 @@
 #pragma once
 
 #include "Serializer.h"
-#define JSON_LIBRARY
-#include "libjson.h"
-
-#include <stack>
+#include "Json.h"
 
 namespace gameplay
 {
@@ -12,6 +9,14 @@ namespace gameplay
 /**
  * Defines a json serializer.
  *
+ * Reading pulls tokens from the file through a fixed-size buffer (see JsonReader), so properties
+ * read in the order they were written are found without searching or keeping the document in
+ * memory. The writer leaves out properties with default values: the first time a property isn't
+ * the next member, the names of the members left in the object are scanned ahead to find out if
+ * it is missing. Members passed over to reach a property written later are kept as text and read
+ * again when asked for. Lists are scanned ahead to count their elements before reading them.
+ * Writing streams the text to the file as properties are written.
+ *
  * @see Serializer
  */
 class SerializerJson : public Serializer
@@ -218,17 +223,48 @@ public:
     
 protected:
     
-    SerializerJson(Type type, const std::string& path, Stream* stream, uint32_t versionMajor, uint32_t versionMinor, JSONNODE* root);
+    SerializerJson(Type type, const std::string& path, Stream* stream, uint32_t versionMajor, uint32_t versionMinor, JsonReader* reader);
     static Serializer* create(const std::string& path, Stream* stream);
     
 private:
-    
-    JSONNODE* createNode(JSONNODE* parent, const char* propertyName);
-    
-    JSONNODE* _root;
-    std::stack<JSONNODE*> _nodes;
-    std::stack<size_t> _nodesListCounts;
-    std::map<unsigned long, JSONNODE*> _xrefsWrite;
+
+    /**
+     * An object or array being read, and where its reading is at.
+     */
+    struct Frame
+    {
+        JsonReader* reader;
+        bool ownsReader;
+        bool list;
+        bool open;
+        bool pending;
+        unsigned int remaining;
+        bool scanned;
+        std::vector<std::string> names;
+        size_t nextName;
+        std::vector<std::pair<std::string, std::string> > skipped;
+    };
+
+    JsonReader* findProperty(const char* propertyName);
+
+    JsonReader* beginProperty(const char* propertyName);
+
+    void endProperty(JsonReader* reader);
+
+    void pushFrame(JsonReader* reader, bool list, bool ownsReader);
+
+    void popFrame();
+
+    void clearFrames();
+
+    unsigned int readNumbers(JsonReader* reader, float* out, unsigned int count);
+
+    JsonReader* _reader;
+    JsonWriter* _writer;
+    std::vector<Frame> _frames;
+    std::vector<float> _floats;
+    std::vector<int> _ints;
+    std::set<unsigned long> _xrefsWrite;
     std::map<unsigned long, Serializable*> _xrefsRead;
 };
 
@@ -0,0 +1,127 @@
+#include "base/Base.h"
+#include "base/ThreadPool.h"
+
+#include <atomic>
+
+namespace gameplay
+{
+
+ThreadPool::ThreadPool(unsigned int threadCount) : _stopping(false)
+{
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        _threads.push_back(std::thread(&ThreadPool::workerProc, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+
+    for (size_t i = 0; i < _threads.size(); ++i)
+    {
+        _threads[i].join();
+    }
+}
+
+ThreadPool* ThreadPool::getDefault()
+{
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return &pool;
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+    return (unsigned int)_threads.size();
+}
+
+void ThreadPool::addTask(const std::function<void()>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(task);
+    }
+    _condition.notify_one();
+}
+
+void ThreadPool::workerProc()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+            if (_tasks.empty())
+                return;
+            task = _tasks.front();
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int, unsigned int)>& func)
+{
+    if (count == 0)
+        return;
+
+    batchSize = std::max(batchSize, 1u);
+    unsigned int batchCount = (count + batchSize - 1) / batchSize;
+    if (batchCount == 1 || _threads.empty())
+    {
+        func(0, count);
+        return;
+    }
+
+    // The state is shared with the helper tasks, which may only start running after all the
+    // batches are done; they then find no batch left and never touch the caller's function.
+    struct State
+    {
+        std::atomic<unsigned int> next;
+        std::atomic<unsigned int> done;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->next = 0;
+    state->done = 0;
+    const std::function<void(unsigned int, unsigned int)>* function = &func;
+
+    std::function<void()> run = [state, function, count, batchSize, batchCount]()
+    {
+        while (true)
+        {
+            unsigned int batch = state->next.fetch_add(1);
+            if (batch >= batchCount)
+                break;
+
+            unsigned int start = batch * batchSize;
+            (*function)(start, std::min(start + batchSize, count));
+
+            if (state->done.fetch_add(1) + 1 == batchCount)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->condition.notify_all();
+            }
+        }
+    };
+
+    unsigned int helpers = std::min(batchCount - 1, (unsigned int)_threads.size());
+    for (unsigned int i = 0; i < helpers; ++i)
+    {
+        addTask(run);
+    }
+
+    // The calling thread works on batches too, so this never waits on a busy pool.
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state, batchCount]() { return state->done == batchCount; });
+}
+
+}
@@ -0,0 +1,87 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+namespace gameplay
+{
+
+/**
+ * Defines a pool of worker threads that run tasks in the background.
+ *
+ * Tasks are run in the order they are added. The default pool is shared by
+ * the engine systems (audio decoding, AI, culling, ...) and has one worker
+ * thread per hardware thread minus the one running the game loop.
+ */
+class ThreadPool
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param threadCount The number of worker threads.
+     */
+    ThreadPool(unsigned int threadCount);
+
+    /**
+     * Destructor. Waits for the queued tasks to finish.
+     */
+    ~ThreadPool();
+
+    /**
+     * Returns the default thread pool shared by the engine.
+     *
+     * @return The default thread pool.
+     */
+    static ThreadPool* getDefault();
+
+    /**
+     * Returns the number of worker threads.
+     *
+     * @return The number of worker threads.
+     */
+    unsigned int getThreadCount() const;
+
+    /**
+     * Queues a task to be run on a worker thread.
+     *
+     * @param task The task to run.
+     */
+    void addTask(const std::function<void()>& task);
+
+    /**
+     * Runs a function over the range [0, count) split in batches, and waits for all of them to finish.
+     *
+     * Batches are run on the worker threads and on the calling thread. The function is
+     * called with the start (inclusive) and end (exclusive) indices of each batch.
+     *
+     * @param count The number of items.
+     * @param batchSize The number of items per batch.
+     * @param func The function to run for each batch.
+     */
+    void parallelFor(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int, unsigned int)>& func);
+
+private:
+
+    ThreadPool(const ThreadPool&);
+
+    ThreadPool& operator=(const ThreadPool&);
+
+    void workerProc();
+
+    std::vector<std::thread> _threads;
+    std::deque<std::function<void()> > _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopping;
+};
+
+}
+
+#endif
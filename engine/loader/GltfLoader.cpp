@@ -6,6 +6,7 @@
 
 #include "../scene/MeshPart.h"
 #include "../scene/BoneJoint.h"
+#include "../scene/MeshOptimizer.h"
 
 #include "material/MaterialParameter.h"
 
@@ -192,6 +193,10 @@ private:
 			}
 		}
 		
+		if (mesh->getPartCount() > 0) {
+			MeshOptimizer::optimize(mesh);
+		}
+
 		Model* model = Model::create(mesh);
 
 		//model->setMaterial();
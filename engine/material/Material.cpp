@@ -4,7 +4,11 @@
 #include "ShaderProgram.h"
 #include "base/Properties.h"
 #include "scene/Node.h"
+#include "scene/Light.h"
+#include "scene/ShadowMap.h"
 #include "MaterialParameter.h"
+#include "UniformBuffer.h"
+#include "scene/Renderer.h"
 #include "platform/Toolkit.h"
 
 namespace gameplay
@@ -24,6 +28,12 @@ Material::~Material()
         SAFE_RELEASE(_parameters[i]);
     }
 
+    for (size_t i = 0, count = _uniformBuffers.size(); i < count; ++i)
+    {
+        if (_shaderProgram->getUniformBlock(i)->getUsage() == UniformBlock::MATERIAL)
+            SAFE_DELETE(_uniformBuffers[i]);
+    }
+
     SAFE_RELEASE(_shaderProgram);
     //SAFE_RELEASE(_vertexAttributeBinding);
     SAFE_RELEASE(_nextPass);
@@ -90,6 +100,20 @@ bool Material::initialize(RenderView* view)
     return true;
 }
 
+/**
+ * Returns the first rendered shadow map of a type of light, sampled by the lit shaders.
+ */
+static ShadowMap* findShadowMap(RenderView* view, Light::Type type)
+{
+    for (size_t i = 0, count = view->shadowMaps.size(); i < count; ++i)
+    {
+        ShadowMap* shadowMap = view->shadowMaps[i];
+        if (shadowMap->getLight()->getLightType() == type && shadowMap->getTexture() && shadowMap->getCascadeCount() > 0)
+            return shadowMap;
+    }
+    return NULL;
+}
+
 void Material::bindCamera(RenderView* view, Node *node) {
     if (!node) return;
     Uniform *uniform = _shaderProgram->getUniform("u_worldViewProjectionMatrix");
@@ -110,7 +134,7 @@ void Material::bindCamera(RenderView* view, Node *node) {
 
     uniform = _shaderProgram->getUniform("u_viewMatrix");
     if (uniform) {
-        MaterialParameter* param = getParameter("u_worldMatrix");
+        MaterialParameter* param = getParameter("u_viewMatrix");
         param->setMatrix(view->camera->getViewMatrix());
         param->_temporary = true;
     }
@@ -208,6 +232,53 @@ void Material::bindCamera(RenderView* view, Node *node) {
     }
 
 
+    // Cascades of the first directional light casting shadows. Unused cascades end at depth 0.
+    uniform = _shaderProgram->getUniform("u_shadowCascadeFar");
+    if (uniform) {
+        ShadowMap* shadowMap = findShadowMap(view, Light::DIRECTIONAL);
+        Matrix matrices[ShadowMap::MAX_CASCADES];
+        float cascadeFar[ShadowMap::MAX_CASCADES] = { 0.0f };
+        if (shadowMap) {
+            for (unsigned int c = 0, count = shadowMap->getCascadeCount(); c < count; ++c) {
+                matrices[c] = shadowMap->getCascade(c).textureMatrix;
+                cascadeFar[c] = shadowMap->getCascade(c).farDepth;
+            }
+            Texture* texture = shadowMap->getTexture();
+            MaterialParameter* param = getParameter("u_shadowMap");
+            param->setSampler(texture);
+            param->_temporary = true;
+            param = getParameter("u_shadowTexelSize");
+            param->setVector2(Vector2(1.0f / texture->getWidth(), 1.0f / texture->getHeight()));
+            param->_temporary = true;
+        }
+        MaterialParameter* param = getParameter("u_shadowMatrix");
+        param->setMatrixArray(matrices, ShadowMap::MAX_CASCADES, true);
+        param->_temporary = true;
+        param = getParameter("u_shadowCascadeFar");
+        param->setVector4(Vector4(cascadeFar[0], cascadeFar[1], cascadeFar[2], cascadeFar[3]));
+        param->_temporary = true;
+    }
+
+    // The first spot light casting shadows. A zero matrix leaves the light unshadowed.
+    uniform = _shaderProgram->getUniform("u_spotShadowMatrix");
+    if (uniform) {
+        ShadowMap* shadowMap = findShadowMap(view, Light::SPOT);
+        Matrix matrix(Matrix::zero());
+        if (shadowMap) {
+            matrix = shadowMap->getCascade(0).textureMatrix;
+            Texture* texture = shadowMap->getTexture();
+            MaterialParameter* param = getParameter("u_spotShadowMap");
+            param->setSampler(texture);
+            param->_temporary = true;
+            param = getParameter("u_spotShadowTexelSize");
+            param->setVector2(Vector2(1.0f / texture->getWidth(), 1.0f / texture->getHeight()));
+            param->_temporary = true;
+        }
+        MaterialParameter* param = getParameter("u_spotShadowMatrix");
+        param->setMatrix(matrix);
+        param->_temporary = true;
+    }
+
     uniform = _shaderProgram->getUniform("u_time");
     if (uniform) {
         MaterialParameter* param = getParameter("u_time");
@@ -374,10 +445,15 @@ void Material::bind(RenderView* view, Node* node)
     if (view) bindCamera(view, node);
 
     // Bind our render state
+    UniformBuffer** blockBuffers = getUniformBuffers();
     for (size_t i = 0, count = _parameters.size(); i < count; ++i)
     {
         GP_ASSERT(_parameters[i]);
-        _parameters[i]->bind(this->_shaderProgram);
+        _parameters[i]->bind(this->_shaderProgram, blockBuffers);
+    }
+    if (blockBuffers)
+    {
+        Renderer::cur()->bindUniformBlocks(_shaderProgram, blockBuffers);
     }
     _state.bind();
 
@@ -388,6 +464,26 @@ void Material::bind(RenderView* view, Node* node)
     }*/
 }
 
+UniformBuffer** Material::getUniformBuffers()
+{
+    unsigned int count = _shaderProgram->getUniformBlockCount();
+    if (count == 0)
+        return NULL;
+
+    if (_uniformBuffers.empty())
+    {
+        // Per-material blocks get their own buffer, which is only uploaded when parameters change.
+        _uniformBuffers.resize(count, NULL);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            UniformBlock* block = _shaderProgram->getUniformBlock(i);
+            UniformBuffer* buffer = Renderer::cur()->getSharedUniformBuffer(block);
+            _uniformBuffers[i] = buffer ? buffer : new UniformBuffer(block->getSize());
+        }
+    }
+    return &_uniformBuffers[0];
+}
+
 void Material::unbind()
 {
     // If we have a vertex attribute binding, unbind it
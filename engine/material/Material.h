@@ -13,6 +13,7 @@ class NodeCloneContext;
 class RenderView;
 class MaterialParameter;
 class ShaderProgram;
+class UniformBuffer;
 
 /**
  * Defines a material for an object to be rendered.
@@ -316,6 +317,8 @@ private:
     bool initialize(RenderView* view);
     void bindCamera(RenderView* view, Node* node);
 
+    UniformBuffer** getUniformBuffers();
+
     std::string name;
     ShaderProgram* _shaderProgram;
     std::string vertexShaderPath;
@@ -336,6 +339,8 @@ private:
      * Collection of MaterialParameter's to be applied to the gameplay::ShaderProgram.
      */
     mutable std::vector<MaterialParameter*> _parameters;
+    // The buffer of each uniform block of the effect, owned by the renderer for shared blocks.
+    std::vector<UniformBuffer*> _uniformBuffers;
 };
 
 }
@@ -3,12 +3,16 @@
 #include "scene/Node.h"
 #include "scene/Renderer.h"
 #include "Texture.h"
+#include "UniformBuffer.h"
 
 namespace gameplay
 {
 
+// The last value stamp given out, shared by all parameters so stamps are never reused.
+static unsigned int __lastVersion = 0;
+
 MaterialParameter::MaterialParameter(const char* name) :
-_type(MaterialParameter::NONE), _count(1), _dynamic(false), _name(name ? name : ""), _uniform(NULL), _loggerDirtyBits(0), _methodBinding(NULL), _temporary(false)
+_type(MaterialParameter::NONE), _count(1), _dynamic(false), _name(name ? name : ""), _uniform(NULL), _loggerDirtyBits(0), _methodBinding(NULL), _temporary(false), _version(0)
 {
     clearValue();
 }
@@ -78,6 +82,7 @@ void MaterialParameter::clearValue()
 
     memset(&_value, 0, sizeof(_value));
     _type = MaterialParameter::NONE;
+    _version = 0;
 }
 
 const char* MaterialParameter::getName() const
@@ -85,6 +90,34 @@ const char* MaterialParameter::getName() const
     return _name.c_str();
 }
 
+unsigned int MaterialParameter::getVersion()
+{
+    if (_version == 0)
+    {
+        switch (_type)
+        {
+        case MaterialParameter::NONE:
+            return 0;
+        case MaterialParameter::FLOAT:
+        case MaterialParameter::INT:
+        case MaterialParameter::SAMPLER:
+        case MaterialParameter::SAMPLER_ARRAY:
+            break;
+        default:
+            // Arrays that were not copied can be changed by their owner at any time.
+            if (!_dynamic)
+                return 0;
+            break;
+        }
+
+        // Stamps are given out lazily, when a value is first bound after it changed.
+        if (++__lastVersion == 0)
+            ++__lastVersion;
+        _version = __lastVersion;
+    }
+    return _version;
+}
+
 Texture* MaterialParameter::getSampler(unsigned int index) const
 {
     if (_type == MaterialParameter::SAMPLER)
@@ -96,6 +129,9 @@ Texture* MaterialParameter::getSampler(unsigned int index) const
 
 void MaterialParameter::setValue(float value)
 {
+    if (_type == MaterialParameter::FLOAT && !_dynamic && _value.floatValue == value)
+        return;
+
     clearValue();
 
     _value.floatValue = value;
@@ -104,6 +140,9 @@ void MaterialParameter::setValue(float value)
 
 void MaterialParameter::setValue(int value)
 {
+    if (_type == MaterialParameter::INT && !_dynamic && _value.intValue == value)
+        return;
+
     clearValue();
 
     _value.intValue = value;
@@ -130,16 +169,7 @@ void MaterialParameter::setValue(const int* values, unsigned int count)
 
 void MaterialParameter::setValue(const Vector2& value)
 {
-    clearValue();
-
-    // Copy data by-value into a dynamic array.
-    float* array = new float[2];
-    memcpy(array, &value.x, sizeof(float) * 2);
-
-    _value.floatPtrValue = array;
-    _dynamic = true;
-    _count = 1;
-    _type = MaterialParameter::VECTOR2;
+    storeValue(&value.x, 2, MaterialParameter::VECTOR2);
 }
 
 void MaterialParameter::setValue(const Vector2* values, unsigned int count)
@@ -154,16 +184,7 @@ void MaterialParameter::setValue(const Vector2* values, unsigned int count)
 
 void MaterialParameter::setValue(const Vector3& value)
 {
-    clearValue();
-
-    // Copy data by-value into a dynamic array.
-    float* array = new float[3];
-    memcpy(array, &value.x, sizeof(float) * 3);
-
-    _value.floatPtrValue = array;
-    _dynamic = true;
-    _count = 1;
-    _type = MaterialParameter::VECTOR3;
+    storeValue(&value.x, 3, MaterialParameter::VECTOR3);
 }
 
 void MaterialParameter::setValue(const Vector3* values, unsigned int count)
@@ -178,16 +199,7 @@ void MaterialParameter::setValue(const Vector3* values, unsigned int count)
 
 void MaterialParameter::setValue(const Vector4& value)
 {
-    clearValue();
-
-    // Copy data by-value into a dynamic array.
-    float* array = new float[4];
-    memcpy(array, &value.x, sizeof(float) * 4);
-
-    _value.floatPtrValue = array;
-    _dynamic = true;
-    _count = 1;
-    _type = MaterialParameter::VECTOR4;
+    storeValue(&value.x, 4, MaterialParameter::VECTOR4);
 }
 
 void MaterialParameter::setValue(const Vector4* values, unsigned int count)
@@ -202,20 +214,32 @@ void MaterialParameter::setValue(const Vector4* values, unsigned int count)
 
 void MaterialParameter::setValue(const Matrix& value)
 {
-    // If this parameter is already storing a single dynamic matrix, no need to clear it.
-    if (!(_dynamic && _count == 1 && _type == MaterialParameter::MATRIX && _value.floatPtrValue != NULL))
+    storeValue(value.m, 16, MaterialParameter::MATRIX);
+}
+
+void MaterialParameter::storeValue(const float* values, unsigned int size, Type type)
+{
+    // If this parameter is already storing a single dynamic value of this type, no need to clear it.
+    if (_dynamic && _count == 1 && _type == type && _value.floatPtrValue != NULL)
+    {
+        // Keep the version when the value is unchanged, so it is not uploaded again.
+        if (memcmp(_value.floatPtrValue, values, sizeof(float) * size) == 0)
+            return;
+    }
+    else
     {
         clearValue();
 
-        // Allocate a new dynamic matrix.
-        _value.floatPtrValue = new float[16];
+        // Copy data by-value into a dynamic array.
+        _value.floatPtrValue = new float[size];
     }
 
-    memcpy(_value.floatPtrValue, value.m, sizeof(float) * 16);
+    memcpy(_value.floatPtrValue, values, sizeof(float) * size);
 
     _dynamic = true;
     _count = 1;
-    _type = MaterialParameter::MATRIX;
+    _type = type;
+    _version = 0;
 }
 
 void MaterialParameter::setValue(const Matrix* values, unsigned int count)
@@ -451,7 +475,7 @@ void MaterialParameter::setSamplerArray(const Texture** values, unsigned int cou
     _type = MaterialParameter::SAMPLER_ARRAY;
 }
 
-void MaterialParameter::bind(ShaderProgram* effect)
+void MaterialParameter::bind(ShaderProgram* effect, UniformBuffer** blockBuffers)
 {
     GP_ASSERT(effect);
 
@@ -473,9 +497,87 @@ void MaterialParameter::bind(ShaderProgram* effect)
         }
     }
 
+    // Uniforms of a block are written to its buffer, which the renderer binds as a whole.
+    if (_uniform->_block)
+    {
+        GP_ASSERT(blockBuffers);
+        writeBlockValue(_uniform, blockBuffers[_uniform->_block->_index]);
+        return;
+    }
+
     Renderer::cur()->bindUniform(this, _uniform, effect);
 }
 
+void MaterialParameter::writeBlockValue(Uniform* uniform, UniformBuffer* buffer)
+{
+    GP_ASSERT(uniform);
+    GP_ASSERT(buffer);
+
+    if (_methodBinding)
+    {
+        _methodBinding->setValue(uniform->getEffect());
+    }
+
+    // Elements of arrays are _arrayStride apart, and a uniform that is not an array has a stride of 0.
+    unsigned int count = uniform->_arrayStride > 0 ? _count : 1;
+    unsigned int components = 0;
+    switch (_type)
+    {
+    case MaterialParameter::FLOAT:
+        buffer->write(uniform->_offset, &_value.floatValue, sizeof(float));
+        return;
+    case MaterialParameter::INT:
+        buffer->write(uniform->_offset, &_value.intValue, sizeof(int));
+        return;
+    case MaterialParameter::INT_ARRAY:
+        GP_ASSERT(_value.intPtrValue);
+        for (unsigned int i = 0; i < count; ++i)
+            buffer->write(uniform->_offset + i * uniform->_arrayStride, &_value.intPtrValue[i], sizeof(int));
+        return;
+    case MaterialParameter::FLOAT_ARRAY:
+        components = 1;
+        break;
+    case MaterialParameter::VECTOR2:
+        components = 2;
+        break;
+    case MaterialParameter::VECTOR3:
+        components = 3;
+        break;
+    case MaterialParameter::VECTOR4:
+        components = 4;
+        break;
+    case MaterialParameter::MATRIX:
+    {
+        // Columns of a matrix are _matrixStride apart, mat3 uniforms only take the upper 3x3.
+        GP_ASSERT(_value.floatPtrValue);
+        unsigned int size = (uniform->getType() == 0x8B5B /*GL_FLOAT_MAT3*/) ? 3 : 4;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const float* m = _value.floatPtrValue + i * 16;
+            unsigned int offset = uniform->_offset + i * uniform->_arrayStride;
+            for (unsigned int column = 0; column < size; ++column)
+                buffer->write(offset + column * uniform->_matrixStride, m + column * 4, sizeof(float) * size);
+        }
+        return;
+    }
+    case MaterialParameter::SAMPLER:
+    case MaterialParameter::SAMPLER_ARRAY:
+        // Samplers can't be declared in blocks.
+        return;
+    default:
+        if ((_loggerDirtyBits & MaterialParameter::PARAMETER_VALUE_NOT_SET) == 0)
+        {
+            GP_WARN("Material parameter value not set for: '%s' in effect: '%s'.", _name.c_str(), uniform->getEffect()->getId());
+            _loggerDirtyBits |= MaterialParameter::PARAMETER_VALUE_NOT_SET;
+        }
+        return;
+    }
+
+    GP_ASSERT(_value.floatPtrValue);
+    for (unsigned int i = 0; i < count; ++i)
+        buffer->write(uniform->_offset + i * uniform->_arrayStride, _value.floatPtrValue + i * components, sizeof(float) * components);
+}
+
 void MaterialParameter::bindValue(Node* node, const char* binding)
 {
     GP_ASSERT(binding);
@@ -699,6 +801,8 @@ void MaterialParameter::setAnimationPropertyValue(int propertyId, AnimationValue
                 default:
                     break;
             }
+            // The value was changed in place.
+            _version = 0;
         }
         break;
     }
@@ -960,9 +1064,10 @@ void MaterialParameter::onDeserialize(Serializer* serializer) {
         setValue(serializer->readFloat("value", 0));
         break;
     case MaterialParameter::FLOAT_ARRAY: {
-        float data[1024];
-        int size = serializer->readFloatArray("value", (float **)&data);
-        setFloatArray(data, size, true);
+        float* data = nullptr;
+        size_t size = serializer->readFloatArray("value", &data);
+        setFloatArray(data, (unsigned int)size, true);
+        SAFE_DELETE_ARRAY(data);
         break;
     }
     case MaterialParameter::INT: {
@@ -970,9 +1075,10 @@ void MaterialParameter::onDeserialize(Serializer* serializer) {
         break;
     }
     case MaterialParameter::INT_ARRAY: {
-        int data[1024];
-        int size = serializer->readIntArray("value", (int**)&data);
-        setIntArray(data, size, true);
+        int* data = nullptr;
+        size_t size = serializer->readIntArray("value", &data);
+        setIntArray(data, (unsigned int)size, true);
+        SAFE_DELETE_ARRAY(data);
         break;
     }
     case MaterialParameter::VECTOR2: {
@@ -13,6 +13,7 @@
 namespace gameplay
 {
     class Node;
+    class UniformBuffer;
 
 /**
  * Defines a material parameter.
@@ -61,6 +62,17 @@ public:
      */
     Texture* getSampler(unsigned int index = 0) const;
 
+    /**
+     * Returns a stamp identifying the current value of this parameter.
+     *
+     * The stamp changes whenever the value is set to something different and is unique
+     * across all parameters, so a renderer can skip uploading a value it uploaded before.
+     *
+     * @return The stamp, or zero if the value refers to memory the parameter does not
+     *      own (arrays set without copying), which may change without notice.
+     */
+    unsigned int getVersion();
+
     /**
      * Sets the value of this parameter to a float value.
      */
@@ -463,7 +475,9 @@ private:
 
     void clearValue();
 
-    void bind(ShaderProgram* effect);
+    void bind(ShaderProgram* effect, UniformBuffer** blockBuffers);
+
+    void writeBlockValue(Uniform* uniform, UniformBuffer* buffer);
 
     void applyAnimationValue(AnimationValue* value, float blendWeight, int components);
 
@@ -517,6 +531,11 @@ public:
     char _loggerDirtyBits;
     MethodBinding* _methodBinding;
     bool _temporary;
+    unsigned int _version;
+
+private:
+
+    void storeValue(const float* values, unsigned int size, Type type);
 };
 
 template <class ClassType, class ParameterType>
@@ -27,6 +27,10 @@ ShaderProgram::~ShaderProgram()
     {
         SAFE_DELETE(itr->second);
     }
+    for (size_t i = 0, count = _uniformBlocks.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_uniformBlocks[i]);
+    }
 
     Renderer::cur()->deleteProgram(this);
 }
@@ -338,6 +342,16 @@ unsigned int ShaderProgram::getUniformCount() const
     return (unsigned int)_uniforms.size();
 }
 
+UniformBlock* ShaderProgram::getUniformBlock(unsigned int index) const
+{
+    return index < _uniformBlocks.size() ? _uniformBlocks[index] : NULL;
+}
+
+unsigned int ShaderProgram::getUniformBlockCount() const
+{
+    return (unsigned int)_uniformBlocks.size();
+}
+
 void ShaderProgram::bind()
 {
     Renderer::cur()->bindProgram(this);
@@ -349,7 +363,7 @@ void ShaderProgram::bind()
 }*/
 
 Uniform::Uniform() :
-    _location(-1), _type(0), _index(0), _effect(NULL)
+    _location(-1), _type(0), _index(0), _effect(NULL), _version(0), _block(NULL), _offset(0), _arrayStride(0), _matrixStride(0)
 {
 }
 
@@ -377,4 +391,34 @@ bool Uniform::isSampler2d() const {
     return getType() == 0x8B5E;
 }
 
+UniformBlock::UniformBlock() :
+    _index(0), _size(0), _binding(0), _usage(UniformBlock::MATERIAL)
+{
+}
+
+const char* UniformBlock::getName() const
+{
+    return _name.c_str();
+}
+
+UniformBlock::Usage UniformBlock::getUsage() const
+{
+    return _usage;
+}
+
+unsigned int UniformBlock::getSize() const
+{
+    return _size;
+}
+
+UniformBlock::Usage UniformBlock::getUsage(const char* name)
+{
+    GP_ASSERT(name);
+    if (strcmp(name, "FrameBlock") == 0)
+        return UniformBlock::FRAME;
+    if (strcmp(name, "DrawBlock") == 0)
+        return UniformBlock::DRAW;
+    return UniformBlock::MATERIAL;
+}
+
 }
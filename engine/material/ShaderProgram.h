@@ -14,6 +14,7 @@ namespace gameplay
 typedef unsigned int VertexAttributeLoc;
 typedef unsigned int ProgramHandle;
 class Uniform;
+class UniformBlock;
 
 /**
  * Defines an effect which can be applied during rendering.
@@ -91,6 +92,22 @@ public:
      */
     unsigned int getUniformCount() const;
 
+    /**
+     * Returns the specified uniform block.
+     *
+     * @param index The index of the block to return.
+     *
+     * @return The block, or NULL if index is invalid.
+     */
+    UniformBlock* getUniformBlock(unsigned int index) const;
+
+    /**
+     * Returns the number of uniform blocks in this effect.
+     *
+     * @return The number of uniform blocks.
+     */
+    unsigned int getUniformBlockCount() const;
+
     /**
      * Binds this effect to make it the currently active effect for the rendering system.
      */
@@ -127,6 +144,7 @@ public:
     std::string _id;
     std::map<std::string, VertexAttributeLoc> _vertexAttributes;
     mutable std::map<std::string, Uniform*> _uniforms;
+    std::vector<UniformBlock*> _uniformBlocks;
     static Uniform _emptyUniform;
 };
 
@@ -190,6 +208,87 @@ public:
     unsigned int _type;
     unsigned int _index;
     ShaderProgram* _effect;
+    // Version of the material parameter value last uploaded to this uniform, or zero if unknown.
+    unsigned int _version;
+    // The block holding this uniform, or NULL for uniforms set individually.
+    UniformBlock* _block;
+    // The std140 layout of a uniform in a block, in bytes.
+    unsigned int _offset;
+    unsigned int _arrayStride;
+    unsigned int _matrixStride;
+};
+
+/**
+ * Represents a std140 uniform block within an effect.
+ *
+ * The values of a block are written to a UniformBuffer and bound with a single call
+ * instead of one call per uniform. What a block holds is given by its name:
+ * - "FrameBlock" holds values that change once per view, such as the view and
+ *   projection matrices. It is shared by all effects, which must declare it identically.
+ * - "DrawBlock" holds values that change with every draw, such as the world matrices.
+ *   It is shared by all effects, which must declare it identically.
+ * - Any other block holds material values and has a buffer per material, only
+ *   uploaded when the material parameters change.
+ */
+class UniformBlock
+{
+    friend class ShaderProgram;
+
+public:
+
+    /**
+     * Defines how often the values of a block change.
+     */
+    enum Usage
+    {
+        FRAME,
+        DRAW,
+        MATERIAL
+    };
+
+    /**
+     * Returns the name of this block.
+     *
+     * @return The name of the block.
+     */
+    const char* getName() const;
+
+    /**
+     * Returns how often the values of this block change.
+     *
+     * @return The usage of the block.
+     */
+    Usage getUsage() const;
+
+    /**
+     * Returns the size of this block.
+     *
+     * @return The size of the block, in bytes.
+     */
+    unsigned int getSize() const;
+
+    /**
+     * Returns the usage of a block from its name.
+     *
+     * @param name The block name.
+     *
+     * @return The usage of a block with that name.
+     */
+    static Usage getUsage(const char* name);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    UniformBlock();
+
+public:
+    std::string _name;
+    unsigned int _index;
+    unsigned int _size;
+    unsigned int _binding;
+    Usage _usage;
 };
 
 }
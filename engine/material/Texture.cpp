@@ -273,6 +273,15 @@ void Texture::setData(const unsigned char* data)
     this->_data = NULL;
 }
 
+void Texture::setSubData(int x, int y, unsigned int width, unsigned int height, const unsigned char* data)
+{
+    GP_ASSERT( data );
+    GP_ASSERT( x >= 0 && y >= 0 && x + width <= _width && y + height <= _height );
+    this->_data = data;
+    Renderer::cur()->updateTextureRegion(this, x, y, width, height);
+    this->_data = NULL;
+}
+
 Texture::Format Texture::getFormat() const
 {
     return _format;
@@ -162,6 +162,19 @@ public:
      */
     void setData(const unsigned char* data);
 
+    /**
+     * Replaces a region of the texture image.
+     *
+     * Only supported for 2D textures.
+     *
+     * @param x The x offset of the region, in pixels.
+     * @param y The y offset of the region, in pixels.
+     * @param width The width of the region, in pixels.
+     * @param height The height of the region, in pixels.
+     * @param data Raw data of the region (expected to be tightly packed).
+     */
+    void setSubData(int x, int y, unsigned int width, unsigned int height, const unsigned char* data);
+
     /**
      * Returns the path that the texture was originally loaded from (if applicable).
      *
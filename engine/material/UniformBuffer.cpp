@@ -0,0 +1,66 @@
+#include "base/Base.h"
+#include "UniformBuffer.h"
+#include "scene/Renderer.h"
+
+namespace gameplay
+{
+
+UniformBuffer::UniformBuffer(unsigned int size) :
+    _data(NULL), _size(0), _handle(0), _dirty(true)
+{
+    reserve(size);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    if (_handle)
+        Renderer::cur()->deleteUniformBuffer(this);
+    SAFE_DELETE_ARRAY(_data);
+}
+
+unsigned int UniformBuffer::getSize() const
+{
+    return _size;
+}
+
+void UniformBuffer::reserve(unsigned int size)
+{
+    if (size <= _size)
+        return;
+
+    unsigned char* data = new unsigned char[size];
+    if (_size > 0)
+        memcpy(data, _data, _size);
+    memset(data + _size, 0, size - _size);
+    SAFE_DELETE_ARRAY(_data);
+    _data = data;
+    _size = size;
+    _dirty = true;
+}
+
+const unsigned char* UniformBuffer::getData() const
+{
+    return _data;
+}
+
+void UniformBuffer::write(unsigned int offset, const void* data, unsigned int size)
+{
+    GP_ASSERT(data);
+    if (offset >= _size)
+        return;
+    if (size > _size - offset)
+        size = _size - offset;
+
+    if (memcmp(_data + offset, data, size) != 0)
+    {
+        memcpy(_data + offset, data, size);
+        _dirty = true;
+    }
+}
+
+bool UniformBuffer::isDirty() const
+{
+    return _dirty;
+}
+
+}
@@ -0,0 +1,87 @@
+#ifndef UNIFORMBUFFER_H_
+#define UNIFORMBUFFER_H_
+
+#include "base/Base.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines the storage of a uniform block.
+ *
+ * The values of the block are kept in memory with the std140 layout reported for the
+ * block by its shader program, and are uploaded by the renderer to a GPU buffer when
+ * they changed since the last upload.
+ */
+class UniformBuffer
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param size The size of the block, in bytes.
+     */
+    UniformBuffer(unsigned int size);
+
+    /**
+     * Destructor. Releases the GPU buffer.
+     */
+    ~UniformBuffer();
+
+    /**
+     * Returns the size of the block.
+     *
+     * @return The size, in bytes.
+     */
+    unsigned int getSize() const;
+
+    /**
+     * Grows the block, keeping its values. The new bytes are zero.
+     *
+     * @param size The new size, in bytes. Smaller sizes are ignored.
+     */
+    void reserve(unsigned int size);
+
+    /**
+     * Returns the values of the block.
+     *
+     * @return The values, laid out as in the GPU buffer.
+     */
+    const unsigned char* getData() const;
+
+    /**
+     * Writes values to the block.
+     *
+     * The block is only marked as changed if the bytes differ from the ones it holds.
+     * Bytes past the end of the block are ignored.
+     *
+     * @param offset The offset to write to, in bytes.
+     * @param data The values to write.
+     * @param size The number of bytes to write.
+     */
+    void write(unsigned int offset, const void* data, unsigned int size);
+
+    /**
+     * Determines if values changed since the block was last uploaded.
+     *
+     * @return True if the block must be uploaded.
+     */
+    bool isDirty() const;
+
+private:
+
+    UniformBuffer(const UniformBuffer&);
+
+    UniformBuffer& operator=(const UniformBuffer&);
+
+public:
+    unsigned char* _data;
+    unsigned int _size;
+    unsigned int _handle;
+    bool _dirty;
+};
+
+}
+
+#endif
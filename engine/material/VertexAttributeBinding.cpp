@@ -22,7 +22,7 @@ namespace gameplay
 static std::vector<VertexAttributeBinding*> __vertexAttributeBindingCache;
 
 VertexAttributeBinding::VertexAttributeBinding() :
-    _handle(0), _mesh(NULL), _effect(NULL), _isDirty(false)
+    _handle(0), _mesh(NULL), _vertexBuffer(0), _effect(NULL), _isDirty(false)
 {
 }
 
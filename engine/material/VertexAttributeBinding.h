@@ -112,6 +112,7 @@ public:
     unsigned int _handle;
     std::vector<VertexAttribute> _attributes;
     Mesh* _mesh;
+    unsigned int _vertexBuffer;     // Vertex buffer of a binding without mesh, such as the streaming buffer of a mesh batch
     ShaderProgram* _effect;
     bool _isDirty;
 };
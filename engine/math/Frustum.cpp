@@ -2,10 +2,218 @@
 #include "Frustum.h"
 #include "BoundingSphere.h"
 #include "BoundingBox.h"
+#include "MathUtil.h"
+#include "MathUtilSIMD.h"
+#include "base/ThreadPool.h"
+
+// Number of volumes tested per thread pool task, a multiple of 32 so tasks don't share visibility masks.
+#define CULL_CHUNK_SIZE 8192
 
 namespace gameplay
 {
 
+/**
+ * Bounding spheres given as arrays, tested against the planes of a frustum
+ * stored as (normal x, normal y, normal z, distance).
+ */
+struct SphereArrays
+{
+    const float (*planes)[4];
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* radius;
+
+    bool test(unsigned int i) const
+    {
+        // The sphere must not be in the negative half-space of any plane, as in BoundingSphere::intersects(const Frustum&).
+        for (int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes[p];
+            float distance = plane[0] * x[i] + plane[1] * y[i] + plane[2] * z[i] + plane[3];
+            if (!(distance >= -radius[i]))
+                return false;
+        }
+        return true;
+    }
+
+#ifdef GP_USE_SSE
+    unsigned int test4(unsigned int i) const
+    {
+        __m128 cx = _mm_loadu_ps(x + i);
+        __m128 cy = _mm_loadu_ps(y + i);
+        __m128 cz = _mm_loadu_ps(z + i);
+        __m128 r = _mm_xor_ps(_mm_loadu_ps(radius + i), _mm_set1_ps(-0.0f));
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes[p];
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), cx),
+                _mm_mul_ps(_mm_set1_ps(plane[1]), cy)), _mm_mul_ps(_mm_set1_ps(plane[2]), cz)), _mm_set1_ps(plane[3]));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, r));
+        }
+        return (unsigned int)_mm_movemask_ps(visible);
+    }
+#endif
+
+#if defined(GP_USE_AVX2) || defined(GP_DISPATCH_AVX2)
+    GP_TARGET_AVX2 unsigned int test8(unsigned int i) const
+    {
+        __m256 cx = _mm256_loadu_ps(x + i);
+        __m256 cy = _mm256_loadu_ps(y + i);
+        __m256 cz = _mm256_loadu_ps(z + i);
+        __m256 r = _mm256_xor_ps(_mm256_loadu_ps(radius + i), _mm256_set1_ps(-0.0f));
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes[p];
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[0]), cx),
+                _mm256_mul_ps(_mm256_set1_ps(plane[1]), cy)), _mm256_mul_ps(_mm256_set1_ps(plane[2]), cz)), _mm256_set1_ps(plane[3]));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, r, _CMP_GE_OQ));
+        }
+        return (unsigned int)_mm256_movemask_ps(visible);
+    }
+#endif
+};
+
+/**
+ * Axis-aligned bounding boxes given as arrays, tested against the planes of a frustum.
+ */
+struct BoxArrays
+{
+    const float (*planes)[4];
+    const float* minX;
+    const float* minY;
+    const float* minZ;
+    const float* maxX;
+    const float* maxY;
+    const float* maxZ;
+
+    bool test(unsigned int i) const
+    {
+        // The distance from the center of the box to each plane must not exceed the
+        // projected extents of the box behind it, as in BoundingBox::intersects(const Frustum&).
+        float centerX = (minX[i] + maxX[i]) * 0.5f;
+        float centerY = (minY[i] + maxY[i]) * 0.5f;
+        float centerZ = (minZ[i] + maxZ[i]) * 0.5f;
+        float extentX = (maxX[i] - minX[i]) * 0.5f;
+        float extentY = (maxY[i] - minY[i]) * 0.5f;
+        float extentZ = (maxZ[i] - minZ[i]) * 0.5f;
+        for (int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes[p];
+            float distance = plane[0] * centerX + plane[1] * centerY + plane[2] * centerZ + plane[3];
+            float extent = fabsf(extentX * plane[0]) + fabsf(extentY * plane[1]) + fabsf(extentZ * plane[2]);
+            if (!(distance >= -extent))
+                return false;
+        }
+        return true;
+    }
+
+#ifdef GP_USE_SSE
+    unsigned int test4(unsigned int i) const
+    {
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 sign = _mm_set1_ps(-0.0f);
+        __m128 x0 = _mm_loadu_ps(minX + i), x1 = _mm_loadu_ps(maxX + i);
+        __m128 y0 = _mm_loadu_ps(minY + i), y1 = _mm_loadu_ps(maxY + i);
+        __m128 z0 = _mm_loadu_ps(minZ + i), z1 = _mm_loadu_ps(maxZ + i);
+        __m128 cx = _mm_mul_ps(_mm_add_ps(x0, x1), half);
+        __m128 cy = _mm_mul_ps(_mm_add_ps(y0, y1), half);
+        __m128 cz = _mm_mul_ps(_mm_add_ps(z0, z1), half);
+        __m128 ex = _mm_mul_ps(_mm_sub_ps(x1, x0), half);
+        __m128 ey = _mm_mul_ps(_mm_sub_ps(y1, y0), half);
+        __m128 ez = _mm_mul_ps(_mm_sub_ps(z1, z0), half);
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes[p];
+            __m128 nx = _mm_set1_ps(plane[0]), ny = _mm_set1_ps(plane[1]), nz = _mm_set1_ps(plane[2]);
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)), _mm_set1_ps(plane[3]));
+            __m128 extent = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign, _mm_mul_ps(ex, nx)), _mm_andnot_ps(sign, _mm_mul_ps(ey, ny))),
+                _mm_andnot_ps(sign, _mm_mul_ps(ez, nz)));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, _mm_xor_ps(extent, sign)));
+        }
+        return (unsigned int)_mm_movemask_ps(visible);
+    }
+#endif
+
+#if defined(GP_USE_AVX2) || defined(GP_DISPATCH_AVX2)
+    GP_TARGET_AVX2 unsigned int test8(unsigned int i) const
+    {
+        __m256 half = _mm256_set1_ps(0.5f);
+        __m256 sign = _mm256_set1_ps(-0.0f);
+        __m256 x0 = _mm256_loadu_ps(minX + i), x1 = _mm256_loadu_ps(maxX + i);
+        __m256 y0 = _mm256_loadu_ps(minY + i), y1 = _mm256_loadu_ps(maxY + i);
+        __m256 z0 = _mm256_loadu_ps(minZ + i), z1 = _mm256_loadu_ps(maxZ + i);
+        __m256 cx = _mm256_mul_ps(_mm256_add_ps(x0, x1), half);
+        __m256 cy = _mm256_mul_ps(_mm256_add_ps(y0, y1), half);
+        __m256 cz = _mm256_mul_ps(_mm256_add_ps(z0, z1), half);
+        __m256 ex = _mm256_mul_ps(_mm256_sub_ps(x1, x0), half);
+        __m256 ey = _mm256_mul_ps(_mm256_sub_ps(y1, y0), half);
+        __m256 ez = _mm256_mul_ps(_mm256_sub_ps(z1, z0), half);
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes[p];
+            __m256 nx = _mm256_set1_ps(plane[0]), ny = _mm256_set1_ps(plane[1]), nz = _mm256_set1_ps(plane[2]);
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_mul_ps(nz, cz)), _mm256_set1_ps(plane[3]));
+            __m256 extent = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(sign, _mm256_mul_ps(ex, nx)), _mm256_andnot_ps(sign, _mm256_mul_ps(ey, ny))),
+                _mm256_andnot_ps(sign, _mm256_mul_ps(ez, nz)));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_xor_ps(extent, sign), _CMP_GE_OQ));
+        }
+        return (unsigned int)_mm256_movemask_ps(visible);
+    }
+#endif
+};
+
+/**
+ * Tests the volumes [start, end) and stores their visibility masks. start is a multiple of 32.
+ */
+template <class Volumes>
+static void intersectRange(const Volumes& volumes, unsigned int start, unsigned int end, bool wide, unsigned int* visibility)
+{
+    for (unsigned int block = start; block < end; block += 32)
+    {
+        unsigned int blockEnd = std::min(block + 32, end);
+        unsigned int mask = 0;
+        unsigned int i = block;
+#if defined(GP_USE_AVX2) || defined(GP_DISPATCH_AVX2)
+        if (wide)
+        {
+            for (; i + 8 <= blockEnd; i += 8)
+                mask |= volumes.test8(i) << (i - block);
+        }
+#endif
+#ifdef GP_USE_SSE
+        for (; i + 4 <= blockEnd; i += 4)
+            mask |= volumes.test4(i) << (i - block);
+#endif
+        for (; i < blockEnd; ++i)
+        {
+            if (volumes.test(i))
+                mask |= 1u << (i - block);
+        }
+        visibility[block / 32] = mask;
+    }
+}
+
+template <class Volumes>
+static void intersectAll(const Volumes& volumes, unsigned int count, bool wide, unsigned int* visibility, ThreadPool* pool)
+{
+    if (pool && count > CULL_CHUNK_SIZE)
+    {
+        pool->parallelFor(count, CULL_CHUNK_SIZE, [&volumes, wide, visibility](unsigned int start, unsigned int end)
+        {
+            intersectRange(volumes, start, end, wide, visibility);
+        });
+    }
+    else
+    {
+        intersectRange(volumes, 0, count, wide, visibility);
+    }
+}
+
 Frustum::Frustum()
 {
     set(Matrix::identity());
@@ -130,6 +338,44 @@ float Frustum::intersects(const Ray& ray) const
     return ray.intersects(*this);
 }
 
+void Frustum::intersectSpheres(const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+                               unsigned int count, unsigned int* visibility, ThreadPool* pool) const
+{
+    GP_ASSERT((centerX && centerY && centerZ && radius && visibility) || count == 0);
+
+    float planes[6][4];
+    getPlanes(planes);
+
+    SphereArrays spheres = { planes, centerX, centerY, centerZ, radius };
+    intersectAll(spheres, count, MathUtil::isAVX2Supported(), visibility, pool);
+}
+
+void Frustum::intersectBoxes(const float* minX, const float* minY, const float* minZ,
+                             const float* maxX, const float* maxY, const float* maxZ,
+                             unsigned int count, unsigned int* visibility, ThreadPool* pool) const
+{
+    GP_ASSERT((minX && minY && minZ && maxX && maxY && maxZ && visibility) || count == 0);
+
+    float planes[6][4];
+    getPlanes(planes);
+
+    BoxArrays boxes = { planes, minX, minY, minZ, maxX, maxY, maxZ };
+    intersectAll(boxes, count, MathUtil::isAVX2Supported(), visibility, pool);
+}
+
+void Frustum::getPlanes(float planes[6][4]) const
+{
+    const Plane* all[6] = { &_near, &_far, &_left, &_right, &_bottom, &_top };
+    for (int i = 0; i < 6; ++i)
+    {
+        const Vector3& normal = all[i]->getNormal();
+        planes[i][0] = normal.x;
+        planes[i][1] = normal.y;
+        planes[i][2] = normal.z;
+        planes[i][3] = all[i]->getDistance();
+    }
+}
+
 void Frustum::set(const Frustum& frustum)
 {
     _near = frustum._near;
@@ -8,6 +8,8 @@
 namespace gameplay
 {
 
+class ThreadPool;
+
 /**
  * Defines a 3-dimensional frustum.
  *
@@ -193,6 +195,46 @@ public:
      */
     float intersects(const Ray& ray) const;
 
+    /**
+     * Tests an array of bounding spheres against the frustum.
+     *
+     * The spheres are given as separate arrays of their center coordinates and radii,
+     * which lets several spheres be tested against each plane at a time with vector
+     * instructions. Bit i % 32 of visibility[i / 32] is set if sphere i intersects the
+     * frustum, with the same result as BoundingSphere::intersects(const Frustum&).
+     *
+     * @param centerX The x coordinates of the sphere centers.
+     * @param centerY The y coordinates of the sphere centers.
+     * @param centerZ The z coordinates of the sphere centers.
+     * @param radius The radii of the spheres.
+     * @param count The number of spheres.
+     * @param visibility An array of (count + 31) / 32 masks to store the results in.
+     * @param pool A thread pool to test chunks of the spheres on, or NULL to test them on the calling thread.
+     */
+    void intersectSpheres(const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+                          unsigned int count, unsigned int* visibility, ThreadPool* pool = NULL) const;
+
+    /**
+     * Tests an array of axis-aligned bounding boxes against the frustum.
+     *
+     * The boxes are given as separate arrays of their minimum and maximum coordinates.
+     * Bit i % 32 of visibility[i / 32] is set if box i intersects the frustum, with the
+     * same result as BoundingBox::intersects(const Frustum&).
+     *
+     * @param minX The minimum x coordinates of the boxes.
+     * @param minY The minimum y coordinates of the boxes.
+     * @param minZ The minimum z coordinates of the boxes.
+     * @param maxX The maximum x coordinates of the boxes.
+     * @param maxY The maximum y coordinates of the boxes.
+     * @param maxZ The maximum z coordinates of the boxes.
+     * @param count The number of boxes.
+     * @param visibility An array of (count + 31) / 32 masks to store the results in.
+     * @param pool A thread pool to test chunks of the boxes on, or NULL to test them on the calling thread.
+     */
+    void intersectBoxes(const float* minX, const float* minY, const float* minZ,
+                        const float* maxX, const float* maxY, const float* maxZ,
+                        unsigned int count, unsigned int* visibility, ThreadPool* pool = NULL) const;
+
     /**
      * Sets this frustum to the specified frustum.
      *
@@ -214,6 +256,11 @@ private:
      */
     void updatePlanes();
 
+    /**
+     * Copies the planes as (normal x, normal y, normal z, distance) for the batch tests.
+     */
+    void getPlanes(float planes[6][4]) const;
+
     Plane _near;
     Plane _far;
     Plane _bottom;
@@ -1,5 +1,7 @@
 #include "base/Base.h"
 #include "MathUtil.h"
+#include "MathUtilSIMD.h"
+#include "Quaternion.h"
 
 namespace gameplay
 {
@@ -25,4 +27,449 @@ void MathUtil::smooth(float* x, float target, float elapsedTime, float riseTime,
     }
 }
 
+#ifdef GP_USE_SSE
+
+/**
+ * Transposes the 4x4 blocks held by the 128-bit lanes of four registers, using the
+ * temporaries tmp0 to tmp3 declared by the caller.
+ */
+#define TRANSPOSE4_LANES(r0, r1, r2, r3, unpacklo, unpackhi, shuffle) \
+    do { \
+        tmp0 = unpacklo(r0, r1); tmp1 = unpacklo(r2, r3); \
+        tmp2 = unpackhi(r0, r1); tmp3 = unpackhi(r2, r3); \
+        r0 = shuffle(tmp0, tmp1, _MM_SHUFFLE(1, 0, 1, 0)); r1 = shuffle(tmp0, tmp1, _MM_SHUFFLE(3, 2, 3, 2)); \
+        r2 = shuffle(tmp2, tmp3, _MM_SHUFFLE(1, 0, 1, 0)); r3 = shuffle(tmp2, tmp3, _MM_SHUFFLE(3, 2, 3, 2)); \
+    } while (0)
+
+// Products of the 2x2 matrices stored as (m00, m01, m10, m11) in a register, used by
+// the block inverse. adj(a) denotes the adjugate of a.
+static inline __m128 mul2x2(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+static inline __m128 adjMul2x2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+static inline __m128 mulAdj2x2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+/**
+ * Computes the slerp coefficients of four quaternion pairs, using the same fast
+ * approximation as Quaternion::slerp, given their dot products.
+ */
+static inline void slerpCoefficients(__m128 cosTheta, float t, __m128* alpha, __m128* beta)
+{
+    // The folding of t is the same for every pair.
+    float f2b = t - 0.5f;
+    float u = f2b >= 0 ? f2b : -f2b;
+    float f2a = u - f2b;
+    f2b += u;
+    u += u;
+    float f1 = 1.0f - u;
+    float sqNotU = f1 * f1;
+    float sqU = u * u;
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 sign = _mm_and_ps(cosTheta, _mm_set1_ps(-0.0f));
+    __m128 a = _mm_or_ps(one, sign);
+    __m128 halfY = _mm_add_ps(one, _mm_mul_ps(a, cosTheta));
+
+    __m128 halfSecHalfTheta = _mm_sub_ps(_mm_set1_ps(1.09f), _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(0.476537f), _mm_mul_ps(_mm_set1_ps(0.0903321f), halfY)), halfY));
+    halfSecHalfTheta = _mm_mul_ps(halfSecHalfTheta, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfY, _mm_mul_ps(halfSecHalfTheta, halfSecHalfTheta))));
+    __m128 versHalfTheta = _mm_sub_ps(one, _mm_mul_ps(halfY, halfSecHalfTheta));
+
+    __m128 ratio2 = _mm_mul_ps(_mm_set1_ps(0.0000440917108f), versHalfTheta);
+    __m128 ratio1 = _mm_add_ps(_mm_set1_ps(-0.00158730159f), _mm_mul_ps(_mm_set1_ps(sqNotU - 16.0f), ratio2));
+    ratio1 = _mm_add_ps(_mm_set1_ps(0.0333333333f), _mm_mul_ps(_mm_mul_ps(ratio1, _mm_set1_ps(sqNotU - 9.0f)), versHalfTheta));
+    ratio1 = _mm_add_ps(_mm_set1_ps(-0.333333333f), _mm_mul_ps(_mm_mul_ps(ratio1, _mm_set1_ps(sqNotU - 4.0f)), versHalfTheta));
+    ratio1 = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(ratio1, _mm_set1_ps(sqNotU - 1.0f)), versHalfTheta));
+
+    ratio2 = _mm_add_ps(_mm_set1_ps(-0.00158730159f), _mm_mul_ps(_mm_set1_ps(sqU - 16.0f), ratio2));
+    ratio2 = _mm_add_ps(_mm_set1_ps(0.0333333333f), _mm_mul_ps(_mm_mul_ps(ratio2, _mm_set1_ps(sqU - 9.0f)), versHalfTheta));
+    ratio2 = _mm_add_ps(_mm_set1_ps(-0.333333333f), _mm_mul_ps(_mm_mul_ps(ratio2, _mm_set1_ps(sqU - 4.0f)), versHalfTheta));
+    ratio2 = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(ratio2, _mm_set1_ps(sqU - 1.0f)), versHalfTheta));
+
+    __m128 s1 = _mm_mul_ps(_mm_set1_ps(f1), _mm_mul_ps(ratio1, halfSecHalfTheta));
+    *alpha = _mm_mul_ps(a, _mm_add_ps(s1, _mm_mul_ps(_mm_set1_ps(f2a), ratio2)));
+    *beta = _mm_add_ps(s1, _mm_mul_ps(_mm_set1_ps(f2b), ratio2));
+}
+
+#if defined(GP_USE_AVX2) || defined(GP_DISPATCH_AVX2)
+
+GP_TARGET_AVX2 static void transformPointsAVX2(const float* m, const float* points, unsigned int count, float* dst)
+{
+    // Two points per iteration, one in each 128-bit lane.
+    __m256 c0 = _mm256_broadcast_ps((const __m128*)m);
+    __m256 c1 = _mm256_broadcast_ps((const __m128*)(m + 4));
+    __m256 c2 = _mm256_broadcast_ps((const __m128*)(m + 8));
+    __m256 c3 = _mm256_broadcast_ps((const __m128*)(m + 12));
+
+    unsigned int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        const float* p = points + i * 3;
+        __m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_broadcast_ss(p)), _mm_broadcast_ss(p + 3), 1);
+        __m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_broadcast_ss(p + 1)), _mm_broadcast_ss(p + 4), 1);
+        __m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_broadcast_ss(p + 2)), _mm_broadcast_ss(p + 5), 1);
+        __m256 r = _mm256_fmadd_ps(c0, x, _mm256_fmadd_ps(c1, y, _mm256_fmadd_ps(c2, z, c3)));
+
+        float* d = dst + i * 3;
+        __m128 lo = _mm256_castps256_ps128(r);
+        __m128 hi = _mm256_extractf128_ps(r, 1);
+        _mm_storel_pi((__m64*)d, lo);
+        _mm_store_ss(d + 2, _mm_movehl_ps(lo, lo));
+        _mm_storel_pi((__m64*)(d + 3), hi);
+        _mm_store_ss(d + 5, _mm_movehl_ps(hi, hi));
+    }
+    if (i < count)
+    {
+        const float* p = points + i * 3;
+        __m128 r = _mm_fmadd_ps(_mm256_castps256_ps128(c0), _mm_set1_ps(p[0]),
+            _mm_fmadd_ps(_mm256_castps256_ps128(c1), _mm_set1_ps(p[1]),
+            _mm_fmadd_ps(_mm256_castps256_ps128(c2), _mm_set1_ps(p[2]), _mm256_castps256_ps128(c3))));
+        float* d = dst + i * 3;
+        _mm_storel_pi((__m64*)d, r);
+        _mm_store_ss(d + 2, _mm_movehl_ps(r, r));
+    }
+}
+
+GP_TARGET_AVX2 static void normalizeQuaternionsAVX2(const float* q, unsigned int count, float* dst)
+{
+    // Two quaternions per iteration, one in each 128-bit lane.
+    unsigned int i = 0;
+    __m256 epsilon = _mm256_set1_ps(0.000001f);
+    for (; i + 2 <= count; i += 2)
+    {
+        __m256 v = _mm256_loadu_ps(q + i * 4);
+        __m256 n = _mm256_sqrt_ps(_mm256_dp_ps(v, v, 0xFF));
+        // Quaternions too close to zero are left as they are.
+        __m256 scale = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(_mm256_set1_ps(1.0f), n), _mm256_cmp_ps(n, epsilon, _CMP_GE_OQ));
+        _mm256_storeu_ps(dst + i * 4, _mm256_mul_ps(v, scale));
+    }
+    if (i < count)
+    {
+        ((const Quaternion*)q)[i].normalize((Quaternion*)dst + i);
+    }
+}
+
+GP_TARGET_AVX2 static void slerpQuaternionsAVX2(const float* q1, const float* q2, float t, unsigned int count, float* dst)
+{
+    // Eight pairs per iteration: each 128-bit lane transposes four quaternions to
+    // x, y, z and w registers, quaternions i..i+3 in the low lanes and i+4..i+7 in the high ones.
+    __m256 tmp0, tmp1, tmp2, tmp3;
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const float* a = q1 + i * 4;
+        const float* b = q2 + i * 4;
+        __m256 ax = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a)),      _mm_loadu_ps(a + 16), 1);
+        __m256 ay = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a + 4)),  _mm_loadu_ps(a + 20), 1);
+        __m256 az = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a + 8)),  _mm_loadu_ps(a + 24), 1);
+        __m256 aw = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a + 12)), _mm_loadu_ps(a + 28), 1);
+        __m256 bx = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(b)),      _mm_loadu_ps(b + 16), 1);
+        __m256 by = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(b + 4)),  _mm_loadu_ps(b + 20), 1);
+        __m256 bz = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(b + 8)),  _mm_loadu_ps(b + 24), 1);
+        __m256 bw = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(b + 12)), _mm_loadu_ps(b + 28), 1);
+        TRANSPOSE4_LANES(ax, ay, az, aw, _mm256_unpacklo_ps, _mm256_unpackhi_ps, _mm256_shuffle_ps);
+        TRANSPOSE4_LANES(bx, by, bz, bw, _mm256_unpacklo_ps, _mm256_unpackhi_ps, _mm256_shuffle_ps);
+
+        __m256 cosTheta = _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_fmadd_ps(az, bz, _mm256_mul_ps(aw, bw))));
+        __m128 alphaLo, betaLo, alphaHi, betaHi;
+        slerpCoefficients(_mm256_castps256_ps128(cosTheta), t, &alphaLo, &betaLo);
+        slerpCoefficients(_mm256_extractf128_ps(cosTheta, 1), t, &alphaHi, &betaHi);
+        __m256 alpha = _mm256_insertf128_ps(_mm256_castps128_ps256(alphaLo), alphaHi, 1);
+        __m256 beta = _mm256_insertf128_ps(_mm256_castps128_ps256(betaLo), betaHi, 1);
+
+        __m256 x = _mm256_fmadd_ps(alpha, ax, _mm256_mul_ps(beta, bx));
+        __m256 y = _mm256_fmadd_ps(alpha, ay, _mm256_mul_ps(beta, by));
+        __m256 z = _mm256_fmadd_ps(alpha, az, _mm256_mul_ps(beta, bz));
+        __m256 w = _mm256_fmadd_ps(alpha, aw, _mm256_mul_ps(beta, bw));
+
+        // Correct the length for small constraint errors in the inputs.
+        __m256 n = _mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_fmadd_ps(z, z, _mm256_mul_ps(w, w))));
+        __m256 f = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), n, _mm256_set1_ps(1.5f));
+        x = _mm256_mul_ps(x, f);
+        y = _mm256_mul_ps(y, f);
+        z = _mm256_mul_ps(z, f);
+        w = _mm256_mul_ps(w, f);
+
+        TRANSPOSE4_LANES(x, y, z, w, _mm256_unpacklo_ps, _mm256_unpackhi_ps, _mm256_shuffle_ps);
+        float* d = dst + i * 4;
+        _mm_storeu_ps(d,      _mm256_castps256_ps128(x));
+        _mm_storeu_ps(d + 4,  _mm256_castps256_ps128(y));
+        _mm_storeu_ps(d + 8,  _mm256_castps256_ps128(z));
+        _mm_storeu_ps(d + 12, _mm256_castps256_ps128(w));
+        _mm_storeu_ps(d + 16, _mm256_extractf128_ps(x, 1));
+        _mm_storeu_ps(d + 20, _mm256_extractf128_ps(y, 1));
+        _mm_storeu_ps(d + 24, _mm256_extractf128_ps(z, 1));
+        _mm_storeu_ps(d + 28, _mm256_extractf128_ps(w, 1));
+    }
+    for (; i < count; ++i)
+    {
+        Quaternion::slerp(((const Quaternion*)q1)[i], ((const Quaternion*)q2)[i], t, (Quaternion*)dst + i);
+    }
+}
+
+#endif
+
+#endif
+
+bool MathUtil::isAVX2Supported()
+{
+#if defined(GP_USE_AVX2)
+    return true;
+#elif defined(GP_DISPATCH_AVX2) && defined(_MSC_VER)
+    static const bool supported = []()
+    {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return supported;
+#elif defined(GP_DISPATCH_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+bool MathUtil::invertMatrix(const float* m, float* dst)
+{
+#ifdef GP_USE_SSE
+    // Invert the matrix as four 2x2 blocks. With c0..c3 its columns, the blocks are
+    // a = (c0.xy, c1.xy), b = (c2.xy, c3.xy), c = (c0.zw, c1.zw) and d = (c2.zw, c3.zw).
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+
+    __m128 a = _mm_movelh_ps(c0, c1);
+    __m128 b = _mm_movehl_ps(c1, c0);
+    __m128 c = _mm_movelh_ps(c2, c3);
+    __m128 d = _mm_movehl_ps(c3, c2);
+
+    // Determinants of the four blocks.
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 detB = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 detC = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 detD = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+    __m128 dc = adjMul2x2(d, c);
+    __m128 ab = adjMul2x2(a, b);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), mul2x2(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), mul2x2(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), mulAdj2x2(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), mulAdj2x2(a, dc));
+
+    // det = |a||d| + |b||c| - tr(adj(a)b adj(d)c)
+    __m128 tr = _mm_mul_ps(ab, _mm_shuffle_ps(dc, dc, _MM_SHUFFLE(3, 1, 2, 0)));
+    tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(2, 3, 0, 1)));
+    tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+    // Close to zero, can't invert.
+    if (fabs(_mm_cvtss_f32(det)) <= MATH_TOLERANCE)
+        return false;
+
+    __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+    x = _mm_mul_ps(x, invDet);
+    y = _mm_mul_ps(y, invDet);
+    z = _mm_mul_ps(z, invDet);
+    w = _mm_mul_ps(w, invDet);
+
+    // Take the adjugates of the blocks while storing them back as columns.
+    _mm_storeu_ps(dst,      _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(dst + 4,  _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(dst + 8,  _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(dst + 12, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+    return true;
+#else
+    float a0 = m[0] * m[5] - m[1] * m[4];
+    float a1 = m[0] * m[6] - m[2] * m[4];
+    float a2 = m[0] * m[7] - m[3] * m[4];
+    float a3 = m[1] * m[6] - m[2] * m[5];
+    float a4 = m[1] * m[7] - m[3] * m[5];
+    float a5 = m[2] * m[7] - m[3] * m[6];
+    float b0 = m[8] * m[13] - m[9] * m[12];
+    float b1 = m[8] * m[14] - m[10] * m[12];
+    float b2 = m[8] * m[15] - m[11] * m[12];
+    float b3 = m[9] * m[14] - m[10] * m[13];
+    float b4 = m[9] * m[15] - m[11] * m[13];
+    float b5 = m[10] * m[15] - m[11] * m[14];
+
+    // Calculate the determinant.
+    float det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0;
+
+    // Close to zero, can't invert.
+    if (fabs(det) <= MATH_TOLERANCE)
+        return false;
+
+    // Support the case where m == dst.
+    float inverse[16];
+    inverse[0]  = m[5] * b5 - m[6] * b4 + m[7] * b3;
+    inverse[1]  = -m[1] * b5 + m[2] * b4 - m[3] * b3;
+    inverse[2]  = m[13] * a5 - m[14] * a4 + m[15] * a3;
+    inverse[3]  = -m[9] * a5 + m[10] * a4 - m[11] * a3;
+
+    inverse[4]  = -m[4] * b5 + m[6] * b2 - m[7] * b1;
+    inverse[5]  = m[0] * b5 - m[2] * b2 + m[3] * b1;
+    inverse[6]  = -m[12] * a5 + m[14] * a2 - m[15] * a1;
+    inverse[7]  = m[8] * a5 - m[10] * a2 + m[11] * a1;
+
+    inverse[8]  = m[4] * b4 - m[5] * b2 + m[7] * b0;
+    inverse[9]  = -m[0] * b4 + m[1] * b2 - m[3] * b0;
+    inverse[10] = m[12] * a4 - m[13] * a2 + m[15] * a0;
+    inverse[11] = -m[8] * a4 + m[9] * a2 - m[11] * a0;
+
+    inverse[12] = -m[4] * b3 + m[5] * b1 - m[6] * b0;
+    inverse[13] = m[0] * b3 - m[1] * b1 + m[2] * b0;
+    inverse[14] = -m[12] * a3 + m[13] * a1 - m[14] * a0;
+    inverse[15] = m[8] * a3 - m[9] * a1 + m[10] * a0;
+
+    multiplyMatrix(inverse, 1.0f / det, dst);
+    return true;
+#endif
+}
+
+void MathUtil::transformPoints(const float* m, const float* points, unsigned int count, float* dst)
+{
+#if defined(GP_USE_AVX2)
+    transformPointsAVX2(m, points, count, dst);
+#else
+#ifdef GP_DISPATCH_AVX2
+    if (isAVX2Supported())
+    {
+        transformPointsAVX2(m, points, count, dst);
+        return;
+    }
+#endif
+    // Points are loaded before their result is stored, to support points being dst.
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const float* p = points + i * 3;
+        transformVector4(m, p[0], p[1], p[2], 1.0f, dst + i * 3);
+    }
+#endif
+}
+
+void MathUtil::normalizeQuaternions(const float* q, unsigned int count, float* dst)
+{
+#if defined(GP_USE_AVX2)
+    normalizeQuaternionsAVX2(q, count, dst);
+#else
+#ifdef GP_DISPATCH_AVX2
+    if (isAVX2Supported())
+    {
+        normalizeQuaternionsAVX2(q, count, dst);
+        return;
+    }
+#endif
+#ifdef GP_USE_SSE
+    __m128 epsilon = _mm_set1_ps(0.000001f);
+    __m128 one = _mm_set1_ps(1.0f);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        __m128 v = _mm_loadu_ps(q + i * 4);
+        __m128 n = _mm_mul_ps(v, v);
+        n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 3, 0, 1)));
+        n = _mm_sqrt_ps(_mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(1, 0, 3, 2))));
+        // Quaternions too close to zero are left as they are.
+        __m128 normalizable = _mm_cmpge_ps(n, epsilon);
+        __m128 scale = _mm_or_ps(_mm_and_ps(normalizable, _mm_div_ps(one, n)), _mm_andnot_ps(normalizable, one));
+        _mm_storeu_ps(dst + i * 4, _mm_mul_ps(v, scale));
+    }
+#else
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        ((const Quaternion*)q)[i].normalize((Quaternion*)dst + i);
+    }
+#endif
+#endif
+}
+
+void MathUtil::slerpQuaternions(const float* q1, const float* q2, float t, unsigned int count, float* dst)
+{
+    GP_ASSERT(!(t < 0.0f || t > 1.0f));
+
+    if (t == 0.0f || t == 1.0f)
+    {
+        memmove(dst, t == 0.0f ? q1 : q2, count * 4 * sizeof(float));
+        return;
+    }
+
+#if defined(GP_USE_AVX2)
+    slerpQuaternionsAVX2(q1, q2, t, count, dst);
+#else
+#ifdef GP_DISPATCH_AVX2
+    if (isAVX2Supported())
+    {
+        slerpQuaternionsAVX2(q1, q2, t, count, dst);
+        return;
+    }
+#endif
+    unsigned int i = 0;
+#ifdef GP_USE_SSE
+    // Four pairs per iteration, transposed to x, y, z and w registers.
+    __m128 tmp0, tmp1, tmp2, tmp3;
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* a = q1 + i * 4;
+        const float* b = q2 + i * 4;
+        __m128 ax = _mm_loadu_ps(a), ay = _mm_loadu_ps(a + 4), az = _mm_loadu_ps(a + 8), aw = _mm_loadu_ps(a + 12);
+        __m128 bx = _mm_loadu_ps(b), by = _mm_loadu_ps(b + 4), bz = _mm_loadu_ps(b + 8), bw = _mm_loadu_ps(b + 12);
+        TRANSPOSE4_LANES(ax, ay, az, aw, _mm_unpacklo_ps, _mm_unpackhi_ps, _mm_shuffle_ps);
+        TRANSPOSE4_LANES(bx, by, bz, bw, _mm_unpacklo_ps, _mm_unpackhi_ps, _mm_shuffle_ps);
+
+        __m128 cosTheta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        __m128 alpha, beta;
+        slerpCoefficients(cosTheta, t, &alpha, &beta);
+
+        __m128 x = _mm_add_ps(_mm_mul_ps(alpha, ax), _mm_mul_ps(beta, bx));
+        __m128 y = _mm_add_ps(_mm_mul_ps(alpha, ay), _mm_mul_ps(beta, by));
+        __m128 z = _mm_add_ps(_mm_mul_ps(alpha, az), _mm_mul_ps(beta, bz));
+        __m128 w = _mm_add_ps(_mm_mul_ps(alpha, aw), _mm_mul_ps(beta, bw));
+
+        // Correct the length for small constraint errors in the inputs.
+        __m128 n = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+        __m128 f = _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_set1_ps(0.5f), n));
+        x = _mm_mul_ps(x, f);
+        y = _mm_mul_ps(y, f);
+        z = _mm_mul_ps(z, f);
+        w = _mm_mul_ps(w, f);
+
+        TRANSPOSE4_LANES(x, y, z, w, _mm_unpacklo_ps, _mm_unpackhi_ps, _mm_shuffle_ps);
+        float* d = dst + i * 4;
+        _mm_storeu_ps(d,      x);
+        _mm_storeu_ps(d + 4,  y);
+        _mm_storeu_ps(d + 8,  z);
+        _mm_storeu_ps(d + 12, w);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        Quaternion::slerp(((const Quaternion*)q1)[i], ((const Quaternion*)q2)[i], t, (Quaternion*)dst + i);
+    }
+#endif
+}
+
 }
@@ -12,6 +12,8 @@ class MathUtil
 {
     friend class Matrix;
     friend class Vector3;
+    friend class Quaternion;
+    friend class Frustum;
 
 public:
 
@@ -44,6 +46,12 @@ public:
      */
     static void smooth(float* x, float target, float elapsedTime, float riseTime, float fallTime);
 
+    /**
+     * Returns whether the processor supports AVX2 and FMA, which the batch operations
+     * of Matrix and Quaternion use when it does.
+     */
+    static bool isAVX2Supported();
+
 private:
 
     inline static void addMatrix(const float* m, float scalar, float* dst);
@@ -66,6 +74,14 @@ private:
 
     inline static void crossVector3(const float* v1, const float* v2, float* dst);
 
+    static bool invertMatrix(const float* m, float* dst);
+
+    static void transformPoints(const float* m, const float* points, unsigned int count, float* dst);
+
+    static void normalizeQuaternions(const float* q, unsigned int count, float* dst);
+
+    static void slerpQuaternions(const float* q1, const float* q2, float t, unsigned int count, float* dst);
+
     MathUtil();
 };
 
@@ -73,8 +89,18 @@ private:
 
 #define MATRIX_SIZE ( sizeof(float) * 16)
 
+// Use the SSE backend on x86 processors with SSE2, which includes every x86-64 processor,
+// unless it is disabled with GP_NO_SSE. The backend only needs SSE2; the batch operations
+// also have an AVX2 variant, selected at runtime on processors supporting it.
+#if !defined(GP_USE_NEON) && !defined(GP_USE_SSE) && !defined(GP_NO_SSE) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GP_USE_SSE
+#endif
+
 #ifdef GP_USE_NEON
 #include "MathUtilNeon.inl"
+#elif defined(GP_USE_SSE)
+#include "MathUtilSSE.inl"
 #else
 #include "MathUtil.inl"
 #endif
@@ -0,0 +1,30 @@
+#ifndef MATHUTILSIMD_H_
+#define MATHUTILSIMD_H_
+
+#include "MathUtil.h"
+
+// Private to the math sources with AVX2 code paths; don't include it from public headers.
+//
+// With the SSE backend, batch operations have AVX2 variants, used directly when the compiler
+// targets AVX2 (GP_USE_AVX2), or compiled for AVX2 with GP_TARGET_AVX2 and selected at runtime
+// with MathUtil::isAVX2Supported() (GP_DISPATCH_AVX2).
+#ifdef GP_USE_SSE
+#if defined(__AVX2__) && defined(__FMA__)
+#define GP_USE_AVX2
+#include <immintrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GP_DISPATCH_AVX2
+#define GP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define GP_DISPATCH_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+#ifndef GP_TARGET_AVX2
+#define GP_TARGET_AVX2
+#endif
+
+#endif
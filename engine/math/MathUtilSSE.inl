@@ -0,0 +1,122 @@
+#include <emmintrin.h>
+
+namespace gameplay
+{
+
+inline void MathUtil::addMatrix(const float* m, float scalar, float* dst)
+{
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(dst,      _mm_add_ps(_mm_loadu_ps(m),      s));
+    _mm_storeu_ps(dst + 4,  _mm_add_ps(_mm_loadu_ps(m + 4),  s));
+    _mm_storeu_ps(dst + 8,  _mm_add_ps(_mm_loadu_ps(m + 8),  s));
+    _mm_storeu_ps(dst + 12, _mm_add_ps(_mm_loadu_ps(m + 12), s));
+}
+
+inline void MathUtil::addMatrix(const float* m1, const float* m2, float* dst)
+{
+    _mm_storeu_ps(dst,      _mm_add_ps(_mm_loadu_ps(m1),      _mm_loadu_ps(m2)));
+    _mm_storeu_ps(dst + 4,  _mm_add_ps(_mm_loadu_ps(m1 + 4),  _mm_loadu_ps(m2 + 4)));
+    _mm_storeu_ps(dst + 8,  _mm_add_ps(_mm_loadu_ps(m1 + 8),  _mm_loadu_ps(m2 + 8)));
+    _mm_storeu_ps(dst + 12, _mm_add_ps(_mm_loadu_ps(m1 + 12), _mm_loadu_ps(m2 + 12)));
+}
+
+inline void MathUtil::subtractMatrix(const float* m1, const float* m2, float* dst)
+{
+    _mm_storeu_ps(dst,      _mm_sub_ps(_mm_loadu_ps(m1),      _mm_loadu_ps(m2)));
+    _mm_storeu_ps(dst + 4,  _mm_sub_ps(_mm_loadu_ps(m1 + 4),  _mm_loadu_ps(m2 + 4)));
+    _mm_storeu_ps(dst + 8,  _mm_sub_ps(_mm_loadu_ps(m1 + 8),  _mm_loadu_ps(m2 + 8)));
+    _mm_storeu_ps(dst + 12, _mm_sub_ps(_mm_loadu_ps(m1 + 12), _mm_loadu_ps(m2 + 12)));
+}
+
+inline void MathUtil::multiplyMatrix(const float* m, float scalar, float* dst)
+{
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(dst,      _mm_mul_ps(_mm_loadu_ps(m),      s));
+    _mm_storeu_ps(dst + 4,  _mm_mul_ps(_mm_loadu_ps(m + 4),  s));
+    _mm_storeu_ps(dst + 8,  _mm_mul_ps(_mm_loadu_ps(m + 8),  s));
+    _mm_storeu_ps(dst + 12, _mm_mul_ps(_mm_loadu_ps(m + 12), s));
+}
+
+inline void MathUtil::multiplyMatrix(const float* m1, const float* m2, float* dst)
+{
+    // Each column of the product is the columns of m1 weighted by a column of m2.
+    // All columns are computed before storing, to support m1 or m2 being dst.
+    __m128 c0 = _mm_loadu_ps(m1);
+    __m128 c1 = _mm_loadu_ps(m1 + 4);
+    __m128 c2 = _mm_loadu_ps(m1 + 8);
+    __m128 c3 = _mm_loadu_ps(m1 + 12);
+
+    __m128 product[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        const float* c = m2 + i * 4;
+        __m128 p = _mm_mul_ps(c0, _mm_set1_ps(c[0]));
+        p = _mm_add_ps(p, _mm_mul_ps(c1, _mm_set1_ps(c[1])));
+        p = _mm_add_ps(p, _mm_mul_ps(c2, _mm_set1_ps(c[2])));
+        product[i] = _mm_add_ps(p, _mm_mul_ps(c3, _mm_set1_ps(c[3])));
+    }
+
+    _mm_storeu_ps(dst,      product[0]);
+    _mm_storeu_ps(dst + 4,  product[1]);
+    _mm_storeu_ps(dst + 8,  product[2]);
+    _mm_storeu_ps(dst + 12, product[3]);
+}
+
+inline void MathUtil::negateMatrix(const float* m, float* dst)
+{
+    __m128 sign = _mm_set1_ps(-0.0f);
+    _mm_storeu_ps(dst,      _mm_xor_ps(_mm_loadu_ps(m),      sign));
+    _mm_storeu_ps(dst + 4,  _mm_xor_ps(_mm_loadu_ps(m + 4),  sign));
+    _mm_storeu_ps(dst + 8,  _mm_xor_ps(_mm_loadu_ps(m + 8),  sign));
+    _mm_storeu_ps(dst + 12, _mm_xor_ps(_mm_loadu_ps(m + 12), sign));
+}
+
+inline void MathUtil::transposeMatrix(const float* m, float* dst)
+{
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(dst,      c0);
+    _mm_storeu_ps(dst + 4,  c1);
+    _mm_storeu_ps(dst + 8,  c2);
+    _mm_storeu_ps(dst + 12, c3);
+}
+
+inline void MathUtil::transformVector4(const float* m, float x, float y, float z, float w, float* dst)
+{
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(x));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4),  _mm_set1_ps(y)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8),  _mm_set1_ps(z)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(w)));
+
+    // dst only holds three components.
+    _mm_storel_pi((__m64*)dst, r);
+    _mm_store_ss(dst + 2, _mm_movehl_ps(r, r));
+}
+
+inline void MathUtil::transformVector4(const float* m, const float* v, float* dst)
+{
+    // Handle case where v == dst.
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4),  _mm_set1_ps(v[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8),  _mm_set1_ps(v[2])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3])));
+    _mm_storeu_ps(dst, r);
+}
+
+inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
+{
+    // Three component vectors can't be loaded without reading past them, and the
+    // shuffles would cost more than the scalar products.
+    float x = (v1[1] * v2[2]) - (v1[2] * v2[1]);
+    float y = (v1[2] * v2[0]) - (v1[0] * v2[2]);
+    float z = (v1[0] * v2[1]) - (v1[1] * v2[0]);
+
+    dst[0] = x;
+    dst[1] = y;
+    dst[2] = z;
+}
+
+}
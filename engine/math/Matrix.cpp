@@ -655,51 +655,8 @@ bool Matrix::invert()
 
 bool Matrix::invert(Matrix* dst) const
 {
-    float a0 = m[0] * m[5] - m[1] * m[4];
-    float a1 = m[0] * m[6] - m[2] * m[4];
-    float a2 = m[0] * m[7] - m[3] * m[4];
-    float a3 = m[1] * m[6] - m[2] * m[5];
-    float a4 = m[1] * m[7] - m[3] * m[5];
-    float a5 = m[2] * m[7] - m[3] * m[6];
-    float b0 = m[8] * m[13] - m[9] * m[12];
-    float b1 = m[8] * m[14] - m[10] * m[12];
-    float b2 = m[8] * m[15] - m[11] * m[12];
-    float b3 = m[9] * m[14] - m[10] * m[13];
-    float b4 = m[9] * m[15] - m[11] * m[13];
-    float b5 = m[10] * m[15] - m[11] * m[14];
-
-    // Calculate the determinant.
-    float det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0;
-
-    // Close to zero, can't invert.
-    if (fabs(det) <= MATH_TOLERANCE)
-        return false;
-
-    // Support the case where m == dst.
-    Matrix inverse;
-    inverse.m[0]  = m[5] * b5 - m[6] * b4 + m[7] * b3;
-    inverse.m[1]  = -m[1] * b5 + m[2] * b4 - m[3] * b3;
-    inverse.m[2]  = m[13] * a5 - m[14] * a4 + m[15] * a3;
-    inverse.m[3]  = -m[9] * a5 + m[10] * a4 - m[11] * a3;
-
-    inverse.m[4]  = -m[4] * b5 + m[6] * b2 - m[7] * b1;
-    inverse.m[5]  = m[0] * b5 - m[2] * b2 + m[3] * b1;
-    inverse.m[6]  = -m[12] * a5 + m[14] * a2 - m[15] * a1;
-    inverse.m[7]  = m[8] * a5 - m[10] * a2 + m[11] * a1;
-
-    inverse.m[8]  = m[4] * b4 - m[5] * b2 + m[7] * b0;
-    inverse.m[9]  = -m[0] * b4 + m[1] * b2 - m[3] * b0;
-    inverse.m[10] = m[12] * a4 - m[13] * a2 + m[15] * a0;
-    inverse.m[11] = -m[8] * a4 + m[9] * a2 - m[11] * a0;
-
-    inverse.m[12] = -m[4] * b3 + m[5] * b1 - m[6] * b0;
-    inverse.m[13] = m[0] * b3 - m[1] * b1 + m[2] * b0;
-    inverse.m[14] = -m[12] * a3 + m[13] * a1 - m[14] * a0;
-    inverse.m[15] = m[8] * a3 - m[9] * a1 + m[10] * a0;
-
-    multiply(inverse, 1.0f / det, dst);
-
-    return true;
+    GP_ASSERT(dst);
+    return MathUtil::invertMatrix(m, dst->m);
 }
 
 bool Matrix::isIdentity() const
@@ -905,6 +862,13 @@ void Matrix::transformPoint(const Vector3& point, Vector3* dst) const
     transformVector(point.x, point.y, point.z, 1.0f, dst);
 }
 
+void Matrix::transformPoints(const Vector3* points, unsigned int count, Vector3* dst) const
+{
+    GP_ASSERT(points || count == 0);
+    GP_ASSERT(dst || count == 0);
+    MathUtil::transformPoints(m, (const float*)points, count, (float*)dst);
+}
+
 void Matrix::transformVector(Vector3* vector) const
 {
     GP_ASSERT(vector);
@@ -762,6 +762,18 @@ public:
      */
     void transformPoint(const Vector3& point, Vector3* dst) const;
 
+    /**
+     * Transforms an array of points by this matrix, and stores the results in dst.
+     *
+     * This is faster than transforming the points one at a time, and uses the
+     * widest vector instructions supported by the processor.
+     *
+     * @param points The points to transform.
+     * @param count The number of points.
+     * @param dst An array of count points to store the transformed points in (may be points).
+     */
+    void transformPoints(const Vector3* points, unsigned int count, Vector3* dst) const;
+
     /**
      * Transforms the specified vector by this matrix by
      * treating the fourth (w) coordinate as zero.
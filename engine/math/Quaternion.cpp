@@ -1,5 +1,6 @@
 #include "base/Base.h"
 #include "Quaternion.h"
+#include "MathUtil.h"
 
 namespace gameplay
 {
@@ -215,6 +216,12 @@ void Quaternion::normalize(Quaternion* dst) const
     dst->w *= n;
 }
 
+void Quaternion::normalize(const Quaternion* quaternions, unsigned int count, Quaternion* dst)
+{
+    GP_ASSERT((quaternions && dst) || count == 0);
+    MathUtil::normalizeQuaternions((const float*)quaternions, count, (float*)dst);
+}
+
 void Quaternion::rotatePoint(const Vector3& point, Vector3* dst) const
 {
 	Quaternion vecQuat;
@@ -321,6 +328,12 @@ void Quaternion::slerp(const Quaternion& q1, const Quaternion& q2, float t, Quat
     slerp(q1.x, q1.y, q1.z, q1.w, q2.x, q2.y, q2.z, q2.w, t, &dst->x, &dst->y, &dst->z, &dst->w);
 }
 
+void Quaternion::slerp(const Quaternion* q1, const Quaternion* q2, float t, unsigned int count, Quaternion* dst)
+{
+    GP_ASSERT((q1 && q2 && dst) || count == 0);
+    MathUtil::slerpQuaternions((const float*)q1, (const float*)q2, t, count, (float*)dst);
+}
+
 void Quaternion::squad(const Quaternion& q1, const Quaternion& q2, const Quaternion& s1, const Quaternion& s2, float t, Quaternion* dst)
 {
     GP_ASSERT(!(t < 0.0f || t > 1.0f));
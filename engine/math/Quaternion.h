@@ -252,6 +252,17 @@ public:
      */
     void normalize(Quaternion* dst) const;
 
+    /**
+     * Normalizes an array of quaternions and stores the results in dst.
+     *
+     * Quaternions with a length of zero are copied as they are.
+     *
+     * @param quaternions The quaternions to normalize.
+     * @param count The number of quaternions.
+     * @param dst An array of count quaternions to store the results in (may be quaternions).
+     */
+    static void normalize(const Quaternion* quaternions, unsigned int count, Quaternion* dst);
+
 	/**
 	* Rotate the specified point by this quaternion
 	* and stores the result in dst
@@ -346,6 +357,20 @@ public:
      * @param dst A quaternion to store the result in.
      */
     static void slerp(const Quaternion& q1, const Quaternion& q2, float t, Quaternion* dst);
+
+    /**
+     * Interpolates between the quaternions of two arrays using spherical linear interpolation.
+     *
+     * The quaternions of each pair are interpolated as with slerp(const Quaternion&, const Quaternion&, float, Quaternion*),
+     * several pairs at a time, so this is faster than interpolating them one at a time.
+     *
+     * @param q1 The first quaternions.
+     * @param q2 The second quaternions.
+     * @param t The interpolation coefficient, shared by all pairs.
+     * @param count The number of quaternions in each array.
+     * @param dst An array of count quaternions to store the results in (may be q1 or q2).
+     */
+    static void slerp(const Quaternion* q1, const Quaternion* q2, float t, unsigned int count, Quaternion* dst);
     
     /**
      * Interpolates over a series of quaternions using spherical spline interpolation.
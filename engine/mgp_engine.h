@@ -13,6 +13,7 @@
 #include "base/SerializerJson.h"
 #include "base/SerializerBinary.h"
 #include "base/Serializable.h"
+#include "base/ThreadPool.h"
 
 
 // Math
@@ -36,6 +37,7 @@
 #include "scene/Mesh.h"
 #include "scene/MeshPart.h"
 #include "material/ShaderProgram.h"
+#include "material/UniformBuffer.h"
 #include "material/Material.h"
 #include "scene/VertexFormat.h"
 #include "material/VertexAttributeBinding.h"
@@ -46,8 +48,17 @@
 #include "scene/Node.h"
 #include "scene/BoneJoint.h"
 #include "scene/Scene.h"
+#include "scene/SceneSnapshot.h"
+#include "scene/Occluder.h"
+#include "scene/OcclusionCuller.h"
+#include "scene/LightGrid.h"
+#include "scene/ShadowMap.h"
+#include "scene/MeshSimplifier.h"
+#include "scene/MeshOptimizer.h"
+#include "scene/LodGroup.h"
 #include "ui/Font.h"
 #include "objects/SpriteBatch.h"
+#include "objects/MergedSpriteBatch.h"
 #include "objects/Sprite.h"
 #include "ui/Text.h"
 #include "objects/TileSet.h"
@@ -0,0 +1,190 @@
+#include "base/Base.h"
+#include "MergedSpriteBatch.h"
+#include "platform/Toolkit.h"
+#include "material/Material.h"
+#include "material/MaterialParameter.h"
+
+// Default size of a draw call of a newly created merged sprite batch
+#define MERGED_BATCH_DEFAULT_SIZE 256
+
+// Merged sprite shaders
+#define MERGED_SPRITE_VSH "res/shaders/sprite-merged.vert"
+#define MERGED_SPRITE_FSH "res/shaders/sprite-merged.frag"
+
+namespace gameplay
+{
+
+MergedSpriteBatch::MergedSpriteBatch()
+    : _effect(NULL), _initialCapacity(0), _current(-1), _started(false), _drawCallCount(0)
+{
+}
+
+MergedSpriteBatch::~MergedSpriteBatch()
+{
+    for (size_t i = 0, count = _segments.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_segments[i]->batch);
+        SAFE_DELETE(_segments[i]);
+    }
+    _segments.clear();
+    SAFE_RELEASE(_effect);
+}
+
+MergedSpriteBatch* MergedSpriteBatch::create(unsigned int initialCapacity)
+{
+    ShaderProgram* effect = ShaderProgram::createFromFile(MERGED_SPRITE_VSH, MERGED_SPRITE_FSH);
+    if (effect == NULL)
+    {
+        GP_ERROR("Unable to load merged sprite effect.");
+        return NULL;
+    }
+
+    MergedSpriteBatch* batch = new MergedSpriteBatch();
+    batch->_effect = effect;
+    batch->_initialCapacity = initialCapacity > 0 ? initialCapacity : MERGED_BATCH_DEFAULT_SIZE;
+
+    Toolkit* game = Toolkit::cur();
+    Matrix::createOrthographicOffCenter(0, game->getViewport().width, game->getViewport().height, 0, 0, 1, &batch->_projectionMatrix);
+
+    return batch;
+}
+
+void MergedSpriteBatch::start()
+{
+    // Draw calls are started as sprites come in.
+    _current = -1;
+    _started = true;
+}
+
+bool MergedSpriteBatch::isStarted() const
+{
+    return _started;
+}
+
+void MergedSpriteBatch::finish()
+{
+    _drawCallCount = 0;
+    for (size_t i = 0, count = _segments.size(); i < count; ++i)
+    {
+        Segment* segment = _segments[i];
+        if (!segment->batch->isStarted())
+            continue;
+
+        if (segment->textureCount > 0)
+            segment->batch->getMaterial()->getParameter("u_textures")->setSamplerArray(segment->textures, segment->textureCount, true);
+
+        segment->batch->finish();
+        segment->batch->draw();
+        ++_drawCallCount;
+    }
+    _started = false;
+}
+
+void MergedSpriteBatch::setProjectionMatrix(const Matrix& matrix)
+{
+    _projectionMatrix = matrix;
+}
+
+const Matrix& MergedSpriteBatch::getProjectionMatrix() const
+{
+    return _projectionMatrix;
+}
+
+void MergedSpriteBatch::getMeshBatches(std::vector<MeshBatch*>* batches) const
+{
+    GP_ASSERT(batches);
+    for (size_t i = 0, count = _segments.size(); i < count; ++i)
+        batches->push_back(_segments[i]->batch);
+}
+
+unsigned int MergedSpriteBatch::getDrawCallCount() const
+{
+    return _drawCallCount;
+}
+
+void MergedSpriteBatch::addSprites(SpriteBatch* batch, const SpriteBatch::SpriteVertex* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
+{
+    GP_ASSERT(batch);
+    GP_ASSERT(vertices);
+
+    // Find the texture in the current draw call, or give it a free slot.
+    const Texture* texture = batch->getSampler();
+    Segment* segment = _current >= 0 ? _segments[_current] : NULL;
+    int slot = -1;
+    if (segment && segment->batch->_vertexCount + vertexCount <= USHRT_MAX)
+    {
+        for (unsigned int i = 0; i < segment->textureCount; ++i)
+        {
+            if (segment->textures[i] == texture)
+            {
+                slot = (int)i;
+                break;
+            }
+        }
+        if (slot < 0 && segment->textureCount < MAX_TEXTURES)
+        {
+            slot = (int)segment->textureCount++;
+            segment->textures[slot] = texture;
+        }
+    }
+
+    // Go on with a new draw call when the textures or 16-bit indices run out.
+    if (slot < 0)
+    {
+        segment = nextSegment();
+        slot = 0;
+        segment->textures[0] = texture;
+        segment->textureCount = 1;
+    }
+
+    if (_vertices.size() < vertexCount)
+        _vertices.resize(vertexCount);
+
+    const float textureIndex = (float)slot;
+    const float sampleMode = (float)batch->getSampleMode();
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        Vertex& vertex = _vertices[i];
+        vertex.sprite = vertices[i];
+        vertex.textureIndex = textureIndex;
+        vertex.sampleMode = sampleMode;
+    }
+
+    segment->batch->add(&_vertices[0], vertexCount, indices, indexCount);
+}
+
+MergedSpriteBatch::Segment* MergedSpriteBatch::nextSegment()
+{
+    ++_current;
+    if (_current == (int)_segments.size())
+    {
+        Material* material = Material::create(_effect);
+        material->getStateBlock()->setBlend(true);
+        material->getStateBlock()->setBlendSrc(StateBlock::BLEND_SRC_ALPHA);
+        material->getStateBlock()->setBlendDst(StateBlock::BLEND_ONE_MINUS_SRC_ALPHA);
+        material->getParameter("u_projectionMatrix")->bindValue(this, &MergedSpriteBatch::getProjectionMatrix);
+
+        // The texture index and sample mode go in the second texture coordinates.
+        VertexFormat::Element vertexElements[] =
+        {
+            VertexFormat::Element(VertexFormat::POSITION, 3),
+            VertexFormat::Element(VertexFormat::TEXCOORD0, 2),
+            VertexFormat::Element(VertexFormat::COLOR, 4),
+            VertexFormat::Element(VertexFormat::TEXCOORD1, 2)
+        };
+        VertexFormat vertexFormat(vertexElements, 4);
+
+        Segment* segment = new Segment();
+        segment->batch = MeshBatch::create(vertexFormat, Mesh::TRIANGLE_STRIP, material, true, _initialCapacity);
+        segment->textureCount = 0;
+        material->release();
+        _segments.push_back(segment);
+    }
+
+    Segment* segment = _segments[_current];
+    segment->textureCount = 0;
+    segment->batch->start();
+    return segment;
+}
+
+}
@@ -0,0 +1,145 @@
+#ifndef MERGEDSPRITEBATCH_H_
+#define MERGEDSPRITEBATCH_H_
+
+#include "SpriteBatch.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a batch drawing the sprites of many sprite batches, with different textures, together.
+ *
+ * Set as the sink of all sprite batches (see SpriteBatch::setSink), it receives their sprites in
+ * the order they are drawn and puts them in a single vertex stream, along with the index of their
+ * texture in an array of up to MAX_TEXTURES samplers and their sample mode. Sprites are drawn in
+ * one draw call as long as they use at most MAX_TEXTURES textures; each time more are needed the
+ * batch goes on with a new draw call, so the drawing order is always kept.
+ *
+ * The sprites are drawn with the blending of the default sprite effect. The state blocks and
+ * materials of the sprite batches whose sprites are merged are not used.
+ */
+class MergedSpriteBatch : public BatchableLayer, public SpriteSink
+{
+public:
+
+    /**
+     * The number of textures a single draw call can sample.
+     */
+    static const unsigned int MAX_TEXTURES = 8;
+
+    /**
+     * Creates a new merged sprite batch.
+     *
+     * @param initialCapacity An optional initial capacity of each draw call (number of sprites).
+     *
+     * @return The new merged sprite batch, or NULL if its effect failed to load.
+     */
+    static MergedSpriteBatch* create(unsigned int initialCapacity = 0);
+
+    /**
+     * Destructor.
+     */
+    virtual ~MergedSpriteBatch();
+
+    /**
+     * Starts merging sprites.
+     */
+    void start();
+
+    /**
+     * Determines if the batch has been started but not yet finished.
+     *
+     * @return True if the batch has been started and not finished.
+     */
+    bool isStarted() const;
+
+    /**
+     * Finishes merging sprites and draws them.
+     */
+    void finish();
+
+    /**
+     * Sets the projection matrix to draw the sprites with.
+     *
+     * @param matrix The projection matrix.
+     */
+    void setProjectionMatrix(const Matrix& matrix);
+
+    /**
+     * Returns the projection matrix to draw the sprites with.
+     *
+     * @return The projection matrix.
+     */
+    const Matrix& getProjectionMatrix() const;
+
+    /**
+     * Adds the mesh batches of the draw calls to a list.
+     *
+     * @param batches The list to add the mesh batches to.
+     */
+    void getMeshBatches(std::vector<MeshBatch*>* batches) const;
+
+    /**
+     * Returns the number of draw calls made by the last call to finish().
+     *
+     * @return The number of draw calls.
+     */
+    unsigned int getDrawCallCount() const;
+
+    /**
+     * @see SpriteSink::addSprites
+     */
+    void addSprites(SpriteBatch* batch, const SpriteBatch::SpriteVertex* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount);
+
+private:
+
+    /**
+     * A draw call, and the textures it samples.
+     */
+    struct Segment
+    {
+        MeshBatch* batch;
+        const Texture* textures[MAX_TEXTURES];
+        unsigned int textureCount;
+    };
+
+    /**
+     * Sprite vertex with the texture index and sample mode of the sprite.
+     */
+    struct Vertex
+    {
+        SpriteBatch::SpriteVertex sprite;
+        float textureIndex;
+        float sampleMode;
+    };
+
+    /**
+     * Constructor.
+     */
+    MergedSpriteBatch();
+
+    /**
+     * Hidden copy constructor.
+     */
+    MergedSpriteBatch(const MergedSpriteBatch& copy);
+
+    /**
+     * Starts the next draw call, creating it if needed.
+     *
+     * @return The draw call.
+     */
+    Segment* nextSegment();
+
+    ShaderProgram* _effect;
+    unsigned int _initialCapacity;
+    std::vector<Segment*> _segments;
+    int _current;
+    bool _started;
+    unsigned int _drawCallCount;
+    std::vector<Vertex> _vertices;
+    Matrix _projectionMatrix;
+};
+
+}
+
+#endif
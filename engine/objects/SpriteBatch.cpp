@@ -24,9 +24,10 @@ namespace gameplay
 {
 
 static ShaderProgram* __spriteEffect = NULL;
+static SpriteSink* __spriteSink = NULL;
 
 SpriteBatch::SpriteBatch()
-    : _batch(NULL), _sampler(NULL), _textureWidthRatio(0.0f), _textureHeightRatio(0.0f)
+    : _batch(NULL), _sampler(NULL), _customEffect(false), _mergeable(false), _sampleMode(SAMPLE_COLOR), _textureWidthRatio(0.0f), _textureHeightRatio(0.0f)
 {
 }
 
@@ -130,6 +131,7 @@ SpriteBatch* SpriteBatch::create(Texture* texture, ShaderProgram* effect, unsign
     texture->addRef();
     batch->_sampler = texture;
     batch->_customEffect = customEffect;
+    batch->_mergeable = !customEffect;
     batch->_batch = meshBatch;
     batch->_textureWidthRatio = 1.0f / (float)texture->getWidth();
     batch->_textureHeightRatio = 1.0f / (float)texture->getHeight();
@@ -234,7 +236,7 @@ void SpriteBatch::draw(float x, float y, float z, float width, float height, flo
     
     static unsigned short indices[4] = { 0, 1, 2, 3 };
 
-    _batch->add(v, 4, indices, 4);
+    addVertices(v, 4, indices, 4);
 }
 
 void SpriteBatch::draw(const Vector3& position, const Vector3& right, const Vector3& forward, float width, float height,
@@ -299,7 +301,7 @@ void SpriteBatch::draw(const Vector3& position, const Vector3& right, const Vect
     SPRITE_ADD_VERTEX(v[3], p3.x, p3.y, p3.z, u2, v2, color.x, color.y, color.z, color.w);
     
     static const unsigned short indices[4] = { 0, 1, 2, 3 };
-    _batch->add(v, 4, const_cast<unsigned short*>(indices), 4);
+    addVertices(v, 4, indices, 4);
 }
 
 void SpriteBatch::draw(float x, float y, float width, float height, float u1, float v1, float u2, float v2, const Vector4& color)
@@ -354,7 +356,15 @@ void SpriteBatch::draw(SpriteBatch::SpriteVertex* vertices, unsigned int vertexC
     GP_ASSERT(vertices);
     GP_ASSERT(indices);
 
-    _batch->add(vertices, vertexCount, indices, indexCount);
+    addVertices(vertices, vertexCount, indices, indexCount);
+}
+
+void SpriteBatch::addVertices(const SpriteVertex* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
+{
+    if (__spriteSink && _mergeable)
+        __spriteSink->addSprites(this, vertices, vertexCount, indices, indexCount);
+    else
+        _batch->add(vertices, vertexCount, indices, indexCount);
 }
 
 void SpriteBatch::draw(float x, float y, float z, float width, float height, float u1, float v1, float u2, float v2, const Vector4& color, bool positionIsCenter)
@@ -377,7 +387,7 @@ void SpriteBatch::draw(float x, float y, float z, float width, float height, flo
 
     static unsigned short indices[4] = { 0, 1, 2, 3 };
 
-    _batch->add(v, 4, indices, 4);
+    addVertices(v, 4, indices, 4);
 }
 
 void SpriteBatch::finish()
@@ -412,6 +422,33 @@ const Matrix& SpriteBatch::getProjectionMatrix() const
     return _projectionMatrix;
 }
 
+void SpriteBatch::getMeshBatches(std::vector<MeshBatch*>* batches) const
+{
+    GP_ASSERT(batches);
+    batches->push_back(_batch);
+}
+
+void SpriteBatch::setSampleMode(SampleMode mode)
+{
+    _sampleMode = mode;
+    _mergeable = true;
+}
+
+SpriteBatch::SampleMode SpriteBatch::getSampleMode() const
+{
+    return _sampleMode;
+}
+
+void SpriteBatch::setSink(SpriteSink* sink)
+{
+    __spriteSink = sink;
+}
+
+SpriteSink* SpriteBatch::getSink()
+{
+    return __spriteSink;
+}
+
 bool SpriteBatch::clipSprite(const Rectangle& clip, float& x, float& y, float& width, float& height, float& u1, float& v1, float& u2, float& v2)
 {
     // Clip the rectangle given by { x, y, width, height } into clip.
@@ -20,9 +20,12 @@ public:
     virtual void finish() = 0;
     virtual void setProjectionMatrix(const Matrix& matrix) = 0;
     virtual bool isStarted() const = 0;
+    virtual void getMeshBatches(std::vector<MeshBatch*>* batches) const = 0;
     virtual ~BatchableLayer() {}
 };
 
+class SpriteSink;
+
 /**
  * Defines a class for drawing groups of sprites.
  *
@@ -41,6 +44,20 @@ class SpriteBatch : public BatchableLayer
 
 public:
 
+    /**
+     * Defines how the texture of a sprite batch is sampled when its sprites are merged into
+     * a single stream by a SpriteSink.
+     */
+    enum SampleMode
+    {
+        /** The texture color is multiplied by the sprite color, as done by the default effect. */
+        SAMPLE_COLOR,
+        /** The texture alpha is multiplied by the sprite alpha, as done by the font effect. */
+        SAMPLE_ALPHA,
+        /** The texture alpha is a distance field, as done by the distance field font effect. */
+        SAMPLE_DISTANCE_FIELD
+    };
+
     /**
      * Creates a new SpriteBatch for drawing sprites with the given texture.
      *
@@ -364,6 +381,49 @@ public:
      */
     const Matrix& getProjectionMatrix() const;
 
+    /**
+     * Adds the mesh batch drawing the sprites to a list.
+     *
+     * @param batches The list to add the mesh batch to.
+     */
+    void getMeshBatches(std::vector<MeshBatch*>* batches) const;
+
+    /**
+     * Sets how a sprite sink samples the texture of this batch.
+     *
+     * Batches using the default effect sample in SAMPLE_COLOR mode. Batches using a custom
+     * effect are only merged by a sprite sink once their sample mode has been set, which
+     * declares that the sink may draw their sprites in place of their effect.
+     *
+     * @param mode The sample mode.
+     */
+    void setSampleMode(SampleMode mode);
+
+    /**
+     * Returns how a sprite sink samples the texture of this batch.
+     *
+     * @return The sample mode.
+     */
+    SampleMode getSampleMode() const;
+
+    /**
+     * Sets a sink receiving the sprites drawn by all sprite batches, instead of their own mesh batches.
+     *
+     * This lets sprites of batches with different textures be drawn together, in the order
+     * they were drawn. Batches using a custom effect without a sample mode still draw their
+     * own sprites.
+     *
+     * @param sink The sink, or NULL to have sprite batches draw their own sprites again.
+     */
+    static void setSink(SpriteSink* sink);
+
+    /**
+     * Returns the sink receiving the sprites drawn by all sprite batches.
+     *
+     * @return The sink, or NULL if sprite batches draw their own sprites.
+     */
+    static SpriteSink* getSink();
+
 private:
 
     /**
@@ -413,14 +473,47 @@ private:
 
     bool clipSprite(const Rectangle& clip, float& x, float& y, float& width, float& height, float& u1, float& v1, float& u2, float& v2);
 
+    /**
+     * Adds vertices to the mesh batch, or to the sprite sink when one is set.
+     */
+    void addVertices(const SpriteVertex* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount);
+
     MeshBatch* _batch;
     Texture* _sampler;
     bool _customEffect;
+    bool _mergeable;
+    SampleMode _sampleMode;
     float _textureWidthRatio;
     float _textureHeightRatio;
     mutable Matrix _projectionMatrix;
 };
 
+/**
+ * Defines an interface for receiving the sprites drawn by sprite batches.
+ *
+ * @see SpriteBatch::setSink
+ */
+class SpriteSink
+{
+public:
+
+    /**
+     * Destructor.
+     */
+    virtual ~SpriteSink() {}
+
+    /**
+     * Adds sprites drawn by a sprite batch.
+     *
+     * @param batch The sprite batch drawing the sprites, which provides their texture and sample mode.
+     * @param vertices The sprite vertices.
+     * @param vertexCount The number of vertices.
+     * @param indices The triangle strip indices.
+     * @param indexCount The number of indices.
+     */
+    virtual void addSprites(SpriteBatch* batch, const SpriteBatch::SpriteVertex* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount) = 0;
+};
+
 }
 
 #endif
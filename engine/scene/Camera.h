@@ -21,6 +21,7 @@ class NodeCloneContext;
 class Camera : public Serializable, public Component, public Transform::Listener, public Ref
 {
     friend class Node;
+    friend class SceneSnapshot;
 
 public:
 
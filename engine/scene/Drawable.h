@@ -9,14 +9,26 @@ namespace gameplay
 class Node;
 class NodeCloneContext;
 class Light;
+class LightGrid;
+class ShadowMap;
+class Material;
 
 
 class RenderView {
 public:
     bool wireframe = false;
     std::vector<Light*> lights;
+    LightGrid* lightGrid = NULL;
+    std::vector<ShadowMap*> shadowMaps;
     Camera* camera = NULL;
+    // The camera selecting levels of detail when not camera, such as the main camera in shadow passes.
+    Camera* lodCamera = NULL;
     Rectangle viewport;
+    // Materials drawing models in place of their own, such as the depth-only materials of shadow passes.
+    // The skinned one draws models whose skin has up to overrideJointCount joints; larger skins keep their own.
+    Material* overrideMaterial = NULL;
+    Material* overrideSkinnedMaterial = NULL;
+    unsigned int overrideJointCount = 0;
 };
 
 /**
@@ -228,6 +228,16 @@ void Light::setColor(float red, float green, float blue)
     setColor(Vector3(red, green, blue));
 }
 
+float Light::getIntensity() const
+{
+    return _intensity;
+}
+
+void Light::setIntensity(float intensity)
+{
+    _intensity = intensity;
+}
+
 float Light::getRange()  const
 {
     GP_ASSERT(_type != DIRECTIONAL);
@@ -336,6 +346,48 @@ float Light::getOuterAngleCos()  const
     return _spot->outerAngleCos;
 }
 
+bool Light::getBoundingSphere(BoundingSphere* dst) const
+{
+    GP_ASSERT(dst);
+
+    switch (_type)
+    {
+    case POINT:
+        dst->set(Vector3::zero(), _point->range);
+        return true;
+    case SPOT:
+    {
+        // A wide cone is bounded by the sphere through the rim of its cap, a narrow one
+        // by the sphere through its apex and rim.
+        float range = _spot->range;
+        float cosAngle = _spot->outerAngleCos;
+        if (_spot->outerAngle > MATH_PIOVER4)
+        {
+            dst->set(Vector3(0.0f, 0.0f, -range * cosAngle), range * sinf(_spot->outerAngle));
+        }
+        else
+        {
+            float radius = range / (2.0f * cosAngle);
+            dst->set(Vector3(0.0f, 0.0f, -radius), radius);
+        }
+        return true;
+    }
+    default:
+        dst->set(Vector3::zero(), 0.0f);
+        return false;
+    }
+}
+
+Light::Shadows Light::getShadows() const
+{
+    return _shadows;
+}
+
+void Light::setShadows(Shadows shadows)
+{
+    _shadows = shadows;
+}
+
 Light* Light::clone(NodeCloneContext &context)
 {
     Light* lightClone = NULL;
@@ -355,6 +407,9 @@ Light* Light::clone(NodeCloneContext &context)
         return NULL;
     }
     GP_ASSERT(lightClone);
+    lightClone->_lighting = _lighting;
+    lightClone->_shadows = _shadows;
+    lightClone->_intensity = _intensity;
 
     if (Node* node = context.findClonedNode(getNode()))
     {
@@ -3,6 +3,7 @@
 
 #include "base/Ref.h"
 #include "math/Vector3.h"
+#include "math/BoundingSphere.h"
 #include "base/Properties.h"
 #include "base/Serializable.h"
 #include "scene/Component.h"
@@ -22,6 +23,7 @@ class NodeCloneContext;
 class Light : public Serializable, public Component, public Ref
 {
     friend class Node;
+    friend class SceneSnapshot;
 
 public:
 
@@ -181,6 +183,20 @@ public:
      */
     void setColor(float red, float green, float blue);
 
+    /**
+     * Gets the light intensity, which scales its color.
+     *
+     * @return The light intensity.
+     */
+    float getIntensity() const;
+
+    /**
+     * Sets the light intensity, which scales its color.
+     *
+     * @param intensity The light intensity to set.
+     */
+    void setIntensity(float intensity);
+
     /**
      * Returns the node associated with this light.
      * 
@@ -251,6 +267,35 @@ public:
      */
     float getOuterAngleCos() const;
 
+    /**
+     * Returns the volume lit by the light, in the local space of its node.
+     *
+     * Spot lights shine down the negative z-axis of their node, and are bounded by the
+     * smallest sphere around their cone.
+     *
+     * @param dst The sphere. Empty for directional lights, which have no bounds.
+     *
+     * @return False for directional lights, true otherwise.
+     */
+    bool getBoundingSphere(BoundingSphere* dst) const;
+
+    /**
+     * Returns the shadows cast by the light.
+     *
+     * @return The shadows.
+     */
+    Shadows getShadows() const;
+
+    /**
+     * Sets the shadows cast by the light.
+     *
+     * Directional lights cast cascaded shadow maps, spot lights a single shadow map.
+     * Point lights don't cast shadows.
+     *
+     * @param shadows The shadows.
+     */
+    void setShadows(Shadows shadows);
+
 
 
 public:
@@ -0,0 +1,308 @@
+#include "base/Base.h"
+#include "LightGrid.h"
+#include "Camera.h"
+#include "Light.h"
+#include "Node.h"
+#include "base/ThreadPool.h"
+#include <cfloat>
+
+namespace gameplay
+{
+
+LightGrid::LightGrid(unsigned int tileCountX, unsigned int tileCountY, unsigned int sliceCount, unsigned int maxLightsPerCluster) :
+    _tileCountX(std::max(tileCountX, 1u)), _tileCountY(std::max(tileCountY, 1u)), _sliceCount(std::max(sliceCount, 1u)),
+    _maxLightsPerCluster(std::max(maxLightsPerCluster, 1u)), _near(0.0f), _far(0.0f), _sliceScale(0.0f), _sliceBias(0.0f)
+{
+    _projection.set(Matrix::zero());
+    unsigned int clusterCount = _tileCountX * _tileCountY * _sliceCount;
+    _clusterLightCounts.resize(clusterCount, 0);
+    _clusterLights.resize(clusterCount * _maxLightsPerCluster);
+    _clusters.resize(clusterCount * 2, 0);
+}
+
+LightGrid::~LightGrid()
+{
+}
+
+unsigned int LightGrid::getTileCountX() const
+{
+    return _tileCountX;
+}
+
+unsigned int LightGrid::getTileCountY() const
+{
+    return _tileCountY;
+}
+
+unsigned int LightGrid::getSliceCount() const
+{
+    return _sliceCount;
+}
+
+float LightGrid::getSliceScale() const
+{
+    return _sliceScale;
+}
+
+float LightGrid::getSliceBias() const
+{
+    return _sliceBias;
+}
+
+const std::vector<unsigned int>& LightGrid::getClusters() const
+{
+    return _clusters;
+}
+
+const std::vector<unsigned int>& LightGrid::getLightIndices() const
+{
+    return _lightIndices;
+}
+
+const std::vector<Vector4>& LightGrid::getLightData() const
+{
+    return _lightData;
+}
+
+void LightGrid::buildClusterBounds(const Camera* camera)
+{
+    // Cluster bounds only change with the projection.
+    const Matrix& projection = camera->getProjectionMatrix();
+    if (!_clusterBounds.empty() && memcmp(projection.m, _projection.m, sizeof(_projection.m)) == 0 &&
+        _near == camera->getNearPlane() && _far == camera->getFarPlane())
+        return;
+
+    _projection = projection;
+    _near = camera->getNearPlane();
+    _far = camera->getFarPlane();
+    float logRatio = logf(_far / _near);
+    _sliceScale = _sliceCount / logRatio;
+    _sliceBias = -logf(_near) * _sliceScale;
+
+    Matrix inverseProjection;
+    _projection.invert(&inverseProjection);
+
+    // Rays through the corners of the tiles, from the near to the far plane in view space.
+    unsigned int cornerCountX = _tileCountX + 1;
+    unsigned int cornerCountY = _tileCountY + 1;
+    std::vector<Vector3> nearCorners(cornerCountX * cornerCountY);
+    std::vector<Vector3> farCorners(cornerCountX * cornerCountY);
+    for (unsigned int y = 0; y < cornerCountY; ++y)
+    {
+        for (unsigned int x = 0; x < cornerCountX; ++x)
+        {
+            float ndcX = 2.0f * x / _tileCountX - 1.0f;
+            float ndcY = 2.0f * y / _tileCountY - 1.0f;
+            Vector4 n, f;
+            inverseProjection.transformVector(Vector4(ndcX, ndcY, -1.0f, 1.0f), &n);
+            inverseProjection.transformVector(Vector4(ndcX, ndcY, 1.0f, 1.0f), &f);
+            nearCorners[y * cornerCountX + x].set(n.x / n.w, n.y / n.w, n.z / n.w);
+            farCorners[y * cornerCountX + x].set(f.x / f.w, f.y / f.w, f.z / f.w);
+        }
+    }
+
+    _clusterBounds.resize(_tileCountX * _tileCountY * _sliceCount);
+    for (unsigned int slice = 0; slice < _sliceCount; ++slice)
+    {
+        float depths[2] =
+        {
+            _near * powf(_far / _near, (float)slice / _sliceCount),
+            _near * powf(_far / _near, (float)(slice + 1) / _sliceCount)
+        };
+        for (unsigned int y = 0; y < _tileCountY; ++y)
+        {
+            for (unsigned int x = 0; x < _tileCountX; ++x)
+            {
+                BoundingBox& bounds = _clusterBounds[(slice * _tileCountY + y) * _tileCountX + x];
+                bounds.min.set(FLT_MAX, FLT_MAX, FLT_MAX);
+                bounds.max.set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+                for (unsigned int corner = 0; corner < 4; ++corner)
+                {
+                    unsigned int index = (y + corner / 2) * cornerCountX + x + corner % 2;
+                    const Vector3& n = nearCorners[index];
+                    const Vector3& f = farCorners[index];
+                    for (int d = 0; d < 2; ++d)
+                    {
+                        float t = (-depths[d] - n.z) / (f.z - n.z);
+                        Vector3 p(n.x + (f.x - n.x) * t, n.y + (f.y - n.y) * t, -depths[d]);
+                        bounds.min.set(std::min(bounds.min.x, p.x), std::min(bounds.min.y, p.y), std::min(bounds.min.z, p.z));
+                        bounds.max.set(std::max(bounds.max.x, p.x), std::max(bounds.max.y, p.y), std::max(bounds.max.z, p.z));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void LightGrid::build(const Camera* camera, const std::vector<Light*>& lights, ThreadPool* pool)
+{
+    GP_ASSERT(camera);
+    buildClusterBounds(camera);
+
+    // Move the lights to view space.
+    const Matrix& view = camera->getViewMatrix();
+    size_t lightCount = lights.size();
+    _lightBounds.resize(lightCount);
+    _lightData.resize(lightCount * 3);
+    for (size_t i = 0; i < lightCount; ++i)
+    {
+        Light* light = lights[i];
+        Node* node = light->getNode();
+        GP_ASSERT(node);
+
+        Matrix worldView;
+        Matrix::multiply(view, node->getWorldMatrix(), &worldView);
+        Vector3 position;
+        Vector3 direction;
+        worldView.getTranslation(&position);
+        worldView.getForwardVector(&direction);
+        direction.normalize();
+
+        Vector4* data = &_lightData[i * 3];
+        Vector3 color = light->getColor() * light->getIntensity();
+        BoundingSphere& bounds = _lightBounds[i];
+        switch (light->getLightType())
+        {
+        case Light::SPOT:
+            data[0].set(position.x, position.y, position.z, light->getRange());
+            data[1].set(color.x, color.y, color.z, light->getInnerAngleCos());
+            data[2].set(direction.x, direction.y, direction.z, light->getOuterAngleCos());
+            light->getBoundingSphere(&bounds);
+            bounds.transform(worldView);
+            break;
+        case Light::POINT:
+            data[0].set(position.x, position.y, position.z, light->getRange());
+            data[1].set(color.x, color.y, color.z, -1.0f);
+            data[2].set(0.0f, 0.0f, 0.0f, -1.0f);
+            light->getBoundingSphere(&bounds);
+            bounds.transform(worldView);
+            break;
+        default:
+            data[0].set(0.0f, 0.0f, 0.0f, 0.0f);
+            data[1].set(color.x, color.y, color.z, -1.0f);
+            data[2].set(direction.x, direction.y, direction.z, -1.0f);
+            bounds.set(Vector3::zero(), 0.0f);
+            break;
+        }
+    }
+
+    // Bin the lights of each slice; slices write to their own clusters only.
+    if (pool && lightCount > 0)
+    {
+        pool->parallelFor(_sliceCount, 1, [this](unsigned int start, unsigned int end)
+        {
+            for (unsigned int slice = start; slice < end; ++slice)
+                binSlice(slice);
+        });
+    }
+    else
+    {
+        for (unsigned int slice = 0; slice < _sliceCount; ++slice)
+            binSlice(slice);
+    }
+
+    // Compact the light lists of the clusters.
+    _lightIndices.clear();
+    for (size_t cluster = 0, clusterCount = _clusterLightCounts.size(); cluster < clusterCount; ++cluster)
+    {
+        unsigned int count = _clusterLightCounts[cluster];
+        _clusters[cluster * 2] = (unsigned int)_lightIndices.size();
+        _clusters[cluster * 2 + 1] = count;
+        const unsigned int* clusterLights = &_clusterLights[cluster * _maxLightsPerCluster];
+        _lightIndices.insert(_lightIndices.end(), clusterLights, clusterLights + count);
+    }
+}
+
+void LightGrid::binSlice(unsigned int slice)
+{
+    unsigned int tileCount = _tileCountX * _tileCountY;
+    unsigned int firstCluster = slice * tileCount;
+    std::fill(_clusterLightCounts.begin() + firstCluster, _clusterLightCounts.begin() + firstCluster + tileCount, 0u);
+
+    // View space looks down the negative z-axis.
+    float sliceMinZ = _clusterBounds[firstCluster].min.z;
+    float sliceMaxZ = _clusterBounds[firstCluster].max.z;
+    for (unsigned int i = 0, lightCount = (unsigned int)_lightBounds.size(); i < lightCount; ++i)
+    {
+        const BoundingSphere& light = _lightBounds[i];
+        if (light.radius <= 0.0f || light.center.z - light.radius > sliceMaxZ || light.center.z + light.radius < sliceMinZ)
+            continue;
+
+        float radiusSq = light.radius * light.radius;
+        for (unsigned int tile = 0; tile < tileCount; ++tile)
+        {
+            unsigned int cluster = firstCluster + tile;
+            const BoundingBox& bounds = _clusterBounds[cluster];
+            float dx = std::max(std::max(bounds.min.x - light.center.x, light.center.x - bounds.max.x), 0.0f);
+            float dy = std::max(std::max(bounds.min.y - light.center.y, light.center.y - bounds.max.y), 0.0f);
+            float dz = std::max(std::max(bounds.min.z - light.center.z, light.center.z - bounds.max.z), 0.0f);
+            if (dx * dx + dy * dy + dz * dz > radiusSq)
+                continue;
+
+            unsigned int& count = _clusterLightCounts[cluster];
+            if (count < _maxLightsPerCluster)
+                _clusterLights[cluster * _maxLightsPerCluster + count++] = i;
+        }
+    }
+}
+
+int LightGrid::getClusterIndex(const Vector3& viewPosition) const
+{
+    float depth = -viewPosition.z;
+    if (_clusterBounds.empty() || depth < _near || depth > _far)
+        return -1;
+
+    Vector4 clip;
+    _projection.transformVector(Vector4(viewPosition.x, viewPosition.y, viewPosition.z, 1.0f), &clip);
+    float ndcX = clip.x / clip.w;
+    float ndcY = clip.y / clip.w;
+    if (ndcX < -1.0f || ndcX > 1.0f || ndcY < -1.0f || ndcY > 1.0f)
+        return -1;
+
+    unsigned int x = std::min((unsigned int)((ndcX + 1.0f) * 0.5f * _tileCountX), _tileCountX - 1);
+    unsigned int y = std::min((unsigned int)((ndcY + 1.0f) * 0.5f * _tileCountY), _tileCountY - 1);
+    unsigned int slice = std::min((unsigned int)std::max(logf(depth) * _sliceScale + _sliceBias, 0.0f), _sliceCount - 1);
+    return (int)((slice * _tileCountY + y) * _tileCountX + x);
+}
+
+void LightGrid::selectLights(const BoundingSphere& bounds, const std::vector<Light*>& lights, unsigned int maxLights,
+                             std::vector<Light*>* dst, std::vector<std::pair<float, Light*> >* ranked)
+{
+    GP_ASSERT(dst);
+    GP_ASSERT(ranked);
+    dst->clear();
+    ranked->clear();
+
+    for (size_t i = 0, count = lights.size(); i < count; ++i)
+    {
+        Light* light = lights[i];
+        Node* node = light->getNode();
+        if (!node)
+            continue;
+
+        const Vector3& color = light->getColor();
+        float intensity = (0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z) * light->getIntensity();
+        BoundingSphere lightBounds;
+        if (!light->getBoundingSphere(&lightBounds))
+        {
+            ranked->push_back(std::make_pair(FLT_MAX, light));
+            continue;
+        }
+        lightBounds.transform(node->getWorldMatrix());
+        if (!lightBounds.intersects(bounds))
+            continue;
+
+        float range = light->getRange();
+        float distance = std::max(node->getTranslationWorld().distance(bounds.center) - bounds.radius, 0.0f);
+        float attenuation = std::max(1.0f - distance / range, 0.0f);
+        ranked->push_back(std::make_pair(intensity * attenuation * attenuation, light));
+    }
+
+    size_t count = std::min(ranked->size(), (size_t)maxLights);
+    std::partial_sort(ranked->begin(), ranked->begin() + count, ranked->end(),
+        [](const std::pair<float, Light*>& a, const std::pair<float, Light*>& b) { return a.first > b.first; });
+    for (size_t i = 0; i < count; ++i)
+        dst->push_back((*ranked)[i].second);
+}
+
+}
@@ -0,0 +1,171 @@
+#ifndef LIGHTGRID_H_
+#define LIGHTGRID_H_
+
+#include "base/Base.h"
+#include "math/Vector3.h"
+#include "math/Vector4.h"
+#include "math/Matrix.h"
+#include "math/BoundingSphere.h"
+#include "math/BoundingBox.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Light;
+class ThreadPool;
+
+/**
+ * Defines a clustered light grid for forward rendering.
+ *
+ * The view frustum is split into clusters: screen tiles, each split along the view depth
+ * in slices of exponentially growing thickness. Each frame, the point and spot lights are
+ * binned into the clusters they touch, in parallel over the slices, producing compact
+ * arrays that can be uploaded as textures or buffers:
+ *
+ * - getClusters() holds, for each cluster, the offset of its first light index and its
+ *   number of lights.
+ * - getLightIndices() holds the light indices of all the clusters, one after the other.
+ * - getLightData() holds three vectors per light, in view space:
+ *   (position, range), (color times intensity, cosine of the inner angle) and
+ *   (direction, cosine of the outer angle). Point lights have a zero direction and
+ *   cosines of -1, directional lights a zero range.
+ *
+ * Shaders find the cluster of a fragment from its window position and view depth d as
+ * tile + getTileCountX() * getTileCountY() * floor(log(d) * getSliceScale() + getSliceBias()).
+ *
+ * When clustered shading is not available, selectLights() picks the most important lights
+ * for a single object instead.
+ */
+class LightGrid
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param tileCountX The number of tiles across the screen.
+     * @param tileCountY The number of tiles down the screen.
+     * @param sliceCount The number of depth slices.
+     * @param maxLightsPerCluster The most lights kept in a cluster. Extra lights are dropped.
+     */
+    LightGrid(unsigned int tileCountX = 16, unsigned int tileCountY = 9, unsigned int sliceCount = 24, unsigned int maxLightsPerCluster = 64);
+
+    /**
+     * Destructor.
+     */
+    ~LightGrid();
+
+    /**
+     * Bins lights into the clusters of a camera.
+     *
+     * Directional lights are ignored, as they light every cluster.
+     *
+     * @param camera The camera, attached to a node.
+     * @param lights The lights, attached to nodes.
+     * @param pool The thread pool to bin the slices on, or NULL to bin on the calling thread.
+     */
+    void build(const Camera* camera, const std::vector<Light*>& lights, ThreadPool* pool = NULL);
+
+    /**
+     * Returns the number of tiles across the screen.
+     */
+    unsigned int getTileCountX() const;
+
+    /**
+     * Returns the number of tiles down the screen.
+     */
+    unsigned int getTileCountY() const;
+
+    /**
+     * Returns the number of depth slices.
+     */
+    unsigned int getSliceCount() const;
+
+    /**
+     * Returns the scale of the logarithm of the view depth giving the slice.
+     */
+    float getSliceScale() const;
+
+    /**
+     * Returns the bias of the logarithm of the view depth giving the slice.
+     */
+    float getSliceBias() const;
+
+    /**
+     * Returns the cluster containing a point.
+     *
+     * @param viewPosition The point, in view space.
+     *
+     * @return The index of the cluster, or -1 if the point is outside of the frustum.
+     */
+    int getClusterIndex(const Vector3& viewPosition) const;
+
+    /**
+     * Returns the offset and light count of each cluster.
+     *
+     * @return Two values per cluster, ordered by slice, then row, then column of tiles.
+     */
+    const std::vector<unsigned int>& getClusters() const;
+
+    /**
+     * Returns the light indices of the clusters.
+     *
+     * @return The indices, in the lights passed to build().
+     */
+    const std::vector<unsigned int>& getLightIndices() const;
+
+    /**
+     * Returns the packed parameters of the lights.
+     *
+     * @return Three vectors per light, in the order of the lights passed to build().
+     */
+    const std::vector<Vector4>& getLightData() const;
+
+    /**
+     * Picks the lights that matter most to an object.
+     *
+     * Lights are ranked by their color intensity, scaled by Light::getIntensity() and
+     * attenuated by the distance to the object. Lights that can't reach the object are
+     * skipped; directional lights are always kept ahead of the others.
+     *
+     * @param bounds The bounds of the object, in world space.
+     * @param lights The lights, attached to nodes.
+     * @param maxLights The most lights to pick.
+     * @param dst The picked lights, most important first.
+     * @param ranked Scratch storage for the ranking, kept by the caller to reuse its memory between draws.
+     */
+    static void selectLights(const BoundingSphere& bounds, const std::vector<Light*>& lights, unsigned int maxLights,
+                             std::vector<Light*>* dst, std::vector<std::pair<float, Light*> >* ranked);
+
+private:
+
+    LightGrid(const LightGrid&);
+
+    LightGrid& operator=(const LightGrid&);
+
+    void buildClusterBounds(const Camera* camera);
+
+    void binSlice(unsigned int slice);
+
+    unsigned int _tileCountX;
+    unsigned int _tileCountY;
+    unsigned int _sliceCount;
+    unsigned int _maxLightsPerCluster;
+    float _near;
+    float _far;
+    float _sliceScale;
+    float _sliceBias;
+    Matrix _projection;
+    std::vector<BoundingBox> _clusterBounds;
+    std::vector<BoundingSphere> _lightBounds;
+    std::vector<unsigned int> _clusterLightCounts;
+    std::vector<unsigned int> _clusterLights;
+    std::vector<unsigned int> _clusters;
+    std::vector<unsigned int> _lightIndices;
+    std::vector<Vector4> _lightData;
+};
+
+}
+
+#endif
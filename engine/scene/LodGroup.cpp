@@ -0,0 +1,284 @@
+#include "base/Base.h"
+#include "LodGroup.h"
+#include "Model.h"
+#include "Node.h"
+#include "MeshSimplifier.h"
+#include "material/MaterialParameter.h"
+#include "platform/Toolkit.h"
+#include <cfloat>
+
+namespace gameplay
+{
+
+LodGroup::LodGroup() : Drawable(), _hysteresis(0.1f), _fadeDuration(0.0f), _nextView(0)
+{
+    for (unsigned int i = 0; i < MAX_VIEWS; ++i)
+    {
+        _views[i].camera = NULL;
+        _views[i].level = 0;
+        _views[i].previousLevel = 0;
+        _views[i].switchTime = 0.0;
+    }
+}
+
+LodGroup::~LodGroup()
+{
+    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+    {
+        _levels[i].model->setNode(NULL);
+        SAFE_RELEASE(_levels[i].model);
+    }
+}
+
+LodGroup* LodGroup::create()
+{
+    return new LodGroup();
+}
+
+LodGroup* LodGroup::create(Model* model, unsigned int levelCount, float reduction, float screenSize)
+{
+    GP_ASSERT(model && model->getMesh());
+    GP_ASSERT(levelCount > 0);
+
+    if (model->getSkin() && levelCount > 1)
+    {
+        GP_ERROR("Failed to create LOD group; skinned models can't be simplified.");
+        return NULL;
+    }
+
+    LodGroup* lodGroup = new LodGroup();
+    lodGroup->addLevel(model, levelCount > 1 ? screenSize : 0.0f);
+
+    Mesh* mesh = model->getMesh();
+    float levelScreenSize = screenSize;
+    for (unsigned int i = 1; i < levelCount; ++i)
+    {
+        Mesh* levelMesh = MeshSimplifier::simplify(mesh, reduction);
+        if (!levelMesh)
+        {
+            GP_ERROR("Failed to simplify mesh for level %u of LOD group.", i);
+            SAFE_RELEASE(lodGroup);
+            return NULL;
+        }
+
+        // The levels share the materials of the model.
+        Model* levelModel = Model::create(levelMesh);
+        if (model->getMaterial())
+            levelModel->setMaterial(model->getMaterial());
+        for (unsigned int j = 0, partCount = levelModel->getMeshPartCount(); j < partCount; ++j)
+        {
+            if (model->hasMaterial(j))
+                levelModel->setMaterial(model->getMaterial(j), j);
+        }
+
+        levelScreenSize *= reduction;
+        lodGroup->addLevel(levelModel, i + 1 < levelCount ? levelScreenSize : 0.0f);
+        levelModel->release();
+        levelMesh->release();
+        mesh = levelMesh;
+    }
+    return lodGroup;
+}
+
+void LodGroup::addLevel(Model* model, float screenSize)
+{
+    GP_ASSERT(model);
+    GP_ASSERT(_levels.empty() || screenSize <= _levels.back().screenSize);
+
+    Level level;
+    level.model = model;
+    level.screenSize = screenSize;
+    model->addRef();
+    model->setNode(_node);
+    _levels.push_back(level);
+}
+
+unsigned int LodGroup::getLevelCount() const
+{
+    return (unsigned int)_levels.size();
+}
+
+Model* LodGroup::getLevelModel(unsigned int index) const
+{
+    GP_ASSERT(index < _levels.size());
+    return _levels[index].model;
+}
+
+float LodGroup::getLevelScreenSize(unsigned int index) const
+{
+    GP_ASSERT(index < _levels.size());
+    return _levels[index].screenSize;
+}
+
+void LodGroup::setHysteresis(float hysteresis)
+{
+    _hysteresis = hysteresis;
+}
+
+float LodGroup::getHysteresis() const
+{
+    return _hysteresis;
+}
+
+void LodGroup::setFadeDuration(float duration)
+{
+    _fadeDuration = duration;
+}
+
+float LodGroup::getFadeDuration() const
+{
+    return _fadeDuration;
+}
+
+const BoundingSphere& LodGroup::getBoundingSphere() const
+{
+    if (_levels.empty() || !_levels[0].model->getMesh())
+        return BoundingSphere::empty();
+    return _levels[0].model->getMesh()->getBoundingSphere();
+}
+
+float LodGroup::computeScreenSize(Camera* camera) const
+{
+    GP_ASSERT(camera);
+
+    BoundingSphere sphere(getBoundingSphere());
+    if (_node)
+        sphere.transform(_node->getWorldMatrix());
+
+    float scale = camera->getProjectionMatrix().m[5];
+    if (camera->getCameraType() == Camera::ORTHOGRAPHIC)
+        return sphere.radius * scale;
+
+    Vector3 eye;
+    if (camera->getNode())
+        camera->getNode()->getWorldMatrix().getTranslation(&eye);
+    float distance = eye.distance(sphere.center);
+    if (distance <= sphere.radius)
+        return FLT_MAX;
+    return sphere.radius * scale / distance;
+}
+
+unsigned int LodGroup::selectLevel(float screenSize, unsigned int currentLevel) const
+{
+    for (unsigned int i = 0, count = (unsigned int)_levels.size(); i < count; ++i)
+    {
+        float threshold = _levels[i].screenSize * (i < currentLevel ? 1.0f + _hysteresis : 1.0f - _hysteresis);
+        if (screenSize >= threshold)
+            return i;
+    }
+    return (unsigned int)_levels.size();
+}
+
+unsigned int LodGroup::getCurrentLevel(Camera* camera) const
+{
+    for (unsigned int i = 0; i < MAX_VIEWS; ++i)
+    {
+        if (_views[i].camera == camera)
+            return _views[i].level;
+    }
+    return (unsigned int)_levels.size();
+}
+
+unsigned int LodGroup::draw(RenderView* view)
+{
+    GP_ASSERT(view);
+
+    unsigned int levelCount = (unsigned int)_levels.size();
+    if (levelCount == 0)
+        return 0;
+    // Shadow passes select the level of the camera they are rendered for, so that shadows
+    // match the drawn level and the cascades, which share one camera, don't switch it.
+    Camera* camera = view->lodCamera ? view->lodCamera : view->camera;
+    if (!camera)
+        return drawLevel(0, view, 0.0f);
+
+    // Find the level drawn last for the camera, replacing the oldest camera if it's new.
+    ViewState* state = NULL;
+    for (unsigned int i = 0; i < MAX_VIEWS && !state; ++i)
+    {
+        if (_views[i].camera == camera)
+            state = &_views[i];
+    }
+    if (!state)
+    {
+        state = &_views[_nextView];
+        _nextView = (_nextView + 1) % MAX_VIEWS;
+        state->camera = camera;
+        state->level = levelCount;
+        state->previousLevel = levelCount;
+    }
+    state->level = std::min(state->level, levelCount);
+    state->previousLevel = std::min(state->previousLevel, levelCount);
+
+    unsigned int level = selectLevel(computeScreenSize(camera), state->level);
+    double time = Toolkit::cur()->getGameTime();
+    if (level != state->level)
+    {
+        state->previousLevel = _fadeDuration > 0.0f ? state->level : levelCount;
+        state->level = level;
+        state->switchTime = time;
+    }
+
+    float fade = 0.0f;
+    if (state->previousLevel < levelCount)
+    {
+        fade = (float)((time - state->switchTime) / _fadeDuration);
+        if (fade >= 1.0f || fade < 0.0f)
+        {
+            state->previousLevel = levelCount;
+            fade = 0.0f;
+        }
+    }
+
+    unsigned int drawCalls = 0;
+    if (state->level < levelCount)
+        drawCalls += drawLevel(state->level, view, fade);
+    if (state->previousLevel < levelCount)
+        drawCalls += drawLevel(state->previousLevel, view, -fade);
+    return drawCalls;
+}
+
+unsigned int LodGroup::drawLevel(unsigned int level, RenderView* view, float fade)
+{
+    Model* model = _levels[level].model;
+    if (_fadeDuration > 0.0f)
+    {
+        if (Material* material = model->getMaterial())
+            material->getParameter("u_lodFade")->setFloat(fade);
+        for (unsigned int i = 0, partCount = model->getMeshPartCount(); i < partCount; ++i)
+        {
+            if (model->hasMaterial(i))
+                model->getMaterial(i)->getParameter("u_lodFade")->setFloat(fade);
+        }
+    }
+    model->setNode(_node);
+    return model->draw(view);
+}
+
+void LodGroup::setNode(Node* node)
+{
+    Drawable::setNode(node);
+    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+        _levels[i].model->setNode(node);
+}
+
+Drawable* LodGroup::clone(NodeCloneContext& context)
+{
+    LodGroup* lodGroup = new LodGroup();
+    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+    {
+        Model* model = static_cast<Model*>(_levels[i].model->clone(context));
+        if (!model)
+        {
+            GP_ERROR("Failed to clone level %u of LOD group.", (unsigned int)i);
+            continue;
+        }
+        lodGroup->addLevel(model, _levels[i].screenSize);
+        model->release();
+    }
+    lodGroup->_hysteresis = _hysteresis;
+    lodGroup->_fadeDuration = _fadeDuration;
+    return lodGroup;
+}
+
+}
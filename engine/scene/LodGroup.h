@@ -0,0 +1,198 @@
+#ifndef LODGROUP_H_
+#define LODGROUP_H_
+
+#include "base/Ref.h"
+#include "Drawable.h"
+#include "math/BoundingSphere.h"
+
+namespace gameplay
+{
+
+class Model;
+
+/**
+ * Defines a drawable choosing between models of decreasing detail by their size on screen.
+ *
+ * Levels are ordered from the most to the least detailed, each drawn while the projected
+ * diameter of the group's bounding sphere, relative to the height of the viewport, is at least
+ * its screen size. Below the screen size of the last level nothing is drawn.
+ *
+ * The level is selected when drawing, and kept for each camera drawing the group. Views
+ * setting RenderView::lodCamera, such as shadow passes, use the level of that camera. To avoid
+ * popping back and forth around a threshold, moving to a finer level needs the screen size
+ * to exceed its threshold by the hysteresis, and moving to a coarser one to fall below it
+ * by the hysteresis.
+ *
+ * When a fade duration is set, both levels are drawn for that long after a switch, with
+ * the "u_lodFade" parameter of their materials set to the progress of the fade, positive
+ * on the new level and negative on the old one, for shaders to dither them in and out.
+ */
+class LodGroup : public Ref, public Drawable
+{
+public:
+
+    /**
+     * The most cameras whose selected level is kept.
+     */
+    static const unsigned int MAX_VIEWS = 4;
+
+    /**
+     * Creates an empty LOD group.
+     *
+     * @return The new LOD group.
+     */
+    static LodGroup* create();
+
+    /**
+     * Creates a LOD group generating its levels by simplifying the mesh of a model.
+     *
+     * Each level keeps a fraction of the triangles of the previous one and shares the
+     * materials of the model. Level i is drawn down to a screen size of
+     * screenSize * reduction^i, and the last level down to any size.
+     *
+     * @param model The most detailed level.
+     * @param levelCount The number of levels, including the model.
+     * @param reduction The fraction of the triangles kept from a level to the next.
+     * @param screenSize The screen size below which the model is replaced by the second level.
+     *
+     * @return The new LOD group, or NULL if the mesh of the model could not be simplified.
+     */
+    static LodGroup* create(Model* model, unsigned int levelCount, float reduction = 0.5f, float screenSize = 0.5f);
+
+    /**
+     * Adds a level, less detailed than the levels already added.
+     *
+     * @param model The model drawn by the level.
+     * @param screenSize The screen size down to which the level is drawn.
+     */
+    void addLevel(Model* model, float screenSize);
+
+    /**
+     * Returns the number of levels.
+     */
+    unsigned int getLevelCount() const;
+
+    /**
+     * Returns the model drawn by a level.
+     *
+     * @param index The index of the level, most detailed first.
+     */
+    Model* getLevelModel(unsigned int index) const;
+
+    /**
+     * Returns the screen size down to which a level is drawn.
+     *
+     * @param index The index of the level, most detailed first.
+     */
+    float getLevelScreenSize(unsigned int index) const;
+
+    /**
+     * Sets the relative margin around the screen sizes before switching levels.
+     *
+     * @param hysteresis The margin. Defaults to 0.1.
+     */
+    void setHysteresis(float hysteresis);
+
+    /**
+     * Returns the relative margin around the screen sizes before switching levels.
+     */
+    float getHysteresis() const;
+
+    /**
+     * Sets how long levels are cross-faded after a switch.
+     *
+     * @param duration The duration, in milliseconds, or 0 to switch at once. Defaults to 0.
+     */
+    void setFadeDuration(float duration);
+
+    /**
+     * Returns how long levels are cross-faded after a switch, in milliseconds.
+     */
+    float getFadeDuration() const;
+
+    /**
+     * Returns the bounding sphere of the group, the bounds of its most detailed level.
+     */
+    const BoundingSphere& getBoundingSphere() const;
+
+    /**
+     * Computes the projected diameter of the group relative to the height of the viewport.
+     *
+     * @param camera The camera.
+     *
+     * @return The screen size, or a large value if the camera is inside the bounds.
+     */
+    float computeScreenSize(Camera* camera) const;
+
+    /**
+     * Selects the level to draw at a screen size.
+     *
+     * @param screenSize The screen size.
+     * @param currentLevel The level drawn so far, or getLevelCount() if none.
+     *
+     * @return The level, or getLevelCount() if nothing should be drawn.
+     */
+    unsigned int selectLevel(float screenSize, unsigned int currentLevel) const;
+
+    /**
+     * Returns the level drawn last for a camera.
+     *
+     * @param camera The camera.
+     *
+     * @return The level, or getLevelCount() if none.
+     */
+    unsigned int getCurrentLevel(Camera* camera) const;
+
+    /**
+     * @see Drawable::draw
+     */
+    unsigned int draw(RenderView* view);
+
+protected:
+
+    /**
+     * @see Drawable::clone
+     */
+    Drawable* clone(NodeCloneContext& context);
+
+    /**
+     * @see Drawable::setNode
+     */
+    void setNode(Node* node);
+
+private:
+
+    struct Level
+    {
+        Model* model;
+        float screenSize;
+    };
+
+    struct ViewState
+    {
+        Camera* camera;
+        unsigned int level;
+        unsigned int previousLevel;
+        double switchTime;
+    };
+
+    LodGroup();
+
+    ~LodGroup();
+
+    LodGroup(const LodGroup&);
+
+    LodGroup& operator=(const LodGroup&);
+
+    unsigned int drawLevel(unsigned int level, RenderView* view, float fade);
+
+    std::vector<Level> _levels;
+    float _hysteresis;
+    float _fadeDuration;
+    ViewState _views[MAX_VIEWS];
+    unsigned int _nextView;
+};
+
+}
+
+#endif
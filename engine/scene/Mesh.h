@@ -26,6 +26,7 @@ class Mesh : public Ref
 {
     friend class Model;
     friend class Bundle;
+    friend class MeshOptimizer;
 
 public:
 
@@ -389,6 +390,8 @@ public:
     void* _vertexData;
     bool _vertexDataDirty;
     VertexAttributeBinding *_vertexAttributeArray;
+    // Binding for the override materials of a RenderView, whose shaders read fewer attributes.
+    VertexAttributeBinding *_overrideVertexAttributeArray;
 };
 
 }
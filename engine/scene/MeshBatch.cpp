@@ -6,8 +6,10 @@ namespace gameplay
 {
 
 MeshBatch::MeshBatch(const VertexFormat& vertexFormat, Mesh::PrimitiveType primitiveType, Material* material, bool indexed, unsigned int initialCapacity, unsigned int growSize)
-    : _vertexFormat(vertexFormat), _primitiveType(primitiveType), _material(material), _indexed(indexed), _capacity(0), _growSize(growSize),
-    _vertexCapacity(0), _indexCapacity(0), _vertexCount(0), _indexCount(0), _vertices(NULL), _verticesPtr(NULL), _indices(NULL), _indicesPtr(NULL), _started(false), _vertexAttributeArray(NULL)
+    : _vertexFormat(vertexFormat), _capacity(0), _growSize(growSize), _vertexCapacity(0), _indexCapacity(0), _vertices(NULL), _verticesPtr(NULL),
+    _indicesPtr(NULL), _started(false), _primitiveType(primitiveType), _material(material), _indices(NULL), _indexFormat(Mesh::INDEX16),
+    _vertexCount(0), _indexCount(0), _indexed(indexed), _vertexAttributeArray(NULL), _vertexBuffer(0), _indexBuffer(0), _vertexBufferSize(0),
+    _indexBufferSize(0), _dirty(true)
 {
     resize(initialCapacity);
 }
@@ -44,7 +46,7 @@ MeshBatch* MeshBatch::create(const VertexFormat& vertexFormat, Mesh::PrimitiveTy
     return batch;
 }
 
-void MeshBatch::add(const void* vertices, size_t size, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
+void MeshBatch::add(const void* vertices, size_t size, unsigned int vertexCount, const void* indices, unsigned int indexSize, unsigned int indexCount)
 {
     GP_ASSERT(vertices);
     
@@ -73,45 +75,73 @@ void MeshBatch::add(const void* vertices, size_t size, unsigned int vertexCount,
         GP_ASSERT(indices);
         GP_ASSERT(_indicesPtr);
 
-        if (_vertexCount == 0)
+        if (_indexFormat == Mesh::INDEX16)
         {
-            // Simply copy values directly into the start of the index array.
-            memcpy(_indicesPtr, indices, indexCount * sizeof(unsigned short));
+            unsigned short* dst = (unsigned short*)_indicesPtr;
+            if (_primitiveType == Mesh::TRIANGLE_STRIP && _vertexCount > 0)
+            {
+                // Create a degenerate triangle to connect separate triangle strips
+                // by duplicating the previous and next vertices.
+                dst[0] = dst[-1];
+                dst[1] = _vertexCount;
+                dst += 2;
+            }
+
+            if (_vertexCount == 0 && indexSize == sizeof(unsigned short))
+            {
+                // Simply copy values directly into the start of the index array.
+                memcpy(dst, indices, indexCount * sizeof(unsigned short));
+            }
+            else if (indexSize == sizeof(unsigned short))
+            {
+                // Loop through all indices and insert them, with their values offset by
+                // 'vertexCount' so that they are relative to the first newly inserted vertex.
+                const unsigned short* src = (const unsigned short*)indices;
+                for (unsigned int i = 0; i < indexCount; ++i)
+                    dst[i] = src[i] + _vertexCount;
+            }
+            else
+            {
+                const unsigned int* src = (const unsigned int*)indices;
+                for (unsigned int i = 0; i < indexCount; ++i)
+                    dst[i] = (unsigned short)(src[i] + _vertexCount);
+            }
+            _indicesPtr = (unsigned char*)(dst + indexCount);
         }
         else
         {
-            if (_primitiveType == Mesh::TRIANGLE_STRIP)
+            unsigned int* dst = (unsigned int*)_indicesPtr;
+            if (_primitiveType == Mesh::TRIANGLE_STRIP && _vertexCount > 0)
             {
-                // Create a degenerate triangle to connect separate triangle strips
-                // by duplicating the previous and next vertices.
-                _indicesPtr[0] = *(_indicesPtr-1);
-                _indicesPtr[1] = _vertexCount;
-                _indicesPtr += 2;
+                dst[0] = dst[-1];
+                dst[1] = _vertexCount;
+                dst += 2;
             }
-            
-            // Loop through all indices and insert them, with their values offset by
-            // 'vertexCount' so that they are relative to the first newly inserted vertex.
-            for (unsigned int i = 0; i < indexCount; ++i)
+
+            if (indexSize == sizeof(unsigned short))
+            {
+                const unsigned short* src = (const unsigned short*)indices;
+                for (unsigned int i = 0; i < indexCount; ++i)
+                    dst[i] = src[i] + _vertexCount;
+            }
+            else if (_vertexCount == 0)
             {
-                _indicesPtr[i] = indices[i] + _vertexCount;
+                memcpy(dst, indices, indexCount * sizeof(unsigned int));
             }
+            else
+            {
+                const unsigned int* src = (const unsigned int*)indices;
+                for (unsigned int i = 0; i < indexCount; ++i)
+                    dst[i] = src[i] + _vertexCount;
+            }
+            _indicesPtr = (unsigned char*)(dst + indexCount);
         }
-        _indicesPtr += indexCount;
         _indexCount = newIndexCount;
     }
     
     _verticesPtr += vBytes;
     _vertexCount = newVertexCount;
-}
-
-void MeshBatch::updateVertexAttributeBinding()
-{
-    GP_ASSERT(_material);
-
-    // Update our vertex attribute bindings.
-    if (_vertexAttributeArray) {
-        _vertexAttributeArray->_isDirty = true;
-    }
+    _dirty = true;
 }
 
 unsigned int MeshBatch::getCapacity() const
@@ -137,7 +167,8 @@ bool MeshBatch::resize(unsigned int capacity)
 
     // Store old batch data.
     unsigned char* oldVertices = _vertices;
-    unsigned short* oldIndices = _indices;
+    unsigned char* oldIndices = _indices;
+    Mesh::IndexFormat oldIndexFormat = _indexFormat;
 
     unsigned int vertexCapacity = 0;
     switch (_primitiveType)
@@ -166,11 +197,13 @@ bool MeshBatch::resize(unsigned int capacity)
     // (we only know how many indices will be stored). Assume the worst case
     // for now, which is the same number of vertices as indices.
     unsigned int indexCapacity = vertexCapacity;
-    if (_indexed && indexCapacity > USHRT_MAX)
-    {
-        GP_ERROR("Index capacity is greater than the maximum unsigned short value (%d > %d).", indexCapacity, USHRT_MAX);
-        return false;
-    }
+
+    // Switch to 32-bit indices once 16-bit ones can't address every vertex. Batches
+    // never switch back, to keep the indices they hold valid.
+    if (_indexed && vertexCapacity > USHRT_MAX + 1)
+        _indexFormat = Mesh::INDEX32;
+    unsigned int oldIndexSize = oldIndexFormat == Mesh::INDEX32 ? sizeof(unsigned int) : sizeof(unsigned short);
+    unsigned int indexSize = _indexFormat == Mesh::INDEX32 ? sizeof(unsigned int) : sizeof(unsigned short);
 
     // Allocate new data and reset pointers.
     unsigned int voffset = _verticesPtr - _vertices;
@@ -182,11 +215,11 @@ bool MeshBatch::resize(unsigned int capacity)
 
     if (_indexed)
     {
-        unsigned int ioffset = _indicesPtr - _indices;
-        _indices = new unsigned short[indexCapacity];
+        unsigned int ioffset = (_indicesPtr - _indices) / oldIndexSize;
+        _indices = new unsigned char[indexCapacity * indexSize];
         if (ioffset >= indexCapacity)
             ioffset = indexCapacity - 1;
-        _indicesPtr = _indices + ioffset;
+        _indicesPtr = _indices + ioffset * indexSize;
     }
 
     // Copy old data back in
@@ -194,7 +227,21 @@ bool MeshBatch::resize(unsigned int capacity)
         memcpy(_vertices, oldVertices, std::min(_vertexCapacity, vertexCapacity) * _vertexFormat.getVertexSize());
     SAFE_DELETE_ARRAY(oldVertices);
     if (oldIndices)
-        memcpy(_indices, oldIndices, std::min(_indexCapacity, indexCapacity) * sizeof(unsigned short));
+    {
+        unsigned int count = std::min(_indexCapacity, indexCapacity);
+        if (oldIndexFormat == _indexFormat)
+        {
+            memcpy(_indices, oldIndices, count * indexSize);
+        }
+        else
+        {
+            // Widen the indices that were batched as 16-bit.
+            const unsigned short* src = (const unsigned short*)oldIndices;
+            unsigned int* dst = (unsigned int*)_indices;
+            for (unsigned int i = 0; i < count; ++i)
+                dst[i] = src[i];
+        }
+    }
     SAFE_DELETE_ARRAY(oldIndices);
 
     // Assign new capacities
@@ -202,15 +249,41 @@ bool MeshBatch::resize(unsigned int capacity)
     _vertexCapacity = vertexCapacity;
     _indexCapacity = indexCapacity;
 
-    // Update our vertex attribute bindings now that our client array pointers have changed
-    updateVertexAttributeBinding();
+    // The vertex attribute binding refers to the streaming vertex buffer rather than to
+    // the client arrays, so it stays valid. The renderer grows the buffers on upload.
+    _dirty = true;
 
     return true;
 }
 
+const VertexFormat& MeshBatch::getVertexFormat() const
+{
+    return _vertexFormat;
+}
+
+const unsigned char* MeshBatch::getVertices() const
+{
+    return _vertices;
+}
+
+const unsigned char* MeshBatch::getIndices() const
+{
+    return _indices;
+}
+
+Mesh::IndexFormat MeshBatch::getIndexFormat() const
+{
+    return _indexFormat;
+}
+
 void MeshBatch::add(const float* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
 {
-    add(vertices, sizeof(float), vertexCount, indices, indexCount);
+    add(vertices, sizeof(float), vertexCount, indices, sizeof(unsigned short), indexCount);
+}
+
+void MeshBatch::add(const float* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+    add(vertices, sizeof(float), vertexCount, indices, sizeof(unsigned int), indexCount);
 }
 
 void MeshBatch::start()
@@ -220,6 +293,7 @@ void MeshBatch::start()
     _verticesPtr = _vertices;
     _indicesPtr = _indices;
     _started = true;
+    _dirty = true;
 }
 
 bool MeshBatch::isStarted() const
@@ -73,6 +73,42 @@ public:
      */
     inline Material* getMaterial() const;
 
+    /**
+     * Returns the vertex format of the batch.
+     *
+     * @return The vertex format of the batched primitives.
+     */
+    const VertexFormat& getVertexFormat() const;
+
+    /**
+     * Returns the vertex data added to the batch since it was last started.
+     *
+     * The data holds _vertexCount vertices and stays valid until the batch is started again.
+     *
+     * @return The batched vertex data.
+     */
+    const unsigned char* getVertices() const;
+
+    /**
+     * Returns the index data added to the batch since it was last started.
+     *
+     * The data holds _indexCount indices of the format returned by getIndexFormat(),
+     * and stays valid until the batch is started again.
+     *
+     * @return The batched index data, or NULL if the batch is not indexed.
+     */
+    const unsigned char* getIndices() const;
+
+    /**
+     * Returns the format of the batched indices.
+     *
+     * Batches use 16-bit indices, and switch to 32-bit indices when they grow past
+     * the number of vertices that 16-bit indices can address.
+     *
+     * @return The index format.
+     */
+    Mesh::IndexFormat getIndexFormat() const;
+
     /**
      * Adds a group of primitives to the batch.
      *
@@ -95,6 +131,19 @@ public:
     template <class T>
     void add(const T* vertices, unsigned int vertexCount, const unsigned short* indices = NULL, unsigned int indexCount = 0);
 
+    /**
+     * Adds a group of primitives with 32-bit indices to the batch.
+     *
+     * @param vertices Array of vertices.
+     * @param vertexCount Number of vertices.
+     * @param indices Array of indices into the vertex array.
+     * @param indexCount Number of indices.
+     *
+     * @see add(const T*, unsigned int, const unsigned short*, unsigned int)
+     */
+    template <class T>
+    void add(const T* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+
     /**
      * Adds a group of primitives to the batch.
      *
@@ -116,6 +165,18 @@ public:
      */
     void add(const float* vertices, unsigned int vertexCount, const unsigned short* indices = NULL, unsigned int indexCount = 0);
 
+    /**
+     * Adds a group of primitives with 32-bit indices to the batch.
+     *
+     * @param vertices Array of vertices.
+     * @param vertexCount Number of vertices.
+     * @param indices Array of indices into the vertex array.
+     * @param indexCount Number of indices.
+     *
+     * @see add(const float*, unsigned int, const unsigned short*, unsigned int)
+     */
+    void add(const float* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+
     /**
      * Starts batching.
      *
@@ -160,9 +221,7 @@ private:
      */
     MeshBatch& operator=(const MeshBatch&);
 
-    void add(const void* vertices, size_t size, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount);
-
-    void updateVertexAttributeBinding();
+    void add(const void* vertices, size_t size, unsigned int vertexCount, const void* indices, unsigned int indexSize, unsigned int indexCount);
 
     bool resize(unsigned int capacity);
 
@@ -177,16 +236,22 @@ private:
     unsigned char* _vertices;
     unsigned char* _verticesPtr;
     
-    unsigned short* _indicesPtr;
+    unsigned char* _indicesPtr;
     bool _started;
 public:
     Mesh::PrimitiveType _primitiveType;
     Material* _material;
-    unsigned short* _indices;
+    unsigned char* _indices;
+    Mesh::IndexFormat _indexFormat;
     unsigned int _vertexCount;
     unsigned int _indexCount;
     bool _indexed;
     VertexAttributeBinding* _vertexAttributeArray;
+    unsigned int _vertexBuffer;         // Streaming vertex buffer, orphaned by the renderer on each upload
+    unsigned int _indexBuffer;          // Streaming index buffer
+    unsigned int _vertexBufferSize;     // Size of the vertex buffer storage, in bytes
+    unsigned int _indexBufferSize;      // Size of the index buffer storage, in bytes
+    bool _dirty;                        // Whether the batch changed since it was last uploaded
 };
 
 }
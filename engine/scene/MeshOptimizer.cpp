@@ -0,0 +1,553 @@
+#include "base/Base.h"
+#include "MeshOptimizer.h"
+#include "MeshPart.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+
+namespace gameplay
+{
+
+// The size of the LRU cache modelled when optimizing, larger than most hardware caches
+// so the order holds up on GPUs with bigger ones.
+static const int VERTEX_CACHE_SIZE = 32;
+
+static unsigned int hashVertex(const unsigned char* vertex, unsigned int vertexSize)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (unsigned int i = 0; i < vertexSize; ++i)
+        hash = (hash ^ vertex[i]) * 16777619u;
+    return hash;
+}
+
+unsigned int MeshOptimizer::weldVertices(unsigned int* remap, const void* vertices, unsigned int vertexCount, unsigned int vertexSize)
+{
+    GP_ASSERT(remap && (vertices || vertexCount == 0));
+
+    const unsigned char* data = (const unsigned char*)vertices;
+    unsigned int tableSize = 1;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    std::vector<unsigned int> table(tableSize, UINT_MAX);
+
+    unsigned int uniqueCount = 0;
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        const unsigned char* vertex = data + i * vertexSize;
+        unsigned int slot = hashVertex(vertex, vertexSize) & (tableSize - 1);
+        while (table[slot] != UINT_MAX && memcmp(data + table[slot] * vertexSize, vertex, vertexSize) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == UINT_MAX)
+        {
+            table[slot] = i;
+            remap[i] = uniqueCount++;
+        }
+        else
+        {
+            remap[i] = remap[table[slot]];
+        }
+    }
+    return uniqueCount;
+}
+
+static float vertexScore(int cachePosition, unsigned int liveTriangles)
+{
+    if (liveTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle score the same, so its neighbours aren't favoured by order.
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3) / (VERTEX_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // Vertices with few triangles left are finished first, so they don't need to come back later.
+    return score + 2.0f / sqrtf((float)liveTriangles);
+}
+
+void MeshOptimizer::optimizeVertexCache(unsigned int* dst, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+{
+    GP_ASSERT(dst && indices && dst != indices);
+    GP_ASSERT(indexCount % 3 == 0);
+
+    unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles around each vertex; the live ones are kept at the front of each range.
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0);
+    for (unsigned int i = 0; i < indexCount; ++i)
+        ++triangleOffsets[indices[i] + 1];
+    for (unsigned int i = 0; i < vertexCount; ++i)
+        triangleOffsets[i + 1] += triangleOffsets[i];
+    std::vector<unsigned int> vertexTriangles(indexCount);
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (unsigned int i = 0; i < indexCount; ++i)
+    {
+        unsigned int v = indices[i];
+        vertexTriangles[triangleOffsets[v] + liveTriangles[v]++] = i / 3;
+    }
+
+    std::vector<float> vertexScores(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; ++i)
+        vertexScores[i] = vertexScore(-1, liveTriangles[i]);
+    std::vector<float> triangleScores(triangleCount);
+    for (unsigned int i = 0; i < triangleCount; ++i)
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+    std::vector<char> emitted(triangleCount, 0);
+
+    unsigned int cache[VERTEX_CACHE_SIZE + 3];
+    unsigned int newCache[VERTEX_CACHE_SIZE + 3];
+    unsigned int cacheCount = 0;
+
+    unsigned int inputCursor = 0;
+    unsigned int best = 0;
+    for (unsigned int output = 0; output < triangleCount; ++output)
+    {
+        if (best == UINT_MAX)
+        {
+            // Dead end: continue with the next triangle of the input.
+            while (emitted[inputCursor])
+                ++inputCursor;
+            best = inputCursor;
+        }
+
+        const unsigned int* triangle = &indices[best * 3];
+        dst[output * 3] = triangle[0];
+        dst[output * 3 + 1] = triangle[1];
+        dst[output * 3 + 2] = triangle[2];
+        emitted[best] = 1;
+
+        // Remove the triangle from its vertices.
+        for (int j = 0; j < 3; ++j)
+        {
+            unsigned int v = triangle[j];
+            unsigned int* begin = &vertexTriangles[triangleOffsets[v]];
+            unsigned int* end = begin + liveTriangles[v];
+            unsigned int* it = std::find(begin, end, best);
+            GP_ASSERT(it != end);
+            std::swap(*it, *(end - 1));
+            --liveTriangles[v];
+        }
+
+        // Move its vertices to the front of the cache.
+        unsigned int newCacheCount = 0;
+        for (int j = 0; j < 3; ++j)
+        {
+            if (std::find(newCache, newCache + newCacheCount, triangle[j]) == newCache + newCacheCount)
+                newCache[newCacheCount++] = triangle[j];
+        }
+        for (unsigned int j = 0; j < cacheCount; ++j)
+        {
+            unsigned int v = cache[j];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache[newCacheCount++] = v;
+        }
+
+        // Update the scores of the vertices in the cache, and of their triangles.
+        for (unsigned int j = 0; j < newCacheCount; ++j)
+        {
+            unsigned int v = newCache[j];
+            int position = j < (unsigned int)VERTEX_CACHE_SIZE ? (int)j : -1;
+            float score = vertexScore(position, liveTriangles[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+            for (unsigned int k = triangleOffsets[v], end = k + liveTriangles[v]; k < end; ++k)
+                triangleScores[vertexTriangles[k]] += delta;
+        }
+        cacheCount = std::min(newCacheCount, (unsigned int)VERTEX_CACHE_SIZE);
+        memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+
+        // Continue with the best triangle using a vertex left in the cache.
+        best = UINT_MAX;
+        float bestScore = -FLT_MAX;
+        for (unsigned int j = 0; j < cacheCount; ++j)
+        {
+            unsigned int v = cache[j];
+            for (unsigned int k = triangleOffsets[v], end = k + liveTriangles[v]; k < end; ++k)
+            {
+                unsigned int t = vertexTriangles[k];
+                if (triangleScores[t] > bestScore)
+                {
+                    best = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+        }
+    }
+}
+
+// Returns the number of vertices of a triangle missing a FIFO cache, adding them to it.
+static unsigned int updateCache(const unsigned int* triangle, unsigned int* cacheTimes, unsigned int* time, unsigned int cacheSize)
+{
+    unsigned int misses = 0;
+    for (int j = 0; j < 3; ++j)
+    {
+        unsigned int v = triangle[j];
+        if (*time - cacheTimes[v] >= cacheSize)
+        {
+            cacheTimes[v] = ++*time;
+            ++misses;
+        }
+    }
+    return misses;
+}
+
+void MeshOptimizer::optimizeOverdraw(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                                     const float* positions, unsigned int vertexCount, unsigned int vertexStride,
+                                     float threshold)
+{
+    GP_ASSERT(dst && indices && positions && dst != indices);
+    GP_ASSERT(indexCount % 3 == 0);
+
+    unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    const unsigned int cacheSize = 16;
+    float targetAcmr = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize) * threshold;
+
+    // Split where the cache restarts, then inside those runs once their cache miss ratio
+    // is low enough to afford the misses of starting a new cluster.
+    std::vector<unsigned int> cacheTimes(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<unsigned int> clusters;
+    unsigned int clusterStart = 0;
+    unsigned int clusterMisses = 0;
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        unsigned int misses = updateCache(&indices[i * 3], &cacheTimes[0], &time, cacheSize);
+        if (i == 0 || misses == 3)
+        {
+            clusters.push_back(i);
+            clusterStart = i;
+            clusterMisses = 0;
+        }
+        clusterMisses += misses;
+
+        if (i + 1 < triangleCount && (float)clusterMisses / (i - clusterStart + 1) <= targetAcmr)
+        {
+            clusters.push_back(i + 1);
+            clusterStart = i + 1;
+            clusterMisses = 0;
+            time += cacheSize + 1;
+        }
+    }
+    // Clusters starting with a full miss right after a soft split appear twice.
+    clusters.erase(std::unique(clusters.begin(), clusters.end()), clusters.end());
+    unsigned int clusterCount = (unsigned int)clusters.size();
+    clusters.push_back(triangleCount);
+
+    // The center of the mesh, weighted by area.
+    std::vector<float> triangleData(triangleCount * 7);
+    double meshCenter[3] = { 0.0, 0.0, 0.0 };
+    double meshArea = 0.0;
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        const float* p0 = (const float*)((const unsigned char*)positions + indices[i * 3] * vertexStride);
+        const float* p1 = (const float*)((const unsigned char*)positions + indices[i * 3 + 1] * vertexStride);
+        const float* p2 = (const float*)((const unsigned char*)positions + indices[i * 3 + 2] * vertexStride);
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float* data = &triangleData[i * 7];
+        data[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        data[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        data[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        data[3] = sqrtf(data[0] * data[0] + data[1] * data[1] + data[2] * data[2]);
+        for (int k = 0; k < 3; ++k)
+        {
+            data[4 + k] = (p0[k] + p1[k] + p2[k]) / 3.0f;
+            meshCenter[k] += data[4 + k] * data[3];
+        }
+        meshArea += data[3];
+    }
+    if (meshArea > 0.0)
+    {
+        for (int k = 0; k < 3; ++k)
+            meshCenter[k] /= meshArea;
+    }
+
+    // Sort the clusters facing away from the center first; they tend to hide the others.
+    std::vector<std::pair<float, unsigned int> > order(clusterCount);
+    for (unsigned int c = 0; c < clusterCount; ++c)
+    {
+        double center[3] = { 0.0, 0.0, 0.0 };
+        double normal[3] = { 0.0, 0.0, 0.0 };
+        double area = 0.0;
+        for (unsigned int i = clusters[c]; i < clusters[c + 1]; ++i)
+        {
+            const float* data = &triangleData[i * 7];
+            for (int k = 0; k < 3; ++k)
+            {
+                normal[k] += data[k];
+                center[k] += data[4 + k] * data[3];
+            }
+            area += data[3];
+        }
+        double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float key = 0.0f;
+        if (area > 0.0 && length > 0.0)
+        {
+            for (int k = 0; k < 3; ++k)
+                key += (float)((center[k] / area - meshCenter[k]) * normal[k] / length);
+        }
+        order[c] = std::make_pair(-key, c);
+    }
+    std::stable_sort(order.begin(), order.end());
+
+    unsigned int write = 0;
+    for (unsigned int c = 0; c < clusterCount; ++c)
+    {
+        unsigned int cluster = order[c].second;
+        unsigned int count = (clusters[cluster + 1] - clusters[cluster]) * 3;
+        memcpy(dst + write, indices + clusters[cluster] * 3, count * sizeof(unsigned int));
+        write += count;
+    }
+    GP_ASSERT(write == indexCount);
+}
+
+unsigned int MeshOptimizer::optimizeVertexFetch(unsigned int* remap, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+{
+    GP_ASSERT(remap && (indices || indexCount == 0));
+
+    for (unsigned int i = 0; i < vertexCount; ++i)
+        remap[i] = UINT_MAX;
+
+    unsigned int usedCount = 0;
+    for (unsigned int i = 0; i < indexCount; ++i)
+    {
+        GP_ASSERT(indices[i] < vertexCount);
+        if (remap[indices[i]] == UINT_MAX)
+            remap[indices[i]] = usedCount++;
+    }
+    return usedCount;
+}
+
+void MeshOptimizer::remapVertices(void* dst, const void* vertices, unsigned int vertexCount, unsigned int vertexSize, const unsigned int* remap)
+{
+    GP_ASSERT(dst && remap && dst != vertices);
+
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        if (remap[i] != UINT_MAX)
+            memcpy((unsigned char*)dst + remap[i] * vertexSize, (const unsigned char*)vertices + i * vertexSize, vertexSize);
+    }
+}
+
+void MeshOptimizer::remapIndices(unsigned int* dst, const unsigned int* indices, unsigned int indexCount, const unsigned int* remap)
+{
+    GP_ASSERT(dst && remap && (indices || indexCount == 0));
+
+    for (unsigned int i = 0; i < indexCount; ++i)
+    {
+        GP_ASSERT(remap[indices[i]] != UINT_MAX);
+        dst[i] = remap[indices[i]];
+    }
+}
+
+float MeshOptimizer::analyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                                        unsigned int cacheSize, float* atvr)
+{
+    GP_ASSERT(indexCount % 3 == 0);
+
+    std::vector<unsigned int> cacheTimes(vertexCount, 0);
+    std::vector<char> used(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    unsigned int misses = 0;
+    unsigned int usedCount = 0;
+    for (unsigned int i = 0; i < indexCount; i += 3)
+    {
+        misses += updateCache(&indices[i], &cacheTimes[0], &time, cacheSize);
+        for (int j = 0; j < 3; ++j)
+        {
+            if (!used[indices[i + j]])
+            {
+                used[indices[i + j]] = 1;
+                ++usedCount;
+            }
+        }
+    }
+
+    if (atvr)
+        *atvr = usedCount > 0 ? (float)misses / usedCount : 0.0f;
+    return indexCount > 0 ? (float)misses / (indexCount / 3) : 0.0f;
+}
+
+Mesh::IndexFormat MeshOptimizer::getIndexFormat(unsigned int vertexCount, bool allowIndex8)
+{
+    if (allowIndex8 && vertexCount <= 256)
+        return Mesh::INDEX8;
+    if (vertexCount <= 65536)
+        return Mesh::INDEX16;
+    return Mesh::INDEX32;
+}
+
+// Returns the triangle indices of the triangle list parts, one after the other.
+static void gatherTriangles(const std::vector<std::vector<unsigned int> >& partIndices, const std::vector<bool>& triangleParts,
+                            std::vector<unsigned int>* triangles)
+{
+    triangles->clear();
+    for (size_t i = 0; i < partIndices.size(); ++i)
+    {
+        if (triangleParts[i])
+            triangles->insert(triangles->end(), partIndices[i].begin(), partIndices[i].end());
+    }
+}
+
+bool MeshOptimizer::optimize(Mesh* mesh, Statistics* statistics, bool allowIndex8)
+{
+    GP_ASSERT(mesh);
+
+    unsigned int vertexCount = mesh->getVertexCount();
+    unsigned int vertexSize = mesh->getVertexSize();
+    unsigned int partCount = mesh->getPartCount();
+    if (!mesh->_vertexData || partCount == 0)
+    {
+        GP_WARN("Mesh optimization requires indexed vertex data in memory.");
+        return false;
+    }
+
+    // Read the indices of the parts.
+    std::vector<std::vector<unsigned int> > partIndices(partCount);
+    std::vector<bool> triangleParts(partCount);
+    bool allIndex8 = true;
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        MeshPart* part = mesh->getPart(i);
+        if (!part->_indexData)
+        {
+            GP_WARN("Mesh optimization requires the indices of part %u in memory.", i);
+            return false;
+        }
+        unsigned int indexCount = part->getIndexCount();
+        std::vector<unsigned int>& indices = partIndices[i];
+        indices.resize(indexCount);
+        for (unsigned int j = 0; j < indexCount; ++j)
+        {
+            switch (part->getIndexFormat())
+            {
+            case Mesh::INDEX8:
+                indices[j] = ((const unsigned char*)part->_indexData)[j];
+                break;
+            case Mesh::INDEX16:
+                indices[j] = ((const unsigned short*)part->_indexData)[j];
+                break;
+            default:
+                indices[j] = ((const unsigned int*)part->_indexData)[j];
+                break;
+            }
+        }
+        triangleParts[i] = part->getPrimitiveType() == Mesh::TRIANGLES && indexCount % 3 == 0;
+        allIndex8 = allIndex8 && part->getIndexFormat() == Mesh::INDEX8;
+    }
+
+    std::vector<unsigned int> triangles;
+    if (statistics)
+    {
+        gatherTriangles(partIndices, triangleParts, &triangles);
+        statistics->vertexCountBefore = vertexCount;
+        statistics->acmrBefore = analyzeVertexCache(triangles.empty() ? NULL : &triangles[0], (unsigned int)triangles.size(),
+            vertexCount, 16, &statistics->atvrBefore);
+    }
+
+    // Weld the duplicate vertices.
+    std::vector<unsigned int> remap(vertexCount);
+    unsigned int uniqueCount = weldVertices(&remap[0], mesh->_vertexData, vertexCount, vertexSize);
+    std::vector<unsigned char> vertices(std::max(uniqueCount, 1u) * vertexSize);
+    remapVertices(&vertices[0], mesh->_vertexData, vertexCount, vertexSize, &remap[0]);
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        if (!partIndices[i].empty())
+            remapIndices(&partIndices[i][0], &partIndices[i][0], (unsigned int)partIndices[i].size(), &remap[0]);
+    }
+
+    // Reorder the triangles for the vertex cache, then for overdraw when the mesh has positions.
+    const VertexFormat& format = mesh->getVertexFormat();
+    int positionOffset = -1;
+    for (unsigned int i = 0, offset = 0; i < format.getElementCount(); ++i)
+    {
+        const VertexFormat::Element& element = format.getElement(i);
+        if (element.usage == VertexFormat::POSITION && element.size >= 3)
+        {
+            positionOffset = (int)offset;
+            break;
+        }
+        offset += element.size * sizeof(float);
+    }
+    std::vector<unsigned int> reordered;
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        std::vector<unsigned int>& indices = partIndices[i];
+        if (!triangleParts[i] || indices.empty())
+            continue;
+        reordered.resize(indices.size());
+        optimizeVertexCache(&reordered[0], &indices[0], (unsigned int)indices.size(), uniqueCount);
+        if (positionOffset >= 0)
+            optimizeOverdraw(&indices[0], &reordered[0], (unsigned int)indices.size(),
+                (const float*)(&vertices[0] + positionOffset), uniqueCount, vertexSize);
+        else
+            indices.swap(reordered);
+    }
+
+    // Reorder the vertices in the order the parts use them, dropping the unused ones.
+    std::vector<unsigned int> allIndices;
+    for (unsigned int i = 0; i < partCount; ++i)
+        allIndices.insert(allIndices.end(), partIndices[i].begin(), partIndices[i].end());
+    unsigned int usedCount = optimizeVertexFetch(&remap[0], allIndices.empty() ? NULL : &allIndices[0],
+        (unsigned int)allIndices.size(), uniqueCount);
+    remapVertices(mesh->_vertexData, &vertices[0], uniqueCount, vertexSize, &remap[0]);
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        if (!partIndices[i].empty())
+            remapIndices(&partIndices[i][0], &partIndices[i][0], (unsigned int)partIndices[i].size(), &remap[0]);
+    }
+
+    // Narrow the indices and upload the mesh again; the buffers are recreated at their new sizes.
+    mesh->_vertexCount = usedCount;
+    if (usedCount > 0)
+        Renderer::cur()->updateMesh(mesh, 0, 0);
+    Mesh::IndexFormat indexFormat = getIndexFormat(usedCount, allowIndex8 || allIndex8);
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        MeshPart* part = mesh->getPart(i);
+        const std::vector<unsigned int>& indices = partIndices[i];
+        part->_indexFormat = indexFormat;
+        free(part->_indexData);
+        part->_indexData = malloc(std::max(part->getIndexSize() * indices.size(), (size_t)1));
+        for (size_t j = 0; j < indices.size(); ++j)
+        {
+            switch (indexFormat)
+            {
+            case Mesh::INDEX8:
+                ((unsigned char*)part->_indexData)[j] = (unsigned char)indices[j];
+                break;
+            case Mesh::INDEX16:
+                ((unsigned short*)part->_indexData)[j] = (unsigned short)indices[j];
+                break;
+            default:
+                ((unsigned int*)part->_indexData)[j] = indices[j];
+                break;
+            }
+        }
+        if (!indices.empty())
+            Renderer::cur()->updateMeshPart(part, 0, 0);
+    }
+
+    if (statistics)
+    {
+        gatherTriangles(partIndices, triangleParts, &triangles);
+        statistics->vertexCountAfter = usedCount;
+        statistics->acmrAfter = analyzeVertexCache(triangles.empty() ? NULL : &triangles[0], (unsigned int)triangles.size(),
+            usedCount, 16, &statistics->atvrAfter);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,174 @@
+#ifndef MESHOPTIMIZER_H_
+#define MESHOPTIMIZER_H_
+
+#include "base/Base.h"
+#include "Mesh.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines functions reordering mesh data for faster rendering.
+ *
+ * Triangles are reordered to reuse the vertices left in the post-transform vertex cache
+ * (Forsyth's linear-speed algorithm), then split into clusters along the cache order and
+ * the clusters sorted to draw outward facing ones first, reducing overdraw. Vertices are
+ * reordered in the order the triangles first use them, so they are fetched sequentially,
+ * duplicate vertices are welded, and indices are narrowed to the smallest format holding them.
+ *
+ * The functions work on indexed triangle lists and may be used when importing or cooking
+ * meshes, or on meshes created at runtime.
+ */
+class MeshOptimizer
+{
+public:
+
+    /**
+     * Defines the cost of drawing a mesh before and after optimizing it.
+     *
+     * The average cache miss ratio (ACMR) is the number of vertices transformed per triangle,
+     * from 0.5 for large regular grids to 3. The average transform to vertex ratio (ATVR) is
+     * the number of vertices transformed per vertex, 1 when each is transformed once.
+     */
+    class Statistics
+    {
+    public:
+
+        /**
+         * The number of vertices.
+         */
+        unsigned int vertexCountBefore;
+        unsigned int vertexCountAfter;
+
+        /**
+         * The average cache miss ratio of the triangles.
+         */
+        float acmrBefore;
+        float acmrAfter;
+
+        /**
+         * The average transform to vertex ratio of the triangles.
+         */
+        float atvrBefore;
+        float atvrAfter;
+    };
+
+    /**
+     * Finds the vertices sharing the same data.
+     *
+     * @param remap Set to the new index of each vertex, the same for equal vertices.
+     *        The new indices are assigned in the order vertices are first seen.
+     * @param vertices The vertex data.
+     * @param vertexCount The number of vertices.
+     * @param vertexSize The size of a vertex, in bytes.
+     *
+     * @return The number of unique vertices.
+     */
+    static unsigned int weldVertices(unsigned int* remap, const void* vertices, unsigned int vertexCount, unsigned int vertexSize);
+
+    /**
+     * Reorders triangles to reduce the vertices transformed more than once.
+     *
+     * @param dst The reordered indices. Holds indexCount indices, and may not be indices.
+     * @param indices The indices of the triangles.
+     * @param indexCount The number of indices.
+     * @param vertexCount The number of vertices.
+     */
+    static void optimizeVertexCache(unsigned int* dst, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount);
+
+    /**
+     * Reorders triangles optimized for the vertex cache to reduce overdraw.
+     *
+     * The triangles are split into clusters where the cache would be mostly empty, and the
+     * clusters sorted by how much they face away from the center of the mesh.
+     *
+     * @param dst The reordered indices. Holds indexCount indices, and may not be indices.
+     * @param indices The indices of the triangles, optimized with optimizeVertexCache().
+     * @param indexCount The number of indices.
+     * @param positions The position of the first vertex, three floats.
+     * @param vertexCount The number of vertices.
+     * @param vertexStride The distance between the positions of consecutive vertices, in bytes.
+     * @param threshold How much the cache miss ratio may grow to allow more clusters.
+     */
+    static void optimizeOverdraw(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                                 const float* positions, unsigned int vertexCount, unsigned int vertexStride,
+                                 float threshold = 1.05f);
+
+    /**
+     * Finds the order of vertices first used by triangles.
+     *
+     * @param remap Set to the new index of each vertex, or UINT_MAX for unused vertices.
+     * @param indices The indices of the triangles.
+     * @param indexCount The number of indices.
+     * @param vertexCount The number of vertices.
+     *
+     * @return The number of used vertices.
+     */
+    static unsigned int optimizeVertexFetch(unsigned int* remap, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount);
+
+    /**
+     * Moves vertices to their new indices.
+     *
+     * @param dst The vertices at their new indices. May not be vertices.
+     * @param vertices The vertex data.
+     * @param vertexCount The number of vertices.
+     * @param vertexSize The size of a vertex, in bytes.
+     * @param remap The new index of each vertex, or UINT_MAX to drop it.
+     */
+    static void remapVertices(void* dst, const void* vertices, unsigned int vertexCount, unsigned int vertexSize, const unsigned int* remap);
+
+    /**
+     * Replaces indices with the new indices of their vertices.
+     *
+     * @param dst The new indices. May be indices.
+     * @param indices The indices.
+     * @param indexCount The number of indices.
+     * @param remap The new index of each vertex.
+     */
+    static void remapIndices(unsigned int* dst, const unsigned int* indices, unsigned int indexCount, const unsigned int* remap);
+
+    /**
+     * Simulates drawing triangles with a FIFO post-transform vertex cache.
+     *
+     * @param indices The indices of the triangles.
+     * @param indexCount The number of indices.
+     * @param vertexCount The number of vertices.
+     * @param cacheSize The number of vertices held by the cache.
+     * @param atvr Set to the average transform to vertex ratio, if not NULL.
+     *
+     * @return The average cache miss ratio.
+     */
+    static float analyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                                    unsigned int cacheSize = 16, float* atvr = NULL);
+
+    /**
+     * Returns the smallest index format holding the indices of a number of vertices.
+     *
+     * @param vertexCount The number of vertices.
+     * @param allowIndex8 true to allow 8-bit indices, which many GPUs convert on the fly.
+     */
+    static Mesh::IndexFormat getIndexFormat(unsigned int vertexCount, bool allowIndex8 = false);
+
+    /**
+     * Optimizes a mesh in place.
+     *
+     * Welds its vertices, optimizes its triangle lists for the vertex cache and overdraw,
+     * reorders its vertices for fetching, drops unused vertices and narrows its indices.
+     * The mesh is uploaded again, its buffers only shrink.
+     *
+     * @param mesh The mesh, with its vertex and index data in memory.
+     * @param statistics Set to the cost of drawing the mesh before and after, if not NULL.
+     * @param allowIndex8 true to allow 8-bit indices.
+     *
+     * @return true if the mesh was optimized, false if its data is not in memory.
+     */
+    static bool optimize(Mesh* mesh, Statistics* statistics = NULL, bool allowIndex8 = false);
+
+private:
+
+    MeshOptimizer();
+};
+
+}
+
+#endif
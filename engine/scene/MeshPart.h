@@ -15,6 +15,7 @@ class MeshPart
 {
     friend class Mesh;
     friend class Model;
+    friend class MeshOptimizer;
 
 public:
 
@@ -0,0 +1,404 @@
+#include "base/Base.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+
+namespace gameplay
+{
+
+/**
+ * A symmetric 4x4 quadric, summing squared distances to planes weighted by triangle area.
+ */
+struct Quadric
+{
+    double a00, a01, a02, a03;
+    double a11, a12, a13;
+    double a22, a23;
+    double a33;
+    double weight;
+};
+
+static void addPlane(Quadric* q, double a, double b, double c, double d, double weight)
+{
+    q->a00 += weight * a * a; q->a01 += weight * a * b; q->a02 += weight * a * c; q->a03 += weight * a * d;
+    q->a11 += weight * b * b; q->a12 += weight * b * c; q->a13 += weight * b * d;
+    q->a22 += weight * c * c; q->a23 += weight * c * d;
+    q->a33 += weight * d * d;
+    q->weight += weight;
+}
+
+static void addQuadric(Quadric* q, const Quadric& other)
+{
+    q->a00 += other.a00; q->a01 += other.a01; q->a02 += other.a02; q->a03 += other.a03;
+    q->a11 += other.a11; q->a12 += other.a12; q->a13 += other.a13;
+    q->a22 += other.a22; q->a23 += other.a23;
+    q->a33 += other.a33;
+    q->weight += other.weight;
+}
+
+// Mean squared distance from a point to the planes of two quadrics.
+static double evaluate(const Quadric& q0, const Quadric& q1, const double* p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    double e = x * x * (q0.a00 + q1.a00) + 2.0 * x * y * (q0.a01 + q1.a01) + 2.0 * x * z * (q0.a02 + q1.a02) + 2.0 * x * (q0.a03 + q1.a03) +
+               y * y * (q0.a11 + q1.a11) + 2.0 * y * z * (q0.a12 + q1.a12) + 2.0 * y * (q0.a13 + q1.a13) +
+               z * z * (q0.a22 + q1.a22) + 2.0 * z * (q0.a23 + q1.a23) +
+               (q0.a33 + q1.a33);
+    double weight = q0.weight + q1.weight;
+    return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+}
+
+static void triangleNormal(const double* p0, const double* p1, const double* p2, double* n)
+{
+    double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+struct Collapse
+{
+    unsigned int from;
+    unsigned int to;
+    double error;
+};
+
+unsigned int MeshSimplifier::simplify(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                                      const float* positions, unsigned int vertexCount, unsigned int vertexStride,
+                                      unsigned int targetIndexCount, float targetError, float* resultError)
+{
+    GP_ASSERT(dst && indices && positions);
+    GP_ASSERT(indexCount % 3 == 0);
+
+    std::vector<unsigned int> result(indices, indices + indexCount);
+    unsigned int count = indexCount;
+
+    // Positions scaled to the unit cube, so errors are relative to the extent of the mesh.
+    std::vector<double> points(vertexCount * 3);
+    double minimum[3] = { DBL_MAX, DBL_MAX, DBL_MAX };
+    double maximum[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        const float* p = (const float*)((const unsigned char*)positions + i * vertexStride);
+        for (int j = 0; j < 3; ++j)
+        {
+            points[i * 3 + j] = p[j];
+            minimum[j] = std::min(minimum[j], (double)p[j]);
+            maximum[j] = std::max(maximum[j], (double)p[j]);
+        }
+    }
+    double extent = std::max(maximum[0] - minimum[0], std::max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+    double scale = extent > 0.0 ? 1.0 / extent : 1.0;
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+            points[i * 3 + j] = (points[i * 3 + j] - minimum[j]) * scale;
+    }
+
+    // Quadrics of the planes of the triangles around each vertex.
+    std::vector<Quadric> quadrics(vertexCount);
+    memset(&quadrics[0], 0, vertexCount * sizeof(Quadric));
+    for (unsigned int i = 0; i < count; i += 3)
+    {
+        const double* p0 = &points[result[i] * 3];
+        double n[3];
+        triangleNormal(p0, &points[result[i + 1] * 3], &points[result[i + 2] * 3], n);
+        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0)
+            continue;
+        n[0] /= length; n[1] /= length; n[2] /= length;
+        double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        double area = length * 0.5;
+        for (int j = 0; j < 3; ++j)
+            addPlane(&quadrics[result[i + j]], n[0], n[1], n[2], d, area);
+    }
+
+    // Vertices on open or non-manifold edges are locked.
+    std::vector<unsigned long long> edges;
+    edges.reserve(count);
+    for (unsigned int i = 0; i < count; i += 3)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            unsigned long long a = result[i + j];
+            unsigned long long b = result[i + (j + 1) % 3];
+            edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<char> locked(vertexCount, 0);
+    for (size_t i = 0, edgeCount = edges.size(); i < edgeCount; )
+    {
+        size_t j = i + 1;
+        while (j < edgeCount && edges[j] == edges[i])
+            ++j;
+        if (j - i != 2)
+        {
+            locked[(unsigned int)(edges[i] >> 32)] = 1;
+            locked[(unsigned int)(edges[i] & 0xFFFFFFFF)] = 1;
+        }
+        i = j;
+    }
+
+    double errorLimit = (double)targetError * targetError;
+    double maxError = 0.0;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1);
+    std::vector<unsigned int> vertexTriangles;
+    std::vector<char> touched(vertexCount);
+    std::vector<Collapse> collapses;
+    while (count > targetIndexCount)
+    {
+        // Triangles around each vertex.
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (unsigned int i = 0; i < count; ++i)
+            ++triangleOffsets[result[i] + 1];
+        for (unsigned int i = 0; i < vertexCount; ++i)
+            triangleOffsets[i + 1] += triangleOffsets[i];
+        vertexTriangles.resize(count);
+        std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (unsigned int i = 0; i < count; ++i)
+            vertexTriangles[fill[result[i]]++] = i / 3;
+
+        // Cheapest direction of each edge.
+        edges.clear();
+        for (unsigned int i = 0; i < count; i += 3)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                unsigned long long a = result[i + j];
+                unsigned long long b = result[i + (j + 1) % 3];
+                edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (size_t i = 0, edgeCount = edges.size(); i < edgeCount; ++i)
+        {
+            unsigned int a = (unsigned int)(edges[i] >> 32);
+            unsigned int b = (unsigned int)(edges[i] & 0xFFFFFFFF);
+            if (locked[a] && locked[b])
+                continue;
+            double errorAB = locked[a] ? DBL_MAX : evaluate(quadrics[a], quadrics[b], &points[b * 3]);
+            double errorBA = locked[b] ? DBL_MAX : evaluate(quadrics[a], quadrics[b], &points[a * 3]);
+            Collapse collapse;
+            collapse.from = errorAB <= errorBA ? a : b;
+            collapse.to = errorAB <= errorBA ? b : a;
+            collapse.error = std::min(errorAB, errorBA);
+            if (collapse.error <= errorLimit)
+                collapses.push_back(collapse);
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+        // Collapse the cheapest edges whose neighbourhoods don't overlap.
+        for (unsigned int i = 0; i < vertexCount; ++i)
+            remap[i] = i;
+        std::fill(touched.begin(), touched.end(), 0);
+        unsigned int removeTarget = (count - targetIndexCount) / 3;
+        unsigned int removed = 0;
+        for (size_t i = 0, collapseCount = collapses.size(); i < collapseCount && removed < removeTarget; ++i)
+        {
+            const Collapse& collapse = collapses[i];
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // Skip collapses flipping the triangles moved with the vertex.
+            bool flips = false;
+            unsigned int degenerate = 0;
+            for (unsigned int t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !flips; ++t)
+            {
+                const unsigned int* triangle = &result[vertexTriangles[t] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    ++degenerate;
+                    continue;
+                }
+                const double* before[3];
+                const double* after[3];
+                for (int j = 0; j < 3; ++j)
+                {
+                    before[j] = &points[triangle[j] * 3];
+                    after[j] = triangle[j] == collapse.from ? &points[collapse.to * 3] : before[j];
+                }
+                double n0[3], n1[3];
+                triangleNormal(before[0], before[1], before[2], n0);
+                triangleNormal(after[0], after[1], after[2], n1);
+                flips = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0;
+            }
+            if (flips)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            addQuadric(&quadrics[collapse.to], quadrics[collapse.from]);
+            maxError = std::max(maxError, collapse.error);
+            removed += degenerate;
+            for (unsigned int t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; ++t)
+            {
+                const unsigned int* triangle = &result[vertexTriangles[t] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+            }
+        }
+        if (removed == 0)
+            break;
+
+        // Apply the collapses and drop the degenerate triangles.
+        unsigned int write = 0;
+        for (unsigned int i = 0; i < count; i += 3)
+        {
+            unsigned int a = remap[result[i]];
+            unsigned int b = remap[result[i + 1]];
+            unsigned int c = remap[result[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        count = write;
+    }
+
+    if (count > 0)
+        memcpy(dst, &result[0], count * sizeof(unsigned int));
+    if (resultError)
+        *resultError = (float)sqrt(maxError);
+    return count;
+}
+
+Mesh* MeshSimplifier::simplify(Mesh* mesh, float ratio, float targetError, float* resultError)
+{
+    GP_ASSERT(mesh);
+
+    const VertexFormat& format = mesh->getVertexFormat();
+    unsigned int positionOffset = 0;
+    unsigned int element = 0;
+    for (; element < format.getElementCount(); ++element)
+    {
+        if (format.getElement(element).usage == VertexFormat::POSITION)
+            break;
+        positionOffset += format.getElement(element).size * sizeof(float);
+    }
+    if (element == format.getElementCount() || format.getElement(element).size < 3 || !mesh->_vertexData)
+    {
+        GP_ERROR("Mesh simplification requires 3D positions in memory.");
+        return NULL;
+    }
+
+    unsigned int vertexCount = mesh->getVertexCount();
+    unsigned int vertexSize = mesh->getVertexSize();
+    const unsigned char* vertexData = (const unsigned char*)mesh->_vertexData;
+
+    // Simplify the triangle lists of the parts.
+    unsigned int partCount = mesh->getPartCount();
+    if (partCount == 0)
+    {
+        GP_ERROR("Mesh simplification requires an indexed mesh with at least one part.");
+        return NULL;
+    }
+    std::vector<std::vector<unsigned int> > partIndices(partCount);
+    float maxError = 0.0f;
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        MeshPart* part = mesh->getPart(i);
+        unsigned int indexCount = part->getIndexCount();
+        if (!part->_indexData)
+        {
+            GP_ERROR("Mesh simplification requires the indices of part %u in memory.", i);
+            return NULL;
+        }
+
+        std::vector<unsigned int>& indices = partIndices[i];
+        indices.resize(indexCount);
+        for (unsigned int j = 0; j < indexCount; ++j)
+        {
+            switch (part->getIndexFormat())
+            {
+            case Mesh::INDEX8:
+                indices[j] = ((const unsigned char*)part->_indexData)[j];
+                break;
+            case Mesh::INDEX16:
+                indices[j] = ((const unsigned short*)part->_indexData)[j];
+                break;
+            default:
+                indices[j] = ((const unsigned int*)part->_indexData)[j];
+                break;
+            }
+        }
+
+        if (part->getPrimitiveType() == Mesh::TRIANGLES && indexCount >= 3)
+        {
+            unsigned int target = std::max((unsigned int)(indexCount / 3 * ratio), 1u) * 3;
+            float error = 0.0f;
+            unsigned int count = simplify(&indices[0], &indices[0], indexCount - indexCount % 3,
+                (const float*)(vertexData + positionOffset), vertexCount, vertexSize, target, targetError, &error);
+            indices.resize(count);
+            maxError = std::max(maxError, error);
+
+            // Collapses leave the triangles in no useful order for the vertex cache.
+            if (count > 0)
+            {
+                std::vector<unsigned int> reordered(count);
+                MeshOptimizer::optimizeVertexCache(&reordered[0], &indices[0], count, vertexCount);
+                indices.swap(reordered);
+            }
+        }
+    }
+
+    // Drop the vertices no longer referenced, in the order they are used.
+    std::vector<unsigned int> remap(vertexCount, UINT_MAX);
+    unsigned int newVertexCount = 0;
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        std::vector<unsigned int>& indices = partIndices[i];
+        for (size_t j = 0; j < indices.size(); ++j)
+        {
+            unsigned int& index = remap[indices[j]];
+            if (index == UINT_MAX)
+                index = newVertexCount++;
+            indices[j] = index;
+        }
+    }
+    std::vector<unsigned char> newVertexData(std::max(newVertexCount, 1u) * vertexSize);
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        if (remap[i] != UINT_MAX)
+            memcpy(&newVertexData[remap[i] * vertexSize], vertexData + i * vertexSize, vertexSize);
+    }
+
+    Mesh* simplified = Mesh::createMesh(format, newVertexCount, false);
+    simplified->setPrimitiveType(mesh->getPrimitiveType());
+    if (newVertexCount > 0)
+        simplified->setVertexData(&newVertexData[0], 0, newVertexCount);
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        MeshPart* part = mesh->getPart(i);
+        const std::vector<unsigned int>& indices = partIndices[i];
+        Mesh::IndexFormat indexFormat = newVertexCount <= 65536 ? Mesh::INDEX16 : Mesh::INDEX32;
+        MeshPart* newPart = simplified->addPart(part->getPrimitiveType(), indexFormat, (unsigned int)indices.size(), false);
+        if (indices.empty())
+            continue;
+        if (indexFormat == Mesh::INDEX16)
+        {
+            std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            newPart->setIndexData(&shortIndices[0], 0, (unsigned int)shortIndices.size());
+        }
+        else
+        {
+            newPart->setIndexData(&indices[0], 0, (unsigned int)indices.size());
+        }
+    }
+    simplified->setBoundingBox(mesh->getBoundingBox());
+    simplified->setBoundingSphere(mesh->getBoundingSphere());
+
+    if (resultError)
+        *resultError = maxError;
+    return simplified;
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef MESHSIMPLIFIER_H_
+#define MESHSIMPLIFIER_H_
+
+#include "base/Base.h"
+
+namespace gameplay
+{
+
+class Mesh;
+
+/**
+ * Defines an offline mesh simplifier based on quadric error metrics.
+ *
+ * Edges are collapsed in order of the quadric error they introduce, measured as the mean
+ * squared distance to the planes of the triangles merged into each vertex. Vertices are
+ * only moved onto one of their neighbours, so the attributes of the remaining vertices
+ * stay valid. Vertices on open edges, including attribute seams where vertices are split,
+ * are kept in place, and collapses that would flip a triangle are skipped.
+ *
+ * Errors are relative to the largest extent of the mesh.
+ */
+class MeshSimplifier
+{
+public:
+
+    /**
+     * Simplifies an indexed triangle list.
+     *
+     * @param dst The simplified indices. Holds up to indexCount indices, and may be indices.
+     * @param indices The indices of the triangles.
+     * @param indexCount The number of indices.
+     * @param positions The position of the first vertex, three floats.
+     * @param vertexCount The number of vertices.
+     * @param vertexStride The distance between the positions of consecutive vertices, in bytes.
+     * @param targetIndexCount The number of indices to reduce to.
+     * @param targetError The largest error allowed, relative to the extent of the mesh.
+     * @param resultError Set to the error of the simplified triangles, if not NULL.
+     *
+     * @return The number of simplified indices. More than targetIndexCount when
+     *         targetError is reached first or no further edge can be collapsed.
+     */
+    static unsigned int simplify(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                                 const float* positions, unsigned int vertexCount, unsigned int vertexStride,
+                                 unsigned int targetIndexCount, float targetError = 1.0f, float* resultError = NULL);
+
+    /**
+     * Creates a simplified copy of a mesh.
+     *
+     * The triangle lists of each part are simplified, other parts are copied. Vertices
+     * no longer used are removed. The copy keeps the bounds of the mesh.
+     *
+     * @param mesh The mesh, with its vertex and index data in memory.
+     * @param ratio The fraction of the triangles to keep.
+     * @param targetError The largest error allowed, relative to the extent of the mesh.
+     * @param resultError Set to the largest error of the simplified parts, if not NULL.
+     *
+     * @return The simplified mesh, or NULL if the mesh has no parts, no position or data in memory.
+     */
+    static Mesh* simplify(Mesh* mesh, float ratio, float targetError = 1.0f, float* resultError = NULL);
+
+private:
+
+    MeshSimplifier();
+};
+
+}
+
+#endif
@@ -219,7 +219,13 @@ unsigned int Model::draw(RenderView* view)
 {
     GP_ASSERT(_mesh);
 
-    Renderer::cur()->renderMesh(_mesh, _material, _partMaterials.size(), _partMaterials.data(), view, _node);
+    Material* overrideMaterial = view ? view->overrideMaterial : NULL;
+    if (overrideMaterial && _skin)
+        overrideMaterial = _skin->getJointCount() <= view->overrideJointCount ? view->overrideSkinnedMaterial : NULL;
+    if (overrideMaterial)
+        Renderer::cur()->renderMesh(_mesh, overrideMaterial, 0, NULL, view, _node);
+    else
+        Renderer::cur()->renderMesh(_mesh, _material, _partMaterials.size(), _partMaterials.data(), view, _node);
 
     return _mesh->getPartCount();
 }
@@ -25,6 +25,7 @@ class Model : public Serializable, public Drawable, public Ref
     friend class Scene;
     friend class Mesh;
     friend class Bundle;
+    friend class SceneSnapshot;
 
 public:
 
@@ -9,6 +9,7 @@
 //#include "physics/PhysicsGhostObject.h"
 //#include "physics/PhysicsCharacter.h"
 #include "objects/Terrain.h"
+#include "LodGroup.h"
 #include "platform/Toolkit.h"
 #include "Drawable.h"
 //#include "ui/Form.h"
@@ -823,24 +824,30 @@ const BoundingSphere& Node::getBoundingSphere() const
                 _bounds.merge(model->getMesh()->getBoundingSphere());
             }
         }
-        if (_light)
+        LodGroup* lodGroup = dynamic_cast<LodGroup*>(_drawable);
+        if (lodGroup && lodGroup->getLevelCount() > 0)
         {
-            switch (_light->getLightType())
+            if (empty)
             {
-            case Light::POINT:
-                if (empty)
-                {
-                    _bounds.set(Vector3::zero(), _light->getRange());
-                    empty = false;
-                }
-                else
-                {
-                    _bounds.merge(BoundingSphere(Vector3::zero(), _light->getRange()));
-                }
-                break;
-            case Light::SPOT:
-                // TODO: Implement spot light bounds
-                break;
+                _bounds.set(lodGroup->getBoundingSphere());
+                empty = false;
+            }
+            else
+            {
+                _bounds.merge(lodGroup->getBoundingSphere());
+            }
+        }
+        BoundingSphere lightBounds;
+        if (_light && _light->getBoundingSphere(&lightBounds))
+        {
+            if (empty)
+            {
+                _bounds.set(lightBounds);
+                empty = false;
+            }
+            else
+            {
+                _bounds.merge(lightBounds);
             }
         }
         if (empty)
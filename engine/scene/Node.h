@@ -43,6 +43,7 @@ class Node : public Transform, public Serializable, public Ref
     friend class Bundle;
     friend class MeshSkin;
     friend class Light;
+    friend class SceneSnapshot;
 #ifdef GP_SCRIPT
     GP_SCRIPT_EVENTS_START();
     GP_SCRIPT_EVENT(update, "<Node>f");
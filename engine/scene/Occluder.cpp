@@ -0,0 +1,76 @@
+#include "base/Base.h"
+#include "Occluder.h"
+
+namespace gameplay
+{
+
+Occluder::Occluder() : _node(NULL)
+{
+}
+
+Occluder::~Occluder()
+{
+}
+
+Occluder* Occluder::create(const Vector3* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
+{
+    GP_ASSERT(vertices && indices);
+    if (indexCount % 3 != 0)
+    {
+        GP_ERROR("Occluder index count must be a multiple of 3 (%u).", indexCount);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < indexCount; ++i)
+    {
+        if (indices[i] >= vertexCount)
+        {
+            GP_ERROR("Occluder index out of range (%u >= %u).", indices[i], vertexCount);
+            return NULL;
+        }
+    }
+
+    Occluder* occluder = new Occluder();
+    occluder->_vertices.assign(vertices, vertices + vertexCount);
+    occluder->_indices.assign(indices, indices + indexCount);
+    return occluder;
+}
+
+Occluder* Occluder::createBox(const BoundingBox& box)
+{
+    Vector3 corners[8];
+    box.getCorners(corners);
+
+    // Corners are ordered near face (z max) LT, LB, RB, RT, then far face (z min) RT, RB, LB, LT.
+    static const unsigned short indices[36] =
+    {
+        0, 1, 2,  0, 2, 3,  // near
+        4, 5, 6,  4, 6, 7,  // far
+        7, 6, 1,  7, 1, 0,  // left
+        3, 2, 5,  3, 5, 4,  // right
+        7, 0, 3,  7, 3, 4,  // top
+        1, 6, 5,  1, 5, 2   // bottom
+    };
+    return create(corners, 8, indices, 36);
+}
+
+Node* Occluder::getNode() const
+{
+    return _node;
+}
+
+void Occluder::setNode(Node* node)
+{
+    _node = node;
+}
+
+const std::vector<Vector3>& Occluder::getVertices() const
+{
+    return _vertices;
+}
+
+const std::vector<unsigned short>& Occluder::getIndices() const
+{
+    return _indices;
+}
+
+}
@@ -0,0 +1,104 @@
+#ifndef OCCLUDER_H_
+#define OCCLUDER_H_
+
+#include "base/Ref.h"
+#include "scene/Component.h"
+#include "math/Vector3.h"
+#include "math/BoundingBox.h"
+
+namespace gameplay
+{
+
+class Node;
+
+/**
+ * Defines a low-poly proxy mesh used to hide other objects during occlusion culling.
+ *
+ * Occluders are attached to nodes with Node::addComponent(), and are rasterized by the
+ * OcclusionCuller with the world transform of their node. The proxy must lie inside the
+ * geometry it stands for (for example the inner walls of a building), otherwise objects
+ * that are actually visible through the geometry may be culled.
+ */
+class Occluder : public Ref, public Component
+{
+public:
+
+    /**
+     * Creates an occluder from an indexed triangle list.
+     *
+     * @param vertices The positions of the vertices, in the local space of the node.
+     * @param vertexCount The number of vertices.
+     * @param indices The indices of the triangles, three per triangle.
+     * @param indexCount The number of indices.
+     *
+     * @return The new occluder.
+     * @script{create}
+     */
+    static Occluder* create(const Vector3* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount);
+
+    /**
+     * Creates an occluder from a box.
+     *
+     * @param box The box, in the local space of the node.
+     *
+     * @return The new occluder.
+     * @script{create}
+     */
+    static Occluder* createBox(const BoundingBox& box);
+
+    /**
+     * Returns the node this occluder is attached to.
+     *
+     * @return The node, or NULL.
+     */
+    Node* getNode() const;
+
+    /**
+     * @see Component::setNode
+     */
+    void setNode(Node* node);
+
+    /**
+     * Returns the vertices of the proxy.
+     *
+     * @return The positions of the vertices, in the local space of the node.
+     */
+    const std::vector<Vector3>& getVertices() const;
+
+    /**
+     * Returns the triangles of the proxy.
+     *
+     * @return The indices of the triangles, three per triangle.
+     */
+    const std::vector<unsigned short>& getIndices() const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    Occluder();
+
+    /**
+     * Destructor.
+     */
+    ~Occluder();
+
+    /**
+     * Hidden copy constructor.
+     */
+    Occluder(const Occluder& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Occluder& operator=(const Occluder&);
+
+    Node* _node;
+    std::vector<Vector3> _vertices;
+    std::vector<unsigned short> _indices;
+};
+
+}
+
+#endif
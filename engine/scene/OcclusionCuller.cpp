@@ -0,0 +1,342 @@
+#include "base/Base.h"
+#include "OcclusionCuller.h"
+#include "Occluder.h"
+#include "base/ThreadPool.h"
+#include "math/MathUtil.h"
+#include <cfloat>
+
+// Rows of the depth buffer rasterized by one task; a multiple of the tile size.
+#define BAND_HEIGHT 16
+// Size of the tiles of the hierarchical depth buffer.
+#define TILE_SIZE 8
+// Smallest w of a vertex in front of the camera.
+#define NEAR_EPSILON 1e-5f
+
+namespace gameplay
+{
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height) :
+    _width(0), _height(0), _tilesX(0), _tilesY(0)
+{
+    _width = std::max((width + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE, (unsigned int)TILE_SIZE);
+    _height = std::max((height + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE, (unsigned int)TILE_SIZE);
+    _tilesX = _width / TILE_SIZE;
+    _tilesY = _height / TILE_SIZE;
+    _depth.resize(_width * _height, 1.0f);
+    _hiz.resize(_tilesX * _tilesY, 1.0f);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+unsigned int OcclusionCuller::getWidth() const
+{
+    return _width;
+}
+
+unsigned int OcclusionCuller::getHeight() const
+{
+    return _height;
+}
+
+void OcclusionCuller::begin(const Matrix& viewProjection)
+{
+    _viewProjection = viewProjection;
+    _triangles.clear();
+}
+
+void OcclusionCuller::addOccluder(const Occluder* occluder, const Matrix& world)
+{
+    GP_ASSERT(occluder);
+    const std::vector<Vector3>& vertices = occluder->getVertices();
+    const std::vector<unsigned short>& indices = occluder->getIndices();
+    if (vertices.empty() || indices.empty())
+        return;
+    addTriangles(&vertices[0], (unsigned int)vertices.size(), &indices[0], (unsigned int)indices.size(), world);
+}
+
+void OcclusionCuller::addTriangles(const Vector3* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount, const Matrix& world)
+{
+    GP_ASSERT(vertices && indices);
+
+    Matrix worldViewProjection;
+    Matrix::multiply(_viewProjection, world, &worldViewProjection);
+    const float* m = worldViewProjection.m;
+
+    // Transform the vertices to screen space, keeping w to detect the ones behind the near plane.
+    _clipVertices.resize(vertexCount);
+    const float halfWidth = _width * 0.5f;
+    const float halfHeight = _height * 0.5f;
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        const Vector3& v = vertices[i];
+        float x = m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12];
+        float y = m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13];
+        float z = m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14];
+        float w = m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15];
+
+        Vector4& dst = _clipVertices[i];
+        if (w < NEAR_EPSILON || z < -w)
+        {
+            dst.set(0.0f, 0.0f, 0.0f, -1.0f);
+            continue;
+        }
+        float invW = 1.0f / w;
+        dst.x = (x * invW + 1.0f) * halfWidth;
+        dst.y = (1.0f - y * invW) * halfHeight;
+        dst.z = (z * invW) * 0.5f + 0.5f;
+        dst.w = w;
+    }
+
+    for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        GP_ASSERT(indices[i] < vertexCount && indices[i + 1] < vertexCount && indices[i + 2] < vertexCount);
+        const Vector4& v0 = _clipVertices[indices[i]];
+        const Vector4& v1 = _clipVertices[indices[i + 1]];
+        const Vector4& v2 = _clipVertices[indices[i + 2]];
+
+        // Triangles crossing the near plane would need clipping; skipping them only
+        // makes the culler occlude less.
+        if (v0.w < 0.0f || v1.w < 0.0f || v2.w < 0.0f)
+            continue;
+
+        Triangle t;
+        t.minX = std::max((int)floorf(std::min(v0.x, std::min(v1.x, v2.x))), 0);
+        t.minY = std::max((int)floorf(std::min(v0.y, std::min(v1.y, v2.y))), 0);
+        t.maxX = std::min((int)ceilf(std::max(v0.x, std::max(v1.x, v2.x))), (int)_width - 1);
+        t.maxY = std::min((int)ceilf(std::max(v0.y, std::max(v1.y, v2.y))), (int)_height - 1);
+        if (t.minX > t.maxX || t.minY > t.maxY)
+            continue;
+
+        // Edge functions A * x + B * y + C, the weight of the vertex opposite to each edge
+        // scaled by the signed area of the triangle.
+        const Vector4* v[3] = { &v0, &v1, &v2 };
+        for (int e = 0; e < 3; ++e)
+        {
+            const Vector4& a = *v[(e + 1) % 3];
+            const Vector4& b = *v[(e + 2) % 3];
+            t.edgeA[e] = a.y - b.y;
+            t.edgeB[e] = b.x - a.x;
+            t.edgeC[e] = a.x * b.y - a.y * b.x;
+        }
+        float area = t.edgeA[0] * v0.x + t.edgeB[0] * v0.y + t.edgeC[0];
+        if (fabsf(area) < MATH_EPSILON)
+            continue;
+
+        // Depth plane, interpolating the depths of the vertices with their weights.
+        float invArea = 1.0f / area;
+        float dz1 = (v1.z - v0.z) * invArea;
+        float dz2 = (v2.z - v0.z) * invArea;
+        t.depthA = dz1 * t.edgeA[1] + dz2 * t.edgeA[2];
+        t.depthB = dz1 * t.edgeB[1] + dz2 * t.edgeB[2];
+        t.depthC = v0.z + dz1 * t.edgeC[1] + dz2 * t.edgeC[2];
+
+        // Both windings are occluding; orient the edges so inside pixels are positive.
+        if (area < 0.0f)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                t.edgeA[e] = -t.edgeA[e];
+                t.edgeB[e] = -t.edgeB[e];
+                t.edgeC[e] = -t.edgeC[e];
+            }
+        }
+        _triangles.push_back(t);
+    }
+}
+
+void OcclusionCuller::rasterize(ThreadPool* pool)
+{
+    unsigned int bandCount = (_height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    if (pool && !_triangles.empty())
+    {
+        pool->parallelFor(bandCount, 1, [this](unsigned int start, unsigned int end)
+        {
+            for (unsigned int band = start; band < end; ++band)
+                rasterizeBand(band);
+        });
+    }
+    else
+    {
+        for (unsigned int band = 0; band < bandCount; ++band)
+            rasterizeBand(band);
+    }
+}
+
+void OcclusionCuller::rasterizeBand(unsigned int band)
+{
+    int minY = band * BAND_HEIGHT;
+    int maxY = std::min(minY + BAND_HEIGHT, (int)_height) - 1;
+
+    std::fill(_depth.begin() + minY * _width, _depth.begin() + (maxY + 1) * _width, 1.0f);
+    for (size_t i = 0, count = _triangles.size(); i < count; ++i)
+    {
+        const Triangle& t = _triangles[i];
+        if (t.maxY >= minY && t.minY <= maxY)
+            rasterizeTriangle(t, std::max(t.minY, minY), std::min(t.maxY, maxY));
+    }
+
+    // Reduce the tiles of the band to their farthest depth.
+    for (int tileY = minY / TILE_SIZE; tileY <= maxY / TILE_SIZE; ++tileY)
+    {
+        for (unsigned int tileX = 0; tileX < _tilesX; ++tileX)
+        {
+            const float* row = &_depth[tileY * TILE_SIZE * _width + tileX * TILE_SIZE];
+            float farthest = 0.0f;
+            for (int y = 0; y < TILE_SIZE; ++y, row += _width)
+            {
+                for (int x = 0; x < TILE_SIZE; ++x)
+                    farthest = std::max(farthest, row[x]);
+            }
+            _hiz[tileY * _tilesX + tileX] = farthest;
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const Triangle& t, int minY, int maxY)
+{
+#ifdef GP_USE_SSE
+    // Four pixels at a time; the width is a multiple of 8 so groups never cross a row.
+    int startX = t.minX & ~3;
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 a0 = _mm_set1_ps(t.edgeA[0]);
+    const __m128 a1 = _mm_set1_ps(t.edgeA[1]);
+    const __m128 a2 = _mm_set1_ps(t.edgeA[2]);
+    const __m128 da = _mm_set1_ps(t.depthA);
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float py = y + 0.5f;
+        __m128 c0 = _mm_set1_ps(t.edgeB[0] * py + t.edgeC[0]);
+        __m128 c1 = _mm_set1_ps(t.edgeB[1] * py + t.edgeC[1]);
+        __m128 c2 = _mm_set1_ps(t.edgeB[2] * py + t.edgeC[2]);
+        __m128 dc = _mm_set1_ps(t.depthB * py + t.depthC);
+        float* row = &_depth[y * _width];
+        for (int x = startX; x <= t.maxX; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            __m128 w0 = _mm_add_ps(_mm_mul_ps(a0, px), c0);
+            __m128 w1 = _mm_add_ps(_mm_mul_ps(a1, px), c1);
+            __m128 w2 = _mm_add_ps(_mm_mul_ps(a2, px), c2);
+
+            // Inside when no weight is negative.
+            __m128 outside = _mm_or_ps(_mm_or_ps(w0, w1), w2);
+            if (_mm_movemask_ps(outside) == 0xF)
+                continue;
+
+            // Keep the depth of the pixels outside, whose sign bit is set.
+            __m128 keep = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(outside), 31));
+            __m128 z = _mm_add_ps(_mm_mul_ps(da, px), dc);
+            __m128 depth = _mm_loadu_ps(row + x);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(keep, depth), _mm_andnot_ps(keep, _mm_min_ps(depth, z))));
+        }
+    }
+#else
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float py = y + 0.5f;
+        float* row = &_depth[y * _width];
+        for (int x = t.minX; x <= t.maxX; ++x)
+        {
+            float px = x + 0.5f;
+            if (t.edgeA[0] * px + t.edgeB[0] * py + t.edgeC[0] < 0.0f ||
+                t.edgeA[1] * px + t.edgeB[1] * py + t.edgeC[1] < 0.0f ||
+                t.edgeA[2] * px + t.edgeB[2] * py + t.edgeC[2] < 0.0f)
+                continue;
+
+            float z = t.depthA * px + t.depthB * py + t.depthC;
+            if (z < row[x])
+                row[x] = z;
+        }
+    }
+#endif
+}
+
+bool OcclusionCuller::isVisible(const BoundingBox& box) const
+{
+    if (box.isEmpty())
+        return true;
+
+    Vector3 corners[8];
+    box.getCorners(corners);
+
+    // Screen rectangle and nearest depth of the box.
+    const float* m = _viewProjection.m;
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float nearest = FLT_MAX;
+    for (int i = 0; i < 8; ++i)
+    {
+        const Vector3& v = corners[i];
+        float x = m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12];
+        float y = m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13];
+        float z = m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14];
+        float w = m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15];
+        if (w < NEAR_EPSILON || z < -w)
+            return true;
+
+        float invW = 1.0f / w;
+        float sx = (x * invW + 1.0f) * _width * 0.5f;
+        float sy = (1.0f - y * invW) * _height * 0.5f;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        nearest = std::min(nearest, (z * invW) * 0.5f + 0.5f);
+    }
+
+    // Boxes leaving the screen are left to frustum culling.
+    if (minX < 0.0f || minY < 0.0f || maxX > _width || maxY > _height)
+        return true;
+
+    int x0 = (int)minX;
+    int y0 = (int)minY;
+    int x1 = std::min((int)maxX, (int)_width - 1);
+    int y1 = std::min((int)maxY, (int)_height - 1);
+    for (int tileY = y0 / TILE_SIZE; tileY <= y1 / TILE_SIZE; ++tileY)
+    {
+        for (int tileX = x0 / TILE_SIZE; tileX <= x1 / TILE_SIZE; ++tileX)
+        {
+            if (_hiz[tileY * _tilesX + tileX] < nearest)
+                continue;
+
+            // Some pixel of the tile is behind the box; check the ones it covers.
+            int tx0 = std::max(x0, tileX * TILE_SIZE);
+            int ty0 = std::max(y0, tileY * TILE_SIZE);
+            int tx1 = std::min(x1, tileX * TILE_SIZE + TILE_SIZE - 1);
+            int ty1 = std::min(y1, tileY * TILE_SIZE + TILE_SIZE - 1);
+            for (int y = ty0; y <= ty1; ++y)
+            {
+                const float* row = &_depth[y * _width];
+                for (int x = tx0; x <= tx1; ++x)
+                {
+                    if (row[x] >= nearest)
+                        return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool OcclusionCuller::isVisible(const BoundingSphere& sphere) const
+{
+    Vector3 extent(sphere.radius, sphere.radius, sphere.radius);
+    return isVisible(BoundingBox(sphere.center - extent, sphere.center + extent));
+}
+
+unsigned int OcclusionCuller::getTriangleCount() const
+{
+    return (unsigned int)_triangles.size();
+}
+
+const float* OcclusionCuller::getDepthBuffer() const
+{
+    return &_depth[0];
+}
+
+const float* OcclusionCuller::getHierarchicalDepthBuffer() const
+{
+    return &_hiz[0];
+}
+
+}
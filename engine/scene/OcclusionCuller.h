@@ -0,0 +1,176 @@
+#ifndef OCCLUSIONCULLER_H_
+#define OCCLUSIONCULLER_H_
+
+#include "base/Base.h"
+#include "math/Matrix.h"
+#include "math/Vector4.h"
+#include "math/BoundingBox.h"
+#include "math/BoundingSphere.h"
+
+namespace gameplay
+{
+
+class Occluder;
+class ThreadPool;
+
+/**
+ * Defines a CPU occlusion culler.
+ *
+ * Each frame, the triangles of the occluders in view are rasterized into a small depth
+ * buffer, which is reduced into a hierarchical depth buffer holding the farthest depth of
+ * each 8x8 pixel tile. Bounding volumes are then tested against it, first per tile and
+ * then per pixel, and are reported hidden when they are behind the occluders at every
+ * pixel they cover.
+ *
+ * The culler is conservative: triangles crossing the near plane are not rasterized, and
+ * volumes crossing the near plane or leaving the screen are always reported visible.
+ * It does not use the GPU.
+ *
+ * Usage, once per frame:
+ * begin() with the view projection matrix of the camera, addOccluder() for each occluder,
+ * rasterize(), then isVisible() for each candidate.
+ */
+class OcclusionCuller
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param width The width of the depth buffer, in pixels. Rounded up to a multiple of 8.
+     * @param height The height of the depth buffer, in pixels. Rounded up to a multiple of 8.
+     */
+    OcclusionCuller(unsigned int width = 256, unsigned int height = 128);
+
+    /**
+     * Destructor.
+     */
+    ~OcclusionCuller();
+
+    /**
+     * Returns the width of the depth buffer.
+     *
+     * @return The width, in pixels.
+     */
+    unsigned int getWidth() const;
+
+    /**
+     * Returns the height of the depth buffer.
+     *
+     * @return The height, in pixels.
+     */
+    unsigned int getHeight() const;
+
+    /**
+     * Starts a frame, removing all the occluders.
+     *
+     * @param viewProjection The view projection matrix of the camera.
+     */
+    void begin(const Matrix& viewProjection);
+
+    /**
+     * Adds the triangles of an occluder to the frame.
+     *
+     * @param occluder The occluder.
+     * @param world The world matrix of the occluder.
+     */
+    void addOccluder(const Occluder* occluder, const Matrix& world);
+
+    /**
+     * Adds triangles to the frame.
+     *
+     * @param vertices The positions of the vertices.
+     * @param vertexCount The number of vertices.
+     * @param indices The indices of the triangles, three per triangle.
+     * @param indexCount The number of indices.
+     * @param world The world matrix of the vertices.
+     */
+    void addTriangles(const Vector3* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount, const Matrix& world);
+
+    /**
+     * Rasterizes the triangles of the frame and builds the hierarchical depth buffer.
+     *
+     * @param pool The thread pool to rasterize bands of the depth buffer on, or NULL
+     *        to rasterize on the calling thread.
+     */
+    void rasterize(ThreadPool* pool = NULL);
+
+    /**
+     * Determines if a box may be visible.
+     *
+     * @param box The box, in world space.
+     *
+     * @return False if the box is hidden by the occluders, true otherwise.
+     */
+    bool isVisible(const BoundingBox& box) const;
+
+    /**
+     * Determines if a sphere may be visible.
+     *
+     * @param sphere The sphere, in world space.
+     *
+     * @return False if the sphere is hidden by the occluders, true otherwise.
+     */
+    bool isVisible(const BoundingSphere& sphere) const;
+
+    /**
+     * Returns the number of triangles added to the frame, after the ones outside of
+     * the screen or crossing the near plane were discarded.
+     *
+     * @return The number of triangles.
+     */
+    unsigned int getTriangleCount() const;
+
+    /**
+     * Returns the depth buffer.
+     *
+     * Rows are stored from the top of the screen, with depths in [0, 1] where 1 is the
+     * far plane.
+     *
+     * @return The depths, getWidth() * getHeight() values.
+     */
+    const float* getDepthBuffer() const;
+
+    /**
+     * Returns the hierarchical depth buffer.
+     *
+     * @return The farthest depth of each 8x8 pixel tile, (getWidth() / 8) * (getHeight() / 8) values.
+     */
+    const float* getHierarchicalDepthBuffer() const;
+
+private:
+
+    /**
+     * A triangle in screen space, with its edge functions and depth plane.
+     */
+    struct Triangle
+    {
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        float depthA, depthB, depthC;
+        int minX, minY, maxX, maxY;
+    };
+
+    OcclusionCuller(const OcclusionCuller&);
+
+    OcclusionCuller& operator=(const OcclusionCuller&);
+
+    void rasterizeBand(unsigned int band);
+
+    void rasterizeTriangle(const Triangle& triangle, int minY, int maxY);
+
+    unsigned int _width;
+    unsigned int _height;
+    unsigned int _tilesX;
+    unsigned int _tilesY;
+    Matrix _viewProjection;
+    std::vector<float> _depth;
+    std::vector<float> _hiz;
+    std::vector<Triangle> _triangles;
+    std::vector<Vector4> _clipVertices;
+};
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include "material/Texture.h"
 #include "material/ShaderProgram.h"
 #include "material/MaterialParameter.h"
+#include "material/UniformBuffer.h"
 #include "material/VertexAttributeBinding.h"
 
 namespace gameplay
@@ -52,6 +53,7 @@ public:
 	virtual void updateMeshPart(MeshPart* part, unsigned int indexStart, unsigned int indexCount) = 0;
 public:
     virtual void updateTexture(Texture* texture) = 0;
+    virtual void updateTextureRegion(Texture* texture, int x, int y, unsigned int width, unsigned int height) = 0;
     virtual void deleteTexture(Texture* texture) = 0;
     virtual void bindTextureSampler(Texture* texture) = 0;
 
@@ -73,6 +75,23 @@ public:
     virtual void bindProgram(ShaderProgram* effect) = 0;
     virtual void bindUniform(MaterialParameter *value, Uniform *uniform, ShaderProgram* effect) = 0;
 
+    /**
+     * Returns the buffer shared by all effects for a per-frame or per-draw uniform block,
+     * grown to the size of the block.
+     *
+     * @return The shared buffer, or NULL for per-material blocks.
+     */
+    virtual UniformBuffer* getSharedUniformBuffer(UniformBlock* block) = 0;
+
+    /**
+     * Uploads the buffers of the uniform blocks of an effect that changed and binds them.
+     *
+     * @param effect The bound effect.
+     * @param buffers The buffer of each block of the effect, in block order.
+     */
+    virtual void bindUniformBlocks(ShaderProgram* effect, UniformBuffer** buffers) = 0;
+    virtual void deleteUniformBuffer(UniformBuffer* buffer) = 0;
+
     //virtual void bindVertexAttributeObj(VertexAttributeBinding *vertextAttribute) = 0;
     //virtual void unbindVertexAttributeObj(VertexAttributeBinding* vertextAttribute) = 0;
     //virtual void deleteVertexAttributeObj(VertexAttributeBinding* vertextAttribute) = 0;
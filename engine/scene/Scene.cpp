@@ -4,6 +4,7 @@
 #include "MeshSkin.h"
 #include "BoneJoint.h"
 #include "objects/Terrain.h"
+#include "SceneSnapshot.h"
 #include "../base/SerializerJson.h"
 
 #define SCENE_NAME ""
@@ -101,7 +102,12 @@ Scene* Scene::create(const char* id)
 
 Scene* Scene::load(const char* filePath)
 {
+    if (SceneSnapshot::isSnapshot(filePath))
+        return SceneSnapshot::load(filePath);
+
     auto rs = SerializerJson::createReader(filePath);
+    if (rs == NULL)
+        return NULL;
     Scene* scene = dynamic_cast<Scene*>(rs->readObject(NULL));
     rs->close();
     delete rs;
@@ -17,6 +17,8 @@ namespace gameplay
  */
 class Scene : public Serializable, public Ref
 {
+    friend class SceneSnapshot;
+
 public:
 
     /**
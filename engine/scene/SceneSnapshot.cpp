@@ -0,0 +1,704 @@
+#include "base/Base.h"
+#include "SceneSnapshot.h"
+#include "Scene.h"
+#include "AssetManager.h"
+#include "MeshSkin.h"
+#include "material/Material.h"
+#include "base/FileSystem.h"
+#include "base/Serializer.h"
+
+// "GPSS", the identifier of snapshot files
+#define SNAPSHOT_MAGIC 0x53535047
+
+// Written in the byte order of the platform, to detect snapshots of the other byte order
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+// Alignment of the tables in the file
+#define SNAPSHOT_ALIGNMENT 16
+
+// Index or offset of nothing
+#define SNAPSHOT_NONE 0xffffffff
+
+// Node flags
+#define SNAPSHOT_NODE_ENABLED 0x01
+#define SNAPSHOT_NODE_STATIC 0x02
+
+namespace gameplay
+{
+
+enum SnapshotTable
+{
+    TABLE_STRINGS,
+    TABLE_NODES,
+    TABLE_COMPONENTS,
+    TABLE_CAMERAS,
+    TABLE_LIGHTS,
+    TABLE_MODELS,
+    TABLE_ASSETS,
+    TABLE_ASSET_REFS,
+    TABLE_COUNT
+};
+
+enum SnapshotComponentType
+{
+    COMPONENT_CAMERA,
+    COMPONENT_LIGHT,
+    COMPONENT_MODEL,
+    COMPONENT_TYPE_COUNT
+};
+
+struct SnapshotTableInfo
+{
+    uint32_t offset;
+    uint32_t count;
+    uint32_t stride;
+};
+
+struct SnapshotHeader
+{
+    uint32_t magic;
+    uint32_t byteOrder;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint32_t size;
+    SnapshotTableInfo tables[TABLE_COUNT];
+    uint32_t sceneName;
+    uint32_t streaming;
+    uint32_t activeCamera;  // Index of the node of the active camera
+    uint32_t reserved;
+};
+
+// Nodes are stored depth-first, so parents come before their children.
+struct SnapshotNode
+{
+    uint32_t name;
+    uint32_t parent;
+    uint32_t flags;
+    uint32_t firstComponent;
+    uint32_t componentCount;
+    float translation[3];
+    float rotation[4];
+    float scale[3];
+    uint32_t reserved;
+};
+
+struct SnapshotComponent
+{
+    uint32_t type;
+    uint32_t index;  // Index in the table of the type
+};
+
+struct SnapshotCamera
+{
+    uint32_t type;
+    float fieldOfView;
+    float zoom[2];
+    float aspectRatio;
+    float nearPlane;
+    float farPlane;
+};
+
+struct SnapshotLight
+{
+    uint32_t type;
+    float color[3];
+    float intensity;
+    float range;
+    float innerAngle;
+    float outerAngle;
+    uint32_t lighting;
+    uint32_t shadows;
+};
+
+struct SnapshotModel
+{
+    uint32_t mesh;
+    uint32_t skin;
+    uint32_t material;
+    uint32_t firstPartMaterial;  // Index in the asset references
+    uint32_t partMaterialCount;
+};
+
+struct SnapshotAsset
+{
+    uint32_t type;  // AssetManager::ResType
+    uint32_t name;
+};
+
+/**
+ * Builds the tables of a snapshot from a scene.
+ */
+class SceneSnapshot::Writer
+{
+public:
+
+    Writer()
+    {
+        // Offset 0 is the empty string.
+        _strings.push_back('\0');
+    }
+
+    uint32_t addString(const std::string& str)
+    {
+        if (str.empty())
+            return 0;
+        std::map<std::string, uint32_t>::const_iterator itr = _stringOffsets.find(str);
+        if (itr != _stringOffsets.end())
+            return itr->second;
+        uint32_t offset = (uint32_t)_strings.size();
+        _strings.insert(_strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+        _stringOffsets[str] = offset;
+        return offset;
+    }
+
+    uint32_t addAsset(AssetManager::ResType type, const std::string& name)
+    {
+        if (name.empty())
+            return SNAPSHOT_NONE;
+        std::pair<uint32_t, std::string> key((uint32_t)type, name);
+        std::map<std::pair<uint32_t, std::string>, uint32_t>::const_iterator itr = _assetIndices.find(key);
+        if (itr != _assetIndices.end())
+            return itr->second;
+        SnapshotAsset asset;
+        asset.type = (uint32_t)type;
+        asset.name = addString(name);
+        uint32_t index = (uint32_t)_assets.size();
+        _assets.push_back(asset);
+        _assetIndices[key] = index;
+        return index;
+    }
+
+    bool addComponent(Component* component)
+    {
+        SnapshotComponent entry;
+        if (Camera* camera = dynamic_cast<Camera*>(component))
+        {
+            SnapshotCamera record;
+            record.type = (uint32_t)camera->_type;
+            record.fieldOfView = camera->_fieldOfView;
+            record.zoom[0] = camera->_zoom[0];
+            record.zoom[1] = camera->_zoom[1];
+            record.aspectRatio = camera->_aspectRatio;
+            record.nearPlane = camera->_nearPlane;
+            record.farPlane = camera->_farPlane;
+            entry.type = COMPONENT_CAMERA;
+            entry.index = (uint32_t)_cameras.size();
+            _cameras.push_back(record);
+        }
+        else if (Light* light = dynamic_cast<Light*>(component))
+        {
+            SnapshotLight record;
+            memset(&record, 0, sizeof(record));
+            record.type = (uint32_t)light->_type;
+            record.color[0] = light->_color.x;
+            record.color[1] = light->_color.y;
+            record.color[2] = light->_color.z;
+            record.intensity = light->_intensity;
+            if (light->_type != Light::DIRECTIONAL)
+                record.range = light->getRange();
+            if (light->_type == Light::SPOT)
+            {
+                record.innerAngle = light->getInnerAngle();
+                record.outerAngle = light->getOuterAngle();
+            }
+            record.lighting = (uint32_t)light->_lighting;
+            record.shadows = (uint32_t)light->_shadows;
+            entry.type = COMPONENT_LIGHT;
+            entry.index = (uint32_t)_lights.size();
+            _lights.push_back(record);
+        }
+        else if (Model* model = dynamic_cast<Model*>(component))
+        {
+            SnapshotModel record;
+            record.mesh = model->_mesh ? addAsset(AssetManager::rt_mesh, model->_mesh->getName()) : SNAPSHOT_NONE;
+            record.skin = model->_skin ? addAsset(AssetManager::rt_skin, model->_skin->getName()) : SNAPSHOT_NONE;
+            record.material = model->_material ? addAsset(AssetManager::rt_materail, model->_material->getName()) : SNAPSHOT_NONE;
+            record.firstPartMaterial = (uint32_t)_assetRefs.size();
+            record.partMaterialCount = (uint32_t)model->_partMaterials.size();
+            for (size_t i = 0; i < model->_partMaterials.size(); ++i)
+            {
+                Material* material = model->_partMaterials[i];
+                _assetRefs.push_back(material ? addAsset(AssetManager::rt_materail, material->getName()) : SNAPSHOT_NONE);
+            }
+            entry.type = COMPONENT_MODEL;
+            entry.index = (uint32_t)_models.size();
+            _models.push_back(record);
+        }
+        else
+        {
+            return false;
+        }
+        _components.push_back(entry);
+        return true;
+    }
+
+    uint32_t addNode(Node* node, uint32_t parent)
+    {
+        uint32_t index = (uint32_t)_nodes.size();
+        _nodeIndices[node] = index;
+
+        SnapshotNode record;
+        record.name = addString(node->_name);
+        record.parent = parent;
+        record.flags = (node->_enabled ? SNAPSHOT_NODE_ENABLED : 0) | (node->_static ? SNAPSHOT_NODE_STATIC : 0);
+        record.firstComponent = (uint32_t)_components.size();
+        const Vector3& translation = node->getTranslation();
+        const Quaternion& rotation = node->getRotation();
+        const Vector3& scale = node->getScale();
+        record.translation[0] = translation.x;
+        record.translation[1] = translation.y;
+        record.translation[2] = translation.z;
+        record.rotation[0] = rotation.x;
+        record.rotation[1] = rotation.y;
+        record.rotation[2] = rotation.z;
+        record.rotation[3] = rotation.w;
+        record.scale[0] = scale.x;
+        record.scale[1] = scale.y;
+        record.scale[2] = scale.z;
+        record.reserved = 0;
+
+        for (size_t i = 0; i < node->_components.size(); ++i)
+        {
+            if (!addComponent(node->_components[i]))
+                GP_WARN("A component of node '%s' is not stored in scene snapshots.", node->_name.c_str());
+        }
+        record.componentCount = (uint32_t)_components.size() - record.firstComponent;
+        _nodes.push_back(record);
+
+        for (size_t i = 0; i < node->_children.size(); ++i)
+            addNode(node->_children[i], index);
+        return index;
+    }
+
+    bool write(Scene* scene, Stream* stream)
+    {
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = SNAPSHOT_MAGIC;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.versionMajor = SceneSnapshot::VERSION_MAJOR;
+        header.versionMinor = SceneSnapshot::VERSION_MINOR;
+        header.sceneName = addString(scene->_name);
+        header.streaming = scene->_streaming ? 1 : 0;
+        header.activeCamera = SNAPSHOT_NONE;
+        if (scene->_activeCamera && scene->_activeCamera->getNode())
+        {
+            std::map<Node*, uint32_t>::const_iterator itr = _nodeIndices.find(scene->_activeCamera->getNode());
+            if (itr != _nodeIndices.end())
+                header.activeCamera = itr->second;
+        }
+
+        const void* tables[TABLE_COUNT];
+        tables[TABLE_STRINGS] = _strings.data();
+        tables[TABLE_NODES] = _nodes.data();
+        tables[TABLE_COMPONENTS] = _components.data();
+        tables[TABLE_CAMERAS] = _cameras.data();
+        tables[TABLE_LIGHTS] = _lights.data();
+        tables[TABLE_MODELS] = _models.data();
+        tables[TABLE_ASSETS] = _assets.data();
+        tables[TABLE_ASSET_REFS] = _assetRefs.data();
+        setTable(&header, TABLE_STRINGS, _strings.size(), 1);
+        setTable(&header, TABLE_NODES, _nodes.size(), sizeof(SnapshotNode));
+        setTable(&header, TABLE_COMPONENTS, _components.size(), sizeof(SnapshotComponent));
+        setTable(&header, TABLE_CAMERAS, _cameras.size(), sizeof(SnapshotCamera));
+        setTable(&header, TABLE_LIGHTS, _lights.size(), sizeof(SnapshotLight));
+        setTable(&header, TABLE_MODELS, _models.size(), sizeof(SnapshotModel));
+        setTable(&header, TABLE_ASSETS, _assets.size(), sizeof(SnapshotAsset));
+        setTable(&header, TABLE_ASSET_REFS, _assetRefs.size(), sizeof(uint32_t));
+
+        // Lay the tables out after the header, aligned, and write the file at once.
+        size_t size = sizeof(SnapshotHeader);
+        for (int i = 0; i < TABLE_COUNT; ++i)
+        {
+            size = (size + SNAPSHOT_ALIGNMENT - 1) & ~(size_t)(SNAPSHOT_ALIGNMENT - 1);
+            header.tables[i].offset = (uint32_t)size;
+            size += (size_t)header.tables[i].count * header.tables[i].stride;
+        }
+        header.size = (uint32_t)size;
+
+        std::vector<unsigned char> data(size, 0);
+        memcpy(&data[0], &header, sizeof(header));
+        for (int i = 0; i < TABLE_COUNT; ++i)
+        {
+            size_t tableSize = (size_t)header.tables[i].count * header.tables[i].stride;
+            if (tableSize > 0)
+                memcpy(&data[header.tables[i].offset], tables[i], tableSize);
+        }
+        return stream->write(&data[0], 1, size) == size;
+    }
+
+private:
+
+    static void setTable(SnapshotHeader* header, int table, size_t count, size_t stride)
+    {
+        header->tables[table].count = (uint32_t)count;
+        header->tables[table].stride = (uint32_t)stride;
+    }
+
+    std::vector<char> _strings;
+    std::map<std::string, uint32_t> _stringOffsets;
+    std::vector<SnapshotNode> _nodes;
+    std::map<Node*, uint32_t> _nodeIndices;
+    std::vector<SnapshotComponent> _components;
+    std::vector<SnapshotCamera> _cameras;
+    std::vector<SnapshotLight> _lights;
+    std::vector<SnapshotModel> _models;
+    std::vector<SnapshotAsset> _assets;
+    std::map<std::pair<uint32_t, std::string>, uint32_t> _assetIndices;
+    std::vector<uint32_t> _assetRefs;
+};
+
+/**
+ * Gives access to the tables of a snapshot in memory.
+ */
+class SnapshotReader
+{
+public:
+
+    SnapshotReader(const unsigned char* data, size_t size) : _data(data), _size(size), _header(NULL)
+    {
+    }
+
+    bool validate()
+    {
+        if (_size < sizeof(SnapshotHeader))
+            return fail("truncated");
+        _header = (const SnapshotHeader*)_data;
+        if (_header->magic != SNAPSHOT_MAGIC)
+            return fail("not a scene snapshot");
+        if (_header->byteOrder != SNAPSHOT_BYTE_ORDER)
+            return fail("written with a different byte order");
+        if (_header->versionMajor != SceneSnapshot::VERSION_MAJOR)
+            return fail("unsupported version");
+        if (_header->size > _size)
+            return fail("truncated");
+
+        const size_t minimumStrides[TABLE_COUNT] =
+        {
+            1,
+            sizeof(SnapshotNode),
+            sizeof(SnapshotComponent),
+            sizeof(SnapshotCamera),
+            sizeof(SnapshotLight),
+            sizeof(SnapshotModel),
+            sizeof(SnapshotAsset),
+            sizeof(uint32_t)
+        };
+        for (int i = 0; i < TABLE_COUNT; ++i)
+        {
+            const SnapshotTableInfo& table = _header->tables[i];
+            if (table.count == 0)
+                continue;
+            if (table.stride < minimumStrides[i] || (i != TABLE_STRINGS && (table.offset % 4 != 0 || table.stride % 4 != 0)) ||
+                (uint64_t)table.offset + (uint64_t)table.count * table.stride > _header->size)
+                return fail("invalid table");
+        }
+
+        const SnapshotTableInfo& strings = _header->tables[TABLE_STRINGS];
+        if (strings.count == 0 || _data[strings.offset + strings.count - 1] != '\0')
+            return fail("invalid strings");
+        if (count(TABLE_NODES) == 0)
+            return fail("no root node");
+
+        // References must be in range, nodes in depth-first order, and each component used once.
+        std::vector<bool> used[COMPONENT_TYPE_COUNT];
+        used[COMPONENT_CAMERA].resize(count(TABLE_CAMERAS), false);
+        used[COMPONENT_LIGHT].resize(count(TABLE_LIGHTS), false);
+        used[COMPONENT_MODEL].resize(count(TABLE_MODELS), false);
+        for (uint32_t i = 0, nodeCount = count(TABLE_NODES); i < nodeCount; ++i)
+        {
+            const SnapshotNode* node = record<SnapshotNode>(TABLE_NODES, i);
+            if ((i == 0) != (node->parent == SNAPSHOT_NONE) || (i > 0 && node->parent >= i))
+                return fail("invalid node parent");
+            if ((uint64_t)node->firstComponent + node->componentCount > count(TABLE_COMPONENTS))
+                return fail("invalid node components");
+            for (uint32_t j = 0; j < node->componentCount; ++j)
+            {
+                const SnapshotComponent* component = record<SnapshotComponent>(TABLE_COMPONENTS, node->firstComponent + j);
+                if (component->type >= COMPONENT_TYPE_COUNT || component->index >= used[component->type].size() || used[component->type][component->index])
+                    return fail("invalid component");
+                used[component->type][component->index] = true;
+            }
+        }
+        for (uint32_t i = 0, modelCount = count(TABLE_MODELS); i < modelCount; ++i)
+        {
+            const SnapshotModel* model = record<SnapshotModel>(TABLE_MODELS, i);
+            if (!isAsset(model->mesh) || !isAsset(model->skin) || !isAsset(model->material) ||
+                (uint64_t)model->firstPartMaterial + model->partMaterialCount > count(TABLE_ASSET_REFS))
+                return fail("invalid model");
+            for (uint32_t j = 0; j < model->partMaterialCount; ++j)
+            {
+                if (!isAsset(*record<uint32_t>(TABLE_ASSET_REFS, model->firstPartMaterial + j)))
+                    return fail("invalid model");
+            }
+        }
+        for (uint32_t i = 0, assetCount = count(TABLE_ASSETS); i < assetCount; ++i)
+        {
+            if (record<SnapshotAsset>(TABLE_ASSETS, i)->type >= AssetManager::rt_count)
+                return fail("invalid asset");
+        }
+        if (_header->activeCamera != SNAPSHOT_NONE && _header->activeCamera >= count(TABLE_NODES))
+            return fail("invalid active camera");
+        return true;
+    }
+
+    const SnapshotHeader* header() const
+    {
+        return _header;
+    }
+
+    uint32_t count(int table) const
+    {
+        return _header->tables[table].count;
+    }
+
+    template<typename T>
+    const T* record(int table, uint32_t index) const
+    {
+        const SnapshotTableInfo& info = _header->tables[table];
+        return (const T*)(_data + info.offset + (size_t)index * info.stride);
+    }
+
+    const char* string(uint32_t offset) const
+    {
+        const SnapshotTableInfo& info = _header->tables[TABLE_STRINGS];
+        return offset < info.count ? (const char*)(_data + info.offset + offset) : "";
+    }
+
+private:
+
+    bool isAsset(uint32_t index) const
+    {
+        return index == SNAPSHOT_NONE || index < count(TABLE_ASSETS);
+    }
+
+    static bool fail(const char* message)
+    {
+        GP_WARN("Invalid scene snapshot: %s.", message);
+        return false;
+    }
+
+    const unsigned char* _data;
+    size_t _size;
+    const SnapshotHeader* _header;
+};
+
+SceneSnapshot::SceneSnapshot()
+{
+}
+
+bool SceneSnapshot::save(Scene* scene, const char* path)
+{
+    GP_ASSERT(scene);
+    GP_ASSERT(path);
+
+    Writer writer;
+    writer.addNode(scene->_rootNode, SNAPSHOT_NONE);
+
+    Stream* stream = FileSystem::open(path, FileSystem::WRITE);
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to open scene snapshot '%s' for writing.", path);
+        return false;
+    }
+    bool result = writer.write(scene, stream);
+    stream->close();
+    SAFE_DELETE(stream);
+    if (!result)
+        GP_WARN("Failed to write scene snapshot '%s'.", path);
+    return result;
+}
+
+Scene* SceneSnapshot::load(const char* path)
+{
+    GP_ASSERT(path);
+
+    Stream* stream = FileSystem::open(path);
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to open scene snapshot '%s'.", path);
+        return NULL;
+    }
+
+    // Read the whole file at once; the tables are used where they are.
+    size_t size = stream->length();
+    uint32_t* data = new uint32_t[(size + sizeof(uint32_t) - 1) / sizeof(uint32_t) + 1];
+    size_t read = stream->read(data, 1, size);
+    stream->close();
+    SAFE_DELETE(stream);
+
+    Scene* scene = NULL;
+    if (read == size)
+        scene = load(data, size);
+    else
+        GP_WARN("Failed to read scene snapshot '%s'.", path);
+    SAFE_DELETE_ARRAY(data);
+    return scene;
+}
+
+Scene* SceneSnapshot::load(const void* data, size_t size)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(((size_t)data & 3) == 0);
+
+    SnapshotReader reader((const unsigned char*)data, size);
+    if (!reader.validate())
+        return NULL;
+
+    // Load each asset once.
+    AssetManager* assetManager = AssetManager::getInstance();
+    std::vector<Ref*> assets(reader.count(TABLE_ASSETS), NULL);
+    for (uint32_t i = 0; i < assets.size(); ++i)
+    {
+        const SnapshotAsset* asset = reader.record<SnapshotAsset>(TABLE_ASSETS, i);
+        assets[i] = assetManager->load(reader.string(asset->name), (AssetManager::ResType)asset->type);
+    }
+
+    // Create the components, one table at a time.
+    std::vector<Component*> components[COMPONENT_TYPE_COUNT];
+    components[COMPONENT_CAMERA].resize(reader.count(TABLE_CAMERAS));
+    for (uint32_t i = 0; i < components[COMPONENT_CAMERA].size(); ++i)
+    {
+        const SnapshotCamera* record = reader.record<SnapshotCamera>(TABLE_CAMERAS, i);
+        Camera* camera = new Camera();
+        camera->_type = record->type == Camera::ORTHOGRAPHIC ? Camera::ORTHOGRAPHIC : Camera::PERSPECTIVE;
+        camera->_fieldOfView = record->fieldOfView;
+        camera->_zoom[0] = record->zoom[0];
+        camera->_zoom[1] = record->zoom[1];
+        camera->_aspectRatio = record->aspectRatio;
+        camera->_nearPlane = record->nearPlane;
+        camera->_farPlane = record->farPlane;
+        components[COMPONENT_CAMERA][i] = camera;
+    }
+
+    components[COMPONENT_LIGHT].resize(reader.count(TABLE_LIGHTS));
+    for (uint32_t i = 0; i < components[COMPONENT_LIGHT].size(); ++i)
+    {
+        const SnapshotLight* record = reader.record<SnapshotLight>(TABLE_LIGHTS, i);
+        Vector3 color(record->color[0], record->color[1], record->color[2]);
+        Light* light;
+        switch (record->type)
+        {
+        case Light::POINT:
+            light = Light::createPoint(color, record->range);
+            break;
+        case Light::SPOT:
+            light = Light::createSpot(color, record->range, record->innerAngle, record->outerAngle);
+            break;
+        default:
+            light = Light::createDirectional(color);
+            break;
+        }
+        light->_intensity = record->intensity;
+        light->_lighting = static_cast<Light::Lighting>(record->lighting);
+        light->_shadows = static_cast<Light::Shadows>(record->shadows);
+        components[COMPONENT_LIGHT][i] = light;
+    }
+
+    components[COMPONENT_MODEL].resize(reader.count(TABLE_MODELS));
+    for (uint32_t i = 0; i < components[COMPONENT_MODEL].size(); ++i)
+    {
+        const SnapshotModel* record = reader.record<SnapshotModel>(TABLE_MODELS, i);
+        Model* model = new Model();
+        model->_mesh = record->mesh != SNAPSHOT_NONE ? dynamic_cast<Mesh*>(assets[record->mesh]) : NULL;
+        if (model->_mesh)
+            model->_mesh->addRef();
+        model->_skin = record->skin != SNAPSHOT_NONE ? dynamic_cast<MeshSkin*>(assets[record->skin]) : NULL;
+        if (model->_skin)
+            model->_skin->addRef();
+        model->_material = record->material != SNAPSHOT_NONE ? dynamic_cast<Material*>(assets[record->material]) : NULL;
+        if (model->_material)
+            model->_material->addRef();
+        unsigned int partCount = model->_mesh ? model->getMeshPartCount() : 0;
+        for (uint32_t j = 0; j < record->partMaterialCount && j < partCount; ++j)
+        {
+            uint32_t asset = *reader.record<uint32_t>(TABLE_ASSET_REFS, record->firstPartMaterial + j);
+            Material* material = asset != SNAPSHOT_NONE ? dynamic_cast<Material*>(assets[asset]) : NULL;
+            if (material)
+                model->setMaterial(material, (int)j);
+        }
+        components[COMPONENT_MODEL][i] = model;
+    }
+
+    // Create the nodes, parents first, and attach their components.
+    std::vector<Node*> nodes(reader.count(TABLE_NODES), NULL);
+    for (uint32_t i = 0; i < nodes.size(); ++i)
+    {
+        const SnapshotNode* record = reader.record<SnapshotNode>(TABLE_NODES, i);
+        Node* node = Node::create(reader.string(record->name));
+        node->_enabled = (record->flags & SNAPSHOT_NODE_ENABLED) != 0;
+        node->_static = (record->flags & SNAPSHOT_NODE_STATIC) != 0;
+        node->set(Vector3(record->scale),
+                  Quaternion(record->rotation[0], record->rotation[1], record->rotation[2], record->rotation[3]),
+                  Vector3(record->translation));
+
+        node->_components.reserve(record->componentCount);
+        for (uint32_t j = 0; j < record->componentCount; ++j)
+        {
+            const SnapshotComponent* component = reader.record<SnapshotComponent>(TABLE_COMPONENTS, record->firstComponent + j);
+            Component* c = components[component->type][component->index];
+            node->_components.push_back(c);
+            c->setNode(node);
+        }
+
+        if (i > 0)
+        {
+            nodes[record->parent]->addChild(node);
+            node->release();
+        }
+        nodes[i] = node;
+    }
+
+    const SnapshotHeader* header = reader.header();
+    Scene* scene = Scene::create();
+    scene->_name = reader.string(header->sceneName);
+    scene->_streaming = header->streaming != 0;
+    SAFE_RELEASE(scene->_rootNode);
+    scene->_rootNode = nodes[0];
+    scene->_rootNode->_scene = scene;
+    if (header->activeCamera != SNAPSHOT_NONE && nodes[header->activeCamera]->getCamera())
+        scene->setActiveCamera(nodes[header->activeCamera]->getCamera());
+
+    return scene;
+}
+
+bool SceneSnapshot::convert(const char* scenePath, const char* snapshotPath)
+{
+    GP_ASSERT(scenePath);
+    GP_ASSERT(snapshotPath);
+
+    Serializer* serializer = Serializer::createReader(scenePath);
+    if (serializer == NULL)
+    {
+        GP_WARN("Failed to open scene '%s'.", scenePath);
+        return false;
+    }
+    Scene* scene = dynamic_cast<Scene*>(serializer->readObject(NULL));
+    serializer->close();
+    SAFE_DELETE(serializer);
+    if (scene == NULL)
+    {
+        GP_WARN("Failed to read scene '%s'.", scenePath);
+        return false;
+    }
+
+    bool result = save(scene, snapshotPath);
+    SAFE_RELEASE(scene);
+    return result;
+}
+
+bool SceneSnapshot::isSnapshot(const char* path)
+{
+    GP_ASSERT(path);
+
+    Stream* stream = FileSystem::open(path);
+    if (stream == NULL)
+        return false;
+    uint32_t magic = 0;
+    bool result = stream->read(&magic, sizeof(magic), 1) == 1 && magic == SNAPSHOT_MAGIC;
+    stream->close();
+    SAFE_DELETE(stream);
+    return result;
+}
+
+}
@@ -0,0 +1,110 @@
+#ifndef SCENESNAPSHOT_H_
+#define SCENESNAPSHOT_H_
+
+#include "base/Base.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Stream;
+
+/**
+ * Defines a binary snapshot of a whole scene, loaded without per-property serialization.
+ *
+ * A snapshot stores a scene as flat tables of fixed-size records: the nodes in depth-first
+ * order with their parent index and local transform, the components of the nodes (cameras,
+ * lights and models) in one table per type, the assets referenced by the components, and a
+ * pool of the strings they use. Each table is 16-byte aligned and the records are read in
+ * place, so loading a snapshot is a single read of the file followed by tight loops creating
+ * the objects of each table, instead of one virtual Serializer call per property and one
+ * class name lookup per object.
+ *
+ * The header holds the schema version and, for each table, its offset, record count and
+ * record size. Snapshots of the same major version load with any minor version: newer
+ * minor versions may only append fields to records, which older readers skip using the
+ * record size. Snapshots are stored in the byte order of the platform that wrote them.
+ *
+ * Snapshots are made from scenes saved with the existing serializers using convert(), or
+ * from a scene in memory using save(). Scene::load() loads snapshots as well as serialized
+ * scenes.
+ */
+class SceneSnapshot
+{
+public:
+
+    /**
+     * The major version of the snapshot schema, changed when records are incompatible.
+     */
+    static const unsigned int VERSION_MAJOR = 1;
+
+    /**
+     * The minor version of the snapshot schema, changed when fields are appended to records.
+     */
+    static const unsigned int VERSION_MINOR = 0;
+
+    /**
+     * Saves a scene as a snapshot.
+     *
+     * Components other than cameras, lights and models are not stored, and are reported.
+     *
+     * @param scene The scene to save.
+     * @param path The path of the snapshot file to write.
+     *
+     * @return True if the snapshot was written, false otherwise.
+     */
+    static bool save(Scene* scene, const char* path);
+
+    /**
+     * Loads a scene from a snapshot file.
+     *
+     * @param path The path of the snapshot file.
+     *
+     * @return The new scene, or NULL if the file is not a valid snapshot.
+     */
+    static Scene* load(const char* path);
+
+    /**
+     * Loads a scene from a snapshot in memory, such as a memory mapped file.
+     *
+     * The scene does not refer to the memory after it is loaded.
+     *
+     * @param data The snapshot, aligned to 4 bytes.
+     * @param size The size of the snapshot, in bytes.
+     *
+     * @return The new scene, or NULL if the data is not a valid snapshot.
+     */
+    static Scene* load(const void* data, size_t size);
+
+    /**
+     * Converts a scene saved with the json or binary serializer to a snapshot.
+     *
+     * @param scenePath The path of the serialized scene.
+     * @param snapshotPath The path of the snapshot file to write.
+     *
+     * @return True if the snapshot was written, false otherwise.
+     */
+    static bool convert(const char* scenePath, const char* snapshotPath);
+
+    /**
+     * Determines if a file is a snapshot.
+     *
+     * @param path The path of the file.
+     *
+     * @return True if the file starts with the snapshot identifier.
+     */
+    static bool isSnapshot(const char* path);
+
+private:
+
+    class Writer;
+
+    /**
+     * Hidden constructor.
+     */
+    SceneSnapshot();
+};
+
+}
+
+#endif
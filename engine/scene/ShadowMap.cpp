@@ -0,0 +1,277 @@
+#include "base/Base.h"
+#include "ShadowMap.h"
+#include "Camera.h"
+#include "Light.h"
+#include "Node.h"
+#include "math/Frustum.h"
+#include "math/Vector4.h"
+#include <chrono>
+
+namespace gameplay
+{
+
+ShadowMap::ShadowMap(Light* light, unsigned int resolution, unsigned int cascadeCount) :
+    _light(light), _resolution(std::max(resolution, 1u)), _maxCascadeCount(1),
+    _cascadeCount(0), _splitLambda(0.75f), _maxDistance(100.0f), _casterDistance(100.0f), _texture(NULL)
+{
+    GP_ASSERT(light);
+    // std::min takes references, which MAX_CASCADES can't bind to without a definition.
+    unsigned int maxCascadeCount = MAX_CASCADES;
+    _maxCascadeCount = std::min(std::max(cascadeCount, 1u), maxCascadeCount);
+    _light->addRef();
+    for (unsigned int i = 0; i < MAX_CASCADES; ++i)
+    {
+        Cascade& cascade = _cascades[i];
+        cascade.nearDepth = 0.0f;
+        cascade.farDepth = 0.0f;
+        cascade.translation.set(Vector3::zero());
+        cascade.casterCount = 0;
+        cascade.drawCalls = 0;
+        cascade.cullTime = 0.0f;
+        cascade.renderTime = 0.0f;
+    }
+}
+
+ShadowMap::~ShadowMap()
+{
+    SAFE_RELEASE(_light);
+}
+
+Light* ShadowMap::getLight() const
+{
+    return _light;
+}
+
+unsigned int ShadowMap::getResolution() const
+{
+    return _resolution;
+}
+
+unsigned int ShadowMap::getCascadeCount() const
+{
+    return _cascadeCount;
+}
+
+const ShadowMap::Cascade& ShadowMap::getCascade(unsigned int index) const
+{
+    GP_ASSERT(index < MAX_CASCADES);
+    return _cascades[index];
+}
+
+ShadowMap::Cascade& ShadowMap::getCascade(unsigned int index)
+{
+    GP_ASSERT(index < MAX_CASCADES);
+    return _cascades[index];
+}
+
+void ShadowMap::setSplitLambda(float lambda)
+{
+    _splitLambda = lambda;
+}
+
+float ShadowMap::getSplitLambda() const
+{
+    return _splitLambda;
+}
+
+void ShadowMap::setMaxDistance(float distance)
+{
+    _maxDistance = distance;
+}
+
+float ShadowMap::getMaxDistance() const
+{
+    return _maxDistance;
+}
+
+void ShadowMap::setCasterDistance(float distance)
+{
+    _casterDistance = distance;
+}
+
+float ShadowMap::getCasterDistance() const
+{
+    return _casterDistance;
+}
+
+Texture* ShadowMap::getTexture() const
+{
+    return _texture;
+}
+
+void ShadowMap::setTexture(Texture* texture)
+{
+    _texture = texture;
+}
+
+void ShadowMap::computeSplits(float nearDepth, float farDepth, unsigned int count, float lambda, float* splits)
+{
+    GP_ASSERT(splits && count > 0 && nearDepth > 0.0f);
+
+    splits[0] = nearDepth;
+    for (unsigned int i = 1; i < count; ++i)
+    {
+        float f = (float)i / count;
+        float logSplit = nearDepth * powf(farDepth / nearDepth, f);
+        float uniformSplit = nearDepth + (farDepth - nearDepth) * f;
+        splits[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+    }
+    splits[count] = farDepth;
+}
+
+void ShadowMap::fitOrthographic(const Vector3* corners, const Quaternion& rotation, unsigned int resolution,
+                                float casterDistance, Matrix* projection)
+{
+    GP_ASSERT(corners && projection);
+
+    // The bounding sphere of the volume keeps the same size as the camera turns.
+    Vector3 center;
+    for (int i = 0; i < 8; ++i)
+        center.add(corners[i]);
+    center.scale(1.0f / 8.0f);
+    float radius = 0.0f;
+    for (int i = 0; i < 8; ++i)
+        radius = std::max(radius, center.distanceSquared(corners[i]));
+    radius = ceilf(sqrtf(radius) * 16.0f) / 16.0f;
+
+    // Move the sphere to light space, snapping it to whole texels.
+    Matrix view;
+    Matrix::createRotation(rotation, &view);
+    view.transpose();
+    view.transformPoint(&center);
+    float texelSize = 2.0f * radius / resolution;
+    center.x = floorf(center.x / texelSize) * texelSize;
+    center.y = floorf(center.y / texelSize) * texelSize;
+
+    // The light looks down its negative z-axis; casters between it and the sphere are kept.
+    Matrix::createOrthographicOffCenter(center.x - radius, center.x + radius, center.y - radius, center.y + radius,
+        -(center.z + radius) - casterDistance, -(center.z - radius), projection);
+}
+
+void ShadowMap::update(const Camera* camera)
+{
+    GP_ASSERT(camera);
+
+    Node* node = _light->getNode();
+    if (!node || _light->getShadows() == Light::Shadows::eNone)
+    {
+        _cascadeCount = 0;
+        return;
+    }
+
+    Quaternion rotation;
+    node->getWorldMatrix().getRotation(&rotation);
+
+    switch (_light->getLightType())
+    {
+    case Light::DIRECTIONAL:
+    {
+        float cameraNear = camera->getNearPlane();
+        float cameraFar = camera->getFarPlane();
+        float farDepth = std::min(cameraFar, _maxDistance);
+        float splits[MAX_CASCADES + 1];
+        computeSplits(cameraNear, farDepth, _maxCascadeCount, _splitLambda, splits);
+
+        // Rays through the corners of the camera frustum, from its near to its far plane.
+        const Matrix& inverseViewProjection = camera->getInverseViewProjectionMatrix();
+        Vector3 nearCorners[4];
+        Vector3 farCorners[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            float x = (i & 1) ? 1.0f : -1.0f;
+            float y = (i & 2) ? 1.0f : -1.0f;
+            Vector4 n, f;
+            inverseViewProjection.transformVector(Vector4(x, y, -1.0f, 1.0f), &n);
+            inverseViewProjection.transformVector(Vector4(x, y, 1.0f, 1.0f), &f);
+            nearCorners[i].set(n.x / n.w, n.y / n.w, n.z / n.w);
+            farCorners[i].set(f.x / f.w, f.y / f.w, f.z / f.w);
+        }
+
+        Matrix view;
+        Matrix::createRotation(rotation, &view);
+        view.transpose();
+        for (unsigned int c = 0; c < _maxCascadeCount; ++c)
+        {
+            Cascade& cascade = _cascades[c];
+            cascade.nearDepth = splits[c];
+            cascade.farDepth = splits[c + 1];
+
+            Vector3 corners[8];
+            for (int i = 0; i < 4; ++i)
+            {
+                Vector3 ray = farCorners[i] - nearCorners[i];
+                corners[i] = nearCorners[i] + ray * ((cascade.nearDepth - cameraNear) / (cameraFar - cameraNear));
+                corners[i + 4] = nearCorners[i] + ray * ((cascade.farDepth - cameraNear) / (cameraFar - cameraNear));
+            }
+
+            cascade.rotation = rotation;
+            cascade.translation.set(Vector3::zero());
+            fitOrthographic(corners, rotation, _resolution, _casterDistance, &cascade.projection);
+            Matrix::multiply(cascade.projection, view, &cascade.viewProjection);
+        }
+        _cascadeCount = _maxCascadeCount;
+        break;
+    }
+    case Light::SPOT:
+    {
+        Cascade& cascade = _cascades[0];
+        float range = _light->getRange();
+        cascade.nearDepth = 0.0f;
+        cascade.farDepth = range;
+        cascade.rotation = rotation;
+        node->getWorldMatrix().getTranslation(&cascade.translation);
+        Matrix::createPerspective(MATH_RAD_TO_DEG(_light->getOuterAngle()) * 2.0f, 1.0f, range * 0.01f, range, &cascade.projection);
+
+        Matrix world;
+        Matrix::createRotation(rotation, &world);
+        world.m[12] = cascade.translation.x;
+        world.m[13] = cascade.translation.y;
+        world.m[14] = cascade.translation.z;
+        Matrix view;
+        world.invert(&view);
+        Matrix::multiply(cascade.projection, view, &cascade.viewProjection);
+        _cascadeCount = 1;
+        break;
+    }
+    default:
+        _cascadeCount = 0;
+        break;
+    }
+
+    // Map clip space to the column of each cascade in the texture, and depth to [0, 1].
+    for (unsigned int c = 0; c < _cascadeCount; ++c)
+    {
+        Matrix bias;
+        bias.m[0] = 0.5f / _cascadeCount;
+        bias.m[5] = 0.5f;
+        bias.m[10] = 0.5f;
+        bias.m[12] = (c + 0.5f) / _cascadeCount;
+        bias.m[13] = 0.5f;
+        bias.m[14] = 0.5f;
+        Matrix::multiply(bias, _cascades[c].viewProjection, &_cascades[c].textureMatrix);
+    }
+}
+
+void ShadowMap::cullCasters(unsigned int cascade, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+                            unsigned int count, unsigned int* visibility, ThreadPool* pool)
+{
+    GP_ASSERT(cascade < _cascadeCount);
+    Cascade& c = _cascades[cascade];
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned int casterCount = 0;
+    if (count > 0)
+    {
+        Frustum frustum(c.viewProjection);
+        frustum.intersectSpheres(centerX, centerY, centerZ, radius, count, visibility, pool);
+        for (unsigned int i = 0, maskCount = (count + 31) / 32; i < maskCount; ++i)
+        {
+            for (unsigned int mask = visibility[i]; mask; mask &= mask - 1)
+                ++casterCount;
+        }
+    }
+    c.casterCount = casterCount;
+    c.cullTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
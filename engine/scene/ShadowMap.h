@@ -0,0 +1,259 @@
+#ifndef SHADOWMAP_H_
+#define SHADOWMAP_H_
+
+#include "base/Base.h"
+#include "math/Matrix.h"
+#include "math/Quaternion.h"
+#include "math/Vector3.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Light;
+class Texture;
+class ThreadPool;
+
+/**
+ * Defines the shadow map of a light.
+ *
+ * Directional lights are given cascaded shadow maps: the view of the camera is split in
+ * depth, and each split is covered by an orthographic projection from the light, fitted
+ * around the bounding sphere of the split so its size doesn't change as the camera turns,
+ * and snapped to whole texels so the shadows don't shimmer as the camera moves.
+ * Spot lights are given a single perspective shadow map covering their cone.
+ *
+ * The cascades are fitted and their casters are culled on the CPU; rendering the depth
+ * of the casters is left to the render pipeline, which stores the cascades side by side
+ * in one depth texture.
+ */
+class ShadowMap
+{
+public:
+
+    /**
+     * The most cascades of a shadow map.
+     */
+    static const unsigned int MAX_CASCADES = 4;
+
+    /**
+     * Defines a cascade of the shadow map, and the cost of its last update.
+     */
+    class Cascade
+    {
+    public:
+
+        /**
+         * The view depth range of the camera covered by the cascade.
+         */
+        float nearDepth;
+        float farDepth;
+
+        /**
+         * The world transform of the camera rendering the cascade.
+         */
+        Quaternion rotation;
+        Vector3 translation;
+
+        /**
+         * The projection of the camera rendering the cascade.
+         */
+        Matrix projection;
+
+        /**
+         * The view projection of the camera rendering the cascade.
+         */
+        Matrix viewProjection;
+
+        /**
+         * The transform from world space to the texture coordinates and depth of the cascade
+         * in the shadow map texture, before the divide by w. Sampled by the lit shaders.
+         */
+        Matrix textureMatrix;
+
+        /**
+         * The number of casters left after culling.
+         */
+        unsigned int casterCount;
+
+        /**
+         * The number of draw calls rendering the casters.
+         */
+        unsigned int drawCalls;
+
+        /**
+         * The time spent culling the casters, in milliseconds.
+         */
+        float cullTime;
+
+        /**
+         * The time spent rendering the casters, in milliseconds.
+         */
+        float renderTime;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param light The light casting the shadows.
+     * @param resolution The width and height of each cascade, in texels.
+     * @param cascadeCount The number of cascades of directional lights, up to MAX_CASCADES.
+     */
+    ShadowMap(Light* light, unsigned int resolution = 1024, unsigned int cascadeCount = MAX_CASCADES);
+
+    /**
+     * Destructor.
+     */
+    ~ShadowMap();
+
+    /**
+     * Returns the light casting the shadows.
+     */
+    Light* getLight() const;
+
+    /**
+     * Returns the width and height of each cascade, in texels.
+     */
+    unsigned int getResolution() const;
+
+    /**
+     * Returns the number of cascades fitted by the last update().
+     *
+     * @return The number of cascades; 1 for spot lights and 0 for lights without shadows.
+     */
+    unsigned int getCascadeCount() const;
+
+    /**
+     * Returns a cascade.
+     *
+     * @param index The index of the cascade, nearest first.
+     *
+     * @return The cascade.
+     */
+    const Cascade& getCascade(unsigned int index) const;
+
+    /**
+     * @see getCascade
+     */
+    Cascade& getCascade(unsigned int index);
+
+    /**
+     * Sets the blend between logarithmic and uniform cascade splits.
+     *
+     * @param lambda 1 for logarithmic splits, 0 for uniform splits. Defaults to 0.75.
+     */
+    void setSplitLambda(float lambda);
+
+    /**
+     * Returns the blend between logarithmic and uniform cascade splits.
+     */
+    float getSplitLambda() const;
+
+    /**
+     * Sets the view depth past which directional lights cast no shadows.
+     *
+     * @param distance The distance, clamped to the far plane of the camera. Defaults to 100.
+     */
+    void setMaxDistance(float distance);
+
+    /**
+     * Returns the view depth past which directional lights cast no shadows.
+     */
+    float getMaxDistance() const;
+
+    /**
+     * Sets how far towards a directional light casters outside of a cascade are kept.
+     *
+     * @param distance The distance. Defaults to 100.
+     */
+    void setCasterDistance(float distance);
+
+    /**
+     * Returns how far towards a directional light casters outside of a cascade are kept.
+     */
+    float getCasterDistance() const;
+
+    /**
+     * Fits the cascades to a camera and the current transform of the light.
+     *
+     * @param camera The camera.
+     */
+    void update(const Camera* camera);
+
+    /**
+     * Culls the shadow casters of a cascade.
+     *
+     * Sets Cascade::casterCount and Cascade::cullTime.
+     *
+     * @param cascade The index of the cascade.
+     * @param centerX The x coordinates of the centers of the casters' bounding spheres.
+     * @param centerY The y coordinates of the centers of the casters' bounding spheres.
+     * @param centerZ The z coordinates of the centers of the casters' bounding spheres.
+     * @param radius The radii of the casters' bounding spheres.
+     * @param count The number of casters.
+     * @param visibility An array of (count + 31) / 32 masks, where bit i % 32 of
+     *        visibility[i / 32] is set if caster i may cast a shadow in the cascade.
+     * @param pool A thread pool to cull on, or NULL to cull on the calling thread.
+     */
+    void cullCasters(unsigned int cascade, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+                     unsigned int count, unsigned int* visibility, ThreadPool* pool = NULL);
+
+    /**
+     * Returns the depth texture holding the cascades side by side.
+     *
+     * @return The texture, or NULL if the shadow map was not rendered.
+     */
+    Texture* getTexture() const;
+
+    /**
+     * Sets the depth texture holding the cascades side by side. Called by the renderer.
+     *
+     * @param texture The texture. Not referenced.
+     */
+    void setTexture(Texture* texture);
+
+    /**
+     * Computes the view depths splitting a depth range into cascades.
+     *
+     * @param nearDepth The near depth of the range.
+     * @param farDepth The far depth of the range.
+     * @param count The number of cascades.
+     * @param lambda The blend between logarithmic (1) and uniform (0) splits.
+     * @param splits count + 1 depths, from nearDepth to farDepth.
+     */
+    static void computeSplits(float nearDepth, float farDepth, unsigned int count, float lambda, float* splits);
+
+    /**
+     * Computes the orthographic projection of a directional light covering a volume.
+     *
+     * The projection covers the bounding sphere of the corners, moved by whole texels.
+     *
+     * @param corners The 8 corners of the volume, in world space.
+     * @param rotation The world rotation of the light.
+     * @param resolution The width and height of the shadow map, in texels.
+     * @param casterDistance How far towards the light the projection extends past the volume.
+     * @param projection The projection, applied after the inverse rotation of the light.
+     */
+    static void fitOrthographic(const Vector3* corners, const Quaternion& rotation, unsigned int resolution,
+                                float casterDistance, Matrix* projection);
+
+private:
+
+    ShadowMap(const ShadowMap&);
+
+    ShadowMap& operator=(const ShadowMap&);
+
+    Light* _light;
+    unsigned int _resolution;
+    unsigned int _maxCascadeCount;
+    unsigned int _cascadeCount;
+    float _splitLambda;
+    float _maxDistance;
+    float _casterDistance;
+    Cascade _cascades[MAX_CASCADES];
+    Texture* _texture;
+};
+
+}
+
+#endif
@@ -2,11 +2,16 @@
 #include "AIAgent.h"
 #include "scene/Node.h"
 
+#include <atomic>
+
 namespace gameplay
 {
 
+// Serial of the next agent created. Zero is never used, so messages can use it for no receiver.
+static std::atomic<unsigned int> __nextAgentSerial(1);
+
 AIAgent::AIAgent()
-    : _stateMachine(NULL), _node(NULL), _enabled(true), _listener(NULL), _next(NULL)
+    : _stateMachine(NULL), _node(NULL), _enabled(true), _listener(NULL), _index(0), _serial(__nextAgentSerial++)
 {
     _stateMachine = new AIStateMachine(this);
 }
@@ -24,6 +24,7 @@ class AIAgent : public Ref, public Component
     friend class Node;
     friend class AIState;
     friend class AIController;
+    friend class AIMessage;
 
 public:
 
@@ -166,7 +167,10 @@ private:
     Node* _node;
     bool _enabled;
     Listener* _listener;
-    AIAgent* _next;
+    unsigned int _index;
+    std::string _indexedId;
+    // Unique number of the agent, which messages addressed to it keep instead of a pointer.
+    unsigned int _serial;
 
 };
 
@@ -1,18 +1,40 @@
 #include "base/Base.h"
 #include "AIController.h"
 #include "platform/Toolkit.h"
+#include "base/ThreadPool.h"
+#include "scene/Node.h"
+
+#include <algorithm>
+
+// Number of agents updated per job when updating in parallel.
+#define AGENT_UPDATE_BATCH_SIZE 64
+
+// Bits per axis of the packed grid cell coordinates.
+#define GRID_CELL_BITS 21
 
 namespace gameplay
 {
 
 static AIController *g_aiController;
 
+thread_local std::vector<AIController::PendingMessage>* AIController::_pendingMessageList = NULL;
+
 AIController *AIController::cur() {
     return g_aiController;
 }
 
+static unsigned long long gridCellKey(int x, int y, int z)
+{
+    const unsigned long long mask = (1ull << GRID_CELL_BITS) - 1;
+    const int offset = 1 << (GRID_CELL_BITS - 1);
+    return (((unsigned long long)(x + offset) & mask) << (GRID_CELL_BITS * 2)) |
+           (((unsigned long long)(y + offset) & mask) << GRID_CELL_BITS) |
+           ((unsigned long long)(z + offset) & mask);
+}
+
 AIController::AIController()
-    : _paused(false), _firstMessage(NULL), _firstAgent(NULL)
+    : _paused(false), _messageSequence(0), _gridDirty(true), _cellSize(0.0f), _parallelUpdate(false),
+      _lodDistance(0.0f), _lodMaxInterval(1), _frame(0)
 {
     g_aiController = this;
 }
@@ -21,31 +43,48 @@ AIController::~AIController()
 {
 }
 
+bool AIController::messageDeliveredAfter(const AIMessage* a, const AIMessage* b)
+{
+    if (a->getDeliveryTime() != b->getDeliveryTime())
+        return a->getDeliveryTime() > b->getDeliveryTime();
+    return a->_sequence > b->_sequence;
+}
+
 void AIController::initialize()
 {
+    Properties* config = Toolkit::cur()->getConfig()->getNamespace("ai", true);
+    if (config)
+    {
+        if (config->exists("spatialCellSize"))
+            setSpatialCellSize(config->getFloat("spatialCellSize"));
+        if (config->exists("parallelUpdate"))
+            setParallelUpdate(config->getBool("parallelUpdate"));
+        if (config->exists("lodDistance"))
+            setUpdateLod(config->getFloat("lodDistance"), config->exists("lodMaxInterval") ? config->getInt("lodMaxInterval") : 8);
+    }
 }
 
 void AIController::finalize()
 {
     // Remove all agents
-    AIAgent* agent = _firstAgent;
-    while (agent)
+    for (size_t i = 0; i < _agents.size(); ++i)
     {
-        AIAgent* temp = agent;
-        agent = agent->_next;
-        SAFE_RELEASE(temp);
+        SAFE_RELEASE(_agents[i]);
     }
-    _firstAgent = NULL;
+    _agents.clear();
+    _agentPositions.clear();
+    _agentElapsedTimes.clear();
+    _agentIndex.clear();
+    _agentSerials.clear();
+    _grid.clear();
 
     // Remove all messages
-    AIMessage* message = _firstMessage;
-    while (message)
+    for (size_t i = 0; i < _messageQueue.size(); ++i)
     {
-        AIMessage* temp = message;
-        message = message->_next;
-        AIMessage::destroy(temp);
+        AIMessage::destroy(_messageQueue[i]);
     }
-    _firstMessage = NULL;
+    _messageQueue.clear();
+    AIMessage::purgePool();
 }
 
 void AIController::pause()
@@ -60,44 +99,95 @@ void AIController::resume()
 
 void AIController::sendMessage(AIMessage* message, float delay)
 {
+    if (_pendingMessageList)
+    {
+        // Sent by an agent updating in parallel, hold it until all agents are done.
+        PendingMessage pending = { message, delay, false, Vector3::zero(), 0.0f };
+        _pendingMessageList->push_back(pending);
+        return;
+    }
+
     if (delay <= 0)
     {
         // Send instantly
-        if (message->getReceiver() == NULL || strlen(message->getReceiver()) == 0)
+        deliverMessage(message, NULL, 0.0f);
+    }
+    else
+    {
+        // Resolve the receiver now rather than on delivery
+        if (message->_receiverSerial == 0 && !message->_receiver.empty())
         {
-            // Broadcast message to all agents
-            AIAgent* agent = _firstAgent;
-            while (agent)
-            {
-                if (agent->processMessage(message))
-                    break; // message consumed by this agent - stop bubbling
-                agent = agent->_next;
-            }
+            AIAgent* receiver = findAgent(message->_receiver.c_str());
+            if (receiver)
+                message->_receiverSerial = receiver->_serial;
         }
-        else
+
+        // Queue for later delivery
+        message->_deliveryTime = Toolkit::cur()->getGameTime() + delay;
+        message->_sequence = _messageSequence++;
+        _messageQueue.push_back(message);
+        std::push_heap(_messageQueue.begin(), _messageQueue.end(), messageDeliveredAfter);
+    }
+}
+
+void AIController::sendMessage(AIMessage* message, const Vector3& center, float radius)
+{
+    if (_pendingMessageList)
+    {
+        PendingMessage pending = { message, 0.0f, true, center, radius };
+        _pendingMessageList->push_back(pending);
+        return;
+    }
+
+    deliverMessage(message, &center, radius);
+}
+
+void AIController::deliverMessage(AIMessage* message, const Vector3* center, float radius)
+{
+    if (center)
+    {
+        // Deliver to the agents in the area until one consumes the message
+        std::vector<AIAgent*> agents;
+        findAgents(*center, radius, &agents);
+        for (size_t i = 0; i < agents.size(); ++i)
         {
-            // Single recipient
-            AIAgent* agent = findAgent(message->getReceiver());
-            if (agent)
-            {
-                agent->processMessage(message);
-            }
-            else
-            {
-                GP_WARN("Failed to locate AIAgent for message recipient: %s", message->getReceiver());
-            }
+            if (agents[i]->processMessage(message))
+                break;
+        }
+    }
+    else if (message->_receiverSerial != 0)
+    {
+        // The receiver may have been removed since the message was addressed to it. Serials
+        // aren't reused, so the message is dropped rather than delivered to another agent.
+        std::unordered_map<unsigned int, AIAgent*>::iterator itr = _agentSerials.find(message->_receiverSerial);
+        if (itr != _agentSerials.end())
+            itr->second->processMessage(message);
+    }
+    else if (message->getReceiver() == NULL || strlen(message->getReceiver()) == 0)
+    {
+        // Broadcast message to all agents
+        for (size_t i = 0; i < _agents.size(); ++i)
+        {
+            if (_agents[i]->processMessage(message))
+                break; // message consumed by this agent - stop bubbling
         }
-
-        // Delete the message, since it is finished being processed
-        AIMessage::destroy(message);
     }
     else
     {
-        // Queue for later delivery
-        if (_firstMessage)
-            message->_next = _firstMessage;
-        _firstMessage = message;
+        // Single recipient
+        AIAgent* agent = findAgent(message->getReceiver());
+        if (agent)
+        {
+            agent->processMessage(message);
+        }
+        else
+        {
+            GP_WARN("Failed to locate AIAgent for message recipient: %s", message->getReceiver());
+        }
     }
+
+    // Delete the message, since it is finished being processed
+    AIMessage::destroy(message);
 }
 
 void AIController::update(float elapsedTime)
@@ -105,86 +195,281 @@ void AIController::update(float elapsedTime)
     if (_paused)
         return;
 
-    // Send all pending messages that have expired
-    AIMessage* prevMsg = NULL;
-    AIMessage* msg = _firstMessage;
-    while (msg)
+    // Send the queued messages that are due (this also deletes them)
+    double gameTime = Toolkit::cur()->getGameTime();
+    while (!_messageQueue.empty() && _messageQueue.front()->getDeliveryTime() <= gameTime)
     {
-        // If the message delivery time has expired, send it (this also deletes it)
-        if (msg->getDeliveryTime() >= Toolkit::cur()->getGameTime())
+        std::pop_heap(_messageQueue.begin(), _messageQueue.end(), messageDeliveredAfter);
+        AIMessage* message = _messageQueue.back();
+        _messageQueue.pop_back();
+        deliverMessage(message, NULL, 0.0f);
+    }
+
+    if (_cellSize > 0.0f || _lodDistance > 0.0f)
+        updateAgentPositions();
+    if (_cellSize > 0.0f)
+        buildSpatialGrid();
+
+    // Pick the agents that update this frame, accumulating the time of the skipped frames
+    _updateAgents.clear();
+    _updateTimes.clear();
+    for (size_t i = 0; i < _agents.size(); ++i)
+    {
+        AIAgent* agent = _agents[i];
+        if (!agent->isEnabled())
+            continue;
+
+        _agentElapsedTimes[i] += elapsedTime;
+        if (_lodDistance > 0.0f)
         {
-            // Link the message out of our list
-            if (prevMsg)
-                prevMsg->_next = msg->_next;
-
-            AIMessage* temp = msg;
-            msg = msg->_next;
-            temp->_next = NULL;
-            sendMessage(temp);
+            float distance = _agentPositions[i].distance(_lodOrigin);
+            unsigned int interval = std::min(1 + (unsigned int)(distance / _lodDistance), _lodMaxInterval);
+            if ((_frame + i) % interval != 0)
+                continue;
         }
-        else
+
+        _updateAgents.push_back(agent);
+        _updateTimes.push_back(_agentElapsedTimes[i]);
+        _agentElapsedTimes[i] = 0.0f;
+    }
+    _frame++;
+
+    unsigned int updateCount = (unsigned int)_updateAgents.size();
+    if (!_parallelUpdate)
+    {
+        for (unsigned int i = 0; i < updateCount; ++i)
         {
-            prevMsg = msg;
-            msg = msg->_next;
+            _updateAgents[i]->update(_updateTimes[i]);
         }
+        return;
     }
 
-    // Update all enabled agents
-    AIAgent* agent = _firstAgent;
-    while (agent)
+    // Update the agents on the thread pool, holding the messages each agent sends
+    if (_pendingMessages.size() < updateCount)
+        _pendingMessages.resize(updateCount);
+    ThreadPool::getDefault()->parallelFor(updateCount, AGENT_UPDATE_BATCH_SIZE, [this](unsigned int start, unsigned int end)
     {
-        if (agent->isEnabled())
-            agent->update(elapsedTime);
+        for (unsigned int i = start; i < end; ++i)
+        {
+            _pendingMessageList = &_pendingMessages[i];
+            _updateAgents[i]->update(_updateTimes[i]);
+        }
+        _pendingMessageList = NULL;
+    });
 
-        agent = agent->_next;
+    // Deliver the held messages in agent order, so the outcome does not depend on the job scheduling
+    for (unsigned int i = 0; i < updateCount; ++i)
+    {
+        std::vector<PendingMessage>& messages = _pendingMessages[i];
+        for (size_t j = 0; j < messages.size(); ++j)
+        {
+            if (messages[j].proximity)
+                sendMessage(messages[j].message, messages[j].center, messages[j].radius);
+            else
+                sendMessage(messages[j].message, messages[j].delay);
+        }
+        messages.clear();
+    }
+}
+
+void AIController::updateAgentPositions()
+{
+    for (size_t i = 0; i < _agents.size(); ++i)
+    {
+        Node* node = _agents[i]->getNode();
+        if (node)
+            _agentPositions[i] = node->getTranslationWorld();
+    }
+}
+
+void AIController::buildSpatialGrid()
+{
+    _grid.resize(_agents.size());
+    float invCellSize = 1.0f / _cellSize;
+    for (size_t i = 0; i < _agents.size(); ++i)
+    {
+        const Vector3& p = _agentPositions[i];
+        _grid[i].first = gridCellKey((int)floorf(p.x * invCellSize), (int)floorf(p.y * invCellSize), (int)floorf(p.z * invCellSize));
+        _grid[i].second = (unsigned int)i;
+    }
+    std::sort(_grid.begin(), _grid.end());
+    _gridDirty = false;
+}
+
+unsigned int AIController::findAgents(const Vector3& center, float radius, std::vector<AIAgent*>* agents) const
+{
+    GP_ASSERT(agents);
+
+    unsigned int count = 0;
+    float radiusSq = radius * radius;
+    if (_cellSize > 0.0f && !_gridDirty)
+    {
+        float invCellSize = 1.0f / _cellSize;
+        int minX = (int)floorf((center.x - radius) * invCellSize), maxX = (int)floorf((center.x + radius) * invCellSize);
+        int minY = (int)floorf((center.y - radius) * invCellSize), maxY = (int)floorf((center.y + radius) * invCellSize);
+        int minZ = (int)floorf((center.z - radius) * invCellSize), maxZ = (int)floorf((center.z + radius) * invCellSize);
+        double cellCount = (double)(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+
+        // Only walk the cells when there are fewer of them than agents
+        if (cellCount <= (double)_agents.size())
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                for (int y = minY; y <= maxY; ++y)
+                {
+                    for (int z = minZ; z <= maxZ; ++z)
+                    {
+                        std::pair<unsigned long long, unsigned int> first(gridCellKey(x, y, z), 0);
+                        std::vector<std::pair<unsigned long long, unsigned int> >::const_iterator itr = std::lower_bound(_grid.begin(), _grid.end(), first);
+                        for (; itr != _grid.end() && itr->first == first.first; ++itr)
+                        {
+                            if (_agentPositions[itr->second].distanceSquared(center) <= radiusSq)
+                            {
+                                agents->push_back(_agents[itr->second]);
+                                count++;
+                            }
+                        }
+                    }
+                }
+            }
+            return count;
+        }
     }
+
+    // Agent positions are only tracked when the grid or the update LOD need them
+    bool tracked = _cellSize > 0.0f || _lodDistance > 0.0f;
+    for (size_t i = 0; i < _agents.size(); ++i)
+    {
+        Node* node = _agents[i]->getNode();
+        if (node && (tracked ? _agentPositions[i] : node->getTranslationWorld()).distanceSquared(center) <= radiusSq)
+        {
+            agents->push_back(_agents[i]);
+            count++;
+        }
+    }
+    return count;
+}
+
+unsigned int AIController::getAgentCount() const
+{
+    return (unsigned int)_agents.size();
+}
+
+void AIController::setSpatialCellSize(float size)
+{
+    _cellSize = std::max(size, 0.0f);
+    _gridDirty = true;
+}
+
+float AIController::getSpatialCellSize() const
+{
+    return _cellSize;
+}
+
+void AIController::setParallelUpdate(bool parallel)
+{
+    _parallelUpdate = parallel;
+}
+
+bool AIController::isParallelUpdate() const
+{
+    return _parallelUpdate;
+}
+
+void AIController::setUpdateLod(float distance, unsigned int maxInterval)
+{
+    _lodDistance = std::max(distance, 0.0f);
+    _lodMaxInterval = std::max(maxInterval, 1u);
+}
+
+void AIController::setLodOrigin(const Vector3& origin)
+{
+    _lodOrigin = origin;
 }
 
 void AIController::addAgent(AIAgent* agent)
 {
-    agent->addRef();
+    GP_ASSERT(!_pendingMessageList);
 
-    if (_firstAgent)
-        agent->_next = _firstAgent;
+    agent->addRef();
 
-    _firstAgent = agent;
+    agent->_index = (unsigned int)_agents.size();
+    agent->_indexedId = agent->getId();
+    _agents.push_back(agent);
+    _agentPositions.push_back(agent->getNode() ? agent->getNode()->getTranslationWorld() : Vector3::zero());
+    _agentElapsedTimes.push_back(0.0f);
+    _agentIndex.insert(std::make_pair(agent->_indexedId, agent));
+    _agentSerials[agent->_serial] = agent;
+    _gridDirty = true;
 }
 
 void AIController::removeAgent(AIAgent* agent)
 {
-    // Search our linked list of agents and link this agent out.
-    AIAgent* prevAgent = NULL;
-    AIAgent* itr = _firstAgent;
-    while (itr)
+    GP_ASSERT(!_pendingMessageList);
+
+    unsigned int index = agent->_index;
+    if (index >= _agents.size() || _agents[index] != agent)
+        return;
+
+    std::pair<std::unordered_multimap<std::string, AIAgent*>::iterator, std::unordered_multimap<std::string, AIAgent*>::iterator> range = _agentIndex.equal_range(agent->_indexedId);
+    for (std::unordered_multimap<std::string, AIAgent*>::iterator itr = range.first; itr != range.second; ++itr)
     {
-        if (itr == agent)
+        if (itr->second == agent)
         {
-            if (prevAgent)
-                prevAgent->_next = agent->_next;
-            else
-                _firstAgent = agent->_next;
-
-            agent->_next = NULL;
-            agent->release();
+            _agentIndex.erase(itr);
             break;
         }
-
-        prevAgent = itr;
-        itr = itr->_next;
     }
+    _agentSerials.erase(agent->_serial);
+
+    // Move the last agent into the free slot
+    unsigned int last = (unsigned int)_agents.size() - 1;
+    _agents[index] = _agents[last];
+    _agentPositions[index] = _agentPositions[last];
+    _agentElapsedTimes[index] = _agentElapsedTimes[last];
+    _agents[index]->_index = index;
+    _agents.pop_back();
+    _agentPositions.pop_back();
+    _agentElapsedTimes.pop_back();
+    _gridDirty = true;
+
+    agent->release();
 }
 
 AIAgent* AIController::findAgent(const char* id) const
 {
     GP_ASSERT(id);
 
-    AIAgent* agent = _firstAgent;
-    while (agent)
+    std::pair<std::unordered_multimap<std::string, AIAgent*>::iterator, std::unordered_multimap<std::string, AIAgent*>::iterator> range = _agentIndex.equal_range(id);
+    for (std::unordered_multimap<std::string, AIAgent*>::iterator itr = range.first; itr != range.second; ++itr)
     {
+        if (strcmp(id, itr->second->getId()) == 0)
+            return itr->second;
+    }
+
+    // The agent ids are the names of their nodes, which can change after the agents are indexed.
+    for (size_t i = 0; i < _agents.size(); ++i)
+    {
+        AIAgent* agent = _agents[i];
         if (strcmp(id, agent->getId()) == 0)
+        {
+            // Re-index the renamed agent, unless agents are being updated in parallel.
+            if (!_pendingMessageList)
+            {
+                std::pair<std::unordered_multimap<std::string, AIAgent*>::iterator, std::unordered_multimap<std::string, AIAgent*>::iterator> stale = _agentIndex.equal_range(agent->_indexedId);
+                for (std::unordered_multimap<std::string, AIAgent*>::iterator itr = stale.first; itr != stale.second; ++itr)
+                {
+                    if (itr->second == agent)
+                    {
+                        _agentIndex.erase(itr);
+                        break;
+                    }
+                }
+                agent->_indexedId = id;
+                _agentIndex.insert(std::make_pair(agent->_indexedId, agent));
+            }
             return agent;
-
-        agent = agent->_next;
+        }
     }
 
     return NULL;
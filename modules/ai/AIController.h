@@ -3,6 +3,7 @@
 
 #include "AIAgent.h"
 #include "AIMessage.h"
+#include "math/Vector3.h"
 
 namespace gameplay
 {
@@ -45,8 +46,112 @@ public:
      */
     AIAgent* findAgent(const char* id) const;
 
+    /**
+     * Sends the specified message to the agents within a radius of a point.
+     *
+     * The agents receive the message in turn until one of them handles it, as for broadcast
+     * messages. The message is destroyed once it has been delivered.
+     *
+     * @param message The message to send.
+     * @param center The center of the area, in world space.
+     * @param radius The radius of the area.
+     */
+    void sendMessage(AIMessage* message, const Vector3& center, float radius);
+
+    /**
+     * Finds the agents within a radius of a point.
+     *
+     * The search uses the spatial grid when one is enabled with setSpatialCellSize().
+     * When the grid or the update LOD is enabled, agent positions are those of their
+     * nodes at the last update.
+     *
+     * @param center The center of the area, in world space.
+     * @param radius The radius of the area.
+     * @param agents The list to add the agents found to.
+     *
+     * @return The number of agents found.
+     */
+    unsigned int findAgents(const Vector3& center, float radius, std::vector<AIAgent*>* agents) const;
+
+    /**
+     * Returns the number of agents registered with the AIController.
+     *
+     * @return The number of agents.
+     */
+    unsigned int getAgentCount() const;
+
+    /**
+     * Sets the cell size of the spatial grid used for proximity queries.
+     *
+     * The grid is rebuilt from the agent positions at every update. A size of zero,
+     * the default, disables the grid and proximity queries test every agent.
+     *
+     * @param size The size of a grid cell, in world units.
+     */
+    void setSpatialCellSize(float size);
+
+    /**
+     * Returns the cell size of the spatial grid used for proximity queries.
+     *
+     * @return The size of a grid cell, or zero when the grid is disabled.
+     */
+    float getSpatialCellSize() const;
+
+    /**
+     * Sets whether agents are updated in parallel on the engine thread pool.
+     *
+     * When enabled, the state listeners of different agents may run at the same time and
+     * must only touch their own agent. Messages sent while agents update are held and
+     * delivered after all agents have updated, in agent order, so the outcome does not
+     * depend on the thread count. Scripted state events are not thread safe, so this is
+     * disabled by default.
+     *
+     * @param parallel true to update agents in parallel, false to update them in turn.
+     */
+    void setParallelUpdate(bool parallel);
+
+    /**
+     * Determines if agents are updated in parallel.
+     *
+     * @return true if agents are updated in parallel, false otherwise.
+     */
+    bool isParallelUpdate() const;
+
+    /**
+     * Sets the update rate level of detail of the agents.
+     *
+     * An agent at distance d from the LOD origin is updated every 1 + d / distance frames,
+     * up to maxInterval frames, with the elapsed time of the skipped frames. Updates of
+     * distant agents are staggered across frames. A distance of zero, the default,
+     * updates every agent every frame.
+     *
+     * @param distance The distance over which the update interval grows by one frame.
+     * @param maxInterval The largest number of frames between two updates of an agent.
+     */
+    void setUpdateLod(float distance, unsigned int maxInterval);
+
+    /**
+     * Sets the point the update rate level of detail distances are measured from,
+     * typically the position of the active camera.
+     *
+     * @param origin The LOD origin, in world space.
+     */
+    void setLodOrigin(const Vector3& origin);
+
 private:
 
+    /**
+     * A message sent while agents are updated in parallel, held until they are done.
+     */
+    struct PendingMessage
+    {
+        AIMessage* message;
+        float delay;
+        bool proximity;
+        Vector3 center;
+        float radius;
+    };
+
     /**
      * Constructor.
      */
@@ -98,9 +203,41 @@ private:
 
     void removeAgent(AIAgent* agent);
 
+    void deliverMessage(AIMessage* message, const Vector3* center, float radius);
+
+    /**
+     * Orders the message queue heap so that the earliest message is at the front.
+     */
+    static bool messageDeliveredAfter(const AIMessage* a, const AIMessage* b);
+
+    void updateAgentPositions();
+
+    void buildSpatialGrid();
+
     bool _paused;
-    AIMessage* _firstMessage;
-    AIAgent* _firstAgent;
+    // Delayed messages in a binary heap ordered by delivery time.
+    std::vector<AIMessage*> _messageQueue;
+    unsigned int _messageSequence;
+    // Agents and their per-agent update data, in parallel arrays indexed by AIAgent::_index.
+    std::vector<AIAgent*> _agents;
+    std::vector<Vector3> _agentPositions;
+    std::vector<float> _agentElapsedTimes;
+    mutable std::unordered_multimap<std::string, AIAgent*> _agentIndex;
+    // Agents by AIAgent::_serial, to deliver the messages addressed to a specific agent.
+    std::unordered_map<unsigned int, AIAgent*> _agentSerials;
+    // Agent indices sorted by grid cell key.
+    std::vector<std::pair<unsigned long long, unsigned int> > _grid;
+    bool _gridDirty;
+    float _cellSize;
+    bool _parallelUpdate;
+    float _lodDistance;
+    unsigned int _lodMaxInterval;
+    Vector3 _lodOrigin;
+    unsigned int _frame;
+    std::vector<AIAgent*> _updateAgents;
+    std::vector<float> _updateTimes;
+    std::vector<std::vector<PendingMessage> > _pendingMessages;
+    static thread_local std::vector<PendingMessage>* _pendingMessageList;
 
 };
 
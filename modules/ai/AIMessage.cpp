@@ -1,34 +1,114 @@
 #include "base/Base.h"
 #include "ai/AIMessage.h"
+#include "ai/AIAgent.h"
+
+#include <mutex>
 
 namespace gameplay
 {
 
+// Number of messages allocated at once when the pool is empty.
+#define MESSAGE_POOL_BLOCK_SIZE 64
+
+// Pool of recycled messages. Messages can be created by agents updating on worker threads.
+static std::mutex __messagePoolMutex;
+static std::vector<AIMessage*> __freeMessages;
+static std::vector<AIMessage*> __messageBlocks;
+static unsigned int __liveMessageCount = 0;
+
 AIMessage::AIMessage()
-    : _id(0), _deliveryTime(0), _parameters(NULL), _parameterCount(0), _messageType(MESSAGE_TYPE_CUSTOM), _next(NULL)
+    : _id(0), _receiverSerial(0), _deliveryTime(0), _sequence(0), _parameters(NULL), _parameterCount(0), _messageType(MESSAGE_TYPE_CUSTOM)
 {
 }
 
 AIMessage::~AIMessage()
 {
-    SAFE_DELETE_ARRAY(_parameters);
 }
 
-AIMessage* AIMessage::create(unsigned int id, const char* sender, const char* receiver, unsigned int parameterCount)
+AIMessage* AIMessage::allocate(unsigned int id, const char* sender, unsigned int parameterCount)
 {
-    AIMessage* message = new AIMessage();
+    AIMessage* message = NULL;
+    {
+        std::lock_guard<std::mutex> lock(__messagePoolMutex);
+        if (__freeMessages.empty())
+        {
+            AIMessage* block = new AIMessage[MESSAGE_POOL_BLOCK_SIZE];
+            __messageBlocks.push_back(block);
+            for (int i = MESSAGE_POOL_BLOCK_SIZE - 1; i >= 0; --i)
+                __freeMessages.push_back(&block[i]);
+        }
+        message = __freeMessages.back();
+        __freeMessages.pop_back();
+        __liveMessageCount++;
+    }
+
     message->_id = id;
-    message->_sender = sender;
-    message->_receiver = receiver;
+    message->_sender = sender ? sender : "";
     message->_parameterCount = parameterCount;
-    if (parameterCount > 0)
-        message->_parameters = new AIMessage::Parameter[parameterCount];
+    if (parameterCount <= sizeof(message->_inlineParameters) / sizeof(Parameter))
+    {
+        message->_parameters = message->_inlineParameters;
+    }
+    else
+    {
+        message->_extraParameters.resize(parameterCount);
+        message->_parameters = &message->_extraParameters[0];
+    }
+    return message;
+}
+
+AIMessage* AIMessage::create(unsigned int id, const char* sender, const char* receiver, unsigned int parameterCount)
+{
+    AIMessage* message = allocate(id, sender, parameterCount);
+    message->_receiver = receiver ? receiver : "";
+    return message;
+}
+
+AIMessage* AIMessage::create(unsigned int id, const char* sender, AIAgent* receiver, unsigned int parameterCount)
+{
+    GP_ASSERT(receiver);
+
+    AIMessage* message = allocate(id, sender, parameterCount);
+    message->_receiver = receiver->getId();
+    message->_receiverSerial = receiver->_serial;
     return message;
 }
 
 void AIMessage::destroy(AIMessage* message)
 {
-    SAFE_DELETE(message);
+    if (!message)
+        return;
+
+    // Reset the message, keeping the memory of its strings for the next use.
+    for (unsigned int i = 0; i < message->_parameterCount; ++i)
+        message->_parameters[i].clear();
+    message->_parameters = NULL;
+    message->_parameterCount = 0;
+    message->_stringData.clear();
+    message->_sender.clear();
+    message->_receiver.clear();
+    message->_receiverSerial = 0;
+    message->_deliveryTime = 0;
+    message->_sequence = 0;
+    message->_messageType = MESSAGE_TYPE_CUSTOM;
+
+    std::lock_guard<std::mutex> lock(__messagePoolMutex);
+    __freeMessages.push_back(message);
+    __liveMessageCount--;
+}
+
+void AIMessage::purgePool()
+{
+    std::lock_guard<std::mutex> lock(__messagePoolMutex);
+    if (__liveMessageCount > 0)
+        return;
+
+    for (size_t i = 0; i < __messageBlocks.size(); ++i)
+    {
+        SAFE_DELETE_ARRAY(__messageBlocks[i]);
+    }
+    __messageBlocks.clear();
+    __freeMessages.clear();
 }
 
 unsigned int AIMessage::getId() const
@@ -146,7 +226,7 @@ const char* AIMessage::getString(unsigned int index) const
     GP_ASSERT(index < _parameterCount);
     GP_ASSERT(_parameters[index].type == AIMessage::STRING);
 
-    return _parameters[index].stringValue;
+    return &_stringData[_parameters[index].stringOffset];
 }
 
 void AIMessage::setString(unsigned int index, const char* value)
@@ -156,12 +236,11 @@ void AIMessage::setString(unsigned int index, const char* value)
 
     clearParameter(index);
 
-    // Copy the string into our parameter
+    // Copy the string into the message string data
     size_t len = strlen(value);
-    char* buffer = new char[len + 1];
-    strcpy(buffer, value);
-    _parameters[index].stringValue = buffer;
+    _parameters[index].stringOffset = (unsigned int)_stringData.size();
     _parameters[index].type = AIMessage::STRING;
+    _stringData.insert(_stringData.end(), value, value + len + 1);
 }
 
 unsigned int AIMessage::getParameterCount() const
@@ -188,16 +267,8 @@ AIMessage::Parameter::Parameter()
 {
 }
 
-AIMessage::Parameter::~Parameter()
-{
-    clear();
-}
-
 void AIMessage::Parameter::clear()
 {
-    if (type == AIMessage::STRING)
-        SAFE_DELETE_ARRAY(stringValue);
-
     type = AIMessage::UNDEFINED;
 }
 
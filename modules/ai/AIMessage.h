@@ -4,6 +4,8 @@
 namespace gameplay
 {
 
+class AIAgent;
+
 /**
  * Defines a simple message structure used for passing messages through
  * the AI system.
@@ -53,6 +55,23 @@ public:
      */
     static AIMessage* create(unsigned int id, const char* sender, const char* receiver, unsigned int parameterCount);
 
+    /**
+     * Creates a new message sent to a specific agent.
+     *
+     * Unlike messages addressed by receiver ID, the receiver does not need to be looked
+     * up by name when the message is delivered. The message does not keep a reference to
+     * the receiver, so it may be created while agents update in parallel; it is dropped
+     * if the receiver was removed from the controller before delivery.
+     *
+     * @param id The message ID.
+     * @param sender AIAgent sender ID (can be empty or null for an anonymous message).
+     * @param receiver The AIAgent receiving the message.
+     * @param parameterCount Number of parameters for this message.
+     *
+     * @return A new AIMessage.
+     */
+    static AIMessage* create(unsigned int id, const char* sender, AIAgent* receiver, unsigned int parameterCount);
+
     /**
      * Destroys an AIMessage.
      *
@@ -64,6 +83,15 @@ public:
      */
     static void destroy(AIMessage* message);
 
+    /**
+     * Frees the memory of the pooled messages.
+     *
+     * Messages are recycled through a pool once destroyed, so that sending messages does
+     * not allocate memory once the pool has grown to the number of messages in flight.
+     * The memory is only freed if no message is alive.
+     */
+    static void purgePool();
+
     /**
      * Returns the message ID.
      *
@@ -221,8 +249,6 @@ private:
     {
         Parameter();
 
-        ~Parameter();
-
         void clear();
 
         union
@@ -232,7 +258,8 @@ private:
             float floatValue;
             double doubleValue;
             bool boolValue;
-            char* stringValue;
+            // Offset of the string in the message string data.
+            unsigned int stringOffset;
         };
 
         AIMessage::ParameterType type;
@@ -267,14 +294,26 @@ private:
 
     void clearParameter(unsigned int index);
 
+    /**
+     * Takes a message from the pool and sets it up.
+     */
+    static AIMessage* allocate(unsigned int id, const char* sender, unsigned int parameterCount);
+
     unsigned int _id;
     std::string _sender;
     std::string _receiver;
+    // Serial of the receiving agent, or zero if the message is addressed by receiver ID.
+    unsigned int _receiverSerial;
     double _deliveryTime;
+    // Order in which the message was queued, to deliver messages due at the same time in order.
+    unsigned int _sequence;
     Parameter* _parameters;
     unsigned int _parameterCount;
+    Parameter _inlineParameters[4];
+    std::vector<Parameter> _extraParameters;
+    // Storage of the string parameters; it keeps its capacity when the message is recycled.
+    std::vector<char> _stringData;
     MessageType _messageType;
-    AIMessage* _next;
 
 };
 
@@ -116,7 +116,7 @@ bool AIStateMachine::setState(AIState* state)
 
 void AIStateMachine::sendChangeStateMessage(AIState* newState)
 {
-    AIMessage* message = AIMessage::create(0, _agent->getId(), _agent->getId(), 1);
+    AIMessage* message = AIMessage::create(0, _agent->getId(), _agent, 1);
     message->_messageType = AIMessage::MESSAGE_TYPE_STATE_CHANGE;
     message->setString(0, newState->getId());
     AIController::cur()->sendMessage(message);
@@ -323,6 +323,7 @@ void Game::shutdown()
         //RenderState::finalize();
 
         SAFE_DELETE(_properties);
+        Properties::clearCache();
 
 		_state = UNINITIALIZED;
     }
@@ -2,45 +2,40 @@
 #include "audio.h"
 #include "AudioBuffer.h"
 #include "base/FileSystem.h"
+#include "AudioController.h"
+#include "base/ThreadPool.h"
 
 #include "3rd/stb_vorbis.h"
 
 namespace gameplay
 {
 
-// Audio buffer cache
-static std::vector<AudioBuffer*> __buffers;
+// Cache of the non-streamed audio buffers by file path. The cache holds a reference on each
+// buffer and releases the least recently used unreferenced ones when over its memory budget.
+static std::unordered_map<std::string, AudioBuffer*> __buffers;
+static std::list<AudioBuffer*> __buffersLru;
+static std::vector<AudioBuffer*> __pendingBuffers;
+static size_t __cacheMemory = 0;
+static size_t __cacheBudget = 64 * 1024 * 1024;
 
-AudioBuffer::AudioBuffer(const char* path, ALuint* buffer, bool streamed)
-: _filePath(path), _streamed(streamed), _buffersNeededCount(0)
+// Size of the blocks read from the stream for the ogg decoder.
+#define OGG_INPUT_CHUNK_SIZE 4096
+
+AudioBuffer::AudioBuffer(const char* path, const std::vector<ALuint>& buffers, bool streamed)
+: _alBufferQueue(buffers), _filePath(path), _streamed(streamed), _buffersNeededCount(0), _streamingBufferSize(0), _duration(0.0f),
+  _loadState(streamed ? LOAD_READY : LOAD_PENDING), _pcmFormat(0), _pcmFrequency(0), _size(0)
 {
-    memcpy(_alBufferQueue, buffer, sizeof(_alBufferQueue));
 }
 
 AudioBuffer::~AudioBuffer()
 {
-    // Remove the buffer from the cache.
-    unsigned int bufferCount = (unsigned int)__buffers.size();
-
-    if (!_streamed)
-    {
-        unsigned int bufferCount = (unsigned int)__buffers.size();
-        for (unsigned int i = 0; i < bufferCount; i++)
-        {
-            if (this == __buffers[i])
-            {
-                __buffers.erase(__buffers.begin() + i);
-                break;
-            }
-        }
-    }
-    else if (_streamStateOgg.get())
+    if (_streamStateOgg.get() && _streamStateOgg->oggFile)
     {
         stb_vorbis* vorbis = static_cast<stb_vorbis*>(_streamStateOgg->oggFile);
         stb_vorbis_close(vorbis);
     }
 
-    for (int i = 0; i < STREAMING_BUFFER_QUEUE_SIZE; i++)
+    for (size_t i = 0; i < _alBufferQueue.size(); i++)
     {
         if (_alBufferQueue[i])
         {
@@ -57,23 +52,29 @@ AudioBuffer* AudioBuffer::create(const char* path, bool streamed)
     AudioBuffer* buffer = NULL;
     if (!streamed)
     {
-        unsigned int bufferCount = (unsigned int)__buffers.size();
-        for (unsigned int i = 0; i < bufferCount; i++)
+        std::unordered_map<std::string, AudioBuffer*>::iterator itr = __buffers.find(path);
+        if (itr != __buffers.end())
         {
-            buffer = __buffers[i];
+            buffer = itr->second;
             GP_ASSERT(buffer);
-            if (buffer->_filePath.compare(path) == 0)
-            {
-                buffer->addRef();
-                return buffer;
-            }
+            __buffersLru.splice(__buffersLru.begin(), __buffersLru, buffer->_cacheItr);
+            buffer->addRef();
+            return buffer;
+        }
+
+        // Missing files are reported right away, decoding errors only once the decode has run.
+        if (!FileSystem::fileExists(path))
+        {
+            GP_ERROR("Failed to load audio file %s.", path);
+            return NULL;
         }
     }
-    ALuint alBuffer[STREAMING_BUFFER_QUEUE_SIZE];
-    memset(alBuffer, 0, sizeof(alBuffer));
+    AudioController* audioController = AudioController::cur();
+    GP_ASSERT(audioController);
 
     // Create 1 buffer for non-streamed sounds or full queue for streamed ones.
-    unsigned int queueSize = streamed ? STREAMING_BUFFER_QUEUE_SIZE : 1;
+    unsigned int queueSize = streamed ? audioController->getStreamingBufferCount() : 1;
+    std::vector<ALuint> alBuffer(queueSize, 0);
     for (unsigned int i = 0; i < queueSize; i++)
     {
         // Load audio data into a buffer.
@@ -85,78 +86,242 @@ AudioBuffer* AudioBuffer::create(const char* path, bool streamed)
             return NULL;
         }
     }
-    
+
+    if (!streamed)
+    {
+        // Decode the whole file on a worker thread; updateCache() uploads the data once it is ready.
+        // Sources playing the buffer in the meantime are kept virtual.
+        buffer = new AudioBuffer(path, alBuffer, false);
+        __buffersLru.push_front(buffer);
+        buffer->_cacheItr = __buffersLru.begin();
+        __buffers[path] = buffer;
+        __pendingBuffers.push_back(buffer);
+        ThreadPool::getDefault()->addTask([buffer]() { buffer->decode(); });
+
+        // One reference for the cache and one for the caller.
+        buffer->addRef();
+        return buffer;
+    }
+
+    std::unique_ptr<Stream> stream;
     std::unique_ptr<AudioStreamStateWav> streamStateWav;
     std::unique_ptr<AudioStreamStateOgg> streamStateOgg;
+    if (!AudioBuffer::load(path, true, stream, streamStateWav, streamStateOgg, NULL))
+    {
+        for (unsigned int i = 0; i < queueSize; i++)
+        {
+            if (alBuffer[i])
+                AL_CHECK(alDeleteBuffers(1, &alBuffer[i]));
+        }
+        return NULL;
+    }
+
+    buffer = new AudioBuffer(path, alBuffer, true);
+
+    buffer->_fileStream.reset(stream.release());
+    buffer->_streamStateWav.reset(streamStateWav.release());
+    buffer->_streamStateOgg.reset(streamStateOgg.release());
+
+    // The decoded data passes through a ring buffer holding two queue buffers worth of PCM
+    // plus room for one decoded frame, since ogg frames do not line up with queue buffers.
+    unsigned int bufferSize = audioController->getStreamingBufferSize();
+    unsigned int frameSize = buffer->_streamStateOgg.get() ? buffer->_streamStateOgg->maxFrameSize : 0;
+    buffer->_streamingBufferSize = bufferSize;
+    buffer->_uploadBuffer.resize(bufferSize);
+    buffer->_ringBuffer.resize(bufferSize * 2 + frameSize);
+
+    if (buffer->_streamStateWav.get())
+        buffer->_buffersNeededCount = (buffer->_streamStateWav->dataSize + bufferSize - 1) / bufferSize;
+    else
+        buffer->_buffersNeededCount = queueSize;
+
+    // Fill the first buffer so the source has data queued before the streaming thread picks it up.
+    if (!buffer->streamData(buffer->_alBufferQueue[0], false))
+    {
+        GP_ERROR("Failed to stream audio file %s.", path);
+        SAFE_RELEASE(buffer);
+        return NULL;
+    }
 
+    return buffer;
+}
+
+bool AudioBuffer::load(const char* path, bool streamed, std::unique_ptr<Stream>& stream,
+                       std::unique_ptr<AudioStreamStateWav>& streamStateWav,
+                       std::unique_ptr<AudioStreamStateOgg>& streamStateOgg, std::vector<char>* pcm)
+{
     // Load sound file.
-    std::unique_ptr<Stream> stream(FileSystem::open(path));
+    stream.reset(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
     {
         GP_ERROR("Failed to load audio file %s.", path);
-        goto cleanup;
+        return false;
     }
-    
+
     // Read the file header
     char header[12];
     if (stream->read(header, 1, 12) != 12)
     {
         GP_ERROR("Invalid header for audio file %s.", path);
-        goto cleanup;
+        return false;
     }
-    
+
     // Check the file format
     if (memcmp(header, "RIFF", 4) == 0)
     {
-        // Fill at least one buffer with sound data.
         streamStateWav.reset(new AudioStreamStateWav());
-        if (!AudioBuffer::loadWav(stream.get(), alBuffer[0], streamed, streamStateWav.get()))
+        if (!AudioBuffer::loadWav(stream.get(), streamed, streamStateWav.get(), pcm))
         {
             GP_ERROR("Invalid wave file: %s", path);
-            goto cleanup;
+            return false;
         }
     }
     else if (memcmp(header, "OggS", 4) == 0)
     {
-        // Fill at least one buffer with sound data.
         streamStateOgg.reset(new AudioStreamStateOgg());
-        if (!AudioBuffer::loadOgg(stream.get(), alBuffer[0], streamed, streamStateOgg.get()))
+        if (!AudioBuffer::loadOgg(stream.get(), streamed, streamStateOgg.get(), pcm))
         {
             GP_ERROR("Invalid ogg file: %s", path);
-            goto cleanup;
+            return false;
         }
     }
     else
     {
         GP_ERROR("Unsupported audio file: %s", path);
-        goto cleanup;
+        return false;
     }
+    return true;
+}
 
-    buffer = new AudioBuffer(path, alBuffer, streamed);
+void AudioBuffer::decode()
+{
+    std::unique_ptr<Stream> stream;
+    std::unique_ptr<AudioStreamStateWav> streamStateWav;
+    std::unique_ptr<AudioStreamStateOgg> streamStateOgg;
+    if (!AudioBuffer::load(_filePath.c_str(), false, stream, streamStateWav, streamStateOgg, &_pcm))
+    {
+        _pcm.clear();
+        _loadState = LOAD_FAILED;
+        return;
+    }
 
-    buffer->_fileStream.reset(stream.release());
-    buffer->_streamStateWav.reset(streamStateWav.release());
-    buffer->_streamStateOgg.reset(streamStateOgg.release());
-    if (buffer->_streamStateWav.get())
-        buffer->_buffersNeededCount = (buffer->_streamStateWav->dataSize + STREAMING_BUFFER_SIZE - 1) / STREAMING_BUFFER_SIZE;
-    else if (buffer->_streamStateOgg.get())
-        buffer->_buffersNeededCount = (buffer->_streamStateOgg->dataSize + STREAMING_BUFFER_SIZE - 1) / STREAMING_BUFFER_SIZE;
+    _pcmFormat = streamStateWav.get() ? streamStateWav->format : streamStateOgg->format;
+    _pcmFrequency = streamStateWav.get() ? streamStateWav->frequency : streamStateOgg->frequency;
 
-    if (!streamed)
-        __buffers.push_back(buffer);
+    // Publishes the decoded data to the main thread.
+    _loadState = LOAD_DECODED;
+}
 
-    return buffer;
-    
-cleanup:
-    for (unsigned int i = 0; i < STREAMING_BUFFER_QUEUE_SIZE; i++)
+bool AudioBuffer::isLoaded() const
+{
+    return _loadState == LOAD_READY;
+}
+
+bool AudioBuffer::isLoadFailed() const
+{
+    return _loadState == LOAD_FAILED;
+}
+
+void AudioBuffer::updateCache()
+{
+    // Upload the sounds decoded since the last frame.
+    for (size_t i = 0; i < __pendingBuffers.size();)
     {
-        if (alBuffer[i])
-            AL_CHECK(alDeleteBuffers(1, &alBuffer[i]));
+        AudioBuffer* buffer = __pendingBuffers[i];
+        int state = buffer->_loadState;
+        if (state == LOAD_PENDING)
+        {
+            i++;
+            continue;
+        }
+
+        if (state == LOAD_DECODED)
+        {
+            AL_CHECK(alBufferData(buffer->_alBufferQueue[0], buffer->_pcmFormat, buffer->_pcm.empty() ? NULL : &buffer->_pcm[0], (ALsizei)buffer->_pcm.size(), buffer->_pcmFrequency));
+
+            // Keep the length of the sound so that virtual voices know when they finish.
+            unsigned int frameSize = 0;
+            switch (buffer->_pcmFormat)
+            {
+            case AL_FORMAT_MONO8:
+                frameSize = 1;
+                break;
+            case AL_FORMAT_MONO16:
+            case AL_FORMAT_STEREO8:
+                frameSize = 2;
+                break;
+            case AL_FORMAT_STEREO16:
+                frameSize = 4;
+                break;
+            }
+            if (frameSize > 0 && buffer->_pcmFrequency > 0)
+                buffer->_duration = (float)buffer->_pcm.size() / (float)(frameSize * buffer->_pcmFrequency);
+
+            buffer->_size = (unsigned int)buffer->_pcm.size();
+            __cacheMemory += buffer->_size;
+            std::vector<char>().swap(buffer->_pcm);
+            buffer->_loadState = LOAD_READY;
+        }
+
+        __pendingBuffers.erase(__pendingBuffers.begin() + i);
+    }
+
+    // Release the least recently used buffers no source references while over budget.
+    // Failed buffers are dropped as soon as they are unreferenced so that a later create() retries them.
+    std::list<AudioBuffer*>::iterator itr = __buffersLru.end();
+    while (itr != __buffersLru.begin())
+    {
+        --itr;
+        AudioBuffer* buffer = *itr;
+        if (buffer->getRefCount() != 1)
+            continue;
+        int state = buffer->_loadState;
+        if (state == LOAD_FAILED || (state == LOAD_READY && __cacheMemory > __cacheBudget))
+        {
+            __cacheMemory -= buffer->_size;
+            __buffers.erase(buffer->_filePath);
+            itr = __buffersLru.erase(itr);
+            SAFE_RELEASE(buffer);
+        }
+    }
+}
+
+void AudioBuffer::clearCache()
+{
+    // Wait for the running decodes, they write into the buffers.
+    for (size_t i = 0; i < __pendingBuffers.size(); i++)
+    {
+        while (__pendingBuffers[i]->_loadState == LOAD_PENDING)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    __pendingBuffers.clear();
+
+    for (std::list<AudioBuffer*>::iterator itr = __buffersLru.begin(); itr != __buffersLru.end(); ++itr)
+    {
+        AudioBuffer* buffer = *itr;
+        SAFE_RELEASE(buffer);
     }
-    return NULL;
+    __buffersLru.clear();
+    __buffers.clear();
+    __cacheMemory = 0;
 }
 
-bool AudioBuffer::loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateWav* streamState)
+void AudioBuffer::setCacheBudget(size_t bytes)
+{
+    __cacheBudget = bytes;
+}
+
+size_t AudioBuffer::getCacheBudget()
+{
+    return __cacheBudget;
+}
+
+size_t AudioBuffer::getCacheMemory()
+{
+    return __cacheMemory;
+}
+
+bool AudioBuffer::loadWav(Stream* stream, bool streamed, AudioStreamStateWav* streamState, std::vector<char>* pcm)
 {
     GP_ASSERT(stream);
 
@@ -287,30 +452,24 @@ bool AudioBuffer::loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStr
                 return false;
             }
 
+            streamState->dataStart = stream->position();
+            streamState->dataSize = dataSize;
+            streamState->format = format;
+            streamState->frequency = frequency;
+
+            // Streamed data is read as it is played.
             if (streamed)
-            {
-                // Save streaming state for later use.
-                streamState->dataStart = stream->position();
-                streamState->dataSize = dataSize;
-                streamState->format = format;
-                streamState->frequency = frequency;
-            
-                // Limit data size to STREAMING_BUFFER_SIZE.
-                if (dataSize > STREAMING_BUFFER_SIZE)
-                    dataSize = STREAMING_BUFFER_SIZE;
-            }
+                return true;
 
-            char* data = new char[dataSize];
-            if (stream->read(data, sizeof(char), dataSize) != dataSize)
+            GP_ASSERT(pcm);
+            pcm->resize(dataSize);
+            if (dataSize > 0 && stream->read(&(*pcm)[0], sizeof(char), dataSize) != dataSize)
             {
                 GP_ERROR("Failed to load wave file; file is missing data.");
-                SAFE_DELETE_ARRAY(data);
+                pcm->clear();
                 return false;
             }
 
-            AL_CHECK( alBufferData(buffer, format, data, dataSize, frequency) );
-            SAFE_DELETE_ARRAY(data);
-
             // We've read the data, so return now.
             return true;
         }
@@ -355,7 +514,7 @@ bool AudioBuffer::loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStr
     return false;
 }
 
-bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateOgg* streamState)
+bool AudioBuffer::loadOgg(Stream* stream, bool streamed, AudioStreamStateOgg* streamState, std::vector<char>* pcm)
 {
     GP_ASSERT(stream);
 
@@ -363,44 +522,8 @@ bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStr
     stream->rewind();
 
     if (streamed) {
-        int data_size = stream->length();
-        unsigned char* data = new unsigned char[data_size];
-        stream->read((char*)data, data_size);
-        int error;
-        stb_vorbis* v = stb_vorbis_open_memory(data, data_size, &error, NULL);
-        if (!v) {
-            GP_ERROR("Failed to open ogg file.");
-            return false;
-        }
-        int num_channels = v->channels;
-        int sample_rate = v->sample_rate;
-        if (num_channels == 1)
-            format = AL_FORMAT_MONO16;
-        else
-            format = AL_FORMAT_STEREO16;
-
-        streamState->dataStart = 0;
-        streamState->dataSize = stream->length();
-        streamState->format = format;
-        streamState->frequency = sample_rate;
-        streamState->oggFile = v;
-
-        static short* decoded[STREAMING_BUFFER_SIZE];
-        int numBytes = STREAMING_BUFFER_SIZE * 2;
-        auto outSamples = (unsigned)stb_vorbis_get_samples_short_interleaved(v, v->channels, (short*)decoded, STREAMING_BUFFER_SIZE);
-        unsigned outBytes = (outSamples * v->channels) << 1u;
-        if (outBytes < STREAMING_BUFFER_SIZE)
-        {
-            numBytes -= outBytes;
-            stb_vorbis_seek_start(v);
-            outSamples =
-                (unsigned)stb_vorbis_get_samples_short_interleaved(v, v->channels, (short*)(decoded + outBytes), numBytes >> 1u);
-
-            outBytes += (outSamples * v->channels) << 1u;
-        }
-
-        AL_CHECK(alBufferData(buffer, format, decoded, outBytes, sample_rate));
-        return true;
+        // Only the headers are parsed here; the audio data is decoded as it is streamed.
+        return openOgg(stream, streamState);
     }
     else {
         int num_channels = 0;
@@ -424,63 +547,204 @@ bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStr
         else
             format = AL_FORMAT_STEREO16;
 
-        AL_CHECK(alBufferData(buffer, format, decoded, len*2, sample_rate));
+        GP_ASSERT(pcm);
+        pcm->assign((const char*)decoded, (const char*)decoded + len * num_channels * sizeof(short));
 
         SAFE_DELETE_ARRAY(data);
 
         free(decoded);
 
-        streamState->dataStart = 0;
-        streamState->dataSize = stream->length();
         streamState->format = format;
         streamState->frequency = sample_rate;
         streamState->oggFile = NULL;
+        streamState->inputSize = 0;
+        streamState->maxFrameSize = 0;
         return true;
     }
 }
 
-bool AudioBuffer::streamData(ALuint buffer, bool looped)
+bool AudioBuffer::openOgg(Stream* stream, AudioStreamStateOgg* streamState)
 {
-    static char buffers[STREAMING_BUFFER_SIZE];
-    
-    if (_streamStateWav.get())
+    GP_ASSERT(stream);
+    GP_ASSERT(streamState);
+
+    streamState->oggFile = NULL;
+    streamState->inputSize = 0;
+    if (streamState->input.size() < OGG_INPUT_CHUNK_SIZE)
+        streamState->input.resize(OGG_INPUT_CHUNK_SIZE);
+
+    // Hand the decoder growing blocks from the start of the file until it has all the headers.
+    stb_vorbis* v = NULL;
+    int used = 0;
+    while (v == NULL)
     {
-        ALsizei bytesRead = _fileStream->read(buffers, sizeof(char), STREAMING_BUFFER_SIZE);
-        
-        if (bytesRead > 0)
-            AL_CHECK(alBufferData(buffer, _streamStateWav->format, buffers, bytesRead, _streamStateWav->frequency));
+        if (streamState->inputSize == streamState->input.size())
+            streamState->input.resize(streamState->input.size() * 2);
+
+        size_t bytesRead = stream->read(&streamState->input[streamState->inputSize], 1, streamState->input.size() - streamState->inputSize);
+        streamState->inputSize += (unsigned int)bytesRead;
 
-        if (bytesRead != STREAMING_BUFFER_SIZE)
+        int error = 0;
+        v = stb_vorbis_open_pushdata(&streamState->input[0], (int)streamState->inputSize, &used, &error, NULL);
+        if (v == NULL && (error != VORBIS_need_more_data || bytesRead == 0))
         {
-            if (looped)
-                _fileStream->seek(_streamStateWav->dataStart, SEEK_SET);
+            GP_ERROR("Failed to open ogg file.");
+            return false;
         }
-        
-        return bytesRead > 0 || looped;
     }
-    else if (_streamStateOgg.get())
-    {
-        stb_vorbis* v = (stb_vorbis*)_streamStateOgg->oggFile;
 
-        static short* decoded[STREAMING_BUFFER_SIZE];
-        int numBytes = STREAMING_BUFFER_SIZE*2;
-        auto outSamples = (unsigned)stb_vorbis_get_samples_short_interleaved(v, v->channels, (short*)decoded, STREAMING_BUFFER_SIZE);
-        unsigned outBytes = (outSamples * v->channels) << 1u;
-        if (outBytes < STREAMING_BUFFER_SIZE && looped)
+    streamState->inputSize -= used;
+    memmove(&streamState->input[0], &streamState->input[used], streamState->inputSize);
+
+    stb_vorbis_info info = stb_vorbis_get_info(v);
+    streamState->format = info.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    streamState->frequency = info.sample_rate;
+    streamState->maxFrameSize = info.max_frame_size * info.channels * sizeof(short);
+    streamState->oggFile = v;
+    return true;
+}
+
+bool AudioBuffer::decodeOggFrame(bool looped)
+{
+    AudioStreamStateOgg* state = _streamStateOgg.get();
+    GP_ASSERT(state);
+
+    while (state->oggFile)
+    {
+        stb_vorbis* v = (stb_vorbis*)state->oggFile;
+        int channels = 0;
+        int samples = 0;
+        float** output = NULL;
+        int used = stb_vorbis_decode_frame_pushdata(v, &state->input[0], (int)state->inputSize, &channels, &output, &samples);
+        if (used > 0)
         {
-            numBytes -= outBytes;
-            stb_vorbis_seek_start(v);
-            outSamples =
-                (unsigned)stb_vorbis_get_samples_short_interleaved(v, v->channels, (short*)(decoded + outBytes), numBytes >> 1u);
+            state->inputSize -= used;
+            memmove(&state->input[0], &state->input[used], state->inputSize);
+        }
 
-            outBytes += (outSamples * v->channels) << 1u;
+        if (samples > 0)
+        {
+            // Interleave the frame as 16-bit PCM straight into the ring buffer.
+            int outChannels = channels > 1 ? 2 : 1;
+            short pcm[512];
+            int pcmCount = 0;
+            for (int i = 0; i < samples; i++)
+            {
+                for (int c = 0; c < outChannels; c++)
+                {
+                    float f = output[c][i] * 32767.0f;
+                    pcm[pcmCount++] = (short)(f > 32767.0f ? 32767.0f : (f < -32768.0f ? -32768.0f : f));
+                }
+                if (pcmCount >= 510 || i == samples - 1)
+                {
+                    _ringBuffer.write((const char*)pcm, pcmCount * sizeof(short));
+                    pcmCount = 0;
+                }
+            }
+            return true;
         }
 
-        AL_CHECK(alBufferData(buffer, _streamStateOgg->format, decoded, outBytes, _streamStateOgg->frequency));
-        return (outBytes > 0) || looped;
+        if (used == 0)
+        {
+            // The decoder needs more data to complete the frame.
+            if (state->inputSize == state->input.size())
+                state->input.resize(state->input.size() * 2);
+
+            size_t bytesRead = _fileStream->read(&state->input[state->inputSize], 1, state->input.size() - state->inputSize);
+            state->inputSize += (unsigned int)bytesRead;
+            if (bytesRead == 0)
+            {
+                if (!looped)
+                    return false;
+
+                // Restart decoding from the beginning of the file.
+                stb_vorbis_close(v);
+                state->oggFile = NULL;
+                _fileStream->rewind();
+                if (!openOgg(_fileStream.get(), state))
+                    return false;
+            }
+        }
     }
-    
     return false;
 }
 
+void AudioBuffer::fillRingBuffer(bool looped)
+{
+    if (_streamStateWav.get())
+    {
+        long dataEnd = _streamStateWav->dataStart + _streamStateWav->dataSize;
+        while (_ringBuffer.space() > 0)
+        {
+            long remaining = dataEnd - _fileStream->position();
+            if (remaining <= 0)
+            {
+                if (!looped)
+                    break;
+                _fileStream->seek(_streamStateWav->dataStart, SEEK_SET);
+                remaining = _streamStateWav->dataSize;
+            }
+
+            unsigned int size = std::min<unsigned int>((unsigned int)_uploadBuffer.size(), std::min<unsigned int>(_ringBuffer.space(), (unsigned int)remaining));
+            size_t bytesRead = _fileStream->read(&_uploadBuffer[0], sizeof(char), size);
+            if (bytesRead == 0)
+                break;
+            _ringBuffer.write(&_uploadBuffer[0], (unsigned int)bytesRead);
+        }
+    }
+    else if (_streamStateOgg.get())
+    {
+        while (_ringBuffer.space() >= _streamStateOgg->maxFrameSize)
+        {
+            if (!decodeOggFrame(looped))
+                break;
+        }
+    }
+}
+
+bool AudioBuffer::streamData(ALuint buffer, bool looped)
+{
+    fillRingBuffer(looped);
+
+    unsigned int size = _ringBuffer.read(&_uploadBuffer[0], _streamingBufferSize);
+    if (size == 0)
+        return false;
+
+    if (_streamStateWav.get())
+        AL_CHECK(alBufferData(buffer, _streamStateWav->format, &_uploadBuffer[0], size, _streamStateWav->frequency));
+    else if (_streamStateOgg.get())
+        AL_CHECK(alBufferData(buffer, _streamStateOgg->format, &_uploadBuffer[0], size, _streamStateOgg->frequency));
+    return true;
+}
+
+void AudioBuffer::PcmRingBuffer::resize(unsigned int capacity)
+{
+    _data.resize(capacity);
+    clear();
+}
+
+unsigned int AudioBuffer::PcmRingBuffer::write(const char* data, unsigned int size)
+{
+    unsigned int capacity = (unsigned int)_data.size();
+    size = std::min(size, capacity - _size);
+    unsigned int writePos = (_readPos + _size) % capacity;
+    unsigned int first = std::min(size, capacity - writePos);
+    memcpy(&_data[writePos], data, first);
+    memcpy(&_data[0], data + first, size - first);
+    _size += size;
+    return size;
+}
+
+unsigned int AudioBuffer::PcmRingBuffer::read(char* data, unsigned int size)
+{
+    unsigned int capacity = (unsigned int)_data.size();
+    size = std::min(size, _size);
+    unsigned int first = std::min(size, capacity - _readPos);
+    memcpy(data, &_data[_readPos], first);
+    memcpy(data + first, &_data[0], size - first);
+    _readPos = (_readPos + size) % capacity;
+    _size -= size;
+    return size;
+}
+
 }
@@ -4,6 +4,8 @@
 #include "base/Ref.h"
 #include "base/Stream.h"
 
+#include <atomic>
+
 namespace gameplay
 {
 
@@ -17,13 +19,14 @@ class AudioSource;
 class AudioBuffer : public Ref
 {
     friend class AudioSource;
+    friend class AudioController;
 
 private:
     
     /**
      * Constructor.
      */
-    AudioBuffer(const char* path, ALuint* buffers, bool streamed);
+    AudioBuffer(const char* path, const std::vector<ALuint>& buffers, bool streamed);
 
     /**
      * Destructor.
@@ -44,6 +47,55 @@ private:
      */
     static AudioBuffer* create(const char* path, bool streamed);
 
+    /**
+     * Uploads the sounds decoded in the background and releases the least recently
+     * used unreferenced buffers while the cache is over its memory budget.
+     *
+     * Called by the audio controller every frame.
+     */
+    static void updateCache();
+
+    /**
+     * Waits for the pending decodes and releases the cache references on all buffers.
+     */
+    static void clearCache();
+
+    /**
+     * Sets the memory budget in bytes of the cached sounds.
+     */
+    static void setCacheBudget(size_t bytes);
+
+    /**
+     * Gets the memory budget in bytes of the cached sounds.
+     */
+    static size_t getCacheBudget();
+
+    /**
+     * Gets the memory in bytes used by the cached sounds.
+     */
+    static size_t getCacheMemory();
+
+    /**
+     * Determines if the sound data has been uploaded and the buffer can be played.
+     */
+    bool isLoaded() const;
+
+    /**
+     * Determines if the sound failed to decode.
+     */
+    bool isLoadFailed() const;
+
+    /**
+     * The load states of a non-streamed buffer.
+     */
+    enum LoadState
+    {
+        LOAD_PENDING,
+        LOAD_DECODED,
+        LOAD_READY,
+        LOAD_FAILED
+    };
+
     struct AudioStreamStateWav
     {
         long dataStart;
@@ -54,29 +106,71 @@ private:
 
     struct AudioStreamStateOgg
     {
-        long dataStart;
-        unsigned int dataSize;
         ALuint format;
         ALuint frequency;
         void *oggFile;
+        // Compressed data read from the stream but not yet consumed by the decoder.
+        std::vector<unsigned char> input;
+        unsigned int inputSize;
+        // Size in bytes of the largest decoded frame.
+        unsigned int maxFrameSize;
     };
 
-    enum { STREAMING_BUFFER_QUEUE_SIZE = 3 };
-    enum { STREAMING_BUFFER_SIZE = 48000 };
+    /**
+     * Ring buffer of decoded PCM data waiting to be queued on the source.
+     */
+    class PcmRingBuffer
+    {
+    public:
+        PcmRingBuffer() : _readPos(0), _size(0) {}
+        void resize(unsigned int capacity);
+        unsigned int write(const char* data, unsigned int size);
+        unsigned int read(char* data, unsigned int size);
+        unsigned int available() const { return _size; }
+        unsigned int space() const { return (unsigned int)_data.size() - _size; }
+        void clear() { _readPos = 0; _size = 0; }
+    private:
+        std::vector<char> _data;
+        unsigned int _readPos;
+        unsigned int _size;
+    };
+
+    static bool load(const char* path, bool streamed, std::unique_ptr<Stream>& stream,
+                     std::unique_ptr<AudioStreamStateWav>& streamStateWav,
+                     std::unique_ptr<AudioStreamStateOgg>& streamStateOgg, std::vector<char>* pcm);
 
-    static bool loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateWav* streamState);
+    static bool loadWav(Stream* stream, bool streamed, AudioStreamStateWav* streamState, std::vector<char>* pcm);
     
-    static bool loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateOgg* streamState);
+    static bool loadOgg(Stream* stream, bool streamed, AudioStreamStateOgg* streamState, std::vector<char>* pcm);
+
+    void decode();
+
+    static bool openOgg(Stream* stream, AudioStreamStateOgg* streamState);
+
+    bool decodeOggFrame(bool looped);
+
+    void fillRingBuffer(bool looped);
 
     bool streamData(ALuint buffer, bool looped);
 
-    ALuint _alBufferQueue[STREAMING_BUFFER_QUEUE_SIZE];
+    std::vector<ALuint> _alBufferQueue;
     std::string _filePath;
     bool _streamed;
     std::unique_ptr<Stream> _fileStream;
     std::unique_ptr<AudioStreamStateWav> _streamStateWav;
     std::unique_ptr<AudioStreamStateOgg> _streamStateOgg;
     int _buffersNeededCount;
+    unsigned int _streamingBufferSize;
+    PcmRingBuffer _ringBuffer;
+    std::vector<char> _uploadBuffer;
+    float _duration;
+    std::atomic<int> _loadState;
+    // Decoded data waiting to be uploaded, written by the decode task.
+    std::vector<char> _pcm;
+    ALuint _pcmFormat;
+    ALuint _pcmFrequency;
+    unsigned int _size;
+    std::list<AudioBuffer*>::iterator _cacheItr;
 };
 
 }
@@ -4,17 +4,45 @@
 #include "scene/AudioListener.h"
 #include "AudioBuffer.h"
 #include "AudioSource.h"
+#include "base/Properties.h"
+#include "platform/Toolkit.h"
 
 #include <algorithm>
 #include <functional>
+#include <cfloat>
 
 namespace gameplay
 {
 
     static AudioController* g_cur;
 
+// Default streaming queue: 3 buffers of 48000 bytes (about 0.27s of 16-bit stereo at 44.1kHz each).
+#define STREAMING_BUFFER_COUNT 3
+#define STREAMING_BUFFER_SIZE 48000
+
+// Default number of sources that are mixed at the same time.
+#define MAX_VOICES 64
+
+// Sources quieter than this (-60dB) never get a real voice.
+#define VOICE_AUDIBILITY_THRESHOLD 0.001f
+
+// Sources that already have a voice keep it unless another source is this much more audible,
+// which avoids swapping voices back and forth between sources of similar audibility.
+#define VOICE_HYSTERESIS 1.25f
+
+#ifdef AL_SOFT_events
+// Called on an OpenAL thread whenever a source finishes playing a queued buffer.
+static void AL_APIENTRY streamingEventCallback(ALenum eventType, ALuint object, ALuint param, ALsizei length, const ALchar* message, void* userParam)
+{
+    if (eventType == AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT && g_cur)
+        g_cur->wakeStreamingThread();
+}
+#endif
+
 AudioController::AudioController() 
-: _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL), _streamingThreadActive(true)
+: _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL), _streamingThreadActive(true), _streamingThreadWake(false),
+  _streamingBufferCount(STREAMING_BUFFER_COUNT), _streamingBufferSize(STREAMING_BUFFER_SIZE),
+  _maxVoices(MAX_VOICES), _voiceCount(0), _realVoiceCount(0), _virtualVoiceCount(0)
 {
     g_cur = this;
 }
@@ -54,6 +82,34 @@ void AudioController::initialize()
         GP_ERROR("Unable to make OpenAL context current. Error: %d\n", alcErr);
     }
     _streamingMutex.reset(new std::mutex());
+
+#ifdef AL_SOFT_events
+    // Wake the streaming thread as soon as a queued buffer has been played instead of polling.
+    if (alIsExtensionPresent("AL_SOFT_events"))
+    {
+        LPALEVENTCONTROLSOFT eventControl = (LPALEVENTCONTROLSOFT)alGetProcAddress("alEventControlSOFT");
+        LPALEVENTCALLBACKSOFT eventCallback = (LPALEVENTCALLBACKSOFT)alGetProcAddress("alEventCallbackSOFT");
+        if (eventControl && eventCallback)
+        {
+            ALenum types[] = { AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT };
+            eventCallback(&streamingEventCallback, this);
+            eventControl(1, types, AL_TRUE);
+        }
+    }
+#endif
+
+    Properties* config = Toolkit::cur()->getConfig()->getNamespace("audio", true);
+    if (config)
+    {
+        if (config->exists("streamingBufferCount"))
+            setStreamingBufferCount(config->getInt("streamingBufferCount"));
+        if (config->exists("streamingBufferSize"))
+            setStreamingBufferSize(config->getInt("streamingBufferSize"));
+        if (config->exists("maxVoices"))
+            setMaxVoices(config->getInt("maxVoices"));
+        if (config->exists("bufferCacheSize"))
+            setBufferCacheSize((size_t)config->getInt("bufferCacheSize") * 1024);
+    }
 }
 
 void AudioController::finalize()
@@ -62,10 +118,20 @@ void AudioController::finalize()
     if (_streamingThread.get())
     {
         _streamingThreadActive = false;
+        wakeStreamingThread();
         _streamingThread->join();
         _streamingThread.reset(NULL);
     }
 
+    AudioBuffer::clearCache();
+
+    for (size_t i = 0; i < _freeVoices.size(); ++i)
+    {
+        AL_CHECK( alDeleteSources(1, &_freeVoices[i]) );
+    }
+    _voiceCount -= (unsigned int)_freeVoices.size();
+    _freeVoices.clear();
+
     alcMakeContextCurrent(NULL);
     if (_alcContext)
     {
@@ -121,6 +187,8 @@ void AudioController::resume()
 
 void AudioController::update(float elapsedTime)
 {
+    AudioBuffer::updateCache();
+
     AudioListener* listener = AudioListener::getInstance();
     if (listener)
     {
@@ -129,6 +197,192 @@ void AudioController::update(float elapsedTime)
         AL_CHECK( alListenerfv(AL_VELOCITY, (ALfloat*)&listener->getVelocity()) );
         AL_CHECK( alListenerfv(AL_POSITION, (ALfloat*)&listener->getPosition()) );
     }
+
+    updateVoices(elapsedTime);
+}
+
+void AudioController::updateVoices(float elapsedTime)
+{
+    AudioListener* listener = AudioListener::getInstance();
+    Vector3 listenerPosition = listener ? listener->getPosition() : Vector3::zero();
+    float seconds = elapsedTime * 0.001f;
+
+    unsigned int loadingCount = 0;
+    _voiceRanking.clear();
+    std::set<AudioSource*>::iterator itr = _playingSources.begin();
+    while (itr != _playingSources.end())
+    {
+        AudioSource* source = *itr;
+        itr++;
+
+        if (source->_virtual && !source->_buffer->isLoaded())
+        {
+            // Sounds that are still decoding wait at their start; the ones that failed are stopped.
+            if (source->_buffer->isLoadFailed())
+            {
+                source->_virtual = false;
+                source->_state = AudioSource::STOPPED;
+                removePlayingSource(source);
+                continue;
+            }
+            loadingCount++;
+            continue;
+        }
+
+        if (source->_virtual)
+        {
+            // Advance the virtual playback position and finish sounds that have played to the end.
+            source->_playbackTime += seconds * source->_pitch;
+            float duration = source->_buffer->_duration;
+            if (!source->_looped && duration > 0.0f && source->_playbackTime >= duration)
+            {
+                source->_virtual = false;
+                source->_state = AudioSource::STOPPED;
+                source->_playbackTime = 0.0f;
+                removePlayingSource(source);
+                continue;
+            }
+        }
+        else if (source->_alSource && !source->isStreamed() && source->getState() == AudioSource::STOPPED)
+        {
+            // Give the voice of a finished sound back to the pool.
+            source->_state = AudioSource::STOPPED;
+            releaseVoice(source->unbindVoice());
+            source->_playbackTime = 0.0f;
+            removePlayingSource(source);
+            continue;
+        }
+
+        // Streamed sources own their buffer queue and always keep their voice.
+        float score = source->isStreamed() ? FLT_MAX : source->getAudibility(listenerPosition);
+        if (source->_alSource && score < FLT_MAX)
+            score *= VOICE_HYSTERESIS;
+        _voiceRanking.push_back(std::make_pair(score, source));
+    }
+
+    std::sort(_voiceRanking.begin(), _voiceRanking.end(),
+        [](const std::pair<float, AudioSource*>& a, const std::pair<float, AudioSource*>& b) { return a.first > b.first; });
+
+    // Take the voices away from the sources that lost them first, so that they can be handed
+    // to the sources that ranked higher.
+    for (size_t i = 0; i < _voiceRanking.size(); ++i)
+    {
+        AudioSource* source = _voiceRanking[i].second;
+        bool audible = i < _maxVoices && _voiceRanking[i].first >= VOICE_AUDIBILITY_THRESHOLD;
+        if (!audible && source->_alSource && !source->isStreamed())
+        {
+            releaseVoice(source->unbindVoice());
+            source->_virtual = true;
+        }
+    }
+
+    _realVoiceCount = 0;
+    _virtualVoiceCount = 0;
+    for (size_t i = 0; i < _voiceRanking.size(); ++i)
+    {
+        AudioSource* source = _voiceRanking[i].second;
+        bool audible = i < _maxVoices && _voiceRanking[i].first >= VOICE_AUDIBILITY_THRESHOLD;
+        if (audible && source->_virtual)
+        {
+            ALuint voice = acquireVoice();
+            if (voice)
+                source->bindVoice(voice);
+        }
+
+        if (source->_virtual)
+            _virtualVoiceCount++;
+        else
+            _realVoiceCount++;
+    }
+    _virtualVoiceCount += loadingCount;
+}
+
+ALuint AudioController::acquireVoice()
+{
+    if (!_freeVoices.empty())
+    {
+        ALuint voice = _freeVoices.back();
+        _freeVoices.pop_back();
+        return voice;
+    }
+
+    if (_voiceCount >= _maxVoices)
+        return 0;
+
+    ALuint voice = 0;
+    AL_CHECK( alGenSources(1, &voice) );
+    if (AL_LAST_ERROR())
+    {
+        // The device ran out of sources before the budget did.
+        return 0;
+    }
+    _voiceCount++;
+    return voice;
+}
+
+void AudioController::releaseVoice(ALuint voice)
+{
+    if (!voice)
+        return;
+
+    if (_voiceCount > _maxVoices)
+    {
+        // The budget was lowered while the voice was in use.
+        AL_CHECK( alDeleteSources(1, &voice) );
+        _voiceCount--;
+        return;
+    }
+    _freeVoices.push_back(voice);
+}
+
+void AudioController::setMaxVoices(unsigned int count)
+{
+    _maxVoices = std::max(count, 1u);
+    while (_voiceCount > _maxVoices && !_freeVoices.empty())
+    {
+        AL_CHECK( alDeleteSources(1, &_freeVoices.back()) );
+        _freeVoices.pop_back();
+        _voiceCount--;
+    }
+}
+
+unsigned int AudioController::getMaxVoices() const
+{
+    return _maxVoices;
+}
+
+unsigned int AudioController::getRealVoiceCount() const
+{
+    return _realVoiceCount;
+}
+
+unsigned int AudioController::getVirtualVoiceCount() const
+{
+    return _virtualVoiceCount;
+}
+
+void AudioController::preload(const char* path)
+{
+    GP_ASSERT(path);
+
+    // The cache keeps its own reference until the sound is evicted.
+    AudioBuffer* buffer = AudioBuffer::create(path, false);
+    SAFE_RELEASE(buffer);
+}
+
+void AudioController::setBufferCacheSize(size_t size)
+{
+    AudioBuffer::setCacheBudget(size);
+}
+
+size_t AudioController::getBufferCacheSize() const
+{
+    return AudioBuffer::getCacheBudget();
+}
+
+size_t AudioController::getBufferCacheMemory() const
+{
+    return AudioBuffer::getCacheMemory();
 }
 
 void AudioController::addPlayingSource(AudioSource* source)
@@ -147,6 +401,8 @@ void AudioController::addPlayingSource(AudioSource* source)
 
             if (startThread)
                 _streamingThread.reset(new std::thread(&streamingThreadProc, this));
+            else
+                wakeStreamingThread();
         }
     }
 }
@@ -171,19 +427,60 @@ void AudioController::removePlayingSource(AudioSource* source)
     } 
 }
 
+void AudioController::setStreamingBufferCount(unsigned int count)
+{
+    _streamingBufferCount = std::max(count, 2u);
+}
+
+unsigned int AudioController::getStreamingBufferCount() const
+{
+    return _streamingBufferCount;
+}
+
+void AudioController::setStreamingBufferSize(unsigned int size)
+{
+    // Keep whole 16-bit stereo frames in each buffer.
+    _streamingBufferSize = std::max(size & ~3u, 4096u);
+}
+
+unsigned int AudioController::getStreamingBufferSize() const
+{
+    return _streamingBufferSize;
+}
+
+void AudioController::wakeStreamingThread()
+{
+    _streamingThreadWake = true;
+    _streamingCondition.notify_one();
+}
+
 void AudioController::streamingThreadProc(void* arg)
 {
     AudioController* controller = (AudioController*)arg;
+    std::vector<AudioSource*> sources;
 
     while (controller->_streamingThreadActive)
     {
-        controller->_streamingMutex->lock();
+        {
+            // Sleep until a buffer has been played or a source started streaming. Without buffer
+            // events, wake up after half a buffer of 16-bit stereo 44.1kHz audio has been played.
+            std::unique_lock<std::mutex> lock(*controller->_streamingMutex);
+            std::chrono::milliseconds timeout(std::max(10u, controller->_streamingBufferSize * 500u / (44100u * 4u)));
+            controller->_streamingCondition.wait_for(lock, timeout, [controller]() {
+                return controller->_streamingThreadWake || !controller->_streamingThreadActive;
+            });
+            controller->_streamingThreadWake = false;
+            sources.assign(controller->_streamingSources.begin(), controller->_streamingSources.end());
+        }
 
-        std::for_each(controller->_streamingSources.begin(), controller->_streamingSources.end(), std::mem_fn(&AudioSource::streamDataIfNeeded));
-        
-        controller->_streamingMutex->unlock();
-   
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            // Only hold the lock while a single source streams so that starting and stopping
+            // sources does not wait for every streaming source to be serviced.
+            std::lock_guard<std::mutex> lock(*controller->_streamingMutex);
+            if (controller->_streamingSources.find(sources[i]) != controller->_streamingSources.end())
+                sources[i]->streamDataIfNeeded();
+        }
     }
 }
 
@@ -5,6 +5,8 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace gameplay
 {
@@ -29,6 +31,114 @@ public:
 
     static AudioController* cur();
 
+    /**
+     * Sets the number of buffers queued on each streamed audio source.
+     *
+     * Only affects streamed sources created afterwards. The default can be set with
+     * the streamingBufferCount property of the audio namespace in game.config.
+     *
+     * @param count The number of queued buffers (at least 2).
+     */
+    void setStreamingBufferCount(unsigned int count);
+
+    /**
+     * Returns the number of buffers queued on each streamed audio source.
+     *
+     * @return The number of queued buffers.
+     */
+    unsigned int getStreamingBufferCount() const;
+
+    /**
+     * Sets the size in bytes of each buffer queued on a streamed audio source.
+     *
+     * Only affects streamed sources created afterwards. The default can be set with
+     * the streamingBufferSize property of the audio namespace in game.config.
+     *
+     * @param size The buffer size in bytes.
+     */
+    void setStreamingBufferSize(unsigned int size);
+
+    /**
+     * Returns the size in bytes of each buffer queued on a streamed audio source.
+     *
+     * @return The buffer size in bytes.
+     */
+    unsigned int getStreamingBufferSize() const;
+
+    /**
+     * Wakes the streaming thread so that streamed sources refill their buffer queues.
+     */
+    void wakeStreamingThread();
+
+    /**
+     * Sets the maximum number of sources that play on a real OpenAL voice at the same time.
+     *
+     * Playing sources beyond this budget, and sources that are too quiet to be heard, play
+     * virtually: their playback position is tracked but they are not mixed. The default can
+     * be set with the maxVoices property of the audio namespace in game.config.
+     *
+     * @param count The maximum number of real voices.
+     */
+    void setMaxVoices(unsigned int count);
+
+    /**
+     * Returns the maximum number of sources that play on a real OpenAL voice at the same time.
+     *
+     * @return The maximum number of real voices.
+     */
+    unsigned int getMaxVoices() const;
+
+    /**
+     * Returns the number of playing sources that had a real voice during the last update.
+     *
+     * @return The number of real voices.
+     */
+    unsigned int getRealVoiceCount() const;
+
+    /**
+     * Returns the number of playing sources that played virtually during the last update.
+     *
+     * @return The number of virtual voices.
+     */
+    unsigned int getVirtualVoiceCount() const;
+
+    /**
+     * Starts decoding a sound in the background so that the sources created from it
+     * later on can play right away.
+     *
+     * Non-streamed sounds are shared through a cache by path and decoded on the default
+     * thread pool. A source playing a sound that is not decoded yet plays virtually until
+     * the sound is uploaded, at the end of a later update.
+     *
+     * @param path The path to the sound file.
+     */
+    void preload(const char* path);
+
+    /**
+     * Sets the memory budget in bytes of the cache of decoded sounds.
+     *
+     * When over budget, the least recently used sounds that no source references are
+     * released. The default is 64MB and can be set in kilobytes with the bufferCacheSize
+     * property of the audio namespace in game.config.
+     *
+     * @param size The memory budget in bytes.
+     */
+    void setBufferCacheSize(size_t size);
+
+    /**
+     * Returns the memory budget in bytes of the cache of decoded sounds.
+     *
+     * @return The memory budget in bytes.
+     */
+    size_t getBufferCacheSize() const;
+
+    /**
+     * Returns the memory in bytes used by the decoded sounds in the cache.
+     *
+     * @return The memory used in bytes.
+     */
+    size_t getBufferCacheMemory() const;
+
 private:
     
     /**
@@ -65,6 +175,21 @@ private:
     
     void removePlayingSource(AudioSource* source);
 
+    /**
+     * Returns a free OpenAL source, or 0 if the voice budget is used up.
+     */
+    ALuint acquireVoice();
+
+    /**
+     * Returns an OpenAL source to the pool of free voices.
+     */
+    void releaseVoice(ALuint voice);
+
+    /**
+     * Advances virtual sources and gives the most audible playing sources the real voices.
+     */
+    void updateVoices(float elapsedTime);
+
     static void streamingThreadProc(void* arg);
 
     ALCdevice* _alcDevice;
@@ -73,9 +198,19 @@ private:
     std::set<AudioSource*> _streamingSources;
     AudioSource* _pausingSource;
 
-    bool _streamingThreadActive;
+    std::atomic<bool> _streamingThreadActive;
+    std::atomic<bool> _streamingThreadWake;
     std::unique_ptr<std::thread> _streamingThread;
     std::unique_ptr<std::mutex> _streamingMutex;
+    std::condition_variable _streamingCondition;
+    unsigned int _streamingBufferCount;
+    unsigned int _streamingBufferSize;
+    unsigned int _maxVoices;
+    unsigned int _voiceCount;
+    std::vector<ALuint> _freeVoices;
+    std::vector<std::pair<float, AudioSource*> > _voiceRanking;
+    unsigned int _realVoiceCount;
+    unsigned int _virtualVoiceCount;
 };
 
 }
@@ -9,39 +9,26 @@
 namespace gameplay
 {
 
-AudioSource::AudioSource(AudioBuffer* buffer, ALuint source) 
-    : _alSource(source), _buffer(buffer), _looped(false), _gain(1.0f), _pitch(1.0f), _node(NULL)
+AudioSource::AudioSource(AudioBuffer* buffer) 
+    : _alSource(0), _buffer(buffer), _looped(false), _gain(1.0f), _pitch(1.0f), _priority(1.0f), _node(NULL),
+      _state(INITIAL), _virtual(false), _playbackTime(0.0f)
 {
     GP_ASSERT(buffer);
-
-    if (isStreamed())
-        AL_CHECK(alSourceQueueBuffers(_alSource, 1, &buffer->_alBufferQueue[0]));
-    else
-        AL_CHECK(alSourcei(_alSource, AL_BUFFER, buffer->_alBufferQueue[0]));
-    
-    AL_CHECK(alSourcei(_alSource, AL_LOOPING, _looped && !isStreamed()));
-    
-    AL_CHECK( alSourcef(_alSource, AL_PITCH, _pitch) );
-    AL_CHECK( alSourcef(_alSource, AL_GAIN, _gain) );
-    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (const ALfloat*)&_velocity) );
 }
 
 AudioSource::~AudioSource()
 {
+    // Remove the source from the controller's set of currently playing sources
+    // regardless of the source's state. E.g. when the AudioController::pause is called
+    // all sources are paused but still remain in controller's set of currently 
+    // playing sources. When the source is deleted afterwards, it should be removed
+    // from controller's set regardless of its playing state.
+    AudioController* audioController = AudioController::cur();
+    GP_ASSERT(audioController);
+    audioController->removePlayingSource(this);
+
     if (_alSource)
-    {
-        // Remove the source from the controller's set of currently playing sources
-        // regardless of the source's state. E.g. when the AudioController::pause is called
-        // all sources are paused but still remain in controller's set of currently 
-        // playing sources. When the source is deleted afterwards, it should be removed
-        // from controller's set regardless of its playing state.
-        AudioController* audioController = AudioController::cur();
-        GP_ASSERT(audioController);
-        audioController->removePlayingSource(this);
-
-        AL_CHECK(alDeleteSources(1, &_alSource));
-        _alSource = 0;
-    }
+        audioController->releaseVoice(unbindVoice());
     SAFE_RELEASE(_buffer);
 }
 
@@ -68,18 +55,8 @@ AudioSource* AudioSource::create(const char* url, bool streamed)
     if (buffer == NULL)
         return NULL;
 
-    // Load the audio source.
-    ALuint alSource = 0;
-
-    AL_CHECK( alGenSources(1, &alSource) );
-    if (AL_LAST_ERROR())
-    {
-        SAFE_RELEASE(buffer);
-        GP_ERROR("Error generating audio source.");
-        return NULL;
-    }
-    
-    return new AudioSource(buffer, alSource);
+    // The OpenAL source (voice) is assigned by the AudioController when the source plays.
+    return new AudioSource(buffer);
 }
 
 AudioSource* AudioSource::create(Properties* properties)
@@ -126,6 +103,10 @@ AudioSource* AudioSource::create(Properties* properties)
     {
         audio->setPitch(properties->getFloat("pitch"));
     }
+    if (properties->exists("priority"))
+    {
+        audio->setPriority(properties->getFloat("priority"));
+    }
     Vector3 v;
     if (properties->getVector3("velocity", &v))
     {
@@ -137,6 +118,12 @@ AudioSource* AudioSource::create(Properties* properties)
 
 AudioSource::State AudioSource::getState() const
 {
+    // Virtual and voiceless sources keep track of their own state.
+    if (_virtual)
+        return PLAYING;
+    if (!_alSource)
+        return _state;
+
     ALint state;
     AL_CHECK( alGetSourcei(_alSource, AL_SOURCE_STATE, &state) );
 
@@ -162,17 +149,44 @@ bool AudioSource::isStreamed() const
 
 void AudioSource::play()
 {
-    AL_CHECK( alSourcePlay(_alSource) );
-
-    // Add the source to the controller's list of currently playing sources.
     AudioController* audioController = AudioController::cur();
     GP_ASSERT(audioController);
+
+    if (_state != PAUSED)
+        _playbackTime = 0.0f;
+    _state = PLAYING;
+
+    if (_alSource)
+    {
+        AL_CHECK( alSourcePlay(_alSource) );
+    }
+    else if (!_virtual && !_buffer->isLoaded())
+    {
+        // The sound is still decoding in the background; it starts once uploaded.
+        _virtual = true;
+    }
+    else if (!_virtual)
+    {
+        // Start on a real voice if one is available, otherwise play virtually until one frees up.
+        ALuint voice = audioController->acquireVoice();
+        if (voice)
+            bindVoice(voice);
+        else
+            _virtual = true;
+    }
+
+    // Add the source to the controller's list of currently playing sources.
     audioController->addPlayingSource(this);
 }
 
 void AudioSource::pause()
 {
-    AL_CHECK( alSourcePause(_alSource) );
+    if (_alSource)
+    {
+        AL_CHECK( alSourcePause(_alSource) );
+    }
+    _virtual = false;
+    _state = PAUSED;
 
     // Remove the source from the controller's set of currently playing sources
     // if the source is being paused by the user and not the controller itself.
@@ -191,17 +205,31 @@ void AudioSource::resume()
 
 void AudioSource::stop()
 {
-    AL_CHECK( alSourceStop(_alSource) );
-
     // Remove the source from the controller's set of currently playing sources.
     AudioController* audioController = AudioController::cur();
     GP_ASSERT(audioController);
     audioController->removePlayingSource(this);
+
+    _virtual = false;
+    _state = STOPPED;
+    _playbackTime = 0.0f;
+
+    // Non-streamed sources give their voice back; streamed sources keep theirs since
+    // their buffer queue lives on it.
+    if (_alSource)
+    {
+        if (isStreamed())
+            AL_CHECK( alSourceStop(_alSource) );
+        else
+            audioController->releaseVoice(unbindVoice());
+    }
 }
 
 void AudioSource::rewind()
 {
-    AL_CHECK( alSourceRewind(_alSource) );
+    _playbackTime = 0.0f;
+    if (_alSource)
+        AL_CHECK( alSourceRewind(_alSource) );
 }
 
 bool AudioSource::isLooped() const
@@ -211,11 +239,14 @@ bool AudioSource::isLooped() const
 
 void AudioSource::setLooped(bool looped)
 {
-    int v = (looped && !isStreamed()) ? AL_TRUE : AL_FALSE;
-    AL_CHECK(alSourcei(_alSource, AL_LOOPING, v));
-    if (AL_LAST_ERROR())
+    if (_alSource)
     {
-        GP_ERROR("Failed to set audio source's looped attribute with error: %d", AL_LAST_ERROR());
+        int v = (looped && !isStreamed()) ? AL_TRUE : AL_FALSE;
+        AL_CHECK(alSourcei(_alSource, AL_LOOPING, v));
+        if (AL_LAST_ERROR())
+        {
+            GP_ERROR("Failed to set audio source's looped attribute with error: %d", AL_LAST_ERROR());
+        }
     }
     _looped = looped;
 }
@@ -227,7 +258,8 @@ float AudioSource::getGain() const
 
 void AudioSource::setGain(float gain)
 {
-    AL_CHECK( alSourcef(_alSource, AL_GAIN, gain) );
+    if (_alSource)
+        AL_CHECK( alSourcef(_alSource, AL_GAIN, gain) );
     _gain = gain;
 }
 
@@ -238,10 +270,26 @@ float AudioSource::getPitch() const
 
 void AudioSource::setPitch(float pitch)
 {
-    AL_CHECK( alSourcef(_alSource, AL_PITCH, pitch) );
+    if (_alSource)
+        AL_CHECK( alSourcef(_alSource, AL_PITCH, pitch) );
     _pitch = pitch;
 }
 
+float AudioSource::getPriority() const
+{
+    return _priority;
+}
+
+void AudioSource::setPriority(float priority)
+{
+    _priority = priority;
+}
+
+bool AudioSource::isVirtual() const
+{
+    return _virtual;
+}
+
 const Vector3& AudioSource::getVelocity() const
 {
     return _velocity;
@@ -249,7 +297,8 @@ const Vector3& AudioSource::getVelocity() const
 
 void AudioSource::setVelocity(const Vector3& velocity)
 {
-    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (ALfloat*)&velocity) );
+    if (_alSource)
+        AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (ALfloat*)&velocity) );
     _velocity = velocity;
 }
 
@@ -289,8 +338,9 @@ void AudioSource::transformChanged(Transform* transform, long cookie)
 {
     if (_node)
     {
-        Vector3 translation = _node->getTranslationWorld();
-        AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&translation.x) );
+        _position = _node->getTranslationWorld();
+        if (_alSource)
+            AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&_position.x) );
     }
 }
 
@@ -298,19 +348,28 @@ AudioSource* AudioSource::clone(NodeCloneContext& context)
 {
     GP_ASSERT(_buffer);
 
-    ALuint alSource = 0;
-    AL_CHECK( alGenSources(1, &alSource) );
-    if (AL_LAST_ERROR())
+    // Streamed buffers hold per-source decoding state, so a clone streams its own copy.
+    AudioBuffer* buffer = _buffer;
+    if (isStreamed())
     {
-        GP_ERROR("Unable to cloning audio.");
-        return NULL;
+        buffer = AudioBuffer::create(_buffer->_filePath.c_str(), true);
+        if (buffer == NULL)
+        {
+            GP_ERROR("Unable to cloning audio.");
+            return NULL;
+        }
+    }
+    else
+    {
+        buffer->addRef();
     }
-    AudioSource* audioClone = new AudioSource(_buffer, alSource);
 
-    _buffer->addRef();
+    AudioSource* audioClone = new AudioSource(buffer);
+
     audioClone->setLooped(isLooped());
     audioClone->setGain(getGain());
     audioClone->setPitch(getPitch());
+    audioClone->setPriority(getPriority());
     audioClone->setVelocity(getVelocity());
     if (Node* node = getNode())
     {
@@ -326,13 +385,13 @@ AudioSource* AudioSource::clone(NodeCloneContext& context)
 bool AudioSource::streamDataIfNeeded()
 {
     GP_ASSERT( isStreamed() );
-    if( getState() != PLAYING )
+    if( !_alSource || getState() != PLAYING )
         return false;
 
     int queuedBuffers;
     alGetSourcei(_alSource, AL_BUFFERS_QUEUED, &queuedBuffers);
  
-    int buffersNeeded = std::min<int>(_buffer->_buffersNeededCount, AudioBuffer::STREAMING_BUFFER_QUEUE_SIZE);
+    int buffersNeeded = std::min<int>(_buffer->_buffersNeededCount, (int)_buffer->_alBufferQueue.size());
     if (queuedBuffers < buffersNeeded)
     {
         while (queuedBuffers < buffersNeeded)
@@ -362,4 +421,76 @@ bool AudioSource::streamDataIfNeeded()
     return true;
 }
 
+void AudioSource::bindVoice(ALuint voice)
+{
+    GP_ASSERT(voice);
+    GP_ASSERT(!_alSource);
+
+    // The streaming thread queues buffers on the voice of streamed sources.
+    std::unique_lock<std::mutex> lock;
+    if (isStreamed())
+        lock = std::unique_lock<std::mutex>(*AudioController::cur()->_streamingMutex);
+
+    _alSource = voice;
+    _virtual = false;
+
+    if (isStreamed())
+        AL_CHECK(alSourceQueueBuffers(_alSource, 1, &_buffer->_alBufferQueue[0]));
+    else
+        AL_CHECK(alSourcei(_alSource, AL_BUFFER, _buffer->_alBufferQueue[0]));
+
+    AL_CHECK( alSourcei(_alSource, AL_LOOPING, _looped && !isStreamed()) );
+    AL_CHECK( alSourcef(_alSource, AL_PITCH, _pitch) );
+    AL_CHECK( alSourcef(_alSource, AL_GAIN, _gain) );
+    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (const ALfloat*)&_velocity) );
+    AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&_position) );
+
+    if (_state == PLAYING)
+    {
+        // Pick up where the source was while it played virtually.
+        float duration = _buffer->_duration;
+        if (!isStreamed() && duration > 0.0f && _playbackTime > 0.0f)
+            AL_CHECK( alSourcef(_alSource, AL_SEC_OFFSET, _looped ? fmodf(_playbackTime, duration) : _playbackTime) );
+        AL_CHECK( alSourcePlay(_alSource) );
+    }
+}
+
+ALuint AudioSource::unbindVoice()
+{
+    GP_ASSERT(_alSource);
+
+    std::unique_lock<std::mutex> lock;
+    if (isStreamed())
+        lock = std::unique_lock<std::mutex>(*AudioController::cur()->_streamingMutex);
+
+    // Remember the playback position so the source can become real again at the same point.
+    ALfloat offset = 0.0f;
+    AL_CHECK( alGetSourcef(_alSource, AL_SEC_OFFSET, &offset) );
+    _playbackTime = offset;
+
+    AL_CHECK( alSourceStop(_alSource) );
+    if (isStreamed())
+    {
+        ALint queued = 0;
+        AL_CHECK( alGetSourcei(_alSource, AL_BUFFERS_QUEUED, &queued) );
+        while (queued-- > 0)
+        {
+            ALuint bufferID;
+            AL_CHECK( alSourceUnqueueBuffers(_alSource, 1, &bufferID) );
+        }
+    }
+    AL_CHECK( alSourcei(_alSource, AL_BUFFER, 0) );
+
+    ALuint voice = _alSource;
+    _alSource = 0;
+    return voice;
+}
+
+float AudioSource::getAudibility(const Vector3& listenerPosition) const
+{
+    // Inverse distance clamped attenuation with OpenAL's default reference distance and rolloff.
+    float distance = std::max(_position.distance(listenerPosition), 1.0f);
+    return _priority * _gain / distance;
+}
+
 }
@@ -141,6 +141,31 @@ public:
      */
     void setPitch(float pitch);
 
+    /**
+     * Returns the priority of the audio source.
+     *
+     * @return The priority.
+     */
+    float getPriority() const;
+
+    /**
+     * Sets the priority of the audio source.
+     *
+     * The AudioController only gives a limited number of playing sources a real voice. Sources are
+     * ranked by their priority multiplied by their gain and distance attenuation; the others keep
+     * playing virtually (without being mixed) until they rank high enough again. The default is 1.
+     *
+     * @param priority The priority of the source.
+     */
+    void setPriority(float priority);
+
+    /**
+     * Determines whether the audio source is playing without a real voice.
+     *
+     * @return true if the source is playing virtually, false otherwise.
+     */
+    bool isVirtual() const;
+
     /**
      * Gets the velocity of the audio source.
      *
@@ -176,7 +201,7 @@ private:
     /**
      * Constructor that takes an AudioBuffer.
      */
-    AudioSource(AudioBuffer* buffer, ALuint source);
+    AudioSource(AudioBuffer* buffer);
 
     /**
      * Destructor.
@@ -208,13 +233,33 @@ private:
 
     bool streamDataIfNeeded();
 
+    /**
+     * Attaches an OpenAL source to this audio source and starts it at the current playback position.
+     */
+    void bindVoice(ALuint voice);
+
+    /**
+     * Detaches the OpenAL source, keeping track of the playback position, and returns it.
+     */
+    ALuint unbindVoice();
+
+    /**
+     * Returns how audible this source is from the given listener position.
+     */
+    float getAudibility(const Vector3& listenerPosition) const;
+
     ALuint _alSource;
     AudioBuffer* _buffer;
     bool _looped;
     float _gain;
     float _pitch;
+    float _priority;
     Vector3 _velocity;
+    Vector3 _position;
     Node* _node;
+    State _state;
+    bool _virtual;
+    float _playbackTime;
 };
 
 }
@@ -10,9 +10,11 @@
 #define AL_LIBTYPE_STATIC
 #include <AL/al.h>
 #include <AL/alc.h>
+#include <AL/alext.h>
 #elif __linux__
 #include <AL/al.h>
 #include <AL/alc.h>
+#include <AL/alext.h>
 #elif __APPLE__
 #include <OpenAL/al.h>
 #include <OpenAL/alc.h>
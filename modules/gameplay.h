@@ -35,6 +35,7 @@
 #include "ui/Control.h"
 #include "ui/ControlFactory.h"
 #include "ui/Container.h"
+#include "ui/ListView.h"
 #include "ui/Form.h"
 #include "ui/Label.h"
 #include "ui/Button.h"
@@ -11,7 +11,7 @@ namespace gameplay
 {
 
 PhysicsCollisionShape::PhysicsCollisionShape(Type type, btCollisionShape* shape, btStridingMeshInterface* meshInterface)
-    : _type(type), _shape(shape), _meshInterface(meshInterface)
+    : _type(type), _shape(shape), _meshInterface(meshInterface), _cacheKey(0)
 {
     memset(&_shapeData, 0, sizeof(_shapeData));
 }
@@ -31,7 +31,6 @@ PhysicsCollisionShape::~PhysicsCollisionShape()
                 {
                     SAFE_DELETE_ARRAY(_shapeData.meshData->indexData[i]);
                 }
-                SAFE_DELETE(_shapeData.meshData);
             }
 
             // Also need to delete the btTriangleIndexVertexArray, if it exists.
@@ -49,6 +48,15 @@ PhysicsCollisionShape::~PhysicsCollisionShape()
 
         // Free the bullet shape.
         SAFE_DELETE(_shape);
+
+        // A baked BVH lives in a buffer that is not owned by the bullet shape, so it
+        // can only be released once the shape referencing it is gone.
+        if (_type == SHAPE_MESH && _shapeData.meshData)
+        {
+            if (_shapeData.meshData->bvhData)
+                btAlignedFree(_shapeData.meshData->bvhData);
+            SAFE_DELETE(_shapeData.meshData);
+        }
     }
 }
 
@@ -242,6 +242,12 @@ private:
     {
         float* vertexData;
         std::vector<unsigned char*> indexData;
+        // Hash of the scaled geometry and its size, compared before reusing the shape from the cache.
+        unsigned long long hash;
+        unsigned int vertexCount;
+        unsigned int indexCount;
+        // Buffer holding a baked BVH deserialized in place (NULL if the BVH was built at load time).
+        void* bvhData;
     };
 
     struct HeightfieldData
@@ -277,6 +283,9 @@ private:
     // Bullet mesh interface for mesh types (NULL otherwise)
     btStridingMeshInterface* _meshInterface;
 
+    // Key of this shape in the PhysicsController shape cache
+    size_t _cacheKey;
+
     // Shape specific cached data
     union
     {
@@ -6,6 +6,7 @@
 #include "scene/MeshPart.h"
 #include "objects/Terrain.h"
 #include "material/MaterialParameter.h"
+#include "base/FileSystem.h"
 
 #ifdef GP_USE_MEM_LEAK_DETECTION
 #undef new
@@ -19,11 +20,40 @@
 // The initial capacity of the Bullet debug drawer's vertex batch.
 #define INITIAL_CAPACITY 280
 
+// Baked collision shape sidecar file header.
+#define BAKED_SHAPE_MAGIC 0x53435047 // 'GPCS'
+#define BAKED_SHAPE_VERSION 2
+#define BAKED_SHAPE_BVH 1
+#define BAKED_SHAPE_HULL 2
+
 namespace gameplay
 {
 
     static PhysicsController* g_cur;
 
+// FNV-1a hash used for shape cache keys and baked shape file names.
+static unsigned long long hashBytes(const void* data, size_t size, unsigned long long hash = 14695981039346656037ULL)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+struct BakedShapeHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int kind;
+    unsigned int size;
+    unsigned long long hash;
+    unsigned int vertexCount;
+    unsigned int indexCount;
+};
+
 const int PhysicsController::DIRTY         = 0x01;
 const int PhysicsController::COLLISION     = 0x02;
 const int PhysicsController::REGISTERED    = 0x04;
@@ -927,11 +957,14 @@ PhysicsCollisionShape* PhysicsController::createBox(const Vector3& extents, cons
     btVector3 halfExtents(scale.x * 0.5 * extents.x, scale.y * 0.5 * extents.y, scale.z * 0.5 * extents.z);
 
     PhysicsCollisionShape* shape;
+    PhysicsCollisionShape::Type type = PhysicsCollisionShape::SHAPE_BOX;
+    size_t key = (size_t)hashBytes(halfExtents.m_floats, sizeof(btScalar) * 3, hashBytes(&type, sizeof(type)));
 
     // Return the box shape from the cache if it already exists.
-    for (unsigned int i = 0; i < _shapes.size(); ++i)
+    auto range = _shapes.equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr)
     {
-        shape = _shapes[i];
+        shape = itr->second;
         GP_ASSERT(shape);
         if (shape->getType() == PhysicsCollisionShape::SHAPE_BOX)
         {
@@ -946,7 +979,7 @@ PhysicsCollisionShape* PhysicsController::createBox(const Vector3& extents, cons
 
     // Create the box shape and add it to the cache.
     shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_BOX, bullet_new<btBoxShape>(halfExtents));
-    _shapes.push_back(shape);
+    addShape(key, shape);
 
     return shape;
 }
@@ -964,11 +997,14 @@ PhysicsCollisionShape* PhysicsController::createSphere(float radius, const Vecto
     float scaledRadius = radius * uniformScale;
 
     PhysicsCollisionShape* shape;
+    PhysicsCollisionShape::Type type = PhysicsCollisionShape::SHAPE_SPHERE;
+    size_t key = (size_t)hashBytes(&scaledRadius, sizeof(float), hashBytes(&type, sizeof(type)));
 
     // Return the sphere shape from the cache if it already exists.
-    for (unsigned int i = 0; i < _shapes.size(); ++i)
+    auto range = _shapes.equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr)
     {
-        shape = _shapes[i];
+        shape = itr->second;
         GP_ASSERT(shape);
         if (shape->getType() == PhysicsCollisionShape::SHAPE_SPHERE)
         {
@@ -983,7 +1019,7 @@ PhysicsCollisionShape* PhysicsController::createSphere(float radius, const Vecto
 
     // Create the sphere shape and add it to the cache.
     shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_SPHERE, bullet_new<btSphereShape>(scaledRadius));
-    _shapes.push_back(shape);
+    addShape(key, shape);
 
     return shape;
 }
@@ -997,11 +1033,15 @@ PhysicsCollisionShape* PhysicsController::createCapsule(float radius, float heig
     float scaledHeight = height * scale.y - radius * 2;
 
     PhysicsCollisionShape* shape;
+    PhysicsCollisionShape::Type type = PhysicsCollisionShape::SHAPE_CAPSULE;
+    float dimensions[2] = { scaledRadius, scaledHeight };
+    size_t key = (size_t)hashBytes(dimensions, sizeof(dimensions), hashBytes(&type, sizeof(type)));
 
     // Return the capsule shape from the cache if it already exists.
-    for (unsigned int i = 0; i < _shapes.size(); i++)
+    auto range = _shapes.equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr)
     {
-        shape = _shapes[i];
+        shape = itr->second;
         GP_ASSERT(shape);
         if (shape->getType() == PhysicsCollisionShape::SHAPE_CAPSULE)
         {
@@ -1016,7 +1056,7 @@ PhysicsCollisionShape* PhysicsController::createCapsule(float radius, float heig
 
     // Create the capsule shape and add it to the cache.
     shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_CAPSULE, bullet_new<btCapsuleShape>(scaledRadius, scaledHeight));
-    _shapes.push_back(shape);
+    addShape(key, shape);
 
     return shape;
 }
@@ -1074,7 +1114,8 @@ PhysicsCollisionShape* PhysicsController::createHeightfield(Node* node, HeightFi
     PhysicsCollisionShape* shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_HEIGHTFIELD, terrainShape);
     shape->_shapeData.heightfieldData = heightfieldData;
 
-    _shapes.push_back(shape);
+    // Heightfields reference mutable height data and are never shared, so they are keyed by address.
+    addShape((size_t)shape, shape);
 
     return shape;
 }
@@ -1083,14 +1124,6 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
 {
     GP_ASSERT(mesh);
 
-    // The mesh must have a valid URL (i.e. it must have been loaded from a Bundle)
-    // in order to fetch mesh data for computing mesh rigid body.
-    if (strlen(mesh->getUrl()) == 0)
-    {
-        GP_ERROR("Cannot create mesh rigid body for mesh without valid URL.");
-        return NULL;
-    }
-
     if (!dynamic)
     {
         // Static meshes use btBvhTriangleMeshShape and therefore only support triangle mesh shapes.
@@ -1120,17 +1153,21 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
         }
     }
 
-    // Read mesh data from URL
+    // Read mesh data from the mesh's CPU copy.
     char* vertexData = (char*)mesh->_vertexData;
     if (vertexData == NULL)
     {
-        GP_ERROR("Failed to load mesh data from url '%s'.", mesh->getUrl());
+        GP_ERROR("Failed to load mesh data from mesh '%s'.", mesh->getName().c_str());
         return NULL;
     }
 
     // Create mesh data to be populated and store in returned collision shape.
     PhysicsCollisionShape::MeshData* shapeMeshData = new PhysicsCollisionShape::MeshData();
     shapeMeshData->vertexData = NULL;
+    shapeMeshData->bvhData = NULL;
+    shapeMeshData->hash = 0;
+    shapeMeshData->vertexCount = 0;
+    shapeMeshData->indexCount = 0;
 
     // Copy the scaled vertex position data to the rigid body's local buffer.
     Matrix m;
@@ -1148,28 +1185,100 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
         memcpy(&(shapeMeshData->vertexData[i * 3]), &v, sizeof(float) * 3);
     }
 
+    // Copy the index data of each part. The mesh keeps its own index data so that
+    // the shape can be looked up (and rebuilt) again for the same mesh.
+    size_t partCount = mesh->getPartCount();
+    for (size_t i = 0; i < partCount; i++)
+    {
+        MeshPart* meshPart = mesh->getPart(i);
+        GP_ASSERT(meshPart);
+
+        unsigned int indexSize = meshPart->getIndexSize() * meshPart->getIndexCount();
+        unsigned char* indexData = new unsigned char[indexSize];
+        if (meshPart->_indexData)
+            memcpy(indexData, meshPart->_indexData, indexSize);
+        else
+            memset(indexData, 0, indexSize);
+        shapeMeshData->indexData.push_back(indexData);
+    }
+
+    // The shape is identified by the scaled geometry it is built from, so identical meshes
+    // share one shape and the baked data stays valid for as long as the geometry does not change.
+    // The cache key is truncated to size_t and may collide, so the full hash, the geometry size
+    // and the vertices are compared before reusing a shape, and the baked files record them too.
+    unsigned long long hash = hashBytes(&dynamic, sizeof(dynamic));
+    hash = hashBytes(shapeMeshData->vertexData, sizeof(float) * 3 * vertexCount, hash);
+    unsigned int indexCount = 0;
+    for (size_t i = 0; i < partCount; i++)
+    {
+        MeshPart* meshPart = mesh->getPart(i);
+        hash = hashBytes(shapeMeshData->indexData[i], meshPart->getIndexSize() * meshPart->getIndexCount(), hash);
+        indexCount += meshPart->getIndexCount();
+    }
+    shapeMeshData->hash = hash;
+    shapeMeshData->vertexCount = vertexCount;
+    shapeMeshData->indexCount = indexCount;
+    PhysicsCollisionShape::Type type = PhysicsCollisionShape::SHAPE_MESH;
+    size_t key = (size_t)hashBytes(&type, sizeof(type), hash);
+
+    // Return the mesh shape from the cache if it already exists.
+    auto range = _shapes.equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr)
+    {
+        PhysicsCollisionShape* shape = itr->second;
+        GP_ASSERT(shape);
+        const PhysicsCollisionShape::MeshData* cachedData = shape->_shapeData.meshData;
+        // Dynamic meshes use a convex hull, without a mesh interface.
+        if (shape->getType() == PhysicsCollisionShape::SHAPE_MESH && (shape->_meshInterface == NULL) == dynamic &&
+            cachedData->hash == hash && cachedData->vertexCount == vertexCount && cachedData->indexCount == indexCount &&
+            memcmp(cachedData->vertexData, shapeMeshData->vertexData, sizeof(float) * 3 * vertexCount) == 0)
+        {
+            for (size_t i = 0; i < shapeMeshData->indexData.size(); i++)
+            {
+                SAFE_DELETE_ARRAY(shapeMeshData->indexData[i]);
+            }
+            SAFE_DELETE_ARRAY(shapeMeshData->vertexData);
+            SAFE_DELETE(shapeMeshData);
+
+            shape->addRef();
+            return shape;
+        }
+    }
+
     btCollisionShape* collisionShape = NULL;
     btTriangleIndexVertexArray* meshInterface = NULL;
 
     if (dynamic)
     {
-        // For dynamic meshes, use a btConvexHullShape approximation
-        btConvexHullShape* originalConvexShape = bullet_new<btConvexHullShape>(shapeMeshData->vertexData, vertexCount, sizeof(float)*3);
+        unsigned int size = 0;
+        btVector3* hullVertices = (btVector3*)loadBakedShape(hash, vertexCount, indexCount, BAKED_SHAPE_HULL, &size);
+        if (hullVertices)
+        {
+            // Use the baked hull.
+            collisionShape = bullet_new<btConvexHullShape>((btScalar*)hullVertices, (int)(size / sizeof(btVector3)));
+            btAlignedFree(hullVertices);
+        }
+        else
+        {
+            // For dynamic meshes, use a btConvexHullShape approximation
+            btConvexHullShape* originalConvexShape = bullet_new<btConvexHullShape>(shapeMeshData->vertexData, vertexCount, sizeof(float)*3);
 
-        // Create a hull approximation for better performance
-	    btShapeHull* hull = bullet_new<btShapeHull>(originalConvexShape);
-	    hull->buildHull(originalConvexShape->getMargin());
-	    collisionShape = bullet_new<btConvexHullShape>((btScalar*)hull->getVertexPointer(), hull->numVertices());
+            // Create a hull approximation for better performance
+            btShapeHull* hull = bullet_new<btShapeHull>(originalConvexShape);
+            hull->buildHull(originalConvexShape->getMargin());
+            collisionShape = bullet_new<btConvexHullShape>((btScalar*)hull->getVertexPointer(), hull->numVertices());
 
-        SAFE_DELETE(hull);
-        SAFE_DELETE(originalConvexShape);
+            saveBakedShape(hash, vertexCount, indexCount, BAKED_SHAPE_HULL, hull->getVertexPointer(), hull->numVertices() * sizeof(btVector3));
+
+            SAFE_DELETE(hull);
+            SAFE_DELETE(originalConvexShape);
+        }
     }
     else
     {
         // For static meshes, use btBvhTriangleMeshShape
         meshInterface = bullet_new<btTriangleIndexVertexArray>();
 
-        size_t partCount = mesh->getPartCount();
         if (partCount > 0)
         {
             PHY_ScalarType indexType = PHY_UCHAR;
@@ -1197,17 +1306,15 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
                 default:
                     GP_ERROR("Unsupported index format (%d).", meshPart->getIndexFormat());
                     SAFE_DELETE(meshInterface);
+                    for (size_t j = 0; j < shapeMeshData->indexData.size(); j++)
+                    {
+                        SAFE_DELETE_ARRAY(shapeMeshData->indexData[j]);
+                    }
                     SAFE_DELETE_ARRAY(shapeMeshData->vertexData);
                     SAFE_DELETE(shapeMeshData);
-                    //SAFE_DELETE(data);
                     return NULL;
                 }
 
-                // Move the index data into the rigid body's local buffer.
-                // Set it to NULL in the MeshPartData so it is not released when the data is freed.
-                shapeMeshData->indexData.push_back((unsigned char*)meshPart->_indexData);
-                meshPart->_indexData = NULL;
-
                 // Create a btIndexedMesh object for the current mesh part.
                 btIndexedMesh indexedMesh;
                 indexedMesh.m_indexType = indexType;
@@ -1248,22 +1355,136 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
             meshInterface->addIndexedMesh(indexedMesh, indexedMesh.m_indexType);
         }
 
-        // Create our collision shape object and store shapeMeshData in it.
-        collisionShape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true);
+        unsigned int size = 0;
+        void* bvhData = loadBakedShape(hash, vertexCount, indexCount, BAKED_SHAPE_BVH, &size);
+        btQuantizedBvh* bvh = bvhData ? btQuantizedBvh::deSerializeInPlace(bvhData, size, false) : NULL;
+        if (bvh)
+        {
+            // Use the baked quantized BVH in place; the buffer is released together with the shape.
+            btBvhTriangleMeshShape* bvhShape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true, false);
+            bvhShape->setOptimizedBvh((btOptimizedBvh*)bvh);
+            shapeMeshData->bvhData = bvhData;
+            collisionShape = bvhShape;
+        }
+        else
+        {
+            if (bvhData)
+                btAlignedFree(bvhData);
+
+            btBvhTriangleMeshShape* bvhShape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true);
+
+            // Bake the BVH that was just built so later loads can skip building it.
+            if (!_shapeCachePath.empty())
+            {
+                btOptimizedBvh* builtBvh = bvhShape->getOptimizedBvh();
+                unsigned int bvhSize = builtBvh->calculateSerializeBufferSize();
+                void* buffer = btAlignedAlloc(bvhSize, 16);
+                if (builtBvh->serializeInPlace(buffer, bvhSize, false))
+                    saveBakedShape(hash, vertexCount, indexCount, BAKED_SHAPE_BVH, buffer, bvhSize);
+                btAlignedFree(buffer);
+            }
+            collisionShape = bvhShape;
+        }
     }
 
     // Create our collision shape object and store shapeMeshData in it.
     PhysicsCollisionShape* shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_MESH, collisionShape, meshInterface);
     shape->_shapeData.meshData = shapeMeshData;
 
-    _shapes.push_back(shape);
-
-    // Free the temporary mesh data now that it's stored in physics system.
-    //SAFE_DELETE(data);
+    addShape(key, shape);
 
     return shape;
 }
 
+void PhysicsController::addShape(size_t key, PhysicsCollisionShape* shape)
+{
+    GP_ASSERT(shape);
+    shape->_cacheKey = key;
+    _shapes.insert(std::make_pair(key, shape));
+}
+
+void PhysicsController::setShapeCachePath(const char* path)
+{
+    _shapeCachePath = path ? path : "";
+}
+
+const char* PhysicsController::getShapeCachePath() const
+{
+    return _shapeCachePath.c_str();
+}
+
+static std::string getBakedShapePath(const std::string& dir, unsigned long long hash, unsigned int kind)
+{
+    char name[32];
+    sprintf(name, "%016llx%s", hash, kind == BAKED_SHAPE_BVH ? ".bvh" : ".hull");
+    return dir + "/" + name;
+}
+
+void* PhysicsController::loadBakedShape(unsigned long long hash, unsigned int vertexCount, unsigned int indexCount, unsigned int kind, unsigned int* size)
+{
+    GP_ASSERT(size);
+
+    if (_shapeCachePath.empty())
+        return NULL;
+
+    std::string path = getBakedShapePath(_shapeCachePath, hash, kind);
+    if (!FileSystem::fileExists(path.c_str()))
+        return NULL;
+
+    std::unique_ptr<Stream> stream(FileSystem::open(path.c_str()));
+    if (stream.get() == NULL)
+        return NULL;
+
+    BakedShapeHeader header;
+    if (stream->read(&header, sizeof(header), 1) != 1 ||
+        header.magic != BAKED_SHAPE_MAGIC || header.version != BAKED_SHAPE_VERSION ||
+        header.kind != kind || header.hash != hash || header.vertexCount != vertexCount ||
+        header.indexCount != indexCount || header.size == 0)
+    {
+        GP_WARN("Ignoring invalid baked collision shape '%s'.", path.c_str());
+        return NULL;
+    }
+
+    // Read the payload straight into 16-byte aligned memory so it can be used in place.
+    void* data = btAlignedAlloc(header.size, 16);
+    if (stream->read(data, 1, header.size) != header.size)
+    {
+        GP_WARN("Failed to read baked collision shape '%s'.", path.c_str());
+        btAlignedFree(data);
+        return NULL;
+    }
+    stream->close();
+
+    *size = header.size;
+    return data;
+}
+
+void PhysicsController::saveBakedShape(unsigned long long hash, unsigned int vertexCount, unsigned int indexCount, unsigned int kind, const void* data, unsigned int size)
+{
+    if (_shapeCachePath.empty())
+        return;
+
+    std::string path = getBakedShapePath(_shapeCachePath, hash, kind);
+    std::unique_ptr<Stream> stream(FileSystem::open(path.c_str(), FileSystem::WRITE));
+    if (stream.get() == NULL || !stream->canWrite())
+    {
+        GP_WARN("Failed to write baked collision shape '%s'.", path.c_str());
+        return;
+    }
+
+    BakedShapeHeader header;
+    header.magic = BAKED_SHAPE_MAGIC;
+    header.version = BAKED_SHAPE_VERSION;
+    header.kind = kind;
+    header.size = size;
+    header.hash = hash;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    stream->write(&header, sizeof(header), 1);
+    stream->write(data, 1, size);
+    stream->close();
+}
+
 void PhysicsController::destroyShape(PhysicsCollisionShape* shape)
 {
     if (shape)
@@ -1271,9 +1492,15 @@ void PhysicsController::destroyShape(PhysicsCollisionShape* shape)
         if (shape->getRefCount() == 1)
         {
             // Remove shape from shape cache.
-            std::vector<PhysicsCollisionShape*>::iterator shapeItr = std::find(_shapes.begin(), _shapes.end(), shape);
-            if (shapeItr != _shapes.end())
-                _shapes.erase(shapeItr);
+            auto range = _shapes.equal_range(shape->_cacheKey);
+            for (auto itr = range.first; itr != range.second; ++itr)
+            {
+                if (itr->second == shape)
+                {
+                    _shapes.erase(itr);
+                    break;
+                }
+            }
         }
 
         // Release the shape.
@@ -306,6 +306,25 @@ public:
      */
     void drawDebug(const Matrix& viewProjection);
 
+    /**
+     * Sets the directory used to store baked collision data for mesh shapes.
+     *
+     * When set, the quantized BVH of static triangle mesh shapes and the convex hull
+     * of dynamic mesh shapes are written to a sidecar file named after the hash of the
+     * mesh data the first time they are built, and are loaded from that file (without
+     * rebuilding) on later loads. An empty path disables baking.
+     *
+     * @param path The directory for baked collision data, relative to the resource path.
+     */
+    void setShapeCachePath(const char* path);
+
+    /**
+     * Returns the directory used to store baked collision data for mesh shapes.
+     *
+     * @return The baked collision data directory, or an empty string if baking is disabled.
+     */
+    const char* getShapeCachePath() const;
+
     /**
      * Performs a ray test on the physics world.
      * 
@@ -448,6 +467,16 @@ private:
     // Creates a triangle mesh collision shape.
     PhysicsCollisionShape* createMesh(Mesh* mesh, const Vector3& scale, bool dynamic);
 
+    // Adds a newly created shape to the shape cache under the given key.
+    void addShape(size_t key, PhysicsCollisionShape* shape);
+
+    // Loads the baked BVH or convex hull of the mesh with the given hash and size from the shape cache directory.
+    // Returns a btAlignedAlloc'ed buffer holding the payload, or NULL if there is no valid baked data.
+    void* loadBakedShape(unsigned long long hash, unsigned int vertexCount, unsigned int indexCount, unsigned int kind, unsigned int* size);
+
+    // Writes a baked BVH or convex hull payload to the shape cache directory.
+    void saveBakedShape(unsigned long long hash, unsigned int vertexCount, unsigned int indexCount, unsigned int kind, const void* data, unsigned int size);
+
     // Destroys a collision shape created through PhysicsController
     void destroyShape(PhysicsCollisionShape* shape);
 
@@ -548,7 +577,8 @@ private:
     btSequentialImpulseConstraintSolver* _solver;
     btDynamicsWorld* _world;
     btGhostPairCallback* _ghostPairCallback;
-    std::vector<PhysicsCollisionShape*> _shapes;
+    std::unordered_multimap<size_t, PhysicsCollisionShape*> _shapes;
+    std::string _shapeCachePath;
     DebugDrawer* _debugDrawer;
     Listener::EventType _status;
     std::vector<Listener*>* _listeners;
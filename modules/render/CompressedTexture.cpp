@@ -1,6 +1,7 @@
 
 #include "CompressedTexture.h"
 #include "ogl.h"
+#include "GLRenderer.h"
 #include "base/FileSystem.h"
 
 using namespace gameplay;
@@ -114,6 +115,8 @@ Texture* CompressedTexture::createCompressedDdsKtx(const char* path) {
         }
 
         glBindTexture(glTexImageTarget, tex);
+        // The texture unit and binding were changed outside of the renderer.
+        static_cast<GLRenderer*>(Renderer::cur())->invalidateStateCache();
 
         int format = GL_RGBA;
         if (tc.bpp == 24) {
@@ -250,6 +253,8 @@ Texture* CompressedTexture::createCompressedPVRTC(const char* path)
     GLuint textureId;
     GL_ASSERT(glGenTextures(1, &textureId));
     GL_ASSERT(glBindTexture(target, textureId));
+    // The texture binding was changed outside of the renderer.
+    static_cast<GLRenderer*>(Renderer::cur())->invalidateStateCache();
 
     Texture::Filter minFilter = mipMapCount > 1 ? Texture::NEAREST_MIPMAP_LINEAR : Texture::LINEAR;
     GL_ASSERT(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter));
@@ -897,6 +902,8 @@ Texture* CompressedTexture::createCompressedDDS(const char* path)
     GLuint textureId;
     GL_ASSERT(glGenTextures(1, &textureId));
     GL_ASSERT(glBindTexture(target, textureId));
+    // The texture binding was changed outside of the renderer.
+    static_cast<GLRenderer*>(Renderer::cur())->invalidateStateCache();
 
     Texture::Filter minFilter = header.dwMipMapCount > 1 ? Texture::NEAREST_MIPMAP_LINEAR : Texture::LINEAR;
     GL_ASSERT(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter));
@@ -12,11 +12,28 @@ GLenum __gl_error_code = GL_NO_ERROR;
 
 using namespace gameplay;
 
-GLRenderer::GLRenderer() {
+// Shadowed handle when the GL state is not known.
+static const GLuint UNKNOWN_HANDLE = 0xffffffff;
+
+GLRenderer::SamplerState::SamplerState() :
+    minFilter(-1), magFilter(-1), wrapS(-1), wrapT(-1), wrapR(-1)
+{
+}
+
+GLRenderer::GLRenderer() :
+  _frameUniforms(NULL), _drawUniforms(NULL), _drawRing(0), _drawRingHead(0), _drawRingOffset(0), _drawRingAlignment(256) {
   GLFrameBuffer::initialize();
+  invalidateStateCache();
+  resetStateCacheStats();
 }
 
 GLRenderer::~GLRenderer() {
+  SAFE_DELETE(_frameUniforms);
+  SAFE_DELETE(_drawUniforms);
+#ifdef GP_USE_UBO
+  if (_drawRing)
+      glDeleteBuffers(1, &_drawRing);
+#endif
   GLFrameBuffer::finalize();
 }
 
@@ -179,10 +196,8 @@ void GLRenderer::renderMesh(Mesh* mesh, Material* _material,
         for (Material* material = _material; material != NULL; material = material->getNextPass())
         {
             material->bind(view, node);
-            if (!mesh->_vertexAttributeArray) {
-                mesh->_vertexAttributeArray = VertexAttributeBinding::create(mesh, material->getEffect());
-            }
-            bindVertexAttributeObj(mesh->_vertexAttributeArray);
+            VertexAttributeBinding* vertexAttributeArray = getMeshVertexAttributeObj(mesh, material, view);
+            bindVertexAttributeObj(vertexAttributeArray);
 
             GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
             if (!view->wireframe || !drawWireframe(mesh))
@@ -190,7 +205,7 @@ void GLRenderer::renderMesh(Mesh* mesh, Material* _material,
                 GL_ASSERT(glDrawArrays(mesh->getPrimitiveType(), 0, mesh->getVertexCount()));
             }
 
-            unbindVertexAttributeObj(mesh->_vertexAttributeArray);
+            unbindVertexAttributeObj(vertexAttributeArray);
             material->unbind();
         }
         return;
@@ -209,10 +224,8 @@ void GLRenderer::renderMesh(Mesh* mesh, Material* _material,
         for (; material != NULL; material = material->getNextPass())
         {
             material->bind(view, node);
-            if (!mesh->_vertexAttributeArray) {
-                mesh->_vertexAttributeArray = VertexAttributeBinding::create(mesh, material->getEffect());
-            }
-            bindVertexAttributeObj(mesh->_vertexAttributeArray);
+            VertexAttributeBinding* vertexAttributeArray = getMeshVertexAttributeObj(mesh, material, view);
+            bindVertexAttributeObj(vertexAttributeArray);
 
             GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->_indexBuffer));
             if (!view->wireframe || !drawWireframe(part))
@@ -220,12 +233,34 @@ void GLRenderer::renderMesh(Mesh* mesh, Material* _material,
                 GL_ASSERT(glDrawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), 0));
             }
 
-            unbindVertexAttributeObj(mesh->_vertexAttributeArray);
+            unbindVertexAttributeObj(vertexAttributeArray);
             material->unbind();
         }
     }
 }
 
+VertexAttributeBinding* GLRenderer::getMeshVertexAttributeObj(Mesh* mesh, Material* material, RenderView* view)
+{
+    ShaderProgram* effect = material->getEffect();
+    bool override = view && (material == view->overrideMaterial || material == view->overrideSkinnedMaterial);
+    if (!override)
+    {
+        if (!mesh->_vertexAttributeArray)
+            mesh->_vertexAttributeArray = VertexAttributeBinding::create(mesh, effect);
+        return mesh->_vertexAttributeArray;
+    }
+
+    // The attribute locations of the override effect differ from the mesh's own effect
+    if (mesh->_overrideVertexAttributeArray && mesh->_overrideVertexAttributeArray->_effect != effect)
+    {
+        deleteVertexAttributeObj(mesh->_overrideVertexAttributeArray);
+        SAFE_DELETE(mesh->_overrideVertexAttributeArray);
+    }
+    if (!mesh->_overrideVertexAttributeArray)
+        mesh->_overrideVertexAttributeArray = VertexAttributeBinding::create(mesh, effect);
+    return mesh->_overrideVertexAttributeArray;
+}
+
 void GLRenderer::deleteMesh(Mesh* mesh) {
     if (mesh->_vertexBuffer)
     {
@@ -244,6 +279,10 @@ void GLRenderer::deleteMesh(Mesh* mesh) {
         SAFE_DELETE(mesh->_vertexAttributeArray);
         mesh->_vertexAttributeArray = NULL;
     }
+    if (mesh->_overrideVertexAttributeArray) {
+        deleteVertexAttributeObj(mesh->_overrideVertexAttributeArray);
+        SAFE_DELETE(mesh->_overrideVertexAttributeArray);
+    }
 }
 
 void GLRenderer::updateMeshPart(MeshPart* part, unsigned int indexStart, unsigned int indexCount) {
@@ -326,14 +365,23 @@ void GLRenderer::renderMeshBatch(MeshBatch* mbatch, RenderView* view, Node* node
     if (mbatch->_vertexCount == 0 || (mbatch->_indexed && mbatch->_indexCount == 0))
         return; // nothing to draw
 
-    // Not using VBOs, so unbind the element array buffer.
-    // ARRAY_BUFFER will be unbound automatically during pass->bind().
-    GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-
     GP_ASSERT(mbatch->_material);
     if (mbatch->_indexed)
         GP_ASSERT(mbatch->_indices);
 
+    // Stream the batch to its buffers once for all passes. The array buffer binding isn't
+    // part of the vertex array state, so the vertices are uploaded before binding it.
+    bool upload = mbatch->_dirty;
+    if (upload)
+    {
+        unsigned int vertexSize = mbatch->_vertexFormat.getVertexSize();
+        uploadStreamBuffer(GL_ARRAY_BUFFER, &mbatch->_vertexBuffer, &mbatch->_vertexBufferSize,
+            mbatch->_vertices, mbatch->_vertexCount * vertexSize, mbatch->_vertexCapacity * vertexSize);
+        mbatch->_dirty = false;
+    }
+
+    unsigned int indexSize = mbatch->_indexFormat == Mesh::INDEX32 ? sizeof(unsigned int) : sizeof(unsigned short);
+
     // Bind the material.
     for (Material* material = mbatch->_material; material != NULL; material = material->getNextPass())
     {
@@ -344,13 +392,26 @@ void GLRenderer::renderMeshBatch(MeshBatch* mbatch, RenderView* view, Node* node
                 deleteVertexAttributeObj(mbatch->_vertexAttributeArray);
                 SAFE_DELETE(mbatch->_vertexAttributeArray);
             }
-            mbatch->_vertexAttributeArray = VertexAttributeBinding::create(mbatch->_vertexFormat, mbatch->_vertices, material->getEffect());
+            mbatch->_vertexAttributeArray = VertexAttributeBinding::create(mbatch->_vertexFormat, NULL, material->getEffect());
+            mbatch->_vertexAttributeArray->_vertexBuffer = mbatch->_vertexBuffer;
         }
         bindVertexAttributeObj(mbatch->_vertexAttributeArray);
 
         if (mbatch->_indexed)
         {
-            GL_ASSERT(glDrawElements(mbatch->_primitiveType, mbatch->_indexCount, GL_UNSIGNED_SHORT, (GLvoid*)mbatch->_indices));
+            // The element array binding belongs to the current vertex array, so the
+            // indices are uploaded after binding it.
+            if (upload)
+            {
+                uploadStreamBuffer(GL_ELEMENT_ARRAY_BUFFER, &mbatch->_indexBuffer, &mbatch->_indexBufferSize,
+                    mbatch->_indices, mbatch->_indexCount * indexSize, mbatch->_indexCapacity * indexSize);
+                upload = false;
+            }
+            else
+            {
+                GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mbatch->_indexBuffer));
+            }
+            GL_ASSERT(glDrawElements(mbatch->_primitiveType, mbatch->_indexCount, mbatch->_indexFormat, 0));
         }
         else
         {
@@ -368,6 +429,19 @@ void GLRenderer::deleteMeshBatch(MeshBatch* mesh) {
         SAFE_DELETE(mesh->_vertexAttributeArray);
         mesh->_vertexAttributeArray = NULL;
     }
+    if (mesh->_vertexBuffer)
+    {
+        GL_ASSERT(glDeleteBuffers(1, &mesh->_vertexBuffer));
+        mesh->_vertexBuffer = 0;
+        mesh->_vertexBufferSize = 0;
+    }
+    if (mesh->_indexBuffer)
+    {
+        GL_ASSERT(glDeleteBuffers(1, &mesh->_indexBuffer));
+        mesh->_indexBuffer = 0;
+        mesh->_indexBufferSize = 0;
+    }
+    mesh->_dirty = true;
 }
 
 void GLRenderer::enableDepthWrite()
@@ -558,7 +632,7 @@ void GLRenderer::updateTexture(Texture* texture) {
         GLuint textureId;
         GL_ASSERT(glGenTextures(1, &textureId));
         texture->_handle = textureId;
-        GL_ASSERT(glBindTexture(target, textureId));
+        bindTexture(target, textureId);
         GL_ASSERT(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
 #ifndef OPENGL_ES
         // glGenerateMipmap is new in OpenGL 3.0. For OpenGL 2.0 we must fallback to use glTexParameteri
@@ -572,7 +646,7 @@ void GLRenderer::updateTexture(Texture* texture) {
     unsigned int height = texture->getHeight();
 
     GLuint textureId = texture->_handle;
-    GL_ASSERT(glBindTexture(target, textureId));
+    bindTexture(target, textureId);
 
     // Load the texture
     size_t bpp = getFormatBPP(format);
@@ -587,6 +661,7 @@ void GLRenderer::updateTexture(Texture* texture) {
         unsigned int textureSize = width * height;
         if (bpp == 0)
         {
+            forgetTexture(textureId);
             glDeleteTextures(1, &textureId);
             GP_ERROR("Failed to determine texture size because format is UNKNOWN.");
             texture->_handle = 0;
@@ -622,6 +697,9 @@ void GLRenderer::updateTexture(Texture* texture) {
         GL_ASSERT(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, texture->_minFilter));
     }
 
+    // The sampler parameters were set directly, bindTextureSampler() applies them again.
+    _samplerStates.erase(textureId);
+
     if (texture->isMipmapped()) {
         GL_ASSERT(glHint(GL_GENERATE_MIPMAP_HINT, GL_NICEST));
         if (std::addressof(glGenerateMipmap))
@@ -629,9 +707,29 @@ void GLRenderer::updateTexture(Texture* texture) {
     }
 }
 
+void GLRenderer::updateTextureRegion(Texture* texture, int x, int y, unsigned int width, unsigned int height) {
+    Texture::Format format = texture->getFormat();
+    GP_ASSERT(texture->getType() == Texture::TEXTURE_2D);
+    GP_ASSERT(texture->_handle);
+
+    GLint internalFormat = getFormatInternal(format);
+    GP_ASSERT(internalFormat != 0);
+
+    GLenum texelType = getFormatTexel(format);
+    GP_ASSERT(texelType != 0);
+
+    bindTexture(GL_TEXTURE_2D, texture->_handle);
+    GL_ASSERT(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_ASSERT(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, internalFormat, texelType, texture->_data));
+
+    if (texture->isMipmapped() && std::addressof(glGenerateMipmap))
+        GL_ASSERT(glGenerateMipmap(GL_TEXTURE_2D));
+}
+
 void GLRenderer::deleteTexture(Texture* texture) {
     if (texture->_handle)
     {
+        forgetTexture(texture->_handle);
         GL_ASSERT(glDeleteTextures(1, &texture->_handle));
         texture->_handle = 0;
     }
@@ -645,18 +743,69 @@ void GLRenderer::bindTextureSampler(Texture* sampler) {
     GLenum target = (GLenum)type;
 
     GLuint textureId = _texture->_handle;
-    GL_ASSERT(glBindTexture(target, textureId));
-
-    GL_ASSERT(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, (GLenum)sampler->_minFilter));
-    GL_ASSERT(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, (GLenum)sampler->_magFilter));
-    GL_ASSERT(glTexParameteri(target, GL_TEXTURE_WRAP_S, (GLenum)sampler->_wrapS));
-    GL_ASSERT(glTexParameteri(target, GL_TEXTURE_WRAP_T, (GLenum)sampler->_wrapT));
+    bindTexture(target, textureId);
+
+    // Sampler parameters are stored with the texture, so only the ones that changed
+    // since the texture was last bound need to be applied.
+    SamplerState& state = _samplerStates[textureId];
+    setSamplerParameter(target, GL_TEXTURE_MIN_FILTER, (GLenum)sampler->_minFilter, &state.minFilter);
+    setSamplerParameter(target, GL_TEXTURE_MAG_FILTER, (GLenum)sampler->_magFilter, &state.magFilter);
+    setSamplerParameter(target, GL_TEXTURE_WRAP_S, (GLenum)sampler->_wrapS, &state.wrapS);
+    setSamplerParameter(target, GL_TEXTURE_WRAP_T, (GLenum)sampler->_wrapT, &state.wrapT);
 #if defined(GL_TEXTURE_WRAP_R) // OpenGL ES 3.x and up, OpenGL 1.2 and up
     if (target == GL_TEXTURE_CUBE_MAP) // We don't want to run this on something that we know will fail
-        GL_ASSERT(glTexParameteri(target, GL_TEXTURE_WRAP_R, (GLenum)sampler->_wrapR));
+        setSamplerParameter(target, GL_TEXTURE_WRAP_R, (GLenum)sampler->_wrapR, &state.wrapR);
 #endif
 }
 
+void GLRenderer::setActiveTextureUnit(unsigned int unit) {
+    GP_ASSERT(unit < MAX_TEXTURE_UNITS);
+    if (_activeTextureUnit != unit)
+    {
+        GL_ASSERT(glActiveTexture(GL_TEXTURE0 + unit));
+        _activeTextureUnit = unit;
+    }
+}
+
+void GLRenderer::bindTexture(unsigned int target, unsigned int handle) {
+    if (_activeTextureUnit >= MAX_TEXTURE_UNITS)
+        setActiveTextureUnit(0);
+
+    GLuint& bound = _boundTextures[_activeTextureUnit][target == GL_TEXTURE_CUBE_MAP ? 1 : 0];
+    if (bound == handle)
+    {
+        ++_stats.textureBindsElided;
+        return;
+    }
+    GL_ASSERT(glBindTexture(target, handle));
+    bound = handle;
+    ++_stats.textureBinds;
+}
+
+void GLRenderer::forgetTexture(unsigned int handle) {
+    // GL unbinds a deleted texture from every unit and may reuse its name.
+    for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        for (unsigned int j = 0; j < 2; ++j)
+        {
+            if (_boundTextures[i][j] == handle)
+                _boundTextures[i][j] = 0;
+        }
+    }
+    _samplerStates.erase(handle);
+}
+
+void GLRenderer::setSamplerParameter(unsigned int target, unsigned int name, int value, int* current) {
+    if (*current == value)
+    {
+        ++_stats.samplerParametersElided;
+        return;
+    }
+    GL_ASSERT(glTexParameteri(target, name, value));
+    *current = value;
+    ++_stats.samplerParameters;
+}
+
 ShaderProgram* GLRenderer::createProgram(ProgramSrc* src) {
     const char* defines = src->defines;
     const char* vshSource = src->vshSource;
@@ -815,6 +964,54 @@ ShaderProgram* GLRenderer::createProgram(ProgramSrc* src) {
         }
     }
 
+    // Query and store uniform blocks from the program. Blocks are bound to binding points
+    // by usage, so the shared per-frame and per-draw blocks stay bound across programs.
+    GLint activeBlocks = 0;
+#ifdef GP_USE_UBO
+    if (glUniformBlockBinding)
+    {
+        GL_ASSERT(glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &activeBlocks));
+    }
+    if (activeBlocks > 0)
+    {
+        GL_ASSERT(glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &length));
+        GLchar* blockName = new GLchar[length + 1];
+        GLint blockSize;
+        unsigned int materialBinding = 2;
+        for (int i = 0; i < activeBlocks; ++i)
+        {
+            GL_ASSERT(glGetActiveUniformBlockName(program, i, length + 1, NULL, blockName));
+            GL_ASSERT(glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize));
+
+            UniformBlock* block = new UniformBlock();
+            block->_name = blockName;
+            block->_index = i;
+            block->_size = blockSize;
+            block->_usage = UniformBlock::getUsage(blockName);
+            switch (block->_usage)
+            {
+            case UniformBlock::FRAME:
+                block->_binding = 0;
+                break;
+            case UniformBlock::DRAW:
+                block->_binding = 1;
+                break;
+            default:
+                block->_binding = materialBinding++;
+                break;
+            }
+            if (block->_binding >= MAX_UNIFORM_BUFFER_BINDINGS)
+            {
+                GP_ERROR("Too many uniform blocks (%d) in program.", activeBlocks);
+            }
+            GL_ASSERT(glUniformBlockBinding(program, i, block->_binding));
+
+            effect->_uniformBlocks.push_back(block);
+        }
+        SAFE_DELETE_ARRAY(blockName);
+    }
+#endif
+
     // Query and store uniforms from the program.
     GLint activeUniforms;
     GL_ASSERT(glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &activeUniforms));
@@ -864,6 +1061,27 @@ ShaderProgram* GLRenderer::createProgram(ProgramSrc* src) {
                     uniform->_index = 0;
                 }
 
+#ifdef GP_USE_UBO
+                if (activeBlocks > 0)
+                {
+                    // Uniforms of a block have no location, they are written at their std140 offset.
+                    GLuint uniformIndex = i;
+                    GLint blockIndex;
+                    GL_ASSERT(glGetActiveUniformsiv(program, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX, &blockIndex));
+                    if (blockIndex >= 0 && blockIndex < activeBlocks)
+                    {
+                        GLint offset, arrayStride, matrixStride;
+                        GL_ASSERT(glGetActiveUniformsiv(program, 1, &uniformIndex, GL_UNIFORM_OFFSET, &offset));
+                        GL_ASSERT(glGetActiveUniformsiv(program, 1, &uniformIndex, GL_UNIFORM_ARRAY_STRIDE, &arrayStride));
+                        GL_ASSERT(glGetActiveUniformsiv(program, 1, &uniformIndex, GL_UNIFORM_MATRIX_STRIDE, &matrixStride));
+                        uniform->_block = effect->_uniformBlocks[blockIndex];
+                        uniform->_offset = offset;
+                        uniform->_arrayStride = arrayStride;
+                        uniform->_matrixStride = matrixStride;
+                    }
+                }
+#endif
+
                 effect->_uniforms[uniformName] = uniform;
             }
             SAFE_DELETE_ARRAY(uniformName);
@@ -877,9 +1095,13 @@ void GLRenderer::deleteProgram(ShaderProgram* effect) {
     if (effect->_program)
     {
         // If our program object is currently bound, unbind it before we're destroyed.
-        if (__currentEffect == effect)
+        if (_currentProgram == effect->_program)
         {
             GL_ASSERT(glUseProgram(0));
+            _currentProgram = 0;
+        }
+        if (__currentEffect == effect)
+        {
             __currentEffect = NULL;
         }
 
@@ -888,9 +1110,16 @@ void GLRenderer::deleteProgram(ShaderProgram* effect) {
     }
 }
 void GLRenderer::bindProgram(ShaderProgram* effect) {
-    GL_ASSERT(glUseProgram(effect->_program));
-
     __currentEffect = effect;
+
+    if (_currentProgram == effect->_program)
+    {
+        ++_stats.programBindsElided;
+        return;
+    }
+    GL_ASSERT(glUseProgram(effect->_program));
+    _currentProgram = effect->_program;
+    ++_stats.programBinds;
 }
 void GLRenderer::bindUniform(MaterialParameter* value, Uniform* uniform, ShaderProgram* effect) {
     GP_ASSERT(uniform);
@@ -901,6 +1130,23 @@ void GLRenderer::bindUniform(MaterialParameter* value, Uniform* uniform, ShaderP
         value->_methodBinding->setValue(effect);
     }
 
+    // Uniform values are program state, so a value this uniform already holds is not
+    // uploaded again. Samplers still bind their textures, which may have been replaced
+    // on their units by other programs.
+    unsigned int version = value->getVersion();
+    bool upload = version == 0 || uniform->_version != version;
+    uniform->_version = version;
+    if (upload)
+    {
+        ++_stats.uniformUploads;
+    }
+    else
+    {
+        ++_stats.uniformUploadsElided;
+        if (value->_type != MaterialParameter::SAMPLER && value->_type != MaterialParameter::SAMPLER_ARRAY)
+            return;
+    }
+
     switch (value->_type)
     {
     case MaterialParameter::FLOAT:
@@ -948,12 +1194,13 @@ void GLRenderer::bindUniform(MaterialParameter* value, Uniform* uniform, ShaderP
         GP_ASSERT((sampler->getType() == Texture::TEXTURE_2D && uniform->_type == GL_SAMPLER_2D) ||
             (sampler->getType() == Texture::TEXTURE_CUBE && uniform->_type == GL_SAMPLER_CUBE));
 
-        GL_ASSERT(glActiveTexture(GL_TEXTURE0 + uniform->_index));
+        setActiveTextureUnit(uniform->_index);
 
         // Bind the sampler - this binds the texture and applies sampler state
         const_cast<Texture*>(sampler)->bind();
 
-        GL_ASSERT(glUniform1i(uniform->_location, uniform->_index));
+        if (upload)
+            GL_ASSERT(glUniform1i(uniform->_location, uniform->_index));
         break;
     }
     case MaterialParameter::SAMPLER_ARRAY: {
@@ -967,7 +1214,7 @@ void GLRenderer::bindUniform(MaterialParameter* value, Uniform* uniform, ShaderP
         {
             GP_ASSERT((const_cast<Texture*>(values[i])->getType() == Texture::TEXTURE_2D && uniform->_type == GL_SAMPLER_2D) ||
                 (const_cast<Texture*>(values[i])->getType() == Texture::TEXTURE_CUBE && uniform->_type == GL_SAMPLER_CUBE));
-            GL_ASSERT(glActiveTexture(GL_TEXTURE0 + uniform->_index + i));
+            setActiveTextureUnit(uniform->_index + i);
 
             // Bind the sampler - this binds the texture and applies sampler state
             const_cast<Texture*>(values[i])->bind();
@@ -976,7 +1223,8 @@ void GLRenderer::bindUniform(MaterialParameter* value, Uniform* uniform, ShaderP
         }
 
         // Pass texture unit array to GL
-        GL_ASSERT(glUniform1iv(uniform->_location, value->_count, units));
+        if (upload)
+            GL_ASSERT(glUniform1iv(uniform->_location, value->_count, units));
         break;
         //case MaterialParameter::METHOD:
             //if (_value.method)
@@ -1004,7 +1252,7 @@ void GLRenderer::bindVertexAttributeObj(VertexAttributeBinding* vertextAttribute
     bool needInitVAO = false;
 
 #ifdef GP_USE_VAO
-    if (b->_handle == 0 && vertextAttribute->_mesh && glGenVertexArrays)
+    if (b->_handle == 0 && (vertextAttribute->_mesh || vertextAttribute->_vertexBuffer) && glGenVertexArrays)
     {
         GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, 0));
         GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
@@ -1020,10 +1268,10 @@ void GLRenderer::bindVertexAttributeObj(VertexAttributeBinding* vertextAttribute
         }
 
         // Bind the new VAO.
-        GL_ASSERT(glBindVertexArray(b->_handle));
+        bindVertexArray(b->_handle);
 
-        // Bind the Mesh VBO so our glVertexAttribPointer calls use it.
-        GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, vertextAttribute->_mesh->getVertexBuffer()));
+        // Bind the VBO so our glVertexAttribPointer calls use it.
+        GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, vertextAttribute->_mesh ? vertextAttribute->_mesh->getVertexBuffer() : vertextAttribute->_vertexBuffer));
 
         needInitVAO = true;
     }
@@ -1033,18 +1281,22 @@ void GLRenderer::bindVertexAttributeObj(VertexAttributeBinding* vertextAttribute
     if (b->_handle)
     {
         // Hardware mode
-        GL_ASSERT(glBindVertexArray(b->_handle));
+        bindVertexArray(b->_handle);
     }
     else
     {
-        // Software mode
+        // Software mode, the attributes must not be recorded into a vertex array left bound.
+#ifdef GP_USE_VAO
+        if (_currentVertexArray != 0 && glBindVertexArray)
+            bindVertexArray(0);
+#endif
         if (b->_mesh)
         {
             GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, b->_mesh->getVertexBuffer()));
         }
         else
         {
-            GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, b->_vertexBuffer));
         }
     }
 
@@ -1072,13 +1324,13 @@ void GLRenderer::bindVertexAttributeObj(VertexAttributeBinding* vertextAttribute
 void GLRenderer::unbindVertexAttributeObj(VertexAttributeBinding* vertextAttribute) {
     if (vertextAttribute->_handle)
     {
-        // Hardware mode
-        GL_ASSERT(glBindVertexArray(0));
+        // Hardware mode, the vertex array is left bound so drawing the same one again
+        // doesn't need to rebind it. The next bind of another one replaces it.
     }
     else
     {
         // Software mode
-        if (vertextAttribute->_mesh)
+        if (vertextAttribute->_mesh || vertextAttribute->_vertexBuffer)
         {
             GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, 0));
         }
@@ -1094,11 +1346,204 @@ void GLRenderer::unbindVertexAttributeObj(VertexAttributeBinding* vertextAttribu
 void GLRenderer::deleteVertexAttributeObj(VertexAttributeBinding* vertextAttribute) {
     if (vertextAttribute->_handle)
     {
+        // GL unbinds a deleted vertex array and may reuse its name.
+        if (_currentVertexArray == vertextAttribute->_handle)
+            _currentVertexArray = 0;
         GL_ASSERT(glDeleteVertexArrays(1, &vertextAttribute->_handle));
         vertextAttribute->_handle = 0;
     }
 }
 
+void GLRenderer::bindVertexArray(unsigned int handle) {
+    if (_currentVertexArray == handle)
+    {
+        ++_stats.vertexArrayBindsElided;
+        return;
+    }
+    GL_ASSERT(glBindVertexArray(handle));
+    _currentVertexArray = handle;
+    ++_stats.vertexArrayBinds;
+}
+
+UniformBuffer* GLRenderer::getSharedUniformBuffer(UniformBlock* block) {
+    GP_ASSERT(block);
+
+    UniformBuffer** shared;
+    switch (block->_usage)
+    {
+    case UniformBlock::FRAME:
+        shared = &_frameUniforms;
+        break;
+    case UniformBlock::DRAW:
+        shared = &_drawUniforms;
+        break;
+    default:
+        return NULL;
+    }
+
+    if (*shared == NULL)
+        *shared = new UniformBuffer(block->_size);
+    else
+        (*shared)->reserve(block->_size);
+    return *shared;
+}
+
+void GLRenderer::bindUniformBlocks(ShaderProgram* effect, UniformBuffer** buffers) {
+    GP_ASSERT(effect);
+    GP_ASSERT(buffers);
+
+#ifdef GP_USE_UBO
+    for (size_t i = 0, count = effect->_uniformBlocks.size(); i < count; ++i)
+    {
+        UniformBlock* block = effect->_uniformBlocks[i];
+        UniformBuffer* buffer = buffers[i];
+        GP_ASSERT(buffer);
+
+        if (block->_usage == UniformBlock::DRAW)
+        {
+            if (buffer->_dirty || _drawRing == 0)
+                copyToDrawRing(buffer, block->_size);
+            bindUniformBuffer(block->_binding, _drawRing, _drawRingOffset, block->_size);
+        }
+        else
+        {
+            if (buffer->_dirty || buffer->_handle == 0)
+                uploadUniformBuffer(buffer);
+            bindUniformBuffer(block->_binding, buffer->_handle, 0, 0);
+        }
+    }
+#endif
+}
+
+void GLRenderer::deleteUniformBuffer(UniformBuffer* buffer) {
+#ifdef GP_USE_UBO
+    if (buffer->_handle)
+    {
+        // GL unbinds a deleted buffer and may reuse its name.
+        for (unsigned int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; ++i)
+        {
+            if (_boundUniformBuffers[i].handle == buffer->_handle)
+                _boundUniformBuffers[i].handle = 0;
+        }
+        GL_ASSERT(glDeleteBuffers(1, &buffer->_handle));
+        buffer->_handle = 0;
+    }
+#endif
+}
+
+void GLRenderer::uploadUniformBuffer(UniformBuffer* buffer) {
+#ifdef GP_USE_UBO
+    if (buffer->_handle == 0)
+    {
+        GL_ASSERT(glGenBuffers(1, &buffer->_handle));
+    }
+
+    // Specifying the whole storage again lets the driver hand out new memory instead of
+    // waiting for draws still reading the previous values.
+    GL_ASSERT(glBindBuffer(GL_UNIFORM_BUFFER, buffer->_handle));
+    GL_ASSERT(glBufferData(GL_UNIFORM_BUFFER, buffer->_size, buffer->_data, GL_DYNAMIC_DRAW));
+    buffer->_dirty = false;
+    ++_stats.uniformBufferUploads;
+#endif
+}
+
+void GLRenderer::uploadStreamBuffer(unsigned int target, unsigned int* handle, unsigned int* storageSize, const void* data, unsigned int size, unsigned int capacity) {
+    if (*handle == 0)
+    {
+        GL_ASSERT(glGenBuffers(1, handle));
+    }
+    GL_ASSERT(glBindBuffer(target, *handle));
+
+    // Orphan the storage before writing, so the driver hands out new memory instead of
+    // waiting for draws still reading the previous contents. The storage is sized for
+    // the whole capacity of the batch so it only grows with it.
+    if (capacity > *storageSize)
+        *storageSize = capacity;
+    GL_ASSERT(glBufferData(target, *storageSize, NULL, GL_STREAM_DRAW));
+    if (size > 0)
+    {
+        GL_ASSERT(glBufferSubData(target, 0, size, data));
+    }
+    ++_stats.streamBufferUploads;
+    _stats.streamBufferBytes += size;
+}
+
+void GLRenderer::copyToDrawRing(UniformBuffer* buffer, unsigned int size) {
+#ifdef GP_USE_UBO
+    GP_ASSERT(size <= buffer->_size && size <= DRAW_RING_SIZE);
+
+    if (_drawRing == 0)
+    {
+        GLint alignment = 0;
+        GL_ASSERT(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+        if (alignment > 0)
+            _drawRingAlignment = alignment;
+
+        GL_ASSERT(glGenBuffers(1, &_drawRing));
+        GL_ASSERT(glBindBuffer(GL_UNIFORM_BUFFER, _drawRing));
+        GL_ASSERT(glBufferData(GL_UNIFORM_BUFFER, DRAW_RING_SIZE, NULL, GL_STREAM_DRAW));
+        _drawRingHead = 0;
+    }
+    else
+    {
+        GL_ASSERT(glBindBuffer(GL_UNIFORM_BUFFER, _drawRing));
+    }
+
+    unsigned int offset = (_drawRingHead + _drawRingAlignment - 1) / _drawRingAlignment * _drawRingAlignment;
+    if (offset + size > DRAW_RING_SIZE)
+    {
+        // The ring is full, get new storage and start over. Draws still reading the
+        // previous storage keep it until they finish.
+        GL_ASSERT(glBufferData(GL_UNIFORM_BUFFER, DRAW_RING_SIZE, NULL, GL_STREAM_DRAW));
+        offset = 0;
+    }
+
+    // The range was never written since the storage was specified, so no draw reads it.
+    void* data;
+    GL_ASSERT(data = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (data)
+    {
+        memcpy(data, buffer->_data, size);
+        GL_ASSERT(glUnmapBuffer(GL_UNIFORM_BUFFER));
+    }
+    else
+    {
+        GL_ASSERT(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, buffer->_data));
+    }
+
+    _drawRingOffset = offset;
+    _drawRingHead = offset + size;
+    buffer->_dirty = false;
+    ++_stats.uniformBufferUploads;
+#endif
+}
+
+void GLRenderer::bindUniformBuffer(unsigned int binding, unsigned int handle, unsigned int offset, unsigned int size) {
+#ifdef GP_USE_UBO
+    GP_ASSERT(binding < MAX_UNIFORM_BUFFER_BINDINGS);
+
+    BufferRange& bound = _boundUniformBuffers[binding];
+    if (bound.handle == handle && bound.offset == offset && bound.size == size)
+    {
+        ++_stats.uniformBufferBindsElided;
+        return;
+    }
+
+    if (size == 0)
+    {
+        GL_ASSERT(glBindBufferBase(GL_UNIFORM_BUFFER, binding, handle));
+    }
+    else
+    {
+        GL_ASSERT(glBindBufferRange(GL_UNIFORM_BUFFER, binding, handle, offset, size));
+    }
+    bound.handle = handle;
+    bound.offset = offset;
+    bound.size = size;
+    ++_stats.uniformBufferBinds;
+#endif
+}
+
 FrameBuffer* GLRenderer::createFrameBuffer(const char* id, unsigned int width, unsigned int height, Texture::Format format) {
     return GLFrameBuffer::create(id, width, height, format);
 }
@@ -1111,3 +1556,29 @@ FrameBuffer* GLRenderer::getCurrentFrameBuffer() {
 FrameBuffer* GLRenderer::getFrameBuffer(const char* id) {
     return GLFrameBuffer::getFrameBuffer(id);
 }
+
+const GLRenderer::StateCacheStats& GLRenderer::getStateCacheStats() const {
+    return _stats;
+}
+
+void GLRenderer::resetStateCacheStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void GLRenderer::invalidateStateCache() {
+    _currentProgram = UNKNOWN_HANDLE;
+    _activeTextureUnit = MAX_TEXTURE_UNITS;
+    for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        _boundTextures[i][0] = UNKNOWN_HANDLE;
+        _boundTextures[i][1] = UNKNOWN_HANDLE;
+    }
+    _samplerStates.clear();
+    _currentVertexArray = UNKNOWN_HANDLE;
+    for (unsigned int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; ++i)
+    {
+        _boundUniformBuffers[i].handle = UNKNOWN_HANDLE;
+        _boundUniformBuffers[i].offset = 0;
+        _boundUniformBuffers[i].size = 0;
+    }
+}
@@ -11,6 +11,28 @@ class FrameBuffer;
 class GLRenderer : public Renderer {
 	ShaderProgram* __currentEffect = NULL;
 public:
+	/**
+	 * Counts of the GL state changes issued by the renderer, and of those
+	 * skipped because the state was already current.
+	 */
+	struct StateCacheStats {
+		unsigned int programBinds;
+		unsigned int programBindsElided;
+		unsigned int textureBinds;
+		unsigned int textureBindsElided;
+		unsigned int samplerParameters;
+		unsigned int samplerParametersElided;
+		unsigned int vertexArrayBinds;
+		unsigned int vertexArrayBindsElided;
+		unsigned int uniformUploads;
+		unsigned int uniformUploadsElided;
+		unsigned int uniformBufferUploads;
+		unsigned int uniformBufferBinds;
+		unsigned int uniformBufferBindsElided;
+		unsigned int streamBufferUploads;
+		unsigned int streamBufferBytes;
+	};
+
 	GLRenderer();
     ~GLRenderer();
 
@@ -31,6 +53,7 @@ public:
 	void updateState(StateBlock* state, int force = 1);
 
 	void updateTexture(Texture* texture);
+	void updateTextureRegion(Texture* texture, int x, int y, unsigned int width, unsigned int height);
 	void deleteTexture(Texture* texture);
 	void bindTextureSampler(Texture* texture);
 
@@ -39,6 +62,10 @@ public:
 	void bindProgram(ShaderProgram* effect);
 	void bindUniform(MaterialParameter* value, Uniform* uniform, ShaderProgram* effect);
 
+	UniformBuffer* getSharedUniformBuffer(UniformBlock* block);
+	void bindUniformBlocks(ShaderProgram* effect, UniformBuffer** buffers);
+	void deleteUniformBuffer(UniformBuffer* buffer);
+
 	void bindVertexAttributeObj(VertexAttributeBinding* vertextAttribute);
 	void unbindVertexAttributeObj(VertexAttributeBinding* vertextAttribute);
 	void deleteVertexAttributeObj(VertexAttributeBinding* vertextAttribute);
@@ -47,11 +74,80 @@ public:
     FrameBuffer* bindDefaultFrameBuffer(unsigned int type = 0x8D40/*GL_FRAMEBUFFER*/);
     FrameBuffer* getCurrentFrameBuffer();
     FrameBuffer* getFrameBuffer(const char* id);
+
+	/**
+	 * Returns the state changes counted since the last call to resetStateCacheStats().
+	 */
+	const StateCacheStats& getStateCacheStats() const;
+
+	/**
+	 * Resets the state change counts to zero, typically once per frame.
+	 */
+	void resetStateCacheStats();
+
+	/**
+	 * Forgets the GL state tracked by the renderer.
+	 *
+	 * Must be called after programs, textures or vertex arrays were bound by code
+	 * that does not go through the renderer.
+	 */
+	void invalidateStateCache();
 private:
+	/**
+	 * The sampler parameters last applied to a texture, -1 when unknown.
+	 */
+	struct SamplerState {
+		int minFilter;
+		int magFilter;
+		int wrapS;
+		int wrapT;
+		int wrapR;
+		SamplerState();
+	};
+
+	/**
+	 * A buffer range bound to a uniform buffer binding point, size 0 for the whole buffer.
+	 */
+	struct BufferRange {
+		unsigned int handle;
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	static const unsigned int MAX_TEXTURE_UNITS = 32;
+	static const unsigned int MAX_UNIFORM_BUFFER_BINDINGS = 24;
+	static const unsigned int DRAW_RING_SIZE = 1024 * 1024;
+
+	void setActiveTextureUnit(unsigned int unit);
+	void bindTexture(unsigned int target, unsigned int handle);
+	void forgetTexture(unsigned int handle);
+	void setSamplerParameter(unsigned int target, unsigned int name, int value, int* current);
+	void bindVertexArray(unsigned int handle);
+	void uploadUniformBuffer(UniformBuffer* buffer);
+	void copyToDrawRing(UniformBuffer* buffer, unsigned int size);
+	void bindUniformBuffer(unsigned int binding, unsigned int handle, unsigned int offset, unsigned int size);
+	void uploadStreamBuffer(unsigned int target, unsigned int* handle, unsigned int* storageSize, const void* data, unsigned int size, unsigned int capacity);
 
 	void enableDepthWrite();
 	void deleteMeshPart(MeshPart* part);
+	VertexAttributeBinding* getMeshVertexAttributeObj(Mesh* mesh, Material* material, RenderView* view);
 
+	unsigned int _currentProgram;
+	unsigned int _activeTextureUnit;
+	// The 2D and cube map textures bound to each texture unit.
+	unsigned int _boundTextures[MAX_TEXTURE_UNITS][2];
+	std::unordered_map<unsigned int, SamplerState> _samplerStates;
+	unsigned int _currentVertexArray;
+	BufferRange _boundUniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
+	// Shared per-frame and per-draw block values. Each draw gets its own copy of the
+	// per-draw values in the ring buffer, so writing them doesn't wait for earlier draws.
+	UniformBuffer* _frameUniforms;
+	UniformBuffer* _drawUniforms;
+	unsigned int _drawRing;
+	unsigned int _drawRingHead;
+	unsigned int _drawRingOffset;
+	unsigned int _drawRingAlignment;
+	StateCacheStats _stats;
 };
 
 }
@@ -1,5 +1,9 @@
 #include "RenderPipline.h"
 #include "math/Vector4.h"
+#include "base/ThreadPool.h"
+#include "scene/Occluder.h"
+#include "scene/LodGroup.h"
+#include <chrono>
 
 using namespace gameplay;
 
@@ -11,7 +15,14 @@ enum RenderQueue
     QUEUE_COUNT
 };
 
-RenderPipline::RenderPipline(Renderer* renderer) : renderer(renderer), _scene(NULL) ,__viewFrustumCulling(true){
+// The most joints of the skins drawn by the skinned shadow caster material.
+static const unsigned int SHADOW_CASTER_JOINT_COUNT = 64;
+
+RenderPipline::RenderPipline(Renderer* renderer) : renderer(renderer), _scene(NULL) ,__viewFrustumCulling(true),
+    _occlusionCulling(false), _occlusionCuller(NULL),
+    _clusteredLighting(false), _lightGrid(NULL), _maxLightsPerDraw(0),
+    _shadows(true), _shadowResolution(1024), _shadowCascadeCount(ShadowMap::MAX_CASCADES), _shadowCameraNode(NULL),
+    _shadowCasterMaterial(NULL), _shadowCasterSkinnedMaterial(NULL) {
 }
 
 void RenderPipline::render(Scene* scene, Camera* camera, Rectangle* viewport) {
@@ -24,26 +35,95 @@ void RenderPipline::render(Scene* scene, Camera* camera, Rectangle* viewport) {
         queue.clear();
     }
 
-    // Clear the color and depth buffers
-    renderer->clear(Renderer::CLEAR_COLOR_DEPTH, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0);
-
-    // Visit all the nodes in the scene for drawing
+    // Visit all the nodes in the scene for drawing, then cull them all at once
+    _drawNodes.clear();
+    _cullIndices.clear();
+    _cullCenterX.clear();
+    _cullCenterY.clear();
+    _cullCenterZ.clear();
+    _cullRadius.clear();
+    _occluderNodes.clear();
+    _lights.clear();
     scene->visit(this, &RenderPipline::buildRenderQueues);
+    cullRenderQueues();
+
+    // Render the shadow maps, then clear the color and depth buffers
+    renderShadows(viewport);
+    renderer->clear(Renderer::CLEAR_COLOR_DEPTH, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0);
 
     // Draw the scene from our render queues
     drawScene(camera, viewport);
 }
 
 bool RenderPipline::buildRenderQueues(Node *node) {
+    if (_occlusionCulling && node->getComponent<Occluder>())
+        _occluderNodes.push_back(node);
+    if (Light* light = node->getLight())
+        _lights.push_back(light);
+
     Drawable* drawable = node->getDrawable();
     if (drawable)
     {
-        // Perform view-frustum culling for this node
-        if (dynamic_cast<Model*>(drawable)) {
-            if (__viewFrustumCulling && !node->getBoundingSphere().intersects(_camera->getFrustum()))
-                return true;
+        // Gather the bounding spheres of models for view-frustum and shadow caster culling
+        int cullIndex = -1;
+        if (dynamic_cast<Model*>(drawable) || dynamic_cast<LodGroup*>(drawable)) {
+            const BoundingSphere& sphere = node->getBoundingSphere();
+            cullIndex = (int)_cullRadius.size();
+            _cullCenterX.push_back(sphere.center.x);
+            _cullCenterY.push_back(sphere.center.y);
+            _cullCenterZ.push_back(sphere.center.z);
+            _cullRadius.push_back(sphere.radius);
+        }
+        _drawNodes.push_back(node);
+        _cullIndices.push_back(cullIndex);
+    }
+    return true;
+}
+
+void RenderPipline::cullRenderQueues() {
+    unsigned int cullCount = (unsigned int)_cullRadius.size();
+    if (cullCount > 0)
+    {
+        _cullVisibility.resize((cullCount + 31) / 32);
+        if (__viewFrustumCulling)
+            _camera->getFrustum().intersectSpheres(&_cullCenterX[0], &_cullCenterY[0], &_cullCenterZ[0], &_cullRadius[0],
+                cullCount, &_cullVisibility[0], ThreadPool::getDefault());
+        else
+            std::fill(_cullVisibility.begin(), _cullVisibility.end(), 0xFFFFFFFFu);
+    }
+
+    // Rasterize the occluders, then hide the models left by frustum culling that are behind them
+    if (cullCount > 0 && _occlusionCulling && !_occluderNodes.empty())
+    {
+        if (!_occlusionCuller)
+            _occlusionCuller = new OcclusionCuller();
+        _occlusionCuller->begin(_camera->getViewProjectionMatrix());
+        for (size_t i = 0, count = _occluderNodes.size(); i < count; ++i)
+        {
+            Node* node = _occluderNodes[i];
+            _occlusionCuller->addOccluder(node->getComponent<Occluder>(), node->getWorldMatrix());
+        }
+        _occlusionCuller->rasterize(ThreadPool::getDefault());
+
+        for (size_t i = 0, count = _drawNodes.size(); i < count; ++i)
+        {
+            int cullIndex = _cullIndices[i];
+            if (cullIndex < 0)
+                continue;
+            unsigned int bit = 1u << (cullIndex % 32);
+            if ((_cullVisibility[cullIndex / 32] & bit) && !_occlusionCuller->isVisible(_drawNodes[i]->getBoundingSphere()))
+                _cullVisibility[cullIndex / 32] &= ~bit;
         }
+    }
+
+    for (size_t i = 0, count = _drawNodes.size(); i < count; ++i)
+    {
+        int cullIndex = _cullIndices[i];
+        if (cullIndex >= 0 && (_cullVisibility[cullIndex / 32] & (1u << (cullIndex % 32))) == 0)
+            continue;
+
         // Determine which render queue to insert the node into
+        Node* node = _drawNodes[i];
         std::vector<Node*>* queue;
         if (node->hasTag("transparent"))
             queue = &_renderQueues[QUEUE_TRANSPARENT];
@@ -52,7 +132,153 @@ bool RenderPipline::buildRenderQueues(Node *node) {
 
         queue->push_back(node);
     }
-    return true;
+}
+
+void RenderPipline::renderShadows(Rectangle* viewport)
+{
+    // Keep the shadow maps of the lights casting shadows this frame, dropping the others
+    std::vector<ShadowMap*> shadowMaps;
+    std::vector<FrameBuffer*> frameBuffers;
+    if (_shadows)
+    {
+        // The lit shaders sample the shadows of one directional and one spot light
+        bool directional = false;
+        bool spot = false;
+        for (size_t i = 0, count = _lights.size(); i < count; ++i)
+        {
+            Light* light = _lights[i];
+            if (light->getShadows() == Light::Shadows::eNone)
+                continue;
+            if (light->getLightType() == Light::DIRECTIONAL && !directional)
+                directional = true;
+            else if (light->getLightType() == Light::SPOT && !spot)
+                spot = true;
+            else
+                continue;
+
+            ShadowMap* shadowMap = NULL;
+            FrameBuffer* frameBuffer = NULL;
+            for (size_t j = 0; j < _shadowMaps.size(); ++j)
+            {
+                if (_shadowMaps[j] && _shadowMaps[j]->getLight() == light)
+                {
+                    shadowMap = _shadowMaps[j];
+                    frameBuffer = _shadowFrameBuffers[j];
+                    _shadowMaps[j] = NULL;
+                    break;
+                }
+            }
+            if (!shadowMap)
+                shadowMap = new ShadowMap(light, _shadowResolution, _shadowCascadeCount);
+            shadowMaps.push_back(shadowMap);
+            frameBuffers.push_back(frameBuffer);
+        }
+    }
+    for (size_t i = 0; i < _shadowMaps.size(); ++i)
+    {
+        SAFE_DELETE(_shadowMaps[i]);
+        SAFE_RELEASE(_shadowFrameBuffers[i]);
+    }
+    _shadowMaps.swap(shadowMaps);
+    _shadowFrameBuffers.swap(frameBuffers);
+    if (_shadowMaps.empty())
+        return;
+
+    if (!_shadowCameraNode)
+    {
+        _shadowCameraNode = Node::create("_shadowCamera");
+        Camera* camera = Camera::createPerspective(45.0f, 1.0f, 1.0f, 10.0f);
+        _shadowCameraNode->setCamera(camera);
+        SAFE_RELEASE(camera);
+    }
+    Camera* shadowCamera = _shadowCameraNode->getCamera();
+
+    // Casters are drawn with depth-only materials instead of their own lit ones
+    if (!_shadowCasterMaterial)
+    {
+        char defines[64];
+        sprintf(defines, "SKINNING;SKINNING_JOINT_COUNT %u", SHADOW_CASTER_JOINT_COUNT);
+        _shadowCasterMaterial = Material::create("res/shaders/colored.vert", "res/shaders/depth.frag", NULL);
+        _shadowCasterSkinnedMaterial = Material::create("res/shaders/colored.vert", "res/shaders/depth.frag", defines);
+        Material* materials[2] = { _shadowCasterMaterial, _shadowCasterSkinnedMaterial };
+        for (int i = 0; i < 2; ++i)
+        {
+            materials[i]->getStateBlock()->setDepthTest(true);
+            materials[i]->getStateBlock()->setDepthWrite(true);
+        }
+    }
+
+    RenderView view;
+    view.camera = shadowCamera;
+    view.lodCamera = _camera;
+    view.wireframe = false;
+    view.overrideMaterial = _shadowCasterMaterial;
+    view.overrideSkinnedMaterial = _shadowCasterSkinnedMaterial;
+    view.overrideJointCount = SHADOW_CASTER_JOINT_COUNT;
+
+    FrameBuffer* previousFrameBuffer = renderer->getCurrentFrameBuffer();
+    unsigned int cullCount = (unsigned int)_cullRadius.size();
+    _casterVisibility.resize((cullCount + 31) / 32);
+    for (size_t i = 0, count = _shadowMaps.size(); i < count; ++i)
+    {
+        ShadowMap* shadowMap = _shadowMaps[i];
+        shadowMap->update(_camera);
+        unsigned int cascadeCount = shadowMap->getCascadeCount();
+        if (cascadeCount == 0)
+            continue;
+
+        // The cascades are stored side by side in one depth texture
+        unsigned int resolution = shadowMap->getResolution();
+        FrameBuffer*& frameBuffer = _shadowFrameBuffers[i];
+        if (frameBuffer && frameBuffer->getWidth() != resolution * cascadeCount)
+            SAFE_RELEASE(frameBuffer);
+        if (!frameBuffer)
+        {
+            char id[32];
+            sprintf(id, "_shadowMap%p", (void*)shadowMap);
+            frameBuffer = renderer->createFrameBuffer(id, resolution * cascadeCount, resolution, Texture::DEPTH);
+            if (!frameBuffer)
+                continue;
+        }
+        shadowMap->setTexture(frameBuffer->getRenderTarget(0)->getTexture());
+
+        frameBuffer->bind();
+        renderer->setViewport(0, 0, resolution * cascadeCount, resolution);
+        renderer->clear(Renderer::CLEAR_DEPTH, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0);
+
+        for (unsigned int c = 0; c < cascadeCount; ++c)
+        {
+            ShadowMap::Cascade& cascade = shadowMap->getCascade(c);
+            cascade.drawCalls = 0;
+            shadowMap->cullCasters(c, cullCount ? &_cullCenterX[0] : NULL, cullCount ? &_cullCenterY[0] : NULL,
+                cullCount ? &_cullCenterZ[0] : NULL, cullCount ? &_cullRadius[0] : NULL,
+                cullCount, cullCount ? &_casterVisibility[0] : NULL, ThreadPool::getDefault());
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            _shadowCameraNode->setRotation(cascade.rotation);
+            _shadowCameraNode->setTranslation(cascade.translation);
+            shadowCamera->setProjectionMatrix(cascade.projection);
+            view.viewport.set((float)(c * resolution), 0.0f, (float)resolution, (float)resolution);
+            renderer->setViewport(c * resolution, 0, resolution, resolution);
+
+            // Opaque models cast shadows, in the order of the render queue
+            for (size_t j = 0, nodeCount = _drawNodes.size(); j < nodeCount; ++j)
+            {
+                int cullIndex = _cullIndices[j];
+                if (cullIndex < 0 || (_casterVisibility[cullIndex / 32] & (1u << (cullIndex % 32))) == 0)
+                    continue;
+                Node* node = _drawNodes[j];
+                if (node->hasTag("transparent"))
+                    continue;
+                cascade.drawCalls += node->getDrawable()->draw(&view);
+            }
+            cascade.renderTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    if (previousFrameBuffer)
+        previousFrameBuffer->bind();
+    renderer->setViewport((int)viewport->x, (int)viewport->y, (int)viewport->width, (int)viewport->height);
 }
 
 void RenderPipline::drawScene(Camera* camera, Rectangle* viewport)
@@ -61,6 +287,16 @@ void RenderPipline::drawScene(Camera* camera, Rectangle* viewport)
     view.camera = camera;
     view.viewport = *viewport;
     view.wireframe = false;
+    view.lights = _lights;
+    view.shadowMaps = _shadowMaps;
+    if (_clusteredLighting)
+    {
+        if (!_lightGrid)
+            _lightGrid = new LightGrid();
+        _lightGrid->build(camera, _lights, ThreadPool::getDefault());
+        view.lightGrid = _lightGrid;
+    }
+
     // Iterate through each render queue and draw the nodes in them
     for (unsigned int i = 0; i < QUEUE_COUNT; ++i)
     {
@@ -68,12 +304,26 @@ void RenderPipline::drawScene(Camera* camera, Rectangle* viewport)
 
         for (size_t j = 0, ncount = queue.size(); j < ncount; ++j)
         {
+            if (_maxLightsPerDraw > 0)
+                LightGrid::selectLights(queue[j]->getBoundingSphere(), _lights, _maxLightsPerDraw, &view.lights, &_rankedLights);
             queue[j]->getDrawable()->draw(&view);
         }
     }
 }
 
 void RenderPipline::finalize() {
+    SAFE_DELETE(_occlusionCuller);
+    SAFE_DELETE(_lightGrid);
+    for (size_t i = 0; i < _shadowMaps.size(); ++i)
+    {
+        SAFE_DELETE(_shadowMaps[i]);
+        SAFE_RELEASE(_shadowFrameBuffers[i]);
+    }
+    _shadowMaps.clear();
+    _shadowFrameBuffers.clear();
+    SAFE_RELEASE(_shadowCameraNode);
+    SAFE_RELEASE(_shadowCasterMaterial);
+    SAFE_RELEASE(_shadowCasterSkinnedMaterial);
     renderer->finalize();
     delete renderer;
     renderer = NULL;
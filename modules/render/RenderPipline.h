@@ -5,6 +5,10 @@
 #include "scene/Renderer.h"
 #include "scene/Scene.h"
 #include "scene/Camera.h"
+#include "scene/OcclusionCuller.h"
+#include "scene/LightGrid.h"
+#include "scene/ShadowMap.h"
+#include "FrameBuffer.h"
 
 namespace gameplay {
 
@@ -15,16 +19,88 @@ namespace gameplay {
 		std::vector<Node*> _renderQueues[2];
 		bool __viewFrustumCulling;
 		Camera* _camera;
+		// Drawable nodes in visit order, with the index of their bounding sphere in the
+		// cull arrays, or -1 if they are not culled.
+		std::vector<Node*> _drawNodes;
+		std::vector<int> _cullIndices;
+		std::vector<float> _cullCenterX;
+		std::vector<float> _cullCenterY;
+		std::vector<float> _cullCenterZ;
+		std::vector<float> _cullRadius;
+		std::vector<unsigned int> _cullVisibility;
+		// Occluders in view, rasterized once the scene is visited when occlusion culling is on.
+		bool _occlusionCulling;
+		OcclusionCuller* _occlusionCuller;
+		std::vector<Node*> _occluderNodes;
+		// Lights of the scene, binned into a clustered grid or picked per draw.
+		std::vector<Light*> _lights;
+		bool _clusteredLighting;
+		LightGrid* _lightGrid;
+		unsigned int _maxLightsPerDraw;
+		std::vector<std::pair<float, Light*> > _rankedLights;
+		// Shadow maps of the lights casting shadows, with the depth frame buffers they are
+		// rendered to, the camera rendering their cascades and the depth-only caster materials.
+		bool _shadows;
+		unsigned int _shadowResolution;
+		unsigned int _shadowCascadeCount;
+		std::vector<ShadowMap*> _shadowMaps;
+		std::vector<FrameBuffer*> _shadowFrameBuffers;
+		Node* _shadowCameraNode;
+		Material* _shadowCasterMaterial;
+		Material* _shadowCasterSkinnedMaterial;
+		std::vector<unsigned int> _casterVisibility;
 	public:
 		RenderPipline(Renderer* renderer);
 		Renderer* getRenderer() { return renderer; }
 		void render(Scene* scene, Camera *camera, Rectangle *viewport);
 
+		/**
+		 * Enables culling the models hidden by the Occluder components of the scene.
+		 */
+		void setOcclusionCulling(bool enabled) { _occlusionCulling = enabled; }
+		bool isOcclusionCulling() const { return _occlusionCulling; }
+		OcclusionCuller* getOcclusionCuller() const { return _occlusionCuller; }
+
+		/**
+		 * Enables binning the point and spot lights into a clustered grid each frame,
+		 * passed to drawables in RenderView::lightGrid.
+		 */
+		void setClusteredLighting(bool enabled) { _clusteredLighting = enabled; }
+		bool isClusteredLighting() const { return _clusteredLighting; }
+		LightGrid* getLightGrid() const { return _lightGrid; }
+
+		/**
+		 * Sets the most lights passed to each drawable in RenderView::lights, picking the
+		 * most important ones. Zero passes all the lights of the scene.
+		 */
+		void setMaxLightsPerDraw(unsigned int maxLights) { _maxLightsPerDraw = maxLights; }
+		unsigned int getMaxLightsPerDraw() const { return _maxLightsPerDraw; }
+
+		/**
+		 * Enables rendering the shadow maps of the first directional and the first spot light
+		 * whose Light::getShadows() is not eNone, passed to drawables in RenderView::shadowMaps.
+		 * Materials defining SHADOWS sample them for directional light 0 and spot light 0.
+		 */
+		void setShadows(bool enabled) { _shadows = enabled; }
+		bool isShadows() const { return _shadows; }
+
+		/**
+		 * Sets the resolution and the number of cascades of the shadow maps created from now on.
+		 */
+		void setShadowMapSize(unsigned int resolution, unsigned int cascadeCount) { _shadowResolution = resolution; _shadowCascadeCount = cascadeCount; }
+
+		/**
+		 * Returns the shadow maps rendered by the last frame, with the cost of each cascade.
+		 */
+		const std::vector<ShadowMap*>& getShadowMaps() const { return _shadowMaps; }
+
 
 		void finalize();
 
 	protected:
 		bool buildRenderQueues(Node* node);
+		void cullRenderQueues();
+		void renderShadows(Rectangle* viewport);
 		void drawScene(Camera* camera, Rectangle* viewport);
 	};
 
@@ -22,10 +22,12 @@ extern PFNGLUNMAPBUFFEROESPROC glUnmapBuffer;
 #define GLEW_STATIC
 #include <GL/glew.h>
 #define GP_USE_VAO
+#define GP_USE_UBO
 #elif __linux__
 #define GLEW_STATIC
 #include <GL/glew.h>
 #define GP_USE_VAO
+#define GP_USE_UBO
 #elif __APPLE__
 #include "TargetConditionals.h"
 #if TARGET_OS_IPHONE || TARGET_IPHONE_SIMULATOR
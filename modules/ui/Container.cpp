@@ -427,7 +427,7 @@ void Container::setScrollPosition(const Vector2& scrollPosition)
 {
     _scrollPosition = scrollPosition;
     setDirty(DIRTY_BOUNDS);
-    setChildrenDirty(DIRTY_BOUNDS, true);
+    setChildrenDirty(DIRTY_BOUNDS, false);
 }
 
 Animation* Container::getAnimation(const char* id) const
@@ -621,10 +621,8 @@ void Container::updateAbsoluteBounds(const Vector2& offset)
     updateScroll();
 }
 
-bool Container::updateChildBounds()
+void Container::updateChildBounds()
 {
-    bool result = false;
-
     for (size_t i = 0, count = _controls.size(); i < count; ++i)
     {
         Control* ctrl = _controls[i];
@@ -634,23 +632,13 @@ bool Container::updateChildBounds()
         {
             bool changed = ctrl->updateBoundsInternal(_scrollPosition);
 
-            // If the child bounds have changed, dirty our bounds and all of our
-            // parent bounds so that our layout and/or bounds are recomputed.
-            if (changed)
-            {
-                Control* parent = this;
-                while (parent && (parent->_autoSize != AUTO_SIZE_NONE || static_cast<Container *>(parent)->getLayout()->getType() != Layout::LAYOUT_ABSOLUTE))
-                {
-                    parent->setDirty(DIRTY_BOUNDS);
-                    parent = parent->_parent;
-                }
-            }
-
-            result = result || changed;
+            // If the child bounds have changed and our layout or size depends on them, dirty our
+            // bounds so that they are recomputed. Our parent is dirtied in turn only if that
+            // changes our own bounds.
+            if (changed && (_autoSize != AUTO_SIZE_NONE || _layout->getType() != Layout::LAYOUT_ABSOLUTE))
+                setDirty(DIRTY_BOUNDS);
         }
     }
-
-    return result;
 }
 
 unsigned int Container::draw(Form* form, const Rectangle& clip)
@@ -1083,30 +1071,7 @@ void Container::updateScroll()
     const Theme::Padding& containerPadding = getPadding();
 
     // Calculate total width and height.
-    _totalWidth = _totalHeight = 0.0f;
-    std::vector<Control*> controls = getControls();
-    for (size_t i = 0, count = controls.size(); i < count; ++i)
-    {
-        Control* control = _controls[i];
-
-        if (!control->isVisible())
-            continue;
-
-        const Rectangle& bounds = control->getBounds();
-        const Theme::Margin& margin = control->getMargin();
-
-        float newWidth = bounds.x + bounds.width + margin.right;
-        if (newWidth > _totalWidth)
-        {
-            _totalWidth = newWidth;
-        }
-
-        float newHeight = bounds.y + bounds.height + margin.bottom;
-        if (newHeight > _totalHeight)
-        {
-            _totalHeight = newHeight;
-        }
-    }
+    getContentSize(&_totalWidth, &_totalHeight);
 
     float vWidth = getImageRegion("verticalScrollBar", state).width;
     float hHeight = getImageRegion("horizontalScrollBar", state).height;
@@ -1199,7 +1164,7 @@ void Container::updateScroll()
     if (dirty)
     {
         setDirty(DIRTY_BOUNDS);
-        setChildrenDirty(DIRTY_BOUNDS, true);
+        setChildrenDirty(DIRTY_BOUNDS, false);
     }
 }
 
@@ -1211,6 +1176,36 @@ void Container::sortControls()
     }
 }
 
+void Container::getContentSize(float* width, float* height) const
+{
+    GP_ASSERT(width);
+    GP_ASSERT(height);
+
+    *width = *height = 0.0f;
+    for (size_t i = 0, count = _controls.size(); i < count; ++i)
+    {
+        Control* control = _controls[i];
+
+        if (!control->isVisible())
+            continue;
+
+        const Rectangle& bounds = control->getBounds();
+        const Theme::Margin& margin = control->getMargin();
+
+        float newWidth = bounds.x + bounds.width + margin.right;
+        if (newWidth > *width)
+        {
+            *width = newWidth;
+        }
+
+        float newHeight = bounds.y + bounds.height + margin.bottom;
+        if (newHeight > *height)
+        {
+            *height = newHeight;
+        }
+    }
+}
+
 bool Container::touchEventScroll(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex)
 {
     switch (evt)
@@ -1297,7 +1292,7 @@ bool Container::touchEventScroll(Touch::TouchEvent evt, int x, int y, unsigned i
 
             _scrollingLastTime = gameTime;
             setDirty(DIRTY_BOUNDS);
-            setChildrenDirty(DIRTY_BOUNDS, true);
+            setChildrenDirty(DIRTY_BOUNDS, false);
             updateScroll();
             return false;
         }
@@ -1432,7 +1427,7 @@ bool Container::mouseEventScroll(Mouse::MouseEvent evt, int x, int y, int wheelD
             if (dirty)
             {
                 setDirty(DIRTY_BOUNDS);
-                setChildrenDirty(DIRTY_BOUNDS, true);
+                setChildrenDirty(DIRTY_BOUNDS, false);
             }
 
             return touchEventScroll(Touch::TOUCH_PRESS, x, y, 0);
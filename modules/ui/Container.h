@@ -353,8 +353,11 @@ protected:
 
     /**
      * Updates the bounds for this container's child controls.
+     *
+     * Only dirty children are laid out again. Children whose bounds changed dirty the
+     * container if its layout or size depends on them.
      */
-    bool updateChildBounds();
+    void updateChildBounds();
 
     /**
      * Sets the specified dirty bits for all children within this container.
@@ -397,6 +400,14 @@ protected:
      */
     void updateScroll();
 
+    /**
+     * Computes the size of the content of the container, which limits scrolling.
+     *
+     * @param width Populated with the content width.
+     * @param height Populated with the content height.
+     */
+    virtual void getContentSize(float* width, float* height) const;
+
     /**
      * Sorts controls by Z-Order (for absolute layouts only).
      * This method is used by controls to notify their parent container when
@@ -470,13 +470,12 @@ void Control::setVisible(bool visible)
 
         setDirty(DIRTY_BOUNDS);
 
-        // force to update parent boundaries when child is hidden
+        // Force to update parent boundaries when child is hidden. Hidden children are skipped by
+        // the parent's bounds update, so only the parent is dirtied here; ancestors whose bounds
+        // depend on it are updated when the parent reports its bounds changed.
         Control* parent = _parent;
-        while (parent && (parent->_autoSize != AUTO_SIZE_NONE || static_cast<Container *>(parent)->getLayout()->getType() != Layout::LAYOUT_ABSOLUTE))
-        {
+        if (parent && (parent->_autoSize != AUTO_SIZE_NONE || static_cast<Container *>(parent)->getLayout()->getType() != Layout::LAYOUT_ABSOLUTE))
             parent->setDirty(DIRTY_BOUNDS);
-            parent = parent->_parent;
-        }
     }
 }
 
@@ -1076,6 +1075,7 @@ void Control::controlEvent(Control::Listener::EventType evt)
 void Control::setDirty(int bits)
 {
     _dirtyBits |= bits;
+    invalidateForm();
 }
 
 bool Control::isDirty(int bit) const
@@ -1083,6 +1083,13 @@ bool Control::isDirty(int bit) const
     return (_dirtyBits & bit) == bit;
 }
 
+void Control::invalidateForm()
+{
+    Form* form = getTopLevelForm();
+    if (form)
+        form->invalidate();
+}
+
 void Control::update(float elapsedTime)
 {
     State state = getState();
@@ -1093,9 +1100,14 @@ void Control::update(float elapsedTime)
 
     // Since opacity is pre-multiplied, we compute it every frame so that we don't need to
     // dirty the entire hierarchy any time a state changes (which could affect opacity).
-    _opacity = getOpacity(state);
+    float opacity = getOpacity(state);
     if (_parent)
-        _opacity *= _parent->_opacity;
+        opacity *= _parent->_opacity;
+    if (opacity != _opacity)
+    {
+        _opacity = opacity;
+        invalidateForm();
+    }
 }
 
 void Control::updateState(State state)
@@ -1118,15 +1130,16 @@ bool Control::updateBoundsInternal(const Vector2& offset)
         _dirtyBits &= ~DIRTY_STATE;
     }
 
-    // If we are a container, always update child bounds first
-    bool changed = false;
+    // If we are a container, always update child bounds first. Children whose bounds changed
+    // dirty us if our layout or size depends on them.
     if (isContainer())
-        changed = static_cast<Container*>(this)->updateChildBounds();
+        static_cast<Container*>(this)->updateChildBounds();
 
     // Clear our dirty bounds bit
     bool dirtyBounds = (_dirtyBits & DIRTY_BOUNDS) != 0;
     _dirtyBits &= ~DIRTY_BOUNDS;
 
+    bool changed = false;
     if (dirtyBounds)
     {
         // Store old bounds so we can determine if they change
@@ -1143,12 +1156,20 @@ bool Control::updateBoundsInternal(const Vector2& offset)
             _viewportBounds != oldViewportBounds ||
             _viewportClipBounds != oldViewportClipBounds)
         {
+            // Only our children are dirtied; their own children are dirtied in turn if
+            // their bounds change, so subtrees that keep their bounds are not laid out again.
             if (isContainer())
-                static_cast<Container*>(this)->setChildrenDirty(DIRTY_BOUNDS, true);
+                static_cast<Container*>(this)->setChildrenDirty(DIRTY_BOUNDS, false);
             changed = true;
         }
+
+        // Lay out again the children dirtied by our new bounds or scroll position.
+        if (isContainer())
+            static_cast<Container*>(this)->updateChildBounds();
     }
 
+    // Only our own bounds are reported; our parent learns of changes to our children
+    // through the bounds they give us.
     return changed;
 }
 
@@ -1575,6 +1596,9 @@ Theme::Style::Overlay** Control::getOverlays(unsigned char overlayTypes, Theme::
     GP_ASSERT(overlays);
     GP_ASSERT(_style);
 
+    // Overlays are only requested to be modified, which changes how the control is drawn.
+    invalidateForm();
+
     unsigned int index = 0;
     if ((overlayTypes & NORMAL) == NORMAL)
     {
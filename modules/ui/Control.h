@@ -1306,6 +1306,13 @@ protected:
      */
     bool isDirty(int bit) const;
 
+    /**
+     * Marks the geometry cached by the form containing this control as out of date.
+     *
+     * @see Form::setRetained
+     */
+    void invalidateForm();
+
     /**
      * Gets the Alignment by string.
      *
@@ -4,6 +4,8 @@
 #include "platform/Toolkit.h"
 #include "base/FileSystem.h"
 #include "material/Material.h"
+#include "material/MaterialParameter.h"
+#include "base/Properties.h"
 
 extern "C" {
 #include "3rd/utf8.h"
@@ -12,6 +14,14 @@ extern "C" {
 #define FONT_VSH "res/shaders/font.vert"
 #define FONT_FSH "res/shaders/font.frag"
 
+// Size distance field glyphs are rasterized at, and the distance in pixels their field spreads over.
+#define DISTANCE_FIELD_SIZE 48
+#define DISTANCE_FIELD_SPREAD 6
+
+// Header of the baked distance field glyph files.
+#define DISTANCE_FIELD_MAGIC 0x46534447 // 'GDSF'
+#define DISTANCE_FIELD_VERSION 1
+
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "3rd/stb_image_write.h"
 
@@ -57,26 +67,116 @@ static std::vector<Font*> __fontCache;
 
 static ShaderProgram* __fontEffect = NULL;
 
+// Incremented when any font releases its textures and sprite batches.
+static unsigned int __glyphClearCount = 0;
+
 
 struct Font::FontTexture {
     SpriteBatch* batch;
     Texture* texture;
     int indexId;
 
-    int lastX;
-    int curY;
-    int maxY;
-    bool isFull;
+    // Skyline of the packed glyphs: the top of the used area as segments sorted by x.
+    struct SkylineNode {
+        int x;
+        int y;
+        int width;
+    };
+    std::vector<SkylineNode> skyline;
+
+    // Area written since the last upload, empty when dirtyX1 <= dirtyX0.
+    int dirtyX0;
+    int dirtyY0;
+    int dirtyX1;
+    int dirtyY1;
 
-    std::vector<Glyph> glyphs;
     unsigned char* data;
 
 
-    FontTexture() : batch(NULL), texture(NULL), indexId(0), lastX(0), curY(0), maxY(0), isFull(false) {}
+    FontTexture() : batch(NULL), texture(NULL), indexId(0), dirtyX0(0), dirtyY0(0), dirtyX1(0), dirtyY1(0), data(NULL) {}
+
+    bool pack(int w, int h, int pageWidth, int pageHeight, int* outX, int* outY);
+    void markDirty(int x, int y, int w, int h);
 };
 
+bool Font::FontTexture::pack(int w, int h, int pageWidth, int pageHeight, int* outX, int* outY) {
+    // Bottom-left skyline: rest the rectangle on the lowest position where it fits,
+    // preferring the narrowest segment to limit wasted space.
+    int bestIndex = -1;
+    int bestY = pageHeight;
+    int bestWidth = pageWidth + 1;
+    for (size_t i = 0; i < skyline.size(); ++i) {
+        int x = skyline[i].x;
+        if (x + w > pageWidth)
+            break;
+
+        int y = 0;
+        int remaining = w;
+        for (size_t j = i; remaining > 0 && j < skyline.size(); ++j) {
+            y = std::max(y, skyline[j].y);
+            remaining -= skyline[j].width;
+        }
+        if (y + h > pageHeight)
+            continue;
+
+        if (y < bestY || (y == bestY && skyline[i].width < bestWidth)) {
+            bestIndex = (int)i;
+            bestY = y;
+            bestWidth = skyline[i].width;
+        }
+    }
+    if (bestIndex < 0)
+        return false;
+
+    SkylineNode node = { skyline[bestIndex].x, bestY + h, w };
+    skyline.insert(skyline.begin() + bestIndex, node);
+
+    // Cut the segments now covered by the new one.
+    for (size_t i = bestIndex + 1; i < skyline.size();) {
+        int end = skyline[i - 1].x + skyline[i - 1].width;
+        if (skyline[i].x >= end)
+            break;
+        int shrink = end - skyline[i].x;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0)
+            break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Merge neighbours of the same height.
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else {
+            ++i;
+        }
+    }
+
+    *outX = node.x;
+    *outY = bestY;
+    return true;
+}
+
+void Font::FontTexture::markDirty(int x, int y, int w, int h) {
+    if (dirtyX1 <= dirtyX0) {
+        dirtyX0 = x;
+        dirtyY0 = y;
+        dirtyX1 = x + w;
+        dirtyY1 = y + h;
+    }
+    else {
+        dirtyX0 = std::min(dirtyX0, x);
+        dirtyY0 = std::min(dirtyY0, y);
+        dirtyX1 = std::max(dirtyX1, x + w);
+        dirtyY1 = std::max(dirtyY1, y + h);
+    }
+}
+
 Font::Font() :
-    _style(PLAIN), _size(30), _spacing(0.0f), textureWidth(256), textureHeight(256), _isStarted(false)
+    _style(PLAIN), _size(30), _spacing(0.0f), textureWidth(512), textureHeight(512), _isStarted(false), distanceField(false), glyphGeneration(0)
 {
     shaderProgram = ShaderProgram::createFromFile(FONT_VSH, FONT_FSH);
 }
@@ -90,13 +190,7 @@ Font::~Font()
         __fontCache.erase(itr);
     }
 
-    for (size_t i = 0, count = fontTextures.size(); i < count; ++i)
-    {
-        fontTextures[i]->texture->release();
-        delete fontTextures[i]->batch;
-        delete fontTextures[i];
-    }
-    fontTextures.clear();
+    clearGlyphs();
 
     for (size_t i = 0, count = fontFaces.size(); i < count; ++i)
     {
@@ -129,10 +223,168 @@ Font* Font::create(const char* path)
     FontFace* face = new FontFace();
     face->load(path);
     font->fontFaces.push_back(face);
+    font->_path = path;
+
+    // Use distance field glyphs when the game is set up for it, loading the baked glyphs next to the font.
+    Properties* config = Toolkit::cur()->getConfig()->getNamespace("ui", true);
+    if (config && config->getBool("fontDistanceField"))
+    {
+        std::string bakedPath = std::string(path) + ".sdf";
+        if (!FileSystem::fileExists(bakedPath.c_str()) || !font->loadDistanceField(bakedPath.c_str()))
+            font->setDistanceField(true);
+    }
 
     return font;
 }
 
+void Font::clearGlyphs()
+{
+    for (size_t i = 0, count = fontTextures.size(); i < count; ++i)
+    {
+        fontTextures[i]->texture->release();
+        delete fontTextures[i]->batch;
+        free(fontTextures[i]->data);
+        delete fontTextures[i];
+    }
+    fontTextures.clear();
+    glyphCache.clear();
+    glyphGeneration++;
+    __glyphClearCount++;
+}
+
+unsigned int Font::getGlyphClearCount()
+{
+    return __glyphClearCount;
+}
+
+Font::FontTexture* Font::addFontTexture(unsigned char* data)
+{
+    FontTexture* fontTexture = new FontTexture();
+    fontTexture->texture = Texture::create(Texture::Format::ALPHA, textureWidth, textureHeight, data);
+    fontTexture->data = data;
+    fontTexture->batch = SpriteBatch::create(fontTexture->texture, shaderProgram);
+    fontTexture->batch->setSampleMode(distanceField ? SpriteBatch::SAMPLE_DISTANCE_FIELD : SpriteBatch::SAMPLE_ALPHA);
+    if (distanceField)
+        fontTexture->batch->getMaterial()->getParameter("u_cutoff")->setValue(Vector2(1.0f, 1.0f));
+    fontTexture->indexId = fontTextures.size();
+    FontTexture::SkylineNode node = { 0, 0, textureWidth };
+    fontTexture->skyline.push_back(node);
+    fontTextures.push_back(fontTexture);
+    return fontTexture;
+}
+
+void Font::setDistanceField(bool enabled)
+{
+    if (distanceField == enabled)
+        return;
+
+    // The glyphs are rasterized differently, start over.
+    clearGlyphs();
+    distanceField = enabled;
+    shaderProgram->release();
+    shaderProgram = ShaderProgram::createFromFile(FONT_VSH, FONT_FSH, enabled ? "DISTANCE_FIELD" : NULL);
+}
+
+bool Font::isDistanceField() const
+{
+    return distanceField;
+}
+
+bool Font::saveDistanceField(const char* path)
+{
+    GP_ASSERT(path);
+
+    if (!distanceField)
+    {
+        GP_WARN("Font '%s' does not use distance field glyphs.", _path.c_str());
+        return false;
+    }
+
+    std::unique_ptr<Stream> stream(FileSystem::open(path, FileSystem::WRITE));
+    if (stream.get() == NULL || !stream->canWrite())
+    {
+        GP_WARN("Failed to write font glyphs '%s'.", path);
+        return false;
+    }
+
+    unsigned int header[6] = { DISTANCE_FIELD_MAGIC, DISTANCE_FIELD_VERSION, (unsigned int)textureWidth, (unsigned int)textureHeight,
+                               (unsigned int)fontTextures.size(), (unsigned int)glyphCache.size() };
+    stream->write(header, sizeof(header), 1);
+    for (std::map<uint64_t, Glyph>::const_iterator itr = glyphCache.begin(); itr != glyphCache.end(); ++itr)
+    {
+        stream->write(&itr->first, sizeof(uint64_t), 1);
+        stream->write(&itr->second, sizeof(Glyph), 1);
+    }
+    for (size_t i = 0; i < fontTextures.size(); ++i)
+    {
+        FontTexture* fontTexture = fontTextures[i];
+        unsigned int nodeCount = (unsigned int)fontTexture->skyline.size();
+        stream->write(&nodeCount, sizeof(nodeCount), 1);
+        stream->write(&fontTexture->skyline[0], sizeof(FontTexture::SkylineNode), nodeCount);
+        stream->write(fontTexture->data, 1, textureWidth * textureHeight);
+    }
+    stream->close();
+    return true;
+}
+
+bool Font::loadDistanceField(const char* path)
+{
+    GP_ASSERT(path);
+
+    std::unique_ptr<Stream> stream(FileSystem::open(path));
+    if (stream.get() == NULL || !stream->canRead())
+    {
+        GP_WARN("Failed to open font glyphs '%s'.", path);
+        return false;
+    }
+
+    unsigned int header[6];
+    if (stream->read(header, sizeof(header), 1) != 1 || header[0] != DISTANCE_FIELD_MAGIC || header[1] != DISTANCE_FIELD_VERSION ||
+        header[2] != (unsigned int)textureWidth || header[3] != (unsigned int)textureHeight)
+    {
+        GP_WARN("Invalid font glyphs file '%s'.", path);
+        return false;
+    }
+
+    setDistanceField(true);
+    clearGlyphs();
+
+    unsigned int textureCount = header[4];
+    unsigned int glyphCount = header[5];
+    for (unsigned int i = 0; i < glyphCount; ++i)
+    {
+        uint64_t key;
+        Glyph glyph;
+        if (stream->read(&key, sizeof(uint64_t), 1) != 1 || stream->read(&glyph, sizeof(Glyph), 1) != 1)
+            break;
+        glyph.imgData = NULL;
+        glyphCache[key] = glyph;
+    }
+    for (unsigned int i = 0; i < textureCount; ++i)
+    {
+        unsigned int nodeCount = 0;
+        std::vector<FontTexture::SkylineNode> skyline;
+        unsigned char* data = (unsigned char*)malloc(textureWidth * textureHeight);
+        bool valid = stream->read(&nodeCount, sizeof(nodeCount), 1) == 1 && nodeCount > 0 && nodeCount <= (unsigned int)textureWidth;
+        if (valid)
+        {
+            skyline.resize(nodeCount);
+            valid = stream->read(&skyline[0], sizeof(FontTexture::SkylineNode), nodeCount) == nodeCount &&
+                    stream->read(data, 1, textureWidth * textureHeight) == (size_t)(textureWidth * textureHeight);
+        }
+        if (!valid)
+        {
+            GP_WARN("Invalid font glyphs file '%s'.", path);
+            free(data);
+            clearGlyphs();
+            return false;
+        }
+        FontTexture* fontTexture = addFontTexture(data);
+        fontTexture->skyline.swap(skyline);
+    }
+    return true;
+}
+
 
 bool Font::isCharacterSupported(int character) const
 {
@@ -146,12 +398,18 @@ void Font::start()
     _isStarted = true;
 }
 
+SpriteBatch* Font::getGlyphBatch(int texture) const
+{
+    GP_ASSERT(texture >= 0 && texture < (int)fontTextures.size());
+    return fontTextures[texture]->batch;
+}
+
 void Font::lazyStart()
 {
     for (size_t i = 0, count = fontTextures.size(); i < count; ++i) {
         SpriteBatch* _batch = fontTextures[i]->batch;
         if (_batch->isStarted())
-            return; // already started
+            continue; // already started
 
         // Update the projection matrix for our batch to match the current viewport
         const Rectangle& vp = Toolkit::cur()->getViewport();
@@ -168,6 +426,9 @@ void Font::lazyStart()
 
 void Font::finish()
 {
+    // Upload the glyphs added since the last flush before the batches draw.
+    flushGlyphs();
+
     for (size_t i = 0, count = fontTextures.size(); i < count; ++i) {
         SpriteBatch* _batch = fontTextures[i]->batch;
         // Finish any font batches that have been started
@@ -188,107 +449,168 @@ bool Font::isStarted() const {
     return _isStarted;
 }
 
+void Font::getMeshBatches(std::vector<MeshBatch*>* batches) const {
+    for (size_t i = 0, count = fontTextures.size(); i < count; ++i) {
+        fontTextures[i]->batch->getMeshBatches(batches);
+    }
+}
 
-bool Font::drawChar(int c, FontInfo& fontInfo, Glyph& glyph, int x, int y, const Vector4& color, int previous) {
-    uint64_t key = ((uint64_t)c << 32) | (((uint64_t)fontInfo.size) << 8) | (fontInfo.bold);
 
+bool Font::cacheGlyph(int c, FontInfo& fontInfo, Glyph& glyph) {
+    // Distance field glyphs are shared by all sizes.
+    uint64_t size = distanceField ? DISTANCE_FIELD_SIZE : fontInfo.size;
+    uint64_t key = ((uint64_t)c << 32) | (size << 8) | (fontInfo.bold);
 
-    FontTexture* fontTexture = NULL;
     auto itr = glyphCache.find(key);
     if (itr != glyphCache.end()) {
         glyph = itr->second;
-        fontTexture = fontTextures[glyph.texture];
+        return true;
     }
-    else {
-        //render char to image
-        if (!fontFaces.at(0)->renderChar(c, fontInfo, glyph)) {
+
+    //render char to image
+    if (distanceField) {
+        FontInfo referenceInfo = fontInfo;
+        referenceInfo.size = DISTANCE_FIELD_SIZE;
+        if (!fontFaces.at(0)->renderCharDistanceField(c, referenceInfo, glyph, DISTANCE_FIELD_SPREAD)) {
             return false;
         }
+    }
+    else if (!fontFaces.at(0)->renderChar(c, fontInfo, glyph)) {
+        return false;
+    }
 
-        //find free space
-        for (int i = 0; i < fontTextures.size(); ++i) {
-            FontTexture* ft = fontTextures[0];
-            if (ft->isFull) continue;
-            if (ft->lastX + glyph.imgW + 1 > textureWidth) {
-                ft->lastX = 0;
-                ft->curY = ft->maxY;
-            }
-            if (ft->curY + glyph.imgH + 1 < textureHeight) {
-                fontTexture = ft;
-                break;
-            }
-            else {
-                ft->isFull = true;
-                //char name[256];
-                //snprintf(name, 256, "fontTexture_%d.png", i);
-                //stbi_write_png(name, textureWidth, textureHeight, 1, ft->data, textureWidth * 1);
-            }
+    //find free space, keeping a pixel of padding around each glyph
+    int x = 0, y = 0;
+    FontTexture* fontTexture = NULL;
+    for (size_t i = 0; i < fontTextures.size(); ++i) {
+        if (fontTextures[i]->pack(glyph.imgW + 1, glyph.imgH + 1, textureWidth, textureHeight, &x, &y)) {
+            fontTexture = fontTextures[i];
+            break;
         }
+    }
 
-        //new texture
-        if (fontTexture == NULL) {
-            fontTexture = new FontTexture();
-            unsigned char* data = (unsigned char*)calloc(1, textureWidth * textureHeight);
-            fontTexture->texture = Texture::create(Texture::Format::ALPHA, textureWidth, textureHeight, data);
-            fontTexture->data = data;
-            fontTexture->batch = SpriteBatch::create(fontTexture->texture, shaderProgram);
-            fontTexture->indexId = fontTextures.size();
-            fontTextures.push_back(fontTexture);
+    //new texture
+    if (fontTexture == NULL) {
+        fontTexture = addFontTexture((unsigned char*)calloc(1, textureWidth * textureHeight));
+        if (!fontTexture->pack(glyph.imgW + 1, glyph.imgH + 1, textureWidth, textureHeight, &x, &y)) {
+            GP_WARN("Glyph %d does not fit in a %dx%d font texture.", c, textureWidth, textureHeight);
+            free(glyph.imgData);
+            glyph.imgData = NULL;
+            return false;
         }
+    }
 
-        //copy sub image
-        glyph.imgX = fontTexture->lastX + 1;
-        glyph.imgY = fontTexture->curY + 1;
-        for (int i = 0; i < glyph.imgH; ++i) {
-            int dstRow = (glyph.imgY + i) * textureWidth;
-            int srcRow = i * glyph.imgW;
-            for (int j = 0; j < glyph.imgW; ++j) {    
-                int dstX = (glyph.imgX + j);
-                fontTexture->data[dstRow + dstX] = glyph.imgData[srcRow + j];
-            }
-        }
-        //stbi_write_png("fontTextureChar.png", glyph.imgW, glyph.imgH, 1, glyph.imgData, glyph.imgW * 1);
-        free(glyph.imgData);
-        glyph.imgData = NULL;
+    //copy sub image
+    glyph.imgX = x + 1;
+    glyph.imgY = y + 1;
+    for (int i = 0; i < glyph.imgH; ++i) {
+        memcpy(fontTexture->data + (glyph.imgY + i) * textureWidth + glyph.imgX, glyph.imgData + i * glyph.imgW, glyph.imgW);
+    }
+    free(glyph.imgData);
+    glyph.imgData = NULL;
+
+    //the texture is updated once for all the glyphs added in a frame
+    fontTexture->markDirty(glyph.imgX, glyph.imgY, glyph.imgW, glyph.imgH);
+    glyph.texture = fontTexture->indexId;
+
+    glyphCache[key] = glyph;
+    return true;
+}
 
-        if (fontTexture->maxY < glyph.imgY + glyph.imgH) {
-            fontTexture->maxY = glyph.imgY + glyph.imgH;
+void Font::flushGlyphs() {
+    for (size_t i = 0, count = fontTextures.size(); i < count; ++i) {
+        FontTexture* fontTexture = fontTextures[i];
+        if (fontTexture->dirtyX1 <= fontTexture->dirtyX0)
+            continue;
+
+        int w = fontTexture->dirtyX1 - fontTexture->dirtyX0;
+        int h = fontTexture->dirtyY1 - fontTexture->dirtyY0;
+        uploadBuffer.resize(w * h);
+        for (int row = 0; row < h; ++row) {
+            memcpy(&uploadBuffer[row * w], fontTexture->data + (fontTexture->dirtyY0 + row) * textureWidth + fontTexture->dirtyX0, w);
         }
-        fontTexture->lastX = glyph.imgX + glyph.imgW;
+        fontTexture->texture->setSubData(fontTexture->dirtyX0, fontTexture->dirtyY0, w, h, &uploadBuffer[0]);
+        fontTexture->dirtyX0 = fontTexture->dirtyX1 = 0;
+    }
+}
 
-        //upload image data
-        fontTexture->texture->setData(fontTexture->data);
-        fontTexture->glyphs.push_back(glyph);
-        glyph.texture = fontTexture->indexId;
-        
-        glyphCache[key] = glyph;
+void Font::prewarm(const char* characters, unsigned int size) {
+    GP_ASSERT(characters);
+
+    if (size == 0)
+    {
+        size = _size;
+    }
+
+    FontInfo fontInfo;
+    fontInfo.bold = 0;
+    fontInfo.size = size;
 
-        //char name[256];
-        //snprintf(name, 256, "fontTexture_%p.png", this);
-        //stbi_write_png(name, textureWidth, textureHeight, 1, fontTexture->data, textureWidth * 1);
+    std::vector<wchar_t> utext(strlen(characters) + 1);
+    size_t utextSize = utf8decode(characters, -1, &utext[0], utext.size(), NULL);
+    for (size_t i = 0; i < utextSize; i++) {
+        wchar_t c = utext[i];
+        if (c == ' ' || c == '\r' || c == '\n' || c == '\t')
+            continue;
+        Glyph glyph;
+        cacheGlyph(c, fontInfo, glyph);
     }
 
-    
-    Texture* texture = fontTexture->texture;
-    SpriteBatch* _batch = fontTexture->batch;
+    flushGlyphs();
+}
+
+bool Font::layoutChar(int c, FontInfo& fontInfo, Glyph& glyph, float x, float y, int previous, float* quad) {
+    if (!cacheGlyph(c, fontInfo, glyph)) {
+        return false;
+    }
 
     if (previous > 0 && previous < 128 && c < 128) {
         float kerning = fontFaces.at(0)->getKerning(fontInfo, previous, c);
         x += kerning;
     }
 
-    _batch->draw(x + (int)(glyph.metrics.horiBearingX), y - (int)(glyph.metrics.horiBearingY - fontInfo.size),
-        glyph.imgW, glyph.imgH,
-        glyph.imgX / (float)textureWidth,
-        (glyph.imgY / (float)textureHeight),
-        (glyph.imgX + glyph.imgW) / (float)textureWidth,
-        ((glyph.imgY + glyph.imgH) / (float)textureHeight),
-        color);
+    // Distance field glyphs are scaled from their reference size; the caller gets the scaled metrics.
+    float scale = 1.0f;
+    if (distanceField) {
+        scale = fontInfo.size / (float)DISTANCE_FIELD_SIZE;
+        glyph.metrics.horiAdvance *= scale;
+    }
+
+    quad[0] = x + glyph.metrics.horiBearingX * scale;
+    quad[1] = y - (glyph.metrics.horiBearingY * scale - fontInfo.size);
+    quad[2] = glyph.imgW * scale;
+    quad[3] = glyph.imgH * scale;
+    quad[4] = glyph.imgX / (float)textureWidth;
+    quad[5] = glyph.imgY / (float)textureHeight;
+    quad[6] = (glyph.imgX + glyph.imgW) / (float)textureWidth;
+    quad[7] = (glyph.imgY + glyph.imgH) / (float)textureHeight;
+    return true;
+}
+
+bool Font::drawChar(int c, FontInfo& fontInfo, Glyph& glyph, int x, int y, const Vector4& color, int previous) {
+    float quad[8];
+    if (!layoutChar(c, fontInfo, glyph, x, y, previous, quad)) {
+        return false;
+    }
 
+    SpriteBatch* _batch = fontTextures[glyph.texture]->batch;
+    if (!_batch->isStarted())
+        lazyStart(); // the glyph went to a new font texture
+
+    _batch->draw(quad[0], quad[1], quad[2], quad[3], quad[4], quad[5], quad[6], quad[7], color);
     return true;
 }
 
 
+size_t Font::decodeText(const char* text, int len)
+{
+    // A UTF-8 string has at most as many characters as bytes.
+    size_t capacity = (len < 0 ? strlen(text) : (size_t)len) + 1;
+    if (decodeBuffer.size() < capacity)
+        decodeBuffer.resize(capacity);
+    return utf8decode(text, len, &decodeBuffer[0], capacity, NULL);
+}
+
 void Font::drawText(const char* text, int x, int y, const Vector4& color, unsigned int size, int len)
 {
     GP_ASSERT(_size);
@@ -299,9 +621,9 @@ void Font::drawText(const char* text, int x, int y, const Vector4& color, unsign
         size = _size;
     }
 
-    wchar_t utext[1024];
-    int utextSize = utf8decode(text, len, utext, 1024, NULL);
-    
+    size_t utextSize = decodeText(text, len);
+    const wchar_t* utext = &decodeBuffer[0];
+
     lazyStart();
 
     int spacing = (int)(size * _spacing);
@@ -361,8 +683,8 @@ void Font::measureText(const char* text, unsigned int size, unsigned int* width,
         size = _size;
     }
 
-    wchar_t utext[1024];
-    int utextSize = utf8decode(text, len, utext, 1024, NULL);
+    size_t utextSize = decodeText(text, len);
+    const wchar_t* utext = &decodeBuffer[0];
 
     if (utextSize == 0)
     {
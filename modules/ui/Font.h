@@ -4,6 +4,8 @@
 #include "objects/SpriteBatch.h"
 #include "FontEngine.h"
 
+size_t utf8decode(char const* str, int len, wchar_t* des, size_t n, int* illegal);
+
 namespace gameplay
 {
 
@@ -13,8 +15,10 @@ namespace gameplay
 class Font : public Ref, public BatchableLayer
 {
     friend class Bundle;
+    friend class Form;
     friend class Text;
     friend class TextBox;
+    friend class TextLayout;
 
 public:
 
@@ -80,8 +84,62 @@ public:
      */
     void finish();
 
+    /**
+     * Rasterizes the glyphs of a set of characters ahead of time.
+     *
+     * Glyphs are otherwise rasterized and packed in the font textures the first time they
+     * are drawn. Pre-warming the characters a screen will show, for example a language's
+     * common character set, avoids doing it while drawing.
+     *
+     * @param characters The UTF-8 encoded characters to rasterize.
+     * @param size The size to rasterize the glyphs at (0 for default size).
+     */
+    void prewarm(const char* characters, unsigned int size = 0);
+
+    /**
+     * Sets whether glyphs are rendered from signed distance fields.
+     *
+     * Distance field glyphs are rasterized once at a reference size and scaled to any
+     * size by the font shader, so all sizes share the same glyphs. Changing the mode
+     * discards the glyphs rasterized so far. The default can be set with the
+     * fontDistanceField property of the ui namespace in game.config.
+     *
+     * @param enabled true to use distance field glyphs, false to rasterize glyphs per size.
+     */
+    void setDistanceField(bool enabled);
+
+    /**
+     * Determines if glyphs are rendered from signed distance fields.
+     *
+     * @return true if glyphs are rendered from distance fields, false otherwise.
+     */
+    bool isDistanceField() const;
+
+    /**
+     * Saves the distance field glyphs rasterized so far to a file.
+     *
+     * Use with prewarm() to bake a character set offline. A font created while distance
+     * field glyphs are enabled in game.config loads the glyphs baked to its path
+     * followed by ".sdf".
+     *
+     * @param path The path of the file to write.
+     *
+     * @return true if the glyphs were saved, false otherwise.
+     */
+    bool saveDistanceField(const char* path);
+
+    /**
+     * Loads distance field glyphs baked with saveDistanceField(), switching to distance field glyphs.
+     *
+     * @param path The path of the file to read.
+     *
+     * @return true if the glyphs were loaded, false otherwise.
+     */
+    bool loadDistanceField(const char* path);
+
     virtual void setProjectionMatrix(const Matrix& matrix);
     virtual bool isStarted() const;
+    virtual void getMeshBatches(std::vector<MeshBatch*>* batches) const;
 
     /**
      * Measures a string's width and height without alignment, wrapping or clipping.
@@ -143,6 +201,47 @@ private:
 
     bool drawChar(int c, FontInfo &fontInfo, Glyph &glyph, int x, int y, const Vector4& color, int previous);
 
+    /**
+     * Computes the quad (x, y, width, height, u1, v1, u2, v2) of a character drawn at a pen position.
+     */
+    bool layoutChar(int c, FontInfo &fontInfo, Glyph &glyph, float x, float y, int previous, float* quad);
+
+    /**
+     * Decodes UTF-8 text into the decode buffer, returning the number of characters.
+     */
+    size_t decodeText(const char* text, int len);
+
+    /**
+     * Finds the glyph of a character, rasterizing it into a font texture if needed.
+     */
+    bool cacheGlyph(int c, FontInfo &fontInfo, Glyph &glyph);
+
+    /**
+     * Uploads the regions of the font textures written since the last flush.
+     */
+    void flushGlyphs();
+
+    /**
+     * Releases the font textures and the cached glyphs.
+     */
+    void clearGlyphs();
+
+    /**
+     * Returns the number of times any font released its textures and glyphs.
+     */
+    static unsigned int getGlyphClearCount();
+
+    struct FontTexture;
+
+    /**
+     * Adds a font texture holding the given data, which it takes ownership of.
+     */
+    FontTexture* addFontTexture(unsigned char* data);
+
+    /**
+     * Returns the sprite batch drawing the glyphs of a font texture.
+     */
+    SpriteBatch* getGlyphBatch(int texture) const;
 
     void lazyStart();
 
@@ -155,13 +254,17 @@ private:
     int textureWidth;
     int textureHeight;
 
-    struct FontTexture;
     std::vector<FontTexture*> fontTextures;
     std::vector<FontFace*> fontFaces;
 
     std::map<uint64_t, Glyph> glyphCache;
+    std::vector<unsigned char> uploadBuffer;
+    std::vector<wchar_t> decodeBuffer;
 
     ShaderProgram* shaderProgram;
+    bool distanceField;
+    // Incremented when the glyphs are discarded, so that text layouts know to lay out again.
+    unsigned int glyphGeneration;
 };
 
 }
@@ -234,4 +234,89 @@ bool FontFace::renderChar(Char uniChar, FontInfo& font, Glyph& g) {
     return true;
 }
 
+// Large value standing for an infinite squared distance.
+#define EDT_INF 1e20f
+
+// Squared distance transform of a 1D function (Felzenszwalb and Huttenlocher).
+static void distanceTransform1D(const float* f, float* d, int* v, float* z, int n) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -EDT_INF;
+    z[1] = EDT_INF;
+    for (int q = 1; q < n; ++q) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = EDT_INF;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q)
+            ++k;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+// Squared distance transform of an image, where 0 marks the pixels to measure the distance to.
+static void distanceTransform2D(std::vector<float>& grid, int w, int h) {
+    int n = std::max(w, h);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+    for (int x = 0; x < w; ++x) {
+        for (int y = 0; y < h; ++y)
+            f[y] = grid[y * w + x];
+        distanceTransform1D(&f[0], &d[0], &v[0], &z[0], h);
+        for (int y = 0; y < h; ++y)
+            grid[y * w + x] = d[y];
+    }
+    for (int y = 0; y < h; ++y) {
+        distanceTransform1D(&grid[y * w], &d[0], &v[0], &z[0], w);
+        memcpy(&grid[y * w], &d[0], w * sizeof(float));
+    }
+}
+
+bool FontFace::renderCharDistanceField(Char uniChar, FontInfo& font, Glyph& g, int spread) {
+    if (!renderChar(uniChar, font, g))
+        return false;
+    if (g.imgW == 0 || g.imgH == 0)
+        return true;
 
+    int w = g.imgW + spread * 2;
+    int h = g.imgH + spread * 2;
+    std::vector<float> outside(w * h, EDT_INF);
+    std::vector<float> inside(w * h, 0.0f);
+    for (int y = 0; y < g.imgH; ++y) {
+        for (int x = 0; x < g.imgW; ++x) {
+            if (g.imgData[y * g.imgW + x] >= 128) {
+                int i = (y + spread) * w + x + spread;
+                outside[i] = 0.0f;
+                inside[i] = EDT_INF;
+            }
+        }
+    }
+    distanceTransform2D(outside, w, h);
+    distanceTransform2D(inside, w, h);
+
+    // Map the signed distance to [0, 255] with the edge at 127.5, inside being brighter.
+    unsigned char* data = (unsigned char*)malloc(w * h);
+    for (int i = 0; i < w * h; ++i) {
+        float distance = sqrtf(outside[i]) - sqrtf(inside[i]);
+        float value = 0.5f - distance / (2.0f * spread);
+        data[i] = (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+    }
+
+    free(g.imgData);
+    g.imgData = data;
+    g.imgW = w;
+    g.imgH = h;
+    g.metrics.width = w;
+    g.metrics.height = h;
+    g.metrics.horiBearingX -= spread;
+    g.metrics.horiBearingY += spread;
+    return true;
+}
@@ -49,6 +49,8 @@ public:
 	~FontFace();
 	bool load(const char* file);
 	bool renderChar(Char ch, FontInfo& font, Glyph& glyph);
+	// Renders a glyph as a signed distance field, with spread pixels of padding on each side.
+	bool renderCharDistanceField(Char ch, FontInfo& font, Glyph& glyph, int spread);
 
 	float getKerning(FontInfo& font, Char previous, Char current);
 	bool merics(Char ch, FontInfo& font, GlyphMetrics& m);
@@ -43,12 +43,14 @@ struct FormInit
 };
 static FormInit __init;
 
-Form::Form() : Drawable(), _batched(true)
+Form::Form() : Drawable(), _batched(true), _merged(false), _mergedBatch(NULL), _retained(false), _redraw(true), _cachedGlyphClearCount(0)
 {
 }
 
 Form::~Form()
 {
+    SAFE_DELETE(_mergedBatch);
+
     // Remove this Form from the global list.
     std::vector<Form*>::iterator it = std::find(__forms.begin(), __forms.end(), this);
     if (it != __forms.end())
@@ -103,6 +105,8 @@ Form* Form::create(const char* url)
     }
 
     form->_batched = formProperties->getBool("batchingEnabled", true);
+    form->_merged = formProperties->getBool("mergingEnabled", false);
+    form->_retained = formProperties->getBool("retained", false);
 
     // Initialize the form and all of its child controls
     form->initialize("Form", style, formProperties);
@@ -261,17 +265,156 @@ unsigned int Form::draw(RenderView* view)
         Matrix::createOrthographicOffCenter(0, viewport.width, viewport.height, 0, 0, 1, &_projectionMatrix);
     }
 
+    // Draw the geometry kept from the last frame if nothing changed since
+    if (_retained && _batched && !_redraw)
+    {
+        int drawCalls = drawCachedBatches();
+        if (drawCalls >= 0)
+            return drawCalls;
+    }
+
+    // Have the sprite batches of the controls send their sprites to the merged batch
+    bool merged = _batched && _merged;
+    if (merged && !_mergedBatch)
+    {
+        _mergedBatch = MergedSpriteBatch::create();
+        merged = _mergedBatch != NULL;
+    }
+    if (merged)
+    {
+        _mergedBatch->setProjectionMatrix(_projectionMatrix);
+        _mergedBatch->start();
+        SpriteBatch::setSink(_mergedBatch);
+    }
+
     // Draw the form
     unsigned int drawCalls = Container::draw(this, _absoluteClipBounds);
 
+    if (merged)
+    {
+        SpriteBatch::setSink(NULL);
+
+        // Finish the merged batch last: the other layers upload the glyphs added while drawing.
+        _batches.push_back(_mergedBatch);
+    }
+
     // Flush all batches that were queued during drawing and then empty the batch list
     if (_batched)
     {
+        if (_retained)
+            cacheBatches();
+
         unsigned int batchCount = _batches.size();
+        drawCalls = batchCount;
+        if (merged)
+        {
+            // Layers whose sprites were merged are empty and draw nothing.
+            drawCalls = 0;
+            std::vector<MeshBatch*> meshBatches;
+            for (unsigned int i = 0; i + 1 < batchCount; ++i)
+                _batches[i]->getMeshBatches(&meshBatches);
+            for (size_t i = 0; i < meshBatches.size(); ++i)
+            {
+                if (meshBatches[i]->isStarted() && meshBatches[i]->_vertexCount > 0)
+                    ++drawCalls;
+            }
+        }
+
         for (unsigned int i = 0; i < batchCount; ++i)
             _batches[i]->finish();
         _batches.clear();
-        drawCalls = batchCount;
+
+        if (merged)
+            drawCalls += _mergedBatch->getDrawCallCount();
+    }
+    return drawCalls;
+}
+
+void Form::cacheBatches()
+{
+    _cachedBatches.clear();
+    _cachedVertices.clear();
+    _cachedIndices.clear();
+
+    std::vector<MeshBatch*> meshBatches;
+    for (size_t i = 0, count = _batches.size(); i < count; ++i)
+    {
+        meshBatches.clear();
+        _batches[i]->getMeshBatches(&meshBatches);
+        for (size_t j = 0; j < meshBatches.size(); ++j)
+        {
+            MeshBatch* meshBatch = meshBatches[j];
+            if (!meshBatch->isStarted() || meshBatch->_vertexCount == 0)
+                continue;
+
+            CachedBatch cached;
+            cached.layer = _batches[i];
+            cached.batch = meshBatch;
+            cached.vertexOffset = _cachedVertices.size();
+            cached.vertexCount = meshBatch->_vertexCount;
+            cached.indexOffset = _cachedIndices.size();
+            cached.indexCount = meshBatch->_indexed ? meshBatch->_indexCount : 0;
+            _cachedBatches.push_back(cached);
+
+            const unsigned char* vertices = meshBatch->getVertices();
+            _cachedVertices.insert(_cachedVertices.end(), vertices, vertices + cached.vertexCount * meshBatch->getVertexFormat().getVertexSize());
+            if (meshBatch->getIndexFormat() == Mesh::INDEX32)
+            {
+                const unsigned int* indices = (const unsigned int*)meshBatch->getIndices();
+                _cachedIndices.insert(_cachedIndices.end(), indices, indices + cached.indexCount);
+            }
+            else
+            {
+                const unsigned short* indices = (const unsigned short*)meshBatch->getIndices();
+                _cachedIndices.insert(_cachedIndices.end(), indices, indices + cached.indexCount);
+            }
+        }
+    }
+    _cachedGlyphClearCount = Font::getGlyphClearCount();
+    _redraw = false;
+}
+
+int Form::drawCachedBatches()
+{
+    // Fonts delete their sprite batches and textures when their glyphs are cleared, which
+    // the cached layers, or the draw calls of the merged batch, may still point to.
+    if (_cachedGlyphClearCount != Font::getGlyphClearCount())
+    {
+        _redraw = true;
+        return -1;
+    }
+
+    // Check that the layers still draw with the cached mesh batches.
+    std::vector<MeshBatch*> meshBatches;
+    for (size_t i = 0, count = _cachedBatches.size(); i < count; ++i)
+    {
+        if (i == 0 || _cachedBatches[i].layer != _cachedBatches[i - 1].layer)
+        {
+            meshBatches.clear();
+            _cachedBatches[i].layer->getMeshBatches(&meshBatches);
+        }
+        if (std::find(meshBatches.begin(), meshBatches.end(), _cachedBatches[i].batch) == meshBatches.end())
+        {
+            _redraw = true;
+            return -1;
+        }
+    }
+
+    int drawCalls = 0;
+    for (size_t i = 0, count = _cachedBatches.size(); i < count; )
+    {
+        BatchableLayer* layer = _cachedBatches[i].layer;
+        layer->setProjectionMatrix(_projectionMatrix);
+        layer->start();
+        for (; i < count && _cachedBatches[i].layer == layer; ++i)
+        {
+            const CachedBatch& cached = _cachedBatches[i];
+            cached.batch->start();
+            cached.batch->add((const float*)&_cachedVertices[cached.vertexOffset], cached.vertexCount,
+                cached.indexCount ? &_cachedIndices[cached.indexOffset] : (const unsigned int*)NULL, cached.indexCount);
+        }
+        layer->finish();
+        ++drawCalls;
     }
     return drawCalls;
 }
@@ -290,6 +433,34 @@ bool Form::isBatchingEnabled() const
 void Form::setBatchingEnabled(bool enabled)
 {
     _batched = enabled;
+    _redraw = true;
+}
+
+bool Form::isMergingEnabled() const
+{
+    return _merged;
+}
+
+void Form::setMergingEnabled(bool enabled)
+{
+    _merged = enabled;
+    _redraw = true;
+}
+
+bool Form::isRetained() const
+{
+    return _retained;
+}
+
+void Form::setRetained(bool retained)
+{
+    _retained = retained;
+    _redraw = true;
+}
+
+void Form::invalidate()
+{
+    _redraw = true;
 }
 
 void Form::updateInternal(float elapsedTime)
@@ -619,6 +790,9 @@ bool Form::pointerEventInternal(bool mouse, int evt, int x, int y, int param)
 
     if (ctrl)
     {
+        // Controls are free to change how they look in response to input.
+        ctrl->invalidateForm();
+
         // Handle setting focus for all press events
         if (pressEvent)
         {
@@ -757,6 +931,8 @@ bool Form::keyEventInternal(Keyboard::KeyEvent evt, int key)
 
     // Dispatch key events
     Control* ctrl = __focusControl;
+    if (ctrl)
+        ctrl->invalidateForm();
     while (ctrl)
     {
         if (ctrl->isEnabled() && ctrl->isVisible())
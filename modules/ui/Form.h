@@ -10,6 +10,7 @@
 #include "platform/Mouse.h"
 //#include "platform/Gamepad.h"
 #include "render/FrameBuffer.h"
+#include "objects/MergedSpriteBatch.h"
 #include "scene/Drawable.h"
 
 namespace gameplay
@@ -140,7 +141,70 @@ public:
      */
     void setBatchingEnabled(bool enabled);
 
+    /**
+     * Determines whether the form merges the sprites of its controls into a few draw calls.
+     *
+     * @return True if merging is enabled for this form, false otherwise.
+     */
+    bool isMergingEnabled() const;
+
+    /**
+     * Turns merging of the sprites of the controls on or off for this form.
+     *
+     * Without merging, a batched form makes a draw call for each texture it draws with: the
+     * theme, each glyph page of each font and each image. With merging, all these sprites go
+     * in the order they are drawn into a single stream sampling up to
+     * MergedSpriteBatch::MAX_TEXTURES textures per draw call, so a form takes one or a handful
+     * of draw calls and overlapping text and controls blend in the right order. Sprite
+     * batches using a custom effect still make their own draw calls.
+     *
+     * Forms only merge sprites when batching is enabled.
+     *
+     * @param enabled True to enable merging, false otherwise (default).
+     */
+    void setMergingEnabled(bool enabled);
+
+    /**
+     * Determines whether the form keeps the geometry it draws between frames.
+     *
+     * @return True if the form is retained, false otherwise.
+     */
+    bool isRetained() const;
+
+    /**
+     * Sets whether the form keeps the geometry it draws between frames.
+     *
+     * A retained form keeps the vertices generated for its controls and draws them again
+     * as long as no control changed, without walking the control hierarchy. This makes
+     * static menus and HUDs nearly free to draw. Changes to the controls (bounds, state,
+     * style, opacity, text or input) redraw the form. Changes made outside of the control
+     * API, such as editing a shared theme, need a call to invalidate().
+     *
+     * Forms are only retained when batching is enabled.
+     *
+     * @param retained True to retain the form, false to draw it every frame (default).
+     */
+    void setRetained(bool retained);
+
+    /**
+     * Makes a retained form generate its geometry again the next time it is drawn.
+     */
+    void invalidate();
+
 private:
+
+    /**
+     * Geometry a mesh batch held when the form was last drawn.
+     */
+    struct CachedBatch
+    {
+        BatchableLayer* layer;
+        MeshBatch* batch;
+        size_t vertexOffset;
+        unsigned int vertexCount;
+        size_t indexOffset;
+        unsigned int indexCount;
+    };
     
     /**
      * Constructor.
@@ -220,6 +284,18 @@ private:
      */
     void finishBatch(BatchableLayer* batch);
 
+    /**
+     * Copies the geometry of the batches drawn this frame into the cache.
+     */
+    void cacheBatches();
+
+    /**
+     * Draws the cached geometry.
+     *
+     * @return The number of draw calls, or -1 if the batches changed since the geometry was cached.
+     */
+    int drawCachedBatches();
+
     /**
      * Unproject a point (from a mouse or touch event) into the scene and then project it onto the form.
      *
@@ -254,6 +330,14 @@ private:
     Matrix _projectionMatrix;           // Projection matrix to be set on SpriteBatch objects when rendering the form
     std::vector<BatchableLayer*> _batches;
     bool _batched;
+    bool _merged;
+    MergedSpriteBatch* _mergedBatch;    // Batch drawing the sprites of all the controls when merging is enabled
+    bool _retained;
+    bool _redraw;                       // Whether the cached geometry is out of date
+    std::vector<CachedBatch> _cachedBatches;
+    std::vector<unsigned char> _cachedVertices;
+    std::vector<unsigned int> _cachedIndices;
+    unsigned int _cachedGlyphClearCount; // Font::getGlyphClearCount() when the geometry was cached
 };
 
 }
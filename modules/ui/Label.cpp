@@ -81,8 +81,13 @@ void Label::update(float elapsedTime)
     Control::update(elapsedTime);
 
     // Update text opacity each frame since opacity is updated in Control::update.
-    _textColor = getTextColor(getState());
-    _textColor.w *= _opacity;
+    Vector4 textColor = getTextColor(getState());
+    textColor.w *= _opacity;
+    if (textColor != _textColor)
+    {
+        _textColor = textColor;
+        invalidateForm();
+    }
 }
 
 void Label::updateState(State state)
@@ -101,8 +106,9 @@ void Label::updateBounds()
         // Measure bounds based only on normal state so that bounds updates are not always required on state changes.
         // This is a trade-off for functionality vs performance, but changing the size of UI controls on hover/focus/etc
         // is a pretty bad practice so we'll prioritize performance here.
-        unsigned int w, h;
-        _font->measureText(_text.c_str(), getFontSize(NORMAL), &w, &h);
+        _textLayout.update(_font, _text.c_str(), getFontSize(NORMAL));
+        unsigned int w = _textLayout.getWidth();
+        unsigned int h = _textLayout.getHeight();
         if (_autoSize & AUTO_SIZE_WIDTH)
         {
             setWidthInternal(w + getBorder(NORMAL).left + getBorder(NORMAL).right + getPadding().left + getPadding().right);
@@ -131,7 +137,8 @@ unsigned int Label::drawText(Form* form, const Rectangle& clip)
 
         //SpriteBatch* batch = _font->getSpriteBatch(fontSize);
         startBatch(form, _font);
-        _font->drawText(_text.c_str(), _textBounds.x, _textBounds.y, _textColor, fontSize);
+        _textLayout.update(_font, _text.c_str(), fontSize);
+        _textLayout.draw(_textBounds.x, _textBounds.y, _textColor);
         finishBatch(form, _font);
 
         return 1;
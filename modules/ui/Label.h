@@ -3,6 +3,7 @@
 
 #include "Control.h"
 #include "Theme.h"
+#include "TextLayout.h"
 
 namespace gameplay
 {
@@ -130,6 +131,11 @@ protected:
      * The font being used to display the label.
      */
     Font* _font;
+
+    /**
+     * The laid out text, kept between frames until the text, font or size changes.
+     */
+    TextLayout _textLayout;
     
     /**
      * The text color being used to display the label.
@@ -0,0 +1,202 @@
+#include "base/Base.h"
+#include "ListView.h"
+
+namespace gameplay
+{
+
+ListView::ListView() : _dataSource(NULL), _itemHeight(32.0f), _reload(false)
+{
+}
+
+ListView::~ListView()
+{
+}
+
+ListView* ListView::create(const char* id, Theme::Style* style)
+{
+    ListView* listView = new ListView();
+    listView->_id = id ? id : "";
+    listView->initialize("ListView", style, NULL);
+    return listView;
+}
+
+Control* ListView::create(Theme::Style* style, Properties* properties)
+{
+    ListView* listView = new ListView();
+    listView->initialize("ListView", style, properties);
+    return listView;
+}
+
+void ListView::initialize(const char* typeName, Theme::Style* style, Properties* properties)
+{
+    Container::initialize(typeName, style, properties);
+
+    if (properties && properties->exists("itemHeight"))
+        _itemHeight = properties->getFloat("itemHeight");
+
+    // Rows are placed by the list, which scrolls vertically and is not sized by its rows.
+    setLayout(Layout::LAYOUT_ABSOLUTE);
+    setScroll(SCROLL_VERTICAL);
+    setAutoSize(AUTO_SIZE_NONE);
+}
+
+const char* ListView::getTypeName() const
+{
+    return "ListView";
+}
+
+void ListView::setDataSource(DataSource* dataSource)
+{
+    _dataSource = dataSource;
+    reloadData();
+}
+
+ListView::DataSource* ListView::getDataSource() const
+{
+    return _dataSource;
+}
+
+void ListView::setItemHeight(float height)
+{
+    if (height != _itemHeight)
+    {
+        _itemHeight = height;
+        reloadData();
+    }
+}
+
+float ListView::getItemHeight() const
+{
+    return _itemHeight;
+}
+
+void ListView::reloadData()
+{
+    _reload = true;
+    setDirty(DIRTY_BOUNDS);
+}
+
+void ListView::scrollToItem(unsigned int index)
+{
+    float top = index * _itemHeight;
+    Vector2 scrollPosition(_scrollPosition);
+    if (top < -scrollPosition.y)
+        scrollPosition.y = -top;
+    else if (top + _itemHeight > -scrollPosition.y + _viewportBounds.height)
+        scrollPosition.y = -(top + _itemHeight - _viewportBounds.height);
+    setScrollPosition(scrollPosition);
+}
+
+Control* ListView::getItem(unsigned int index) const
+{
+    for (size_t i = 0, count = _rows.size(); i < count; ++i)
+    {
+        if (_rowItems[i] == (int)index)
+            return _rows[i];
+    }
+    return NULL;
+}
+
+int ListView::getItemIndex(Control* item) const
+{
+    while (item && item->getParent() != this)
+        item = item->getParent();
+
+    for (size_t i = 0, count = _rows.size(); i < count; ++i)
+    {
+        if (_rows[i] == item)
+            return _rowItems[i];
+    }
+    return -1;
+}
+
+void ListView::getContentSize(float* width, float* height) const
+{
+    GP_ASSERT(width);
+    GP_ASSERT(height);
+
+    *width = 0.0f;
+    *height = _dataSource ? _dataSource->getItemCount() * _itemHeight : 0.0f;
+}
+
+void ListView::updateAbsoluteBounds(const Vector2& offset)
+{
+    // Updates the scroll position, which decides the items in view.
+    Container::updateAbsoluteBounds(offset);
+
+    updateItems();
+
+    // Lay out the rows that were bound now rather than on the next update.
+    updateChildBounds();
+}
+
+void ListView::updateItems()
+{
+    unsigned int first = 0;
+    unsigned int last = 0;
+    if (_dataSource && _itemHeight > 0.0f)
+    {
+        unsigned int count = _dataSource->getItemCount();
+        float top = std::max(-_scrollPosition.y, 0.0f);
+        first = std::min((unsigned int)(top / _itemHeight), count);
+        last = std::min((unsigned int)ceil((top + _viewportBounds.height) / _itemHeight), count);
+        last = std::max(first, last);
+    }
+
+    // Free the rows displaying items out of view, and all of them when the items changed.
+    _visibleRows.assign(last - first, -1);
+    for (size_t i = 0, count = _rows.size(); i < count; ++i)
+    {
+        int item = _rowItems[i];
+        if (item >= (int)first && item < (int)last && !_reload)
+            _visibleRows[item - first] = (int)i;
+        else
+            _rowItems[i] = -1;
+    }
+    _reload = false;
+
+    // Bind the items coming into view to free rows, creating rows when none is left.
+    size_t freeRow = 0;
+    for (unsigned int index = first; index < last; ++index)
+    {
+        if (_visibleRows[index - first] >= 0)
+            continue;
+
+        while (freeRow < _rows.size() && _rowItems[freeRow] >= 0)
+            ++freeRow;
+
+        if (freeRow == _rows.size())
+        {
+            Control* row = _dataSource->createItem(this);
+            if (!row)
+            {
+                GP_WARN("List view '%s' data source failed to create an item.", getId());
+                break;
+            }
+            addControl(row);
+            row->release();
+            _rows.push_back(row);
+            _rowItems.push_back(-1);
+        }
+
+        _rowItems[freeRow] = (int)index;
+        _dataSource->bindItem(_rows[freeRow], index);
+    }
+
+    for (size_t i = 0, count = _rows.size(); i < count; ++i)
+    {
+        Control* row = _rows[i];
+        if (_rowItems[i] >= 0)
+        {
+            row->setPosition(0, _rowItems[i] * _itemHeight);
+            row->setSize(_viewportBounds.width, _itemHeight);
+            row->setVisible(true);
+        }
+        else
+        {
+            row->setVisible(false);
+        }
+    }
+}
+
+}
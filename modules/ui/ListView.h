@@ -0,0 +1,205 @@
+#ifndef LISTVIEW_H_
+#define LISTVIEW_H_
+
+#include "Container.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a vertically scrolling list of items of the same height, provided by a data source.
+ *
+ * Only the items in view are backed by controls. The list creates controls for as many rows as
+ * fit in its viewport and binds them to other items as it scrolls, so lists of many thousands of
+ * items cost about the same to update, lay out and draw as lists of a single screen of items.
+ *
+ * The list positions and sizes its rows: each row spans the width of the list and has the item height.
+ *
+ * @see http://gameplay3d.github.io/GamePlay/docs/file-formats.html#wiki-UI_Forms
+ */
+class ListView : public Container
+{
+    friend class ControlFactory;
+
+public:
+
+    /**
+     * Provides the items of a list view.
+     */
+    class DataSource
+    {
+    public:
+
+        /**
+         * Destructor.
+         */
+        virtual ~DataSource() { }
+
+        /**
+         * Returns the number of items in the list.
+         *
+         * @return The number of items.
+         */
+        virtual unsigned int getItemCount() = 0;
+
+        /**
+         * Creates a control to display items in.
+         *
+         * The control is reused to display other items as the list scrolls.
+         *
+         * @param list The list the control is created for.
+         *
+         * @return A new control, which the list takes ownership of.
+         */
+        virtual Control* createItem(ListView* list) = 0;
+
+        /**
+         * Sets up a control to display an item.
+         *
+         * @param item A control returned by createItem().
+         * @param index The index of the item to display.
+         */
+        virtual void bindItem(Control* item, unsigned int index) = 0;
+    };
+
+    /**
+     * Creates a new list view.
+     *
+     * @param id The list view ID.
+     * @param style The list view style (optional).
+     *
+     * @return The new list view.
+     * @script{create}
+     */
+    static ListView* create(const char* id, Theme::Style* style = NULL);
+
+    /**
+     * Extends ScriptTarget::getTypeName() to return the type name of this class.
+     *
+     * @return The type name of this class: "ListView"
+     * @see ScriptTarget::getTypeName()
+     */
+    const char* getTypeName() const;
+
+    /**
+     * Sets the data source providing the items of the list.
+     *
+     * The list does not take ownership of the data source.
+     *
+     * @param dataSource The data source, or NULL to empty the list.
+     */
+    void setDataSource(DataSource* dataSource);
+
+    /**
+     * Returns the data source providing the items of the list.
+     *
+     * @return The data source.
+     */
+    DataSource* getDataSource() const;
+
+    /**
+     * Sets the height of the items.
+     *
+     * @param height The item height, in pixels.
+     */
+    void setItemHeight(float height);
+
+    /**
+     * Returns the height of the items.
+     *
+     * @return The item height, in pixels.
+     */
+    float getItemHeight() const;
+
+    /**
+     * Binds the items in view again, after the items or their number changed.
+     */
+    void reloadData();
+
+    /**
+     * Scrolls the list so that an item is in view.
+     *
+     * @param index The index of the item.
+     */
+    void scrollToItem(unsigned int index);
+
+    /**
+     * Returns the control displaying an item.
+     *
+     * @param index The index of the item.
+     *
+     * @return The control displaying the item, or NULL if the item is not in view.
+     */
+    Control* getItem(unsigned int index) const;
+
+    /**
+     * Returns the index of the item displayed by a control of the list.
+     *
+     * @param item A control displaying an item, or one of its children.
+     *
+     * @return The index of the item, or -1 if the control does not display an item.
+     */
+    int getItemIndex(Control* item) const;
+
+protected:
+
+    /**
+     * Constructor.
+     */
+    ListView();
+
+    /**
+     * Destructor.
+     */
+    virtual ~ListView();
+
+    /**
+     * Creates a new list view.
+     *
+     * @param style The control's custom style.
+     * @param properties A properties object containing a definition of the list view (optional).
+     *
+     * @return The new list view.
+     */
+    static Control* create(Theme::Style* style, Properties* properties = NULL);
+
+    /**
+     * @see Control::initialize
+     */
+    void initialize(const char* typeName, Theme::Style* style, Properties* properties);
+
+    /**
+     * @see Control::updateAbsoluteBounds
+     */
+    void updateAbsoluteBounds(const Vector2& offset);
+
+    /**
+     * @see Container::getContentSize
+     */
+    void getContentSize(float* width, float* height) const;
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    ListView(const ListView& copy);
+
+    /**
+     * Binds the items in view to rows, creating rows as needed, and hides the other rows.
+     */
+    void updateItems();
+
+    DataSource* _dataSource;
+    float _itemHeight;
+    bool _reload;
+    // Controls displaying items, and the index of the item each displays (-1 for unused rows).
+    std::vector<Control*> _rows;
+    std::vector<int> _rowItems;
+    // Rows displaying the items in view, by item index relative to the first item in view.
+    std::vector<int> _visibleRows;
+};
+
+}
+
+#endif
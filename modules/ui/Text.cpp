@@ -37,15 +37,14 @@ Text* Text::create(const char* fontPath, const char* str, const Vector4& color,
         size = font->_size;
     }
 
-    unsigned int widthOut, heightOut;
-    font->measureText(str, size, &widthOut, &heightOut);
     Text* text = new Text();
     text->_font = font;
     text->_drawFont = font;
     text->_text = str;
     text->_size = size;
-    text->_width = (float)widthOut + 1;
-    text->_height = (float)heightOut + 1;
+    text->_textLayout.update(font, str, size);
+    text->_width = (float)text->_textLayout.getWidth() + 1;
+    text->_height = (float)text->_textLayout.getHeight() + 1;
     text->_color = color;
 
     return text;
@@ -257,10 +256,9 @@ unsigned int Text::draw(RenderView* view)
             clipViewport.y += position.y;
         }
     }
+    _textLayout.update(_drawFont, _text.c_str(), _size);
     _drawFont->start();
-    _drawFont->drawText(_text.c_str(), position.x, position.y,
-                    Vector4(_color.x, _color.y, _color.z, _color.w * _opacity), _size
-                    );
+    _textLayout.draw(position.x, position.y, Vector4(_color.x, _color.y, _color.z, _color.w * _opacity));
     _drawFont->finish();
     return 1;
 }
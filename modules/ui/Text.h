@@ -5,6 +5,7 @@
 #include "animation/AnimationTarget.h"
 #include "base/Properties.h"
 #include "ui/Font.h"
+#include "ui/TextLayout.h"
 #include "math/Vector2.h"
 #include "math/Vector4.h"
 #include "material/ShaderProgram.h"
@@ -281,6 +282,7 @@ private:
     Font* _font;
     Font* _drawFont;
     std::string _text;
+    TextLayout _textLayout;
     unsigned int _size;
     float _width;
     float _height;
@@ -388,7 +388,8 @@ unsigned int TextBox::drawText(Form* form, const Rectangle& clip)
         //SpriteBatch* batch = _font->getSpriteBatch(fontSize);
         startBatch(form, _font);
         //_font->start();
-        _font->drawText(displayedText.c_str(), _textBounds.x, _textBounds.y, _textColor, fontSize);
+        _textLayout.update(_font, displayedText.c_str(), fontSize);
+        _textLayout.draw(_textBounds.x, _textBounds.y, _textColor);
         //_font->finish();
         finishBatch(form, _font);
 
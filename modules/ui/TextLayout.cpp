@@ -0,0 +1,199 @@
+#include "base/Base.h"
+#include "TextLayout.h"
+
+namespace gameplay
+{
+
+TextLayout::TextLayout()
+    : _font(NULL), _size(0), _wrapWidth(0), _fontGeneration(0), _valid(false), _width(0), _height(0)
+{
+}
+
+TextLayout::~TextLayout()
+{
+    SAFE_RELEASE(_font);
+}
+
+bool TextLayout::update(Font* font, const char* text, unsigned int size, unsigned int width)
+{
+    GP_ASSERT(font);
+    GP_ASSERT(text);
+
+    if (size == 0)
+    {
+        size = font->_size;
+    }
+
+    if (_valid && font == _font && size == _size && width == _wrapWidth &&
+        _fontGeneration == font->glyphGeneration && _text == text)
+    {
+        return false;
+    }
+
+    if (font != _font)
+    {
+        font->addRef();
+        SAFE_RELEASE(_font);
+        _font = font;
+    }
+    _text = text;
+    _size = size;
+    _wrapWidth = width;
+    layout();
+    return true;
+}
+
+void TextLayout::invalidate()
+{
+    _valid = false;
+}
+
+void TextLayout::layout()
+{
+    _characters.resize(_text.size() + 1);
+    size_t count = utf8decode(_text.c_str(), -1, &_characters[0], _characters.size(), NULL);
+    _characters.resize(count);
+
+    _quads.clear();
+    _lines.clear();
+    _lines.push_back(0);
+    _valid = true;
+    _fontGeneration = _font->glyphGeneration;
+
+    FontInfo fontInfo;
+    fontInfo.bold = 0;
+    fontInfo.size = _size;
+    GlyphMetrics metrics;
+    _font->fontFaces.at(0)->merics(0, fontInfo, metrics);
+
+    int spacing = (int)(_size * _font->_spacing);
+    float xPos = 0, yPos = 0;
+    // Lines are drawn _size apart but measured by the line height of the font, as
+    // Font::drawText and Font::measureText do.
+    float measuredY = 0;
+    float maxWidth = 0;
+
+    // Quad following the last break opportunity on the current line, and the pen position there.
+    int breakQuad = -1;
+    float breakX = 0;
+
+    wchar_t previous = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        wchar_t c = _characters[i];
+        switch (c)
+        {
+        case ' ':
+            xPos += _size / 2;
+            breakQuad = (int)_quads.size();
+            breakX = xPos;
+            break;
+        case '\r':
+        case '\n':
+            yPos += _size;
+            measuredY += metrics.height;
+            xPos = 0;
+            _lines.push_back((unsigned int)_quads.size());
+            breakQuad = -1;
+            break;
+        case '\t':
+            xPos += _size * 2;
+            breakQuad = (int)_quads.size();
+            breakX = xPos;
+            break;
+        default:
+            {
+                Glyph glyph;
+                float rect[8];
+                if (_font->layoutChar(c, fontInfo, glyph, xPos, yPos, previous, rect))
+                {
+                    GlyphQuad quad;
+                    quad.x = rect[0];
+                    quad.y = rect[1];
+                    quad.width = rect[2];
+                    quad.height = rect[3];
+                    quad.u1 = rect[4];
+                    quad.v1 = rect[5];
+                    quad.u2 = rect[6];
+                    quad.v2 = rect[7];
+                    quad.texture = glyph.texture;
+                    _quads.push_back(quad);
+                    xPos += floor(glyph.metrics.horiAdvance + spacing);
+                }
+                else
+                {
+                    xPos += _size;
+                }
+
+                // Move the word to the next line when it goes past the wrapping width.
+                if (_wrapWidth > 0 && xPos > _wrapWidth && breakQuad > (int)_lines.back())
+                {
+                    maxWidth = std::max(maxWidth, breakX);
+                    for (size_t j = breakQuad; j < _quads.size(); ++j)
+                    {
+                        _quads[j].x -= breakX;
+                        _quads[j].y += _size;
+                    }
+                    xPos -= breakX;
+                    yPos += _size;
+                    measuredY += metrics.height;
+                    _lines.push_back((unsigned int)breakQuad);
+                    breakQuad = -1;
+                }
+            }
+            break;
+        }
+
+        maxWidth = std::max(maxWidth, xPos);
+        previous = c;
+    }
+
+    _width = count > 0 ? (unsigned int)maxWidth : 0;
+    _height = count > 0 ? (unsigned int)(metrics.height + measuredY) : 0;
+}
+
+void TextLayout::draw(float x, float y, const Vector4& color, const Rectangle& clip)
+{
+    if (!_font)
+        return;
+
+    // The font discarded its glyphs since the text was laid out.
+    if (!_valid || _fontGeneration != _font->glyphGeneration)
+        layout();
+
+    if (_quads.empty())
+        return;
+
+    _font->lazyStart();
+    for (size_t i = 0; i < _quads.size(); ++i)
+    {
+        const GlyphQuad& quad = _quads[i];
+        SpriteBatch* batch = _font->getGlyphBatch(quad.texture);
+        if (clip.isEmpty())
+            batch->draw(x + quad.x, y + quad.y, quad.width, quad.height, quad.u1, quad.v1, quad.u2, quad.v2, color);
+        else
+            batch->draw(x + quad.x, y + quad.y, quad.width, quad.height, quad.u1, quad.v1, quad.u2, quad.v2, color, clip);
+    }
+}
+
+Font* TextLayout::getFont() const
+{
+    return _font;
+}
+
+unsigned int TextLayout::getWidth() const
+{
+    return _width;
+}
+
+unsigned int TextLayout::getHeight() const
+{
+    return _height;
+}
+
+unsigned int TextLayout::getLineCount() const
+{
+    return _valid ? (unsigned int)_lines.size() : 0;
+}
+
+}
@@ -0,0 +1,131 @@
+#ifndef TEXTLAYOUT_H_
+#define TEXTLAYOUT_H_
+
+#include "Font.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines the layout of a piece of text drawn with a font.
+ *
+ * The layout keeps the decoded characters, the position of each glyph, the line breaks
+ * and the bounds of the text, so that text drawn every frame is only laid out again when
+ * the text, font, size or wrapping width changes.
+ */
+class TextLayout
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    TextLayout();
+
+    /**
+     * Destructor.
+     */
+    ~TextLayout();
+
+    /**
+     * Lays out text, unless the layout already holds the same text laid out the same way.
+     *
+     * @param font The font to draw the text with.
+     * @param text The UTF-8 encoded text.
+     * @param size The size to draw the text at (0 for the font's default size).
+     * @param width The width to wrap lines at, or 0 to only break lines at new line characters.
+     *
+     * @return true if the text was laid out again, false if the layout was up to date.
+     */
+    bool update(Font* font, const char* text, unsigned int size = 0, unsigned int width = 0);
+
+    /**
+     * Draws the text into the font's sprite batches.
+     *
+     * @param x The viewport x position to draw the text at.
+     * @param y The viewport y position to draw the text at.
+     * @param color The color of the text.
+     * @param clip The clipping rectangle, or an empty rectangle to not clip the text.
+     */
+    void draw(float x, float y, const Vector4& color, const Rectangle& clip = Rectangle());
+
+    /**
+     * Discards the layout so that the next update lays the text out again.
+     */
+    void invalidate();
+
+    /**
+     * Returns the font the text is laid out with.
+     *
+     * @return The font, or NULL if no text was laid out.
+     */
+    Font* getFont() const;
+
+    /**
+     * Returns the width of the laid out text.
+     *
+     * @return The width of the text, in pixels.
+     */
+    unsigned int getWidth() const;
+
+    /**
+     * Returns the height of the laid out text.
+     *
+     * @return The height of the text, in pixels.
+     */
+    unsigned int getHeight() const;
+
+    /**
+     * Returns the number of lines of the laid out text.
+     *
+     * @return The number of lines.
+     */
+    unsigned int getLineCount() const;
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    TextLayout(const TextLayout& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TextLayout& operator=(const TextLayout&);
+
+    void layout();
+
+    /**
+     * A glyph quad, relative to the position the text is drawn at.
+     */
+    struct GlyphQuad
+    {
+        float x;
+        float y;
+        float width;
+        float height;
+        float u1;
+        float v1;
+        float u2;
+        float v2;
+        int texture;
+    };
+
+    Font* _font;
+    std::string _text;
+    unsigned int _size;
+    unsigned int _wrapWidth;
+    unsigned int _fontGeneration;
+    bool _valid;
+    std::vector<wchar_t> _characters;
+    std::vector<GlyphQuad> _quads;
+    // Index of the first quad of each line.
+    std::vector<unsigned int> _lines;
+    unsigned int _width;
+    unsigned int _height;
+};
+
+}
+
+#endif
@@ -23,6 +23,67 @@ in vec3 v_spotLightDirection[SPOT_LIGHT_COUNT];
 in vec3 v_cameraDirection; 
 #endif
 
+#if defined(SHADOWS)
+in vec3 v_shadowPosition;
+in float v_shadowDepth;
+
+// Directional light 0 is shadowed by the cascades of the first directional shadow map,
+// side by side in u_shadowMap, and spot light 0 by the first spot shadow map.
+#if (DIRECTIONAL_LIGHT_COUNT > 0)
+uniform sampler2D u_shadowMap;
+uniform vec2 u_shadowTexelSize;
+uniform mat4 u_shadowMatrix[4];
+uniform vec4 u_shadowCascadeFar;
+#endif
+
+#if (SPOT_LIGHT_COUNT > 0)
+uniform sampler2D u_spotShadowMap;
+uniform vec2 u_spotShadowTexelSize;
+uniform mat4 u_spotShadowMatrix;
+#endif
+
+float getShadow(sampler2D shadowMap, vec4 shadowCoord, vec2 texelSize, float bias)
+{
+    // Behind the light or past the far plane of the shadow map, nothing casts shadows.
+    if (shadowCoord.w <= 0.0)
+        return 1.0;
+    vec3 coord = shadowCoord.xyz / shadowCoord.w;
+    if (coord.z >= 1.0)
+        return 1.0;
+
+    // 2x2 percentage-closer filtering
+    float lit = 0.0;
+    for (int y = 0; y < 2; ++y)
+    {
+        for (int x = 0; x < 2; ++x)
+        {
+            vec2 offset = (vec2(float(x), float(y)) - 0.5) * texelSize;
+            lit += step(coord.z - bias, texture2D(shadowMap, coord.xy + offset).r);
+        }
+    }
+    return lit * 0.25;
+}
+
+float getShadowBias(vec3 normalVector, vec3 lightDirection)
+{
+    // Surfaces facing away from the light need a larger bias against shadow acne.
+    return 0.0005 + 0.002 * (1.0 - clamp(dot(normalVector, lightDirection), 0.0, 1.0));
+}
+
+#if (DIRECTIONAL_LIGHT_COUNT > 0)
+float getDirectionalShadow(float bias)
+{
+    // The nearest cascade covering the depth of the pixel; unused cascades end at depth 0.
+    for (int c = 0; c < 4; ++c)
+    {
+        if (v_shadowDepth < u_shadowCascadeFar[c])
+            return getShadow(u_shadowMap, u_shadowMatrix[c] * vec4(v_shadowPosition, 1.0), u_shadowTexelSize, bias);
+    }
+    return 1.0;
+}
+#endif
+#endif
+
 
 
 vec3 computeLighting(vec3 normalVector, vec3 lightDirection, vec3 lightColor, float attenuation)
@@ -76,7 +137,12 @@ vec3 getLitPixel()
         #else
         vec3 lightDirection = normalize(u_directionalLightDirection[i] * 2.0);
         #endif 
-        combinedColor += computeLighting(normalVector, -lightDirection, u_directionalLightColor[i], 1.0);
+        float shadow = 1.0;
+        #if defined(SHADOWS)
+        if (i == 0)
+            shadow = getDirectionalShadow(getShadowBias(normalVector, -lightDirection));
+        #endif
+        combinedColor += computeLighting(normalVector, -lightDirection, u_directionalLightColor[i], shadow);
     }
     #endif
 
@@ -110,6 +176,11 @@ vec3 getLitPixel()
 
 		// Apply spot attenuation
         attenuation *= smoothstep(u_spotLightOuterAngleCos[i], u_spotLightInnerAngleCos[i], spotCurrentAngleCos);
+        #if defined(SHADOWS)
+        if (i == 0)
+            attenuation *= getShadow(u_spotShadowMap, u_spotShadowMatrix * vec4(v_shadowPosition, 1.0), u_spotShadowTexelSize,
+                getShadowBias(normalVector, vertexToSpotLightDirection));
+        #endif
         combinedColor += computeLighting(normalVector, vertexToSpotLightDirection, u_spotLightColor[i], attenuation);
     }
     #endif
@@ -23,6 +23,18 @@ out vec3 v_spotLightDirection[SPOT_LIGHT_COUNT];
 out vec3 v_cameraDirection;
 #endif
 
+#if defined(SHADOWS)
+out vec3 v_shadowPosition;
+out float v_shadowDepth;
+
+void applyShadow(vec4 position)
+{
+    // World position looked up in the shadow maps, and view depth picking the cascade.
+    v_shadowPosition = (u_worldMatrix * position).xyz;
+    v_shadowDepth = -(u_worldViewMatrix * position).z;
+}
+#endif
+
 
 #if defined(BUMPED)
 void applyLight(vec4 position, mat3 tangentSpaceTransformMatrix)
@@ -60,6 +72,10 @@ void applyLight(vec4 position, mat3 tangentSpaceTransformMatrix)
     // Compute camera direction and transform it to tangent space.
     v_cameraDirection = tangentSpaceTransformMatrix * (u_cameraPosition - positionWorldViewSpace.xyz);
     #endif
+
+    #if defined(SHADOWS)
+    applyShadow(position);
+    #endif
 }
 #else
 void applyLight(vec4 position)
@@ -87,6 +103,10 @@ void applyLight(vec4 position)
     #if defined(SPECULAR)  
 	v_cameraDirection = u_cameraPosition - positionWorldViewSpace.xyz;
     #endif
+
+    #if defined(SHADOWS)
+    applyShadow(position);
+    #endif
 }
 
 #endif
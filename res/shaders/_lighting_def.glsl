@@ -1,3 +1,4 @@
+#include "_uniform_blocks.glsl"
 
 #ifndef DIRECTIONAL_LIGHT_COUNT
 #define DIRECTIONAL_LIGHT_COUNT 0
@@ -24,8 +25,6 @@ uniform sampler2D u_normalMap;
 //uniform mat4 u_normalMatrix;
 #endif
 
-uniform mat4 u_inverseTransposeWorldViewMatrix;
-
 #if (DIRECTIONAL_LIGHT_COUNT > 0)
 uniform vec3 u_directionalLightColor[DIRECTIONAL_LIGHT_COUNT];
 #if !defined(BUMPED)
@@ -53,8 +52,4 @@ uniform vec3 u_spotLightDirection[SPOT_LIGHT_COUNT];
 uniform float u_specularExponent;
 #endif
 
-#if defined(SPECULAR)
-uniform vec3 u_cameraPosition;
-#endif
-
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef UNIFORM_BLOCKS_GLSL
+#define UNIFORM_BLOCKS_GLSL
+
+///////////////////////////////////////////////////////////
+// Uniforms set by the engine for every view and every draw.
+// With UNIFORM_BLOCKS defined they are read from the shared std140 blocks, which
+// must be declared identically by all shaders, otherwise they are plain uniforms.
+#if defined(UNIFORM_BLOCKS)
+
+layout(std140) uniform FrameBlock
+{
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    mat4 u_viewProjectionMatrix;
+    vec3 u_cameraPosition;
+};
+
+layout(std140) uniform DrawBlock
+{
+    mat4 u_worldMatrix;
+    mat4 u_worldViewMatrix;
+    mat4 u_worldViewProjectionMatrix;
+    mat4 u_inverseTransposeWorldViewMatrix;
+};
+
+#else
+
+uniform mat4 u_viewMatrix;
+uniform mat4 u_projectionMatrix;
+uniform mat4 u_viewProjectionMatrix;
+uniform vec3 u_cameraPosition;
+
+uniform mat4 u_worldMatrix;
+uniform mat4 u_worldViewMatrix;
+uniform mat4 u_worldViewProjectionMatrix;
+uniform mat4 u_inverseTransposeWorldViewMatrix;
+
+#endif
+
+#endif
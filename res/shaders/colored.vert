@@ -28,7 +28,6 @@ in vec3 a_binormal;
 
 ///////////////////////////////////////////////////////////
 // Uniforms
-uniform mat4 u_worldViewProjectionMatrix;
 
 #if defined(SKINNING)
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];
@@ -39,7 +38,6 @@ uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];
 #endif
 
 #if defined(CLIP_PLANE)
-uniform mat4 u_worldMatrix;
 uniform vec4 u_clipPlane;
 #endif
 
@@ -0,0 +1,13 @@
+#ifdef OPENGL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+///////////////////////////////////////////////////////////
+// Draws depth only, such as the shadow casters of shadow maps.
+void main()
+{
+}
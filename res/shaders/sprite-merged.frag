@@ -0,0 +1,62 @@
+#ifdef OPENGL_ES
+#extension GL_OES_standard_derivatives : enable
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+///////////////////////////////////////////////////////////
+// Uniforms
+uniform sampler2D u_textures[8];
+
+///////////////////////////////////////////////////////////
+// Varyings
+in vec2 v_texCoord;
+in vec4 v_color;
+in vec2 v_sampler;     // texture index, sample mode
+out vec4 FragColor;
+
+vec4 sampleTexture(float index, vec2 texCoord)
+{
+    // Samplers can only be indexed by constants in GLSL ES 1.0.
+    if (index < 0.5)
+        return texture2D(u_textures[0], texCoord);
+    else if (index < 1.5)
+        return texture2D(u_textures[1], texCoord);
+    else if (index < 2.5)
+        return texture2D(u_textures[2], texCoord);
+    else if (index < 3.5)
+        return texture2D(u_textures[3], texCoord);
+    else if (index < 4.5)
+        return texture2D(u_textures[4], texCoord);
+    else if (index < 5.5)
+        return texture2D(u_textures[5], texCoord);
+    else if (index < 6.5)
+        return texture2D(u_textures[6], texCoord);
+    return texture2D(u_textures[7], texCoord);
+}
+
+void main()
+{
+    vec4 texel = sampleTexture(v_sampler.x, v_texCoord);
+    float smoothing = fwidth(texel.a);
+
+    if (v_sampler.y < 0.5)
+    {
+        // Color
+        FragColor = v_color * texel;
+    }
+    else if (v_sampler.y < 1.5)
+    {
+        // Alpha
+        FragColor = vec4(v_color.rgb, texel.a * v_color.a);
+    }
+    else
+    {
+        // Distance field
+        float alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, texel.a);
+        FragColor = vec4(v_color.rgb, alpha * v_color.a);
+    }
+}
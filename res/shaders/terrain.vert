@@ -16,7 +16,6 @@ in vec3 a_binormal;
 
 ///////////////////////////////////////////////////////////
 // Uniforms
-uniform mat4 u_worldViewProjectionMatrix;
 #if !defined(NORMAL_MAP) && defined(LIGHTING)
 uniform mat4 u_normalMatrix;
 #endif
@@ -26,7 +26,6 @@ in vec3 a_binormal;
 
 ///////////////////////////////////////////////////////////
 // Uniforms
-uniform mat4 u_worldViewProjectionMatrix;
 #if !defined(NORMAL_MAP) && defined(LIGHTING)
 uniform mat4 u_normalMatrix;
 #endif
@@ -44,7 +43,6 @@ uniform vec2 u_textureOffset;
 #endif
 
 #if defined(CLIP_PLANE)
-uniform mat4 u_worldMatrix;
 uniform vec4 u_clipPlane;
 #endif
 
@@ -0,0 +1,227 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "gameplay.h"
+
+using namespace gameplay;
+
+// Times the math operations of the backend the engine was built with, next to plain scalar
+// loops doing the same work. Build the engine with GP_NO_SSE to time the scalar backend, or
+// for AVX2 (-mavx2 -mfma, /arch:AVX2) to use the AVX2 batch operations without dispatching.
+
+static const unsigned int COUNT = 4096;
+static const unsigned int REPEAT = 500;
+static const unsigned int CULL_COUNT = 100000;
+
+// Sums results so that the timed work isn't optimized away.
+static float __checksum = 0.0f;
+
+static float random(float min, float max)
+{
+    return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+static Quaternion randomRotation()
+{
+    Quaternion q(random(-1, 1), random(-1, 1), random(-1, 1), random(-1, 1));
+    q.normalize();
+    return q;
+}
+
+// Returns the time taken by one call of f, in nanoseconds.
+template <class F>
+static double measure(F f)
+{
+    // Warm up the caches first.
+    f();
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < REPEAT; ++i)
+        f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / REPEAT;
+}
+
+static void report(const char* name, double engineTime, double scalarTime = 0.0)
+{
+    if (scalarTime > 0.0)
+        printf("%-28s %10.2f ns %10.2f ns %8.2fx\n", name, engineTime / COUNT, scalarTime / COUNT, scalarTime / engineTime);
+    else
+        printf("%-28s %10.2f ns\n", name, engineTime / COUNT);
+}
+
+static void multiplyScalar(const float* m1, const float* m2, float* dst)
+{
+    float product[16];
+    for (int c = 0; c < 4; ++c)
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            product[c * 4 + r] = m1[r] * m2[c * 4] + m1[4 + r] * m2[c * 4 + 1] + m1[8 + r] * m2[c * 4 + 2] + m1[12 + r] * m2[c * 4 + 3];
+        }
+    }
+    memcpy(dst, product, sizeof(product));
+}
+
+static void transformPointScalar(const float* m, const Vector3& p, Vector3* dst)
+{
+    float x = m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12];
+    float y = m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13];
+    float z = m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14];
+    dst->set(x, y, z);
+}
+
+int main()
+{
+    srand(1);
+
+    std::vector<Matrix> m1(COUNT), m2(COUNT), matrices(COUNT);
+    std::vector<Vector3> points(COUNT), transformed(COUNT);
+    std::vector<Vector4> vectors(COUNT), vectorsTransformed(COUNT);
+    std::vector<Quaternion> q1(COUNT), q2(COUNT), quaternions(COUNT);
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        Matrix::createRotation(randomRotation(), &m1[i]);
+        m1[i].translate(random(-100, 100), random(-100, 100), random(-100, 100));
+        m1[i].scale(random(0.5f, 2.0f));
+        Matrix::createRotation(randomRotation(), &m2[i]);
+        points[i].set(random(-100, 100), random(-100, 100), random(-100, 100));
+        vectors[i].set(random(-100, 100), random(-100, 100), random(-100, 100), 1.0f);
+        q1[i] = randomRotation();
+        q2[i] = randomRotation();
+        // Unnormalized quaternions, as accumulated by blending animations.
+        quaternions[i].set(q1[i].x * 3.0f, q1[i].y * 3.0f, q1[i].z * 3.0f, q1[i].w * 3.0f);
+    }
+
+#if defined(GP_USE_NEON)
+    const char* backend = "NEON";
+#elif defined(GP_USE_SSE)
+    const char* backend = MathUtil::isAVX2Supported() ? "SSE2, AVX2 batches" : "SSE2";
+#else
+    const char* backend = "scalar";
+#endif
+    printf("Math backend: %s\n", backend);
+    printf("%-28s %13s %13s %9s\n", "Operation", "Engine", "Scalar", "Speedup");
+
+    double engineTime, scalarTime;
+
+    engineTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+            Matrix::multiply(m1[i], m2[i], &matrices[i]);
+        __checksum += matrices[COUNT - 1].m[12];
+    });
+    scalarTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+            multiplyScalar(m1[i].m, m2[i].m, matrices[i].m);
+        __checksum += matrices[COUNT - 1].m[12];
+    });
+    report("Matrix::multiply", engineTime, scalarTime);
+
+    // Build with GP_NO_SSE to compare the inverse with the scalar backend.
+    engineTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+            m1[i].invert(&matrices[i]);
+        __checksum += matrices[COUNT - 1].m[12];
+    });
+    report("Matrix::invert", engineTime);
+
+    engineTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+            m1[i].transformVector(vectors[i], &vectorsTransformed[i]);
+        __checksum += vectorsTransformed[COUNT - 1].x;
+    });
+    scalarTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+        {
+            const float* m = m1[i].m;
+            const Vector4& v = vectors[i];
+            vectorsTransformed[i].set(m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w,
+                                      m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w,
+                                      m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w,
+                                      m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w);
+        }
+        __checksum += vectorsTransformed[COUNT - 1].x;
+    });
+    report("Matrix::transformVector", engineTime, scalarTime);
+
+    engineTime = measure([&]()
+    {
+        m1[0].transformPoints(&points[0], COUNT, &transformed[0]);
+        __checksum += transformed[COUNT - 1].x;
+    });
+    scalarTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+            transformPointScalar(m1[0].m, points[i], &transformed[i]);
+        __checksum += transformed[COUNT - 1].x;
+    });
+    report("Matrix::transformPoints", engineTime, scalarTime);
+
+    std::vector<Quaternion> normalized(COUNT);
+    engineTime = measure([&]()
+    {
+        Quaternion::normalize(&quaternions[0], COUNT, &normalized[0]);
+        __checksum += normalized[COUNT - 1].x;
+    });
+    scalarTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+            quaternions[i].normalize(&normalized[i]);
+        __checksum += normalized[COUNT - 1].x;
+    });
+    report("Quaternion::normalize[]", engineTime, scalarTime);
+
+    std::vector<Quaternion> blended(COUNT);
+    engineTime = measure([&]()
+    {
+        Quaternion::slerp(&q1[0], &q2[0], 0.3f, COUNT, &blended[0]);
+        __checksum += blended[COUNT - 1].x;
+    });
+    scalarTime = measure([&]()
+    {
+        for (unsigned int i = 0; i < COUNT; ++i)
+            Quaternion::slerp(q1[i], q2[i], 0.3f, &blended[i]);
+        __checksum += blended[COUNT - 1].x;
+    });
+    report("Quaternion::slerp[]", engineTime, scalarTime);
+
+    // Culling of spheres spread around a camera at the origin, given as arrays.
+    std::vector<float> x(CULL_COUNT), y(CULL_COUNT), z(CULL_COUNT), radius(CULL_COUNT);
+    std::vector<BoundingSphere> spheres(CULL_COUNT);
+    for (unsigned int i = 0; i < CULL_COUNT; ++i)
+    {
+        x[i] = random(-1000, 1000);
+        y[i] = random(-1000, 1000);
+        z[i] = random(-1000, 1000);
+        radius[i] = random(1, 20);
+        spheres[i].set(Vector3(x[i], y[i], z[i]), radius[i]);
+    }
+    Matrix projection;
+    Matrix::createPerspective(60.0f, 16.0f / 9.0f, 1.0f, 1000.0f, &projection);
+    Frustum frustum(projection);
+    std::vector<unsigned int> visibility((CULL_COUNT + 31) / 32);
+    engineTime = measure([&]()
+    {
+        frustum.intersectSpheres(&x[0], &y[0], &z[0], &radius[0], CULL_COUNT, &visibility[0]);
+        __checksum += (float)visibility[0];
+    });
+    scalarTime = measure([&]()
+    {
+        unsigned int visible = 0;
+        for (unsigned int i = 0; i < CULL_COUNT; ++i)
+        {
+            if (frustum.intersects(spheres[i]))
+                ++visible;
+        }
+        __checksum += (float)visible;
+    });
+    printf("%-28s %10.2f us %10.2f us %8.2fx\n", "Frustum::intersectSpheres", engineTime / 1000.0, scalarTime / 1000.0, scalarTime / engineTime);
+
+    printf("Times are per element, and for %u spheres when culling. Checksum: %g\n", CULL_COUNT, __checksum);
+    return 0;
+}